@@ -0,0 +1,25 @@
+#ifndef _PICONET_HOST_HARDWARE_CLOCKS_H_
+#define _PICONET_HOST_HARDWARE_CLOCKS_H_
+
+#include "pico.h"
+
+#define CLOCKS_CLK_GPOUT0_CTRL_AUXSRC_VALUE_CLK_USB 0x7
+
+enum clock_index {
+    clk_gpout0 = 0,
+    clk_gpout1,
+    clk_gpout2,
+    clk_gpout3,
+    clk_ref,
+    clk_sys,
+    clk_peri,
+    clk_usb,
+    clk_adc,
+    clk_rtc,
+    CLK_COUNT
+};
+
+void     clock_gpio_init(uint gpio, uint src, float div);
+uint32_t clock_get_hz(enum clock_index clk_index);
+
+#endif
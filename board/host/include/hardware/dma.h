@@ -0,0 +1,51 @@
+#ifndef _PICONET_HOST_HARDWARE_DMA_H_
+#define _PICONET_HOST_HARDWARE_DMA_H_
+
+#include "pico.h"
+
+/*
+ * Just enough DMA to copy words from a PIO RX FIFO to memory (see pio_host.c).
+ */
+
+enum dma_channel_transfer_size {
+    DMA_SIZE_8 = 0,
+    DMA_SIZE_16 = 1,
+    DMA_SIZE_32 = 2
+};
+
+typedef struct {
+    uint    dreq;
+} dma_channel_config;
+
+int                 dma_claim_unused_channel(bool required);
+dma_channel_config  dma_channel_get_default_config(uint channel);
+void                dma_channel_configure(
+                        uint channel,
+                        const dma_channel_config *config,
+                        volatile void *write_addr,
+                        const volatile void *read_addr,
+                        uint transfer_count,
+                        bool trigger);
+bool                dma_channel_is_busy(uint channel);
+void                dma_channel_abort(uint channel);
+
+static inline void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size) {
+    (void) c;
+    (void) size;
+}
+
+static inline void channel_config_set_read_increment(dma_channel_config *c, bool incr) {
+    (void) c;
+    (void) incr;
+}
+
+static inline void channel_config_set_write_increment(dma_channel_config *c, bool incr) {
+    (void) c;
+    (void) incr;
+}
+
+static inline void channel_config_set_dreq(dma_channel_config *c, uint dreq) {
+    c->dreq = dreq;
+}
+
+#endif
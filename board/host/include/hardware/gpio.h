@@ -0,0 +1,14 @@
+#ifndef _PICONET_HOST_HARDWARE_GPIO_H_
+#define _PICONET_HOST_HARDWARE_GPIO_H_
+
+#include "pico.h"
+
+#define GPIO_IN                     0
+#define GPIO_OUT                    1
+
+void gpio_init(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_put(uint gpio, bool value);
+bool gpio_get(uint gpio);
+
+#endif
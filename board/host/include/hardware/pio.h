@@ -0,0 +1,53 @@
+#ifndef _PICONET_HOST_HARDWARE_PIO_H_
+#define _PICONET_HOST_HARDWARE_PIO_H_
+
+#include "pico.h"
+
+/*
+ * The emulator has no PIO; instead each command word pushed to a state machine is executed
+ * immediately as a single ADLC bus cycle against the simulated ADLC (see pio_host.c). Whilst
+ * snooping, reads are made whenever the firmware looks at the state machine's IRQ flag or
+ * spins in tight_loop_contents, as if the PIO had been running alongside it.
+ */
+
+#define PIO_SM0_EXECCTRL_JMP_PIN_LSB    24
+#define PIO_SM0_EXECCTRL_JMP_PIN_BITS   0x1f000000
+
+typedef struct {
+    uint32_t    execctrl;
+} pio_sm_hw_t;
+
+typedef struct pio_hw {
+    uint        claimed_sm_mask;
+    uint32_t    rxf[4];
+    pio_sm_hw_t sm[4];
+    uint32_t    irq;
+} pio_hw_t;
+
+typedef pio_hw_t *PIO;
+
+typedef struct {
+    const uint16_t* instructions;
+    uint8_t         length;
+    int8_t          origin;
+} pio_program_t;
+
+extern pio_hw_t host_pio0;
+
+#define pio0 (&host_pio0)
+
+static inline void hw_write_masked(uint32_t *addr, uint32_t values, uint32_t write_mask) {
+    *addr = (*addr & ~write_mask) | (values & write_mask);
+}
+
+int      pio_claim_unused_sm(PIO pio, bool required);
+uint     pio_add_program(PIO pio, const pio_program_t *program);
+void     pio_sm_put_blocking(PIO pio, uint sm, uint32_t data);
+uint32_t pio_sm_get_blocking(PIO pio, uint sm);
+bool     pio_sm_is_rx_fifo_empty(PIO pio, uint sm);
+uint32_t pio_sm_get(PIO pio, uint sm);
+uint     pio_get_dreq(PIO pio, uint sm, bool is_tx);
+bool     pio_interrupt_get(PIO pio, uint pio_interrupt_num);
+void     pio_interrupt_clear(PIO pio, uint pio_interrupt_num);
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef _PICONET_HOST_HARDWARE_SYNC_H_
+#define _PICONET_HOST_HARDWARE_SYNC_H_
+
+#include "pico.h"
+
+/*
+ * Core 0's event register. Host "interrupt handlers" (the USB RX callback and timers) run on
+ * their own threads, excluded whilst core 0 has interrupts disabled.
+ */
+void        __wfe(void);
+void        __sev(void);
+uint32_t    save_and_disable_interrupts(void);
+void        restore_interrupts(uint32_t status);
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef _PICONET_HOST_PICO_H_
+#define _PICONET_HOST_PICO_H_
+
+/*
+ * Host stand-in for the subset of the Pico SDK used by the firmware. Only what the
+ * firmware actually calls is provided; see board/README.md.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;
+
+#define PICO_OK                     0
+#define PICO_ERROR_TIMEOUT          -1
+#define PICO_ERROR_NO_DATA          -3
+
+#define PICO_DEFAULT_LED_PIN        25
+
+// everything runs from RAM on the host
+#define __not_in_flash(group)
+#define __not_in_flash_func(func_name)  func_name
+
+void tight_loop_contents(void);
+
+#endif
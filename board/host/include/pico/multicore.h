@@ -0,0 +1,18 @@
+#ifndef _PICONET_HOST_PICO_MULTICORE_H_
+#define _PICONET_HOST_PICO_MULTICORE_H_
+
+#include "pico.h"
+
+/*
+ * Core 1 runs as a host thread. Note that, unlike the RP2040, both "cores" are preemptively
+ * scheduled by the host OS.
+ */
+void        multicore_launch_core1(void (*entry)(void));
+
+// the inter-core FIFO from core 1 to core 0, 8 words deep as on the RP2040
+bool        multicore_fifo_rvalid(void);
+bool        multicore_fifo_wready(void);
+void        multicore_fifo_push_blocking(uint32_t data);
+uint32_t    multicore_fifo_pop_blocking(void);
+
+#endif
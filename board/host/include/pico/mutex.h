@@ -0,0 +1,16 @@
+#ifndef _PICONET_HOST_PICO_MUTEX_H_
+#define _PICONET_HOST_PICO_MUTEX_H_
+
+#include <pthread.h>
+
+#include "pico.h"
+
+typedef struct {
+    pthread_mutex_t lock;
+} mutex_t;
+
+void mutex_init(mutex_t *mtx);
+void mutex_enter_blocking(mutex_t *mtx);
+void mutex_exit(mutex_t *mtx);
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef _PICONET_HOST_PICO_STDIO_DRIVER_H_
+#define _PICONET_HOST_PICO_STDIO_DRIVER_H_
+
+#include "pico.h"
+
+typedef struct stdio_driver {
+    void (*out_chars)(const char *buf, int len);
+} stdio_driver_t;
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef _PICONET_HOST_PICO_STDLIB_H_
+#define _PICONET_HOST_PICO_STDLIB_H_
+
+#include "pico.h"
+#include "hardware/gpio.h"
+#include "pico/stdio/driver.h"
+
+void            stdio_set_driver_enabled(stdio_driver_t *driver, bool enabled);
+
+absolute_time_t get_absolute_time(void);
+uint32_t        to_ms_since_boot(absolute_time_t t);
+uint64_t        time_us_64(void);
+uint32_t        time_us_32(void);
+void            sleep_ms(uint32_t ms);
+void            sleep_us(uint64_t us);
+void            busy_wait_us(uint64_t delay_us);
+
+typedef struct repeating_timer repeating_timer_t;
+typedef bool (*repeating_timer_callback_t)(repeating_timer_t *rt);
+
+struct repeating_timer {
+    int64_t                     delay_us;
+    repeating_timer_callback_t  callback;
+    void                        *user_data;
+};
+
+bool            add_repeating_timer_us(
+                    int64_t delay_us,
+                    repeating_timer_callback_t callback,
+                    void *user_data,
+                    repeating_timer_t *out);
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef _PICONET_HOST_PICO_UTIL_QUEUE_H_
+#define _PICONET_HOST_PICO_UTIL_QUEUE_H_
+
+#include <pthread.h>
+
+#include "pico.h"
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t  changed;
+    uint8_t*        data;
+    uint            element_size;
+    uint            element_count;
+    uint            rptr;
+    uint            level;
+} queue_t;
+
+void queue_init(queue_t *q, uint element_size, uint element_count);
+void queue_free(queue_t *q);
+uint queue_get_level(queue_t *q);
+bool queue_is_empty(queue_t *q);
+bool queue_is_full(queue_t *q);
+bool queue_try_add(queue_t *q, const void *data);
+bool queue_try_remove(queue_t *q, void *data);
+bool queue_try_peek(queue_t *q, void *data);
+void queue_add_blocking(queue_t *q, const void *data);
+void queue_remove_blocking(queue_t *q, void *data);
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef _PICONET_HOST_PINCTL_PIO_H_
+#define _PICONET_HOST_PINCTL_PIO_H_
+
+/*
+ * Host replacement for the header pioasm generates from ../src/pinctl.pio. The program itself
+ * is never run: pio_host.c performs the equivalent bus cycle for each command word.
+ */
+
+#include "hardware/pio.h"
+
+static const pio_program_t pinctl_program = {
+    .instructions = NULL,
+    .length = 0,
+    .origin = -1,
+};
+
+static inline void pinctl_program_init(PIO pio, uint sm, uint offset, uint pin_data_7, uint pin_cs, float frequency) {
+    (void) pio;
+    (void) sm;
+    (void) offset;
+    (void) pin_data_7;
+    (void) pin_cs;
+    (void) frequency;
+}
+
+static inline void pinctl_set_latch_pin(PIO pio, uint sm, uint pin) {
+    hw_write_masked(&pio->sm[sm].execctrl, pin << PIO_SM0_EXECCTRL_JMP_PIN_LSB, PIO_SM0_EXECCTRL_JMP_PIN_BITS);
+}
+
+#endif
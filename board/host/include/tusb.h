@@ -0,0 +1,34 @@
+#ifndef _PICONET_HOST_TUSB_H_
+#define _PICONET_HOST_TUSB_H_
+
+#include "pico.h"
+#include "tusb_config.h"
+
+/*
+ * The TinyUSB device API for CDC ACM and vendor interfaces, each interface being a
+ * pseudo-terminal (see host_usb_attach() and host_usb_attach_vendor()). Writes fill a FIFO of
+ * CFG_TUD_xxx_TX_BUFSIZE bytes which, as on the board, is only sent once flushed or a packet's
+ * worth has been written.
+ */
+
+bool        tusb_init(void);
+void        tud_task(void);
+
+bool        tud_cdc_n_connected(uint8_t itf);
+uint32_t    tud_cdc_n_read(uint8_t itf, void *buffer, uint32_t bufsize);
+void        tud_cdc_n_read_flush(uint8_t itf);
+uint32_t    tud_cdc_n_write(uint8_t itf, const void *buffer, uint32_t bufsize);
+uint32_t    tud_cdc_n_write_flush(uint8_t itf);
+uint32_t    tud_cdc_n_write_available(uint8_t itf);
+
+uint32_t    tud_vendor_n_read(uint8_t itf, void *buffer, uint32_t bufsize);
+uint32_t    tud_vendor_n_write(uint8_t itf, const void *buffer, uint32_t bufsize);
+uint32_t    tud_vendor_n_write_flush(uint8_t itf);
+uint32_t    tud_vendor_n_write_available(uint8_t itf);
+
+// implemented by the firmware, invoked by tud_task() once input arrives
+void        tud_cdc_rx_cb(uint8_t itf);
+void        tud_vendor_rx_cb(uint8_t itf, const uint8_t *buffer, uint16_t bufsize);
+void        tud_umount_cb(void);
+
+#endif
@@ -0,0 +1,522 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "adlc.h"
+#include "adlc_model.h"
+#include "econet_line.h"
+#include "host.h"
+
+#define RX_BACKLOG_MAX      32
+#define FIFO_DEPTH          3
+
+// without strict timing, frames which ended this long before the receiver was next looked at
+// (e.g. whilst the firmware was in STOP mode) are lost rather than backlogged
+#define RX_BACKLOG_MAX_AGE_NS   10000000ull
+
+// frames looped back from the transmitter have IDs distinct from those given by the line
+#define LOOP_FRAME_ID_BASE      0x80000000u
+
+typedef struct {
+    uint32_t    id;
+    uint64_t    start_ns;
+    bool        ended;
+    bool        corrupt;
+    size_t      len;
+    size_t      read_pos;
+    uint8_t     data[];
+} rx_frame_t;
+
+typedef enum {
+    TX_IDLE = 0L,
+    TX_LOADING,
+    TX_SENDING
+} tx_state_t;
+
+static bool                 _strict;
+static int                  _endpoint;
+static bool                 _in_reset;
+static uint8_t              _cr1;
+static uint8_t              _cr2;
+static uint8_t              _cr3;
+static uint8_t              _cr4;
+
+static rx_frame_t*          _rx_frames[RX_BACKLOG_MAX];
+static uint                 _rx_head;
+static uint                 _rx_count;
+static bool                 _rx_overrun;
+
+static tx_state_t           _tx_state;
+static uint8_t              _tx_buffer[LINE_MAX_FRAME_SZ];
+static size_t               _tx_len;
+static uint64_t             _tx_start_ns;
+static uint64_t             _tx_end_ns;
+static bool                 _tx_underrun;
+static uint32_t             _loop_frame_id;     // of the frame being looped back, if any
+static uint32_t             _loop_frames;
+
+static adlc_model_stats_t   _stats;
+
+static rx_frame_t* _rx_head_frame(void) {
+    return _rx_count > 0 ? _rx_frames[_rx_head] : NULL;
+}
+
+static void _rx_pop(void) {
+    free(_rx_frames[_rx_head]);
+    _rx_frames[_rx_head] = NULL;
+    _rx_head = (_rx_head + 1) % RX_BACKLOG_MAX;
+    _rx_count--;
+}
+
+// number of bytes of the frame that have arrived in the receiver
+static size_t _rx_arrived(const rx_frame_t* f, uint64_t now_ns) {
+    uint64_t byte_ns = line_byte_ns();
+    if (now_ns < f->start_ns + 2 * byte_ns) {
+        return 0;
+    }
+    size_t arrived = (now_ns - f->start_ns) / byte_ns - 1;
+    return arrived < f->len ? arrived : f->len;
+}
+
+// number of bytes of the frame the CPU may read, holding back the last until the closing flag
+static size_t _rx_readable(const rx_frame_t* f, uint64_t now_ns) {
+    if (f->ended || f->len == 0) {
+        return f->len;
+    }
+    size_t arrived = _rx_arrived(f, now_ns);
+    return arrived < f->len ? arrived : f->len - 1;
+}
+
+static bool _rx_started(const rx_frame_t* f, uint64_t now_ns) {
+    return _rx_arrived(f, now_ns) > 0;
+}
+
+static void _rx_drop_head(void) {
+    rx_frame_t* f = _rx_head_frame();
+    if (f == NULL) {
+        return;
+    }
+    if (f->read_pos > 0) {
+        _stats.frames_discarded++;
+    } else {
+        _stats.frames_missed++;
+    }
+    _rx_pop();
+}
+
+static void _rx_check_overrun(uint64_t now_ns) {
+    if (!_strict) {
+        return;
+    }
+
+    rx_frame_t* f = _rx_head_frame();
+    while (f != NULL && _rx_arrived(f, now_ns) > f->read_pos + FIFO_DEPTH) {
+        _rx_overrun = true;
+        _stats.rx_overruns++;
+        _stats.frames_missed++;
+        _rx_pop();
+        f = _rx_head_frame();
+    }
+}
+
+static void _rx_flush_started(uint64_t now_ns) {
+    rx_frame_t* f = _rx_head_frame();
+    while (f != NULL && _rx_started(f, now_ns)) {
+        _rx_drop_head();
+        f = _rx_head_frame();
+    }
+}
+
+// queues a frame for the receiver, with room for it to grow to `capacity` bytes
+static rx_frame_t* _rx_push(const line_frame_t* frame, size_t capacity) {
+    if (_in_reset
+            || (_strict && (_cr1 & CR1_RX_RESET))
+            || _rx_count >= RX_BACKLOG_MAX
+            || frame->end_ns + RX_BACKLOG_MAX_AGE_NS < line_now_ns()) {
+        _stats.frames_missed++;
+        return NULL;
+    }
+
+    rx_frame_t* f = malloc(sizeof(rx_frame_t) + capacity);
+    if (f == NULL) {
+        _stats.frames_missed++;
+        return NULL;
+    }
+    f->id = frame->id;
+    f->start_ns = frame->start_ns;
+    f->ended = false;
+    f->corrupt = frame->corrupt;
+    f->len = frame->len;
+    f->read_pos = 0;
+    memcpy(f->data, frame->data, frame->len);
+
+    _rx_frames[(_rx_head + _rx_count) % RX_BACKLOG_MAX] = f;
+    _rx_count++;
+    return f;
+}
+
+static void _on_frame_start(void* ctx, const line_frame_t* frame) {
+    // in loop mode the receiver hears only the transmitter
+    if (_cr3 & CR3_LOOP_MODE) {
+        _stats.frames_missed++;
+        return;
+    }
+    _rx_push(frame, frame->len);
+}
+
+static void _on_frame_end(void* ctx, const line_frame_t* frame) {
+    for (uint i = 0; i < _rx_count; i++) {
+        rx_frame_t* f = _rx_frames[(_rx_head + i) % RX_BACKLOG_MAX];
+        if (f->id == frame->id) {
+            f->ended = true;
+            f->corrupt = frame->corrupt;
+            break;
+        }
+    }
+}
+
+static rx_frame_t* _rx_find(uint32_t id) {
+    for (uint i = 0; i < _rx_count; i++) {
+        rx_frame_t* f = _rx_frames[(_rx_head + i) % RX_BACKLOG_MAX];
+        if (f->id == id) {
+            return f;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Loop mode: each byte written to the transmitter is queued for our own receiver as it's
+ * written, rather than the frame going onto the line once complete, so that the firmware can
+ * (and with strict timing, must) read the frame back whilst still sending it.
+ */
+static void _loop_start(uint64_t now_ns) {
+    line_frame_t frame = {
+        .id = LOOP_FRAME_ID_BASE | (_loop_frames++ & ~LOOP_FRAME_ID_BASE),
+        .sender = _endpoint,
+        .start_ns = now_ns,
+        .end_ns = now_ns,
+        .corrupt = false,
+        .len = 0,
+        .data = NULL
+    };
+    _loop_frame_id = _rx_push(&frame, sizeof(_tx_buffer)) ? frame.id : 0;
+}
+
+static void _loop_append(uint8_t value) {
+    rx_frame_t* f = _loop_frame_id ? _rx_find(_loop_frame_id) : NULL;
+    if (f != NULL && f->len < sizeof(_tx_buffer)) {
+        f->data[f->len++] = value;
+    }
+}
+
+static void _on_loop_end(void* ctx, uint64_t now_ns) {
+    line_frame_t frame = { .id = (uint32_t) (uintptr_t) ctx, .corrupt = false };
+    _on_frame_end(NULL, &frame);
+}
+
+// the closing flag (or an abort, if corrupt) reaches the receiver at end_ns
+static void _loop_end(uint64_t end_ns, bool corrupt) {
+    if (_loop_frame_id == 0) {
+        return;
+    }
+
+    rx_frame_t* f = _rx_find(_loop_frame_id);
+    if (f != NULL && corrupt) {
+        f->ended = true;
+        f->corrupt = true;
+    } else if (f != NULL && !line_schedule(end_ns, _on_loop_end, (void*) (uintptr_t) f->id)) {
+        f->ended = true;
+    }
+    _loop_frame_id = 0;
+}
+
+static uint8_t _status_2(uint64_t now_ns) {
+    if (_in_reset || (_cr1 & CR1_RX_RESET)) {
+        return 0;
+    }
+
+    _rx_check_overrun(now_ns);
+
+    uint8_t sr2 = _rx_overrun ? STATUS_2_RX_OVERRUN : 0;
+    rx_frame_t* f = _rx_head_frame();
+    if (f != NULL && f->read_pos < _rx_readable(f, now_ns)) {
+        if (f->read_pos == 0) {
+            sr2 |= STATUS_2_ADDR_PRESENT;
+        } else if (f->read_pos == f->len - 1) {
+            sr2 |= f->corrupt ? STATUS_2_FCS_ERROR : STATUS_2_FRAME_VALID;
+        } else {
+            sr2 |= STATUS_2_RDA;
+        }
+    }
+
+    if (line_idle_at() <= now_ns) {
+        sr2 |= STATUS_2_INACTIVE_IDLE_RX;
+    }
+
+    return sr2;
+}
+
+static uint8_t _status_1(uint64_t now_ns) {
+    uint8_t sr2 = _status_2(now_ns);
+    uint8_t sr1 = 0;
+
+    // prioritised status: a status 2 condition masks RDA
+    if (sr2 & (STATUS_2_ADDR_PRESENT | STATUS_2_FRAME_VALID | STATUS_2_ABORT_RX | STATUS_2_FCS_ERROR | STATUS_2_RX_OVERRUN)) {
+        sr1 |= STATUS_1_S2_RD_REQ;
+    } else if (sr2 & STATUS_2_RDA) {
+        sr1 |= STATUS_1_RDA;
+    }
+
+    if (!_in_reset && !(_cr1 & CR1_TX_RESET)) {
+        switch (_tx_state) {
+            case TX_IDLE:
+                sr1 |= STATUS_1_FRAME_COMPLETE;
+                break;
+            case TX_LOADING: {
+                size_t sent = 0;
+                if (now_ns > _tx_start_ns + line_byte_ns()) {
+                    sent = (now_ns - _tx_start_ns) / line_byte_ns() - 1;
+                }
+                if (!_strict || _tx_len < sent + FIFO_DEPTH) {
+                    sr1 |= STATUS_1_FRAME_COMPLETE;
+                }
+                break;
+            }
+            case TX_SENDING:
+                if (now_ns >= _tx_end_ns) {
+                    sr1 |= STATUS_1_FRAME_COMPLETE;
+                }
+                break;
+        }
+        if (_tx_underrun) {
+            sr1 |= STATUS_1_TX_UNDERRUN;
+        }
+    }
+
+    if (_cr3 & CR3_LOOP_MODE) {
+        sr1 |= STATUS_1_LOOP;
+    }
+
+    if (((_cr1 & CR1_RIE) && (sr1 & (STATUS_1_S2_RD_REQ | STATUS_1_RDA)))
+            || ((_cr1 & CR1_TIE) && (sr1 & (STATUS_1_FRAME_COMPLETE | STATUS_1_TX_UNDERRUN)))) {
+        sr1 |= STATUS_1_IRQ;
+    }
+
+    return sr1;
+}
+
+static uint8_t _read_fifo(uint64_t now_ns) {
+    if (_in_reset || (_cr1 & CR1_RX_RESET)) {
+        _stats.empty_fifo_reads++;
+        return 0;
+    }
+
+    _rx_check_overrun(now_ns);
+
+    rx_frame_t* f = _rx_head_frame();
+    if (f == NULL || f->read_pos >= _rx_readable(f, now_ns)) {
+        _stats.empty_fifo_reads++;
+        return 0;
+    }
+
+    uint8_t value = f->data[f->read_pos++];
+    if (f->read_pos == f->len) {
+        _stats.frames_received++;
+        _rx_pop();
+    }
+    return value;
+}
+
+// whether the transmitter has run out of bytes since the frame started
+static bool _tx_fifo_emptied(uint64_t now_ns) {
+    uint64_t byte_ns = line_byte_ns();
+    return now_ns > _tx_start_ns + byte_ns && (now_ns - _tx_start_ns) / byte_ns - 1 > _tx_len;
+}
+
+static void _tx_abort_underrun(void) {
+    _loop_end(0, true);
+    _tx_underrun = true;
+    _stats.tx_underruns++;
+    _tx_state = TX_IDLE;
+}
+
+static void _tx_send(uint64_t now_ns) {
+    // the frame occupies the line for its full length, ending no sooner than the bytes still
+    // in the FIFO, FCS and closing flag could be sent
+    uint64_t duration_ns = line_frame_duration_ns(_tx_len);
+    uint64_t end_ns = _tx_start_ns + duration_ns;
+    if (end_ns < now_ns + FIFO_DEPTH * line_byte_ns()) {
+        end_ns = now_ns + FIFO_DEPTH * line_byte_ns();
+    }
+
+    if (_loop_frame_id != 0) {
+        _loop_end(end_ns, false);
+    } else {
+        line_transmit(_endpoint, _tx_buffer, _tx_len, end_ns - duration_ns);
+    }
+    _stats.frames_sent++;
+    _tx_end_ns = end_ns;
+    _tx_state = TX_SENDING;
+}
+
+static void _write_fifo(uint8_t value, bool last, uint64_t now_ns) {
+    if (_in_reset || (_cr1 & CR1_TX_RESET)) {
+        return;
+    }
+
+    if (_tx_state != TX_LOADING) {
+        _tx_state = TX_LOADING;
+        _tx_len = 0;
+        _tx_start_ns = now_ns;
+        if (_cr3 & CR3_LOOP_MODE) {
+            _loop_start(now_ns);
+        }
+    }
+
+    if (_strict && _tx_fifo_emptied(now_ns)) {
+        _tx_abort_underrun();
+        return;
+    }
+
+    if (_tx_len < sizeof(_tx_buffer)) {
+        _tx_buffer[_tx_len++] = value;
+        _loop_append(value);
+    }
+
+    if (last) {
+        _tx_send(now_ns);
+    }
+}
+
+static void _write_cr1(uint8_t value, uint64_t now_ns) {
+    _cr1 = value;
+
+    if (value & CR1_TX_RESET) {
+        if (_tx_state == TX_LOADING) {
+            _loop_end(0, true);
+            _tx_state = TX_IDLE;
+        }
+        _tx_underrun = false;
+    }
+
+    if (value & (CR1_RX_RESET | CR1_RX_FRAME_DISCONTINUE)) {
+        rx_frame_t* f = _rx_head_frame();
+        if (_strict) {
+            _rx_flush_started(now_ns);
+        } else if (f != NULL && f->read_pos > 0) {
+            _rx_drop_head();
+        }
+    }
+
+    if (value & CR1_RX_RESET) {
+        _rx_overrun = false;
+    }
+}
+
+static void _write_cr2(uint8_t value, uint64_t now_ns) {
+    _cr2 = value;
+
+    if (value & CR2_CLEAR_RX_STATUS) {
+        _rx_overrun = false;
+    }
+
+    if (value & CR2_CLEAR_TX_STATUS) {
+        _tx_underrun = false;
+        if (_tx_state == TX_SENDING && now_ns >= _tx_end_ns) {
+            _tx_state = TX_IDLE;
+        }
+    }
+
+    if ((value & CR2_TX_LAST_DATA) && _tx_state == TX_LOADING) {
+        if (_strict && _tx_fifo_emptied(now_ns)) {
+            _tx_abort_underrun();
+        } else {
+            _tx_send(now_ns);
+        }
+    }
+}
+
+void adlc_model_init(bool strict_timing) {
+    static const line_endpoint_t endpoint = {
+        .ctx = NULL,
+        .frame_start = _on_frame_start,
+        .frame_end = _on_frame_end
+    };
+
+    _strict = strict_timing;
+    _endpoint = line_attach(&endpoint);
+    adlc_model_set_reset(true);
+}
+
+void adlc_model_set_reset(bool asserted) {
+    _in_reset = asserted;
+    if (!asserted) {
+        return;
+    }
+
+    // as the datasheet: reset clears CR2-CR4 and sets the CR1 TX and RX reset bits
+    _cr1 = CR1_TX_RESET | CR1_RX_RESET;
+    _cr2 = 0;
+    _cr3 = 0;
+    _cr4 = 0;
+    while (_rx_count > 0) {
+        _rx_drop_head();
+    }
+    _rx_overrun = false;
+    _tx_state = TX_IDLE;
+    _tx_underrun = false;
+}
+
+uint8_t adlc_model_read(uint reg) {
+    uint64_t now_ns = host_time_ns();
+    line_advance(now_ns);
+    _stats.bus_reads++;
+
+    switch (reg & 0x03) {
+        case 0:
+            return _status_1(now_ns);
+        case 1:
+            return _status_2(now_ns);
+        default:
+            return _read_fifo(now_ns);
+    }
+}
+
+void adlc_model_write(uint reg, uint8_t value) {
+    uint64_t now_ns = host_time_ns();
+    line_advance(now_ns);
+    _stats.bus_writes++;
+
+    if (_in_reset) {
+        return;
+    }
+
+    bool address_control = _cr1 & CR1_ADDR_CONTROL;
+    switch (reg & 0x03) {
+        case 0:
+            _write_cr1(value, now_ns);
+            break;
+        case 1:
+            if (address_control) {
+                _cr3 = value;
+            } else {
+                _write_cr2(value, now_ns);
+            }
+            break;
+        case 2:
+            _write_fifo(value, false, now_ns);
+            break;
+        case 3:
+            if (address_control) {
+                _cr4 = value;
+            } else {
+                _write_fifo(value, true, now_ns);
+            }
+            break;
+    }
+}
+
+const adlc_model_stats_t* adlc_model_stats(void) {
+    return &_stats;
+}
@@ -0,0 +1,41 @@
+#ifndef _PICONET_HOST_ADLC_MODEL_H_
+#define _PICONET_HOST_ADLC_MODEL_H_
+
+#include "pico.h"
+
+/*
+ * Register-level model of the MC6854 ADLC attached to the simulated Econet line.
+ *
+ * Received bytes become readable at the rate they arrive on the line; the last byte of a
+ * frame is held back until its closing flag, when it is reported with FV (or FCS error if
+ * the frame collided). Transmitted frames go onto the line when TX_LAST_DATA is written
+ * and report frame complete once the line has had time to send them. In loop mode (CR3) they
+ * are received by the ADLC itself instead, over the same time, and frames on the line are
+ * ignored.
+ *
+ * With strict timing, the 3-byte FIFOs are modelled: a receiver that falls more than three
+ * bytes behind the line overruns, a transmitter that falls behind underruns, and frames that
+ * start whilst the receiver is held in reset are lost. Without it, the firmware can never be
+ * too slow: frames queue (up to a backlog limit) until read, which suits measuring the
+ * throughput of the software path rather than line timing.
+ */
+
+typedef struct {
+    uint64_t    bus_reads;
+    uint64_t    bus_writes;
+    uint64_t    frames_received;    // read by the CPU through to FV
+    uint64_t    frames_discarded;   // abandoned by the CPU (e.g. address mismatch)
+    uint64_t    frames_missed;      // lost to overrun, rx reset or a full backlog
+    uint64_t    frames_sent;
+    uint64_t    rx_overruns;
+    uint64_t    tx_underruns;
+    uint64_t    empty_fifo_reads;
+} adlc_model_stats_t;
+
+void                        adlc_model_init(bool strict_timing);
+void                        adlc_model_set_reset(bool asserted);
+uint8_t                     adlc_model_read(uint reg);
+void                        adlc_model_write(uint reg, uint8_t value);
+const adlc_model_stats_t*   adlc_model_stats(void);
+
+#endif
@@ -0,0 +1,164 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_CYCLE_COUNTER
+#endif
+
+#include "base64.h"
+#include "lib/b64/cencode.h"
+#include "lib/b64/cdecode.h"
+
+// payload sizes of interest: a scout, the largest TX frame and the largest RX frame
+#define SMALL_SZ            32
+#define TX_SZ               3500
+#define RX_SZ               16536
+#define MIN_BYTES           (64 * 1024 * 1024)
+
+static uint8_t  _input[RX_SZ];
+static char     _encoded[BASE64_ENCODED_LEN(RX_SZ) + 1];
+static uint8_t  _decoded[RX_SZ];
+
+typedef size_t (*codec_fn)(size_t len);
+
+typedef struct {
+    double      ns_per_byte;
+    double      cycles_per_byte;
+} result_t;
+
+static uint64_t _now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t _cycles(void) {
+#ifdef HAVE_CYCLE_COUNTER
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static size_t _libb64_encode(size_t len) {
+    base64_encodestate state;
+    base64_init_encodestate(&state);
+    char* c = _encoded;
+    c += base64_encode_block(_input, len, c, &state);
+    c += base64_encode_blockend(c, &state);
+    *c = 0;
+    return c - _encoded;
+}
+
+static size_t _libb64_decode(size_t len) {
+    base64_decodestate state;
+    base64_init_decodestate(&state);
+    return base64_decode_block(_encoded, BASE64_ENCODED_LEN(len), _decoded, &state);
+}
+
+static size_t _table_encode(size_t len) {
+    if (!base64_encode(_input, len, _encoded, sizeof(_encoded))) {
+        return 0;
+    }
+    return BASE64_ENCODED_LEN(len);
+}
+
+static size_t _table_decode(size_t len) {
+    base64_decoder_t decoder;
+    size_t decoded_len = 0;
+    base64_decoder_init(&decoder);
+    if (!base64_decode_update(
+                &decoder,
+                (const uint8_t*) _encoded,
+                BASE64_ENCODED_LEN(len),
+                _decoded,
+                sizeof(_decoded),
+                &decoded_len)
+            || !base64_decode_final(&decoder, _decoded, sizeof(_decoded), &decoded_len)) {
+        return 0;
+    }
+    return decoded_len;
+}
+
+// Times enough repetitions to process MIN_BYTES of payload, per byte of payload (i.e. of the
+// binary side, whichever direction)
+static result_t _measure(codec_fn fn, size_t len) {
+    size_t iterations = MIN_BYTES / len;
+    volatile size_t sink = 0;
+
+    uint64_t start_ns = _now_ns();
+    uint64_t start_cycles = _cycles();
+    for (size_t i = 0; i < iterations; i++) {
+        sink += fn(len);
+    }
+    uint64_t cycles = _cycles() - start_cycles;
+    uint64_t ns = _now_ns() - start_ns;
+    (void) sink;
+
+    double bytes = (double) iterations * len;
+    return (result_t) { ns / bytes, cycles / bytes };
+}
+
+static void _check(size_t len) {
+    if (_libb64_encode(len) != BASE64_ENCODED_LEN(len)) {
+        fprintf(stderr, "libb64 encoded length mismatch for %zu bytes\n", len);
+        exit(1);
+    }
+    char expected[sizeof(_encoded)];
+    strcpy(expected, _encoded);
+
+    memset(_encoded, 0, sizeof(_encoded));
+    if (_table_encode(len) != BASE64_ENCODED_LEN(len) || strcmp(expected, _encoded) != 0) {
+        fprintf(stderr, "encoding differs from libb64 for %zu bytes\n", len);
+        exit(1);
+    }
+
+    memset(_decoded, 0, sizeof(_decoded));
+    if (_table_decode(len) != len || memcmp(_decoded, _input, len) != 0) {
+        fprintf(stderr, "decoding failed to round trip %zu bytes\n", len);
+        exit(1);
+    }
+}
+
+static void _report(const char* op, size_t len, codec_fn before, codec_fn after) {
+    result_t b = _measure(before, len);
+    result_t a = _measure(after, len);
+    printf("%-7s %6zu %10.2f %10.2f %10.2f %10.2f %8.2fx\n",
+        op, len, b.ns_per_byte, b.cycles_per_byte, a.ns_per_byte, a.cycles_per_byte,
+        b.ns_per_byte / a.ns_per_byte);
+}
+
+/*
+ * Compares the firmware's base64 codec with the libb64 one it replaced, checking that the two
+ * agree and reporting the cost of each per payload byte. Cycles are those of the host's time
+ * stamp counter (zero where there isn't one), so only the ratio carries over to the RP2040.
+ */
+int main(void) {
+    srand(1);
+    for (size_t i = 0; i < sizeof(_input); i++) {
+        _input[i] = rand();
+    }
+
+    for (size_t len = 0; len <= 64; len++) {
+        _check(len);
+    }
+    _check(TX_SZ);
+    _check(RX_SZ);
+
+    printf("                    libb64                  table\n");
+    printf("op        bytes    ns/byte  cyc/byte    ns/byte  cyc/byte  speedup\n");
+    const size_t sizes[] = { SMALL_SZ, TX_SZ, RX_SZ };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        _report("encode", sizes[i], _libb64_encode, _table_encode);
+    }
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        _libb64_encode(sizes[i]);
+        _report("decode", sizes[i], _libb64_decode, _table_decode);
+    }
+    return 0;
+}
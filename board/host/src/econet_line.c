@@ -0,0 +1,290 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "econet_line.h"
+
+typedef struct {
+    bool            in_use;
+    bool            started;
+    bool            ended;
+    line_frame_t    frame;
+} line_slot_t;
+
+typedef struct {
+    bool            in_use;
+    uint64_t        at_ns;
+    line_timer_fn_t fn;
+    void*           ctx;
+} line_timer_t;
+
+static uint64_t         _byte_ns;
+static line_endpoint_t  _endpoints[LINE_MAX_ENDPOINTS];
+static int              _endpoint_count;
+static line_slot_t      _slots[LINE_MAX_FRAMES];
+static line_timer_t     _timers[LINE_MAX_TIMERS];
+static uint32_t         _next_frame_id;
+static uint64_t         _next_due_ns = UINT64_MAX;
+static uint64_t         _idle_at_ns;
+static uint64_t         _last_end_ns;
+static uint64_t         _now_ns;
+static uint32_t         _error_ppm;
+static uint32_t         _random = 1;
+static line_stats_t     _stats;
+
+// xorshift32, so that runs are repeatable
+static uint32_t _next_random(void) {
+    _random ^= _random << 13;
+    _random ^= _random >> 17;
+    _random ^= _random << 5;
+    return _random;
+}
+
+static void _update_next_due(void) {
+    _next_due_ns = UINT64_MAX;
+    for (int i = 0; i < LINE_MAX_FRAMES; i++) {
+        line_slot_t* slot = &_slots[i];
+        if (!slot->in_use) {
+            continue;
+        }
+        if (!slot->started && slot->frame.start_ns < _next_due_ns) {
+            _next_due_ns = slot->frame.start_ns;
+        }
+        if (!slot->ended && slot->frame.end_ns < _next_due_ns) {
+            _next_due_ns = slot->frame.end_ns;
+        }
+    }
+    for (int i = 0; i < LINE_MAX_TIMERS; i++) {
+        if (_timers[i].in_use && _timers[i].at_ns < _next_due_ns) {
+            _next_due_ns = _timers[i].at_ns;
+        }
+    }
+}
+
+void line_init(uint32_t bitrate) {
+    _byte_ns = 8000000000ull / bitrate;
+    memset(_slots, 0, sizeof(_slots));
+    memset(_timers, 0, sizeof(_timers));
+    memset(&_stats, 0, sizeof(_stats));
+    _endpoint_count = 0;
+    _next_frame_id = 1;
+    _next_due_ns = UINT64_MAX;
+    _idle_at_ns = 0;
+    _last_end_ns = 0;
+    _error_ppm = 0;
+    _random = 1;
+}
+
+// corrupts the given proportion of frames (in parts per million), as noise on the line would
+void line_set_error_rate(uint32_t ppm) {
+    _error_ppm = ppm;
+}
+
+int line_attach(const line_endpoint_t* endpoint) {
+    if (_endpoint_count >= LINE_MAX_ENDPOINTS) {
+        return -1;
+    }
+    _endpoints[_endpoint_count] = *endpoint;
+    return _endpoint_count++;
+}
+
+uint64_t line_byte_ns(void) {
+    return _byte_ns;
+}
+
+uint64_t line_frame_duration_ns(size_t len) {
+    return (len + LINE_FRAME_OVERHEAD_BYTES) * _byte_ns;
+}
+
+const line_frame_t* line_transmit(int sender, const uint8_t* data, size_t len, uint64_t start_ns) {
+    line_slot_t* free_slot = NULL;
+    for (int i = 0; i < LINE_MAX_FRAMES; i++) {
+        if (!_slots[i].in_use) {
+            free_slot = &_slots[i];
+            break;
+        }
+    }
+
+    if (free_slot == NULL || len == 0 || len > LINE_MAX_FRAME_SZ) {
+        _stats.dropped++;
+        return NULL;
+    }
+
+    uint8_t* copy = malloc(len);
+    if (copy == NULL) {
+        _stats.dropped++;
+        return NULL;
+    }
+    memcpy(copy, data, len);
+
+    line_frame_t* frame = &free_slot->frame;
+    frame->id = _next_frame_id++;
+    frame->sender = sender;
+    frame->start_ns = start_ns;
+    frame->end_ns = start_ns + line_frame_duration_ns(len);
+    frame->corrupt = false;
+    frame->len = len;
+    frame->data = copy;
+
+    // any frame overlapping this one on the wire is garbled, as is this one
+    for (int i = 0; i < LINE_MAX_FRAMES; i++) {
+        line_slot_t* other = &_slots[i];
+        if (!other->in_use || other->ended) {
+            continue;
+        }
+        if (other->frame.start_ns < frame->end_ns && frame->start_ns < other->frame.end_ns) {
+            other->frame.corrupt = true;
+            frame->corrupt = true;
+        }
+    }
+    if (frame->corrupt) {
+        _stats.collisions++;
+    } else if (_error_ppm > 0 && _next_random() % 1000000 < _error_ppm) {
+        frame->corrupt = true;
+        _stats.errors++;
+    }
+
+    free_slot->in_use = true;
+    free_slot->started = false;
+    free_slot->ended = false;
+
+    _stats.frames++;
+    _stats.bytes += len;
+    _stats.busy_ns += frame->end_ns - frame->start_ns;
+    if (frame->end_ns > _idle_at_ns) {
+        _idle_at_ns = frame->end_ns;
+    }
+
+    if (start_ns < _next_due_ns) {
+        _next_due_ns = start_ns;
+    }
+
+    return frame;
+}
+
+bool line_schedule(uint64_t at_ns, line_timer_fn_t fn, void* ctx) {
+    for (int i = 0; i < LINE_MAX_TIMERS; i++) {
+        line_timer_t* timer = &_timers[i];
+        if (!timer->in_use) {
+            timer->in_use = true;
+            timer->at_ns = at_ns;
+            timer->fn = fn;
+            timer->ctx = ctx;
+            if (at_ns < _next_due_ns) {
+                _next_due_ns = at_ns;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+// removes any pending timers for fn with the given context
+void line_cancel(line_timer_fn_t fn, void* ctx) {
+    for (int i = 0; i < LINE_MAX_TIMERS; i++) {
+        line_timer_t* timer = &_timers[i];
+        if (timer->in_use && timer->fn == fn && timer->ctx == ctx) {
+            timer->in_use = false;
+        }
+    }
+    _update_next_due();
+}
+
+void line_advance(uint64_t now_ns) {
+    _now_ns = now_ns;
+    while (_next_due_ns <= now_ns) {
+        // find the earliest due event; frame ends sort before starts and timers at the same time
+        uint64_t        due_ns = UINT64_MAX;
+        line_slot_t*    due_slot = NULL;
+        bool            due_is_end = false;
+        line_timer_t*   due_timer = NULL;
+
+        for (int i = 0; i < LINE_MAX_FRAMES; i++) {
+            line_slot_t* slot = &_slots[i];
+            if (!slot->in_use) {
+                continue;
+            }
+            if (!slot->ended && slot->started && slot->frame.end_ns <= due_ns) {
+                if (slot->frame.end_ns < due_ns || !due_is_end) {
+                    due_ns = slot->frame.end_ns;
+                    due_slot = slot;
+                    due_is_end = true;
+                    due_timer = NULL;
+                }
+            }
+            if (!slot->started && slot->frame.start_ns < due_ns) {
+                due_ns = slot->frame.start_ns;
+                due_slot = slot;
+                due_is_end = false;
+                due_timer = NULL;
+            }
+        }
+        for (int i = 0; i < LINE_MAX_TIMERS; i++) {
+            line_timer_t* timer = &_timers[i];
+            if (timer->in_use && timer->at_ns < due_ns) {
+                due_ns = timer->at_ns;
+                due_timer = timer;
+                due_slot = NULL;
+            }
+        }
+
+        if (due_ns > now_ns) {
+            break;
+        }
+
+        if (due_timer != NULL) {
+            due_timer->in_use = false;
+            due_timer->fn(due_timer->ctx, due_ns);
+        } else if (due_slot != NULL && !due_is_end) {
+            due_slot->started = true;
+            for (int i = 0; i < _endpoint_count; i++) {
+                if (i != due_slot->frame.sender && _endpoints[i].frame_start != NULL) {
+                    _endpoints[i].frame_start(_endpoints[i].ctx, &due_slot->frame);
+                }
+            }
+        } else if (due_slot != NULL) {
+            due_slot->ended = true;
+            if (due_slot->frame.end_ns > _last_end_ns) {
+                _last_end_ns = due_slot->frame.end_ns;
+            }
+            for (int i = 0; i < _endpoint_count; i++) {
+                if (i != due_slot->frame.sender && _endpoints[i].frame_end != NULL) {
+                    _endpoints[i].frame_end(_endpoints[i].ctx, &due_slot->frame);
+                } else if (i == due_slot->frame.sender && _endpoints[i].frame_sent != NULL) {
+                    _endpoints[i].frame_sent(_endpoints[i].ctx, &due_slot->frame);
+                }
+            }
+            free(due_slot->frame.data);
+            due_slot->frame.data = NULL;
+            due_slot->in_use = false;
+        }
+
+        _update_next_due();
+    }
+}
+
+uint64_t line_now_ns(void) {
+    return _now_ns;
+}
+
+uint64_t line_idle_at(void) {
+    return _idle_at_ns;
+}
+
+// When a station listening at now_ns will next see the line idle, given the frames it has
+// noticed so far (those whose opening flag has begun, a bit time ago); now_ns or earlier if it's
+// idle already
+uint64_t line_sensed_idle_at(uint64_t now_ns) {
+    uint64_t last_end_ns = _last_end_ns;
+    for (int i = 0; i < LINE_MAX_FRAMES; i++) {
+        const line_slot_t* slot = &_slots[i];
+        if (slot->in_use && slot->frame.start_ns + _byte_ns / 8 <= now_ns && slot->frame.end_ns > last_end_ns) {
+            last_end_ns = slot->frame.end_ns;
+        }
+    }
+    return last_end_ns == 0 ? 0 : last_end_ns + LINE_IDLE_BITS * _byte_ns / 8;
+}
+
+const line_stats_t* line_stats(void) {
+    return &_stats;
+}
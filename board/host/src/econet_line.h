@@ -0,0 +1,73 @@
+#ifndef _PICONET_HOST_ECONET_LINE_H_
+#define _PICONET_HOST_ECONET_LINE_H_
+
+#include "pico.h"
+
+/*
+ * Simulated Econet line shared by the emulated ADLC and any virtual stations.
+ *
+ * Frames are placed on the line with a start time and occupy it for their length in bits
+ * (plus flags and FCS) at the configured bit rate. Each attached endpoint, other than the
+ * sender, is told when a frame starts and when it ends. Overlapping frames collide and are
+ * marked corrupt. Nothing happens in the background: time only advances when line_advance()
+ * is called, which the ADLC model does on every bus access.
+ *
+ * Stations contending for the line see it through line_sensed_idle_at(), which knows only of
+ * frames already a bit time in, so two stations that start within a bit time of each other
+ * collide as they would on a real Econet.
+ */
+
+#define LINE_MAX_ENDPOINTS          8
+#define LINE_MAX_FRAMES             64
+#define LINE_MAX_TIMERS             256
+#define LINE_MAX_FRAME_SZ           20000
+
+// opening flag, two FCS bytes and closing flag
+#define LINE_FRAME_OVERHEAD_BYTES   4
+
+// consecutive 1s after which a receiver reports the line idle
+#define LINE_IDLE_BITS              15
+
+typedef struct {
+    uint32_t    id;
+    int         sender;
+    uint64_t    start_ns;
+    uint64_t    end_ns;
+    bool        corrupt;
+    size_t      len;
+    uint8_t*    data;
+} line_frame_t;
+
+typedef struct {
+    void*       ctx;
+    void        (*frame_start)(void* ctx, const line_frame_t* frame);
+    void        (*frame_end)(void* ctx, const line_frame_t* frame);
+    void        (*frame_sent)(void* ctx, const line_frame_t* frame);   // own frame ended
+} line_endpoint_t;
+
+typedef void (*line_timer_fn_t)(void* ctx, uint64_t now_ns);
+
+typedef struct {
+    uint64_t    frames;
+    uint64_t    bytes;
+    uint64_t    collisions;
+    uint64_t    errors;             // frames corrupted by --frame-errors
+    uint64_t    dropped;
+    uint64_t    busy_ns;
+} line_stats_t;
+
+void                line_init(uint32_t bitrate);
+void                line_set_error_rate(uint32_t ppm);
+int                 line_attach(const line_endpoint_t* endpoint);
+uint64_t            line_byte_ns(void);
+uint64_t            line_frame_duration_ns(size_t len);
+const line_frame_t* line_transmit(int sender, const uint8_t* data, size_t len, uint64_t start_ns);
+bool                line_schedule(uint64_t at_ns, line_timer_fn_t fn, void* ctx);
+void                line_cancel(line_timer_fn_t fn, void* ctx);
+void                line_advance(uint64_t now_ns);
+uint64_t            line_now_ns(void);
+uint64_t            line_idle_at(void);
+uint64_t            line_sensed_idle_at(uint64_t now_ns);
+const line_stats_t* line_stats(void);
+
+#endif
@@ -0,0 +1,236 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "econet_line.h"
+#include "econet_peers.h"
+
+#define DATA_TIMEOUT_NS         100000000ull
+#define ACK_TIMEOUT_NS          200000000ull
+
+typedef struct {
+    bool        awaiting_data;
+    uint8_t     from_station;
+    uint8_t     from_net;
+    uint64_t    deadline_ns;
+} responder_t;
+
+typedef enum {
+    SENDER_IDLE = 0L,
+    SENDER_AWAIT_SCOUT_ACK,
+    SENDER_AWAIT_DATA_ACK
+} sender_state_t;
+
+static peers_config_t   _config;
+static peers_stats_t    _stats;
+static int              _endpoint;
+static responder_t      _responders[256];
+
+static uint64_t         _traffic_interval_ns;
+static uint32_t         _traffic_seq;
+
+static sender_state_t   _sender_state;
+static uintptr_t        _sender_seq;
+static uint64_t         _sender_attempt_ns;
+static uint64_t         _sender_interval_ns;
+
+static uint8_t          _frame[LINE_MAX_FRAME_SZ];
+
+static void _sender_tick(void* ctx, uint64_t now_ns);
+
+static uint64_t _max(uint64_t a, uint64_t b) {
+    return a > b ? a : b;
+}
+
+static size_t _build_header(uint8_t dest, uint8_t dest_net, uint8_t src, uint8_t src_net) {
+    _frame[0] = dest;
+    _frame[1] = dest_net;
+    _frame[2] = src;
+    _frame[3] = src_net;
+    return 4;
+}
+
+static size_t _build_payload(size_t offset, size_t size, uint32_t seq) {
+    for (size_t i = 0; i < size && offset + i < sizeof(_frame); i++) {
+        _frame[offset + i] = (uint8_t) (seq + i);
+    }
+    return offset + size < sizeof(_frame) ? offset + size : sizeof(_frame);
+}
+
+static const line_frame_t* _send(size_t len, uint64_t start_ns) {
+    return line_transmit(_endpoint, _frame, len, start_ns);
+}
+
+static void _send_ack(const line_frame_t* incoming, const uint8_t* extra, size_t extra_len) {
+    size_t len = _build_header(incoming->data[2], incoming->data[3], incoming->data[0], incoming->data[1]);
+    memcpy(_frame + len, extra, extra_len);
+    _send(len + extra_len, incoming->end_ns + _config.turnaround_ns);
+}
+
+static void _respond(const line_frame_t* frame) {
+    uint8_t dest = frame->data[0];
+    uint8_t src = frame->data[2];
+    uint8_t src_net = frame->data[3];
+    responder_t* responder = &_responders[dest];
+
+    if (responder->awaiting_data) {
+        responder->awaiting_data = false;
+        if (responder->from_station == src && responder->from_net == src_net
+                && frame->end_ns <= responder->deadline_ns) {
+            _send_ack(frame, NULL, 0);
+            _stats.data_acked++;
+            return;
+        }
+    }
+
+    if (frame->len < 6) {
+        return;
+    }
+
+    uint8_t ctrl = frame->data[4];
+    uint8_t port = frame->data[5];
+    if (port == 0 && ctrl == 0x88) {
+        // machine type peek: BBC Micro, NFS 3.60
+        static const uint8_t machine_type[] = { 0x01, 0x00, 0x60, 0x03 };
+        _send_ack(frame, machine_type, sizeof(machine_type));
+        _stats.peeks_answered++;
+        return;
+    }
+
+    _send_ack(frame, NULL, 0);
+    _stats.scouts_acked++;
+    responder->awaiting_data = true;
+    responder->from_station = src;
+    responder->from_net = src_net;
+    responder->deadline_ns = frame->end_ns + DATA_TIMEOUT_NS;
+}
+
+static void _traffic_tick(void* ctx, uint64_t now_ns) {
+    uint64_t turnaround_ns = _config.turnaround_ns;
+    uint64_t t = _max(now_ns, line_idle_at() + turnaround_ns);
+    uint64_t start_ns = t;
+    uint32_t seq = _traffic_seq++;
+
+    // scout, scout ack, data, data ack
+    size_t len = _build_header(_config.traffic_dest, 0, _config.traffic_src, 0);
+    _frame[len++] = 0x80;
+    _frame[len++] = 0x99;
+    _send(len, t);
+    t += line_frame_duration_ns(len) + turnaround_ns;
+
+    len = _build_header(_config.traffic_src, 0, _config.traffic_dest, 0);
+    _send(len, t);
+    t += line_frame_duration_ns(len) + turnaround_ns;
+
+    len = _build_payload(_build_header(_config.traffic_dest, 0, _config.traffic_src, 0), _config.traffic_size, seq);
+    _send(len, t);
+    t += line_frame_duration_ns(len) + turnaround_ns;
+
+    len = _build_header(_config.traffic_src, 0, _config.traffic_dest, 0);
+    _send(len, t);
+    t += line_frame_duration_ns(len) + turnaround_ns;
+
+    _stats.traffic_frames += 4;
+    _stats.traffic_handshakes++;
+
+    line_schedule(_max(start_ns + _traffic_interval_ns, t), _traffic_tick, NULL);
+}
+
+static void _sender_finish(uint64_t now_ns) {
+    _sender_state = SENDER_IDLE;
+    _sender_seq++;
+    line_schedule(_max(_sender_attempt_ns + _sender_interval_ns, now_ns + _config.turnaround_ns), _sender_tick, NULL);
+}
+
+static void _sender_timeout(void* ctx, uint64_t now_ns) {
+    if ((uintptr_t) ctx != _sender_seq || _sender_state == SENDER_IDLE) {
+        return;
+    }
+
+    if (_sender_state == SENDER_AWAIT_SCOUT_ACK) {
+        _stats.sender_no_scout_ack++;
+    } else {
+        _stats.sender_no_data_ack++;
+    }
+    _sender_finish(now_ns);
+}
+
+static void _sender_tick(void* ctx, uint64_t now_ns) {
+    uint64_t t = _max(now_ns, line_idle_at() + _config.turnaround_ns);
+
+    size_t len = _build_header(_config.sender_target, 0, _config.sender_station, 0);
+    _frame[len++] = 0x80;
+    _frame[len++] = _config.sender_port;
+    _send(len, t);
+
+    _sender_state = SENDER_AWAIT_SCOUT_ACK;
+    _sender_attempt_ns = t;
+    _stats.sender_attempts++;
+    line_schedule(t + ACK_TIMEOUT_NS, _sender_timeout, (void*) _sender_seq);
+}
+
+static void _sender_ack(const line_frame_t* frame) {
+    if (frame->data[2] != _config.sender_target) {
+        return;
+    }
+
+    switch (_sender_state) {
+        case SENDER_AWAIT_SCOUT_ACK: {
+            size_t len = _build_payload(
+                _build_header(_config.sender_target, 0, _config.sender_station, 0),
+                _config.sender_size,
+                (uint32_t) (_sender_seq / _config.sender_repeats));
+            _send(len, frame->end_ns + _config.turnaround_ns);
+            _sender_state = SENDER_AWAIT_DATA_ACK;
+            break;
+        }
+        case SENDER_AWAIT_DATA_ACK:
+            _stats.sender_ok++;
+            _sender_finish(frame->end_ns);
+            break;
+        default:
+            break;
+    }
+}
+
+static void _on_frame_end(void* ctx, const line_frame_t* frame) {
+    if (frame->corrupt || frame->len < 4) {
+        return;
+    }
+
+    uint8_t dest = frame->data[0];
+    if (_config.sender_station != 0 && dest == _config.sender_station && frame->len == 4) {
+        _sender_ack(frame);
+    } else if (_config.responders[dest]) {
+        _respond(frame);
+    }
+}
+
+void peers_init(const peers_config_t* config) {
+    static const line_endpoint_t endpoint = {
+        .ctx = NULL,
+        .frame_start = NULL,
+        .frame_end = _on_frame_end
+    };
+
+    _config = *config;
+    memset(&_stats, 0, sizeof(_stats));
+    memset(_responders, 0, sizeof(_responders));
+    _endpoint = line_attach(&endpoint);
+}
+
+void peers_start(uint64_t now_ns) {
+    if (_config.traffic_rate > 0) {
+        _traffic_interval_ns = 4000000000ull / _config.traffic_rate;
+        line_schedule(now_ns, _traffic_tick, NULL);
+    }
+
+    if (_config.sender_station != 0 && _config.sender_rate > 0) {
+        _sender_interval_ns = 1000000000ull / _config.sender_rate;
+        line_schedule(now_ns, _sender_tick, NULL);
+    }
+}
+
+const peers_stats_t* peers_stats(void) {
+    return &_stats;
+}
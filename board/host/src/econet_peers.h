@@ -0,0 +1,50 @@
+#ifndef _PICONET_HOST_ECONET_PEERS_H_
+#define _PICONET_HOST_ECONET_PEERS_H_
+
+#include "pico.h"
+
+/*
+ * Virtual Econet stations attached to the simulated line:
+ *
+ * - responders acknowledge scouts and data frames addressed to them (and answer machine
+ *   type peeks) like an idle client would, so that transmissions from Piconet succeed;
+ * - a traffic generator plays four-way handshakes between two other stations at a given
+ *   frame rate, for Piconet to see in MONITOR mode;
+ * - a sender repeatedly transmits to Piconet's station, for Piconet to receive in LISTEN
+ *   mode.
+ */
+
+typedef struct {
+    bool        responders[256];
+    uint64_t    turnaround_ns;
+
+    uint32_t    traffic_rate;       // frames per second, four per handshake; 0 to disable
+    size_t      traffic_size;       // payload bytes in each data frame
+    uint8_t     traffic_src;
+    uint8_t     traffic_dest;
+
+    uint8_t     sender_station;     // 0 to disable
+    uint8_t     sender_target;
+    uint8_t     sender_port;
+    uint32_t    sender_rate;        // transmissions per second
+    size_t      sender_size;        // payload bytes in each data frame
+    uint32_t    sender_repeats;     // times each payload is sent, as if retrying after lost acks
+} peers_config_t;
+
+typedef struct {
+    uint64_t    scouts_acked;
+    uint64_t    data_acked;
+    uint64_t    peeks_answered;
+    uint64_t    traffic_frames;
+    uint64_t    traffic_handshakes;
+    uint64_t    sender_attempts;
+    uint64_t    sender_ok;
+    uint64_t    sender_no_scout_ack;
+    uint64_t    sender_no_data_ack;
+} peers_stats_t;
+
+void                    peers_init(const peers_config_t* config);
+void                    peers_start(uint64_t now_ns);
+const peers_stats_t*    peers_stats(void);
+
+#endif
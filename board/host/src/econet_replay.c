@@ -0,0 +1,315 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "base64.h"
+#include "econet_line.h"
+#include "econet_replay.h"
+#include "host.h"
+
+#define CAPTURE_LINE_MAX            (BASE64_ENCODED_LEN(LINE_MAX_FRAME_SZ) + 64)
+#define ACK_TIMEOUT_NS              20000000ull
+
+typedef enum {
+    REPLAY_ROLE_SKIP = 0L,          // not replayed
+    REPLAY_ROLE_OTHER,              // between other stations, replayed as captured
+    REPLAY_ROLE_BROADCAST,
+    REPLAY_ROLE_SCOUT,              // to the replayed station, which should acknowledge it
+    REPLAY_ROLE_DATA                // following an acknowledged scout (two frames back)
+} replay_role_t;
+
+typedef struct {
+    uint64_t        at_ns;          // from the first frame, scaled by the speed
+    replay_role_t   role;
+    bool            acked;
+    size_t          len;
+    uint8_t*        data;
+} replay_frame_t;
+
+static replay_frame_t*  _frames;
+static size_t           _frame_count;
+static uint8_t          _station;
+static int              _endpoint;
+static uint64_t         _turnaround_ns;
+static uint64_t         _start_ns;
+static uint64_t         _delay_ns;          // by which the replay has fallen behind the capture
+static size_t           _next;
+static int64_t          _awaiting;          // frame waiting for an acknowledgement, or -1
+static uint64_t         _awaiting_end_ns;
+static uint64_t         _transactions_at_start;
+static replay_stats_t   _stats;
+
+static void _on_next(void* ctx, uint64_t now_ns);
+
+static bool _is_from(const replay_frame_t* f, uint8_t station) {
+    return f->len >= 4 && f->data[2] == station && f->data[3] == 0;
+}
+
+static bool _is_to(const replay_frame_t* f, uint8_t station) {
+    return f->len >= 4 && f->data[0] == station && f->data[1] == 0;
+}
+
+// a frame from the replayed station to the source of frame i, just before it
+static bool _follows_reply(size_t i) {
+    return i >= 1
+        && _is_from(&_frames[i - 1], _station)
+        && _is_to(&_frames[i - 1], _frames[i].data[2]);
+}
+
+static replay_role_t _role_of(size_t i) {
+    const replay_frame_t* f = &_frames[i];
+    if (f->len < 4 || _is_from(f, _station)) {
+        return REPLAY_ROLE_SKIP;
+    }
+    if (f->data[0] == 0xff) {
+        return REPLAY_ROLE_BROADCAST;
+    }
+    if (!_is_to(f, _station)) {
+        return REPLAY_ROLE_OTHER;
+    }
+
+    // a data frame follows the replayed station's scout ack; any other frame following one of
+    // its frames is a reply to a handshake of its own, which Piconet won't have started
+    if (_follows_reply(i)) {
+        return i >= 2 && _frames[i - 2].role == REPLAY_ROLE_SCOUT && _frames[i - 1].len == 4
+                && _frames[i - 2].data[2] == f->data[2]
+            ? REPLAY_ROLE_DATA
+            : REPLAY_ROLE_SKIP;
+    }
+
+    // immediate operations (port 0) are left to the firmware to ignore, unacknowledged
+    return f->len >= 6 && f->data[5] != 0 ? REPLAY_ROLE_SCOUT : REPLAY_ROLE_OTHER;
+}
+
+static bool _append(const uint8_t* data, size_t len, uint64_t at_ns) {
+    replay_frame_t* frames = realloc(_frames, (_frame_count + 1) * sizeof(replay_frame_t));
+    if (frames == NULL) {
+        return false;
+    }
+    _frames = frames;
+
+    replay_frame_t* f = &_frames[_frame_count++];
+    memset(f, 0, sizeof(*f));
+    f->at_ns = at_ns;
+    f->len = len;
+    if (len > 0) {
+        f->data = malloc(len);
+        if (f->data == NULL) {
+            return false;
+        }
+        memcpy(f->data, data, len);
+    }
+    return true;
+}
+
+static bool _decode(const char* b64, uint8_t* output, size_t* len) {
+    base64_decoder_t decoder;
+    *len = 0;
+    base64_decoder_init(&decoder);
+    return base64_decode_update(&decoder, (const uint8_t*) b64, strlen(b64), output, LINE_MAX_FRAME_SZ, len)
+        && base64_decode_final(&decoder, output, LINE_MAX_FRAME_SZ, len);
+}
+
+/*
+ * Reads the MONITOR events of a capture. Frames that can't be replayed (compressed or
+ * malformed) are kept, empty, so that the handshake each frame belongs to can still be worked
+ * out from those before it.
+ */
+bool replay_load(const char* path, uint8_t station, uint32_t speed) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Failed to open capture '%s': %s\n", path, strerror(errno));
+        return false;
+    }
+
+    static char line[CAPTURE_LINE_MAX];
+    static uint8_t data[LINE_MAX_FRAME_SZ];
+    double first_s = -1;
+    bool timestamped = speed > 0;
+    bool ok = true;
+
+    _station = station;
+    while (ok && fgets(line, sizeof(line), file) != NULL) {
+        char* token = strtok(line, " \t\r\n");
+        double at_s = 0;
+        if (token != NULL && strcmp(token, "MONITOR") != 0) {
+            char* end;
+            at_s = strtod(token, &end);
+            token = *end == '\0' ? strtok(NULL, " \t\r\n") : NULL;
+        } else {
+            timestamped = false;
+        }
+        if (token == NULL || strcmp(token, "MONITOR") != 0) {
+            continue;
+        }
+
+        if (first_s < 0) {
+            first_s = at_s;
+        }
+        uint64_t at_ns = timestamped ? (uint64_t) ((at_s - first_s) * 1e9 / speed) : 0;
+
+        // with SET_SNAPLEN, the frame's length precedes its (perhaps truncated) data
+        const char* b64 = strtok(NULL, " \t\r\n");
+        const char* after = strtok(NULL, " \t\r\n");
+        size_t frame_len = 0;
+        if (after != NULL) {
+            frame_len = (size_t) strtoul(b64, NULL, 10);
+            b64 = after;
+        }
+        size_t len = 0;
+        if (b64 == NULL || *b64 == '~' || !_decode(b64, data, &len) || len < 4
+                || (after != NULL && len != frame_len)) {
+            len = 0;
+        }
+        ok = _append(data, len, at_ns);
+    }
+    fclose(file);
+
+    if (!ok) {
+        fprintf(stderr, "Out of memory reading capture '%s'\n", path);
+        return false;
+    }
+
+    // without timestamps throughout, frames go back to back
+    for (size_t i = 0; i < _frame_count; i++) {
+        if (!timestamped) {
+            _frames[i].at_ns = 0;
+        }
+        _frames[i].role = _role_of(i);
+    }
+    _stats.frames = _frame_count;
+    return true;
+}
+
+static void _complete(uint64_t now_ns) {
+    _stats.complete = true;
+    _stats.end_ns = now_ns;
+    _stats.bus_transactions = pio_host_stats()->transactions - _transactions_at_start;
+}
+
+static void _on_timeout(void* ctx, uint64_t now_ns) {
+    if (_awaiting >= 0) {
+        _awaiting = -1;
+        _on_next(NULL, now_ns);
+    }
+}
+
+// Sends the next frame to be replayed, as near its time in the capture as the line and any
+// handshake in progress allow, and arranges for the one after.
+static void _on_next(void* ctx, uint64_t now_ns) {
+    while (_next < _frame_count) {
+        replay_frame_t* f = &_frames[_next];
+        if (f->role == REPLAY_ROLE_SKIP) {
+            _stats.skipped++;
+            _next++;
+            continue;
+        }
+        if (f->role == REPLAY_ROLE_DATA && !_frames[_next - 2].acked) {
+            _stats.data_not_sent++;
+            _next++;
+            continue;
+        }
+
+        uint64_t due_ns = _start_ns + f->at_ns + _delay_ns;
+        uint64_t start_ns = line_idle_at() + _turnaround_ns;
+        if (start_ns < now_ns) {
+            start_ns = now_ns;
+        }
+        if (start_ns < due_ns) {
+            start_ns = due_ns;
+        }
+        _delay_ns += start_ns - due_ns;
+
+        if (start_ns > now_ns) {
+            line_schedule(start_ns, _on_next, NULL);
+            return;
+        }
+
+        uint64_t end_ns = start_ns + line_frame_duration_ns(f->len);
+        line_transmit(_endpoint, f->data, f->len, start_ns);
+        _stats.replayed++;
+        _next++;
+
+        switch (f->role) {
+            case REPLAY_ROLE_BROADCAST:
+                _stats.broadcasts++;
+                break;
+            case REPLAY_ROLE_SCOUT:
+                _stats.scouts++;
+                break;
+            case REPLAY_ROLE_DATA:
+                _stats.data_frames++;
+                break;
+            default:
+                break;
+        }
+
+        if (f->role == REPLAY_ROLE_SCOUT || f->role == REPLAY_ROLE_DATA) {
+            _awaiting = _next - 1;
+            _awaiting_end_ns = end_ns;
+            line_schedule(end_ns + ACK_TIMEOUT_NS, _on_timeout, NULL);
+        } else {
+            line_schedule(end_ns, _on_next, NULL);
+        }
+        return;
+    }
+
+    if (!_stats.complete) {
+        _complete(now_ns);
+    }
+}
+
+static void _on_frame_end(void* ctx, const line_frame_t* frame) {
+    if (_awaiting < 0 || frame->corrupt || frame->len != 4) {
+        return;
+    }
+
+    replay_frame_t* f = &_frames[_awaiting];
+    if (frame->data[0] != f->data[2] || frame->data[1] != f->data[3]
+            || frame->data[2] != _station || frame->data[3] != 0) {
+        return;
+    }
+
+    uint64_t turnaround_ns = frame->start_ns - _awaiting_end_ns;
+    _stats.turnaround_total_ns += turnaround_ns;
+    if (turnaround_ns > _stats.turnaround_max_ns) {
+        _stats.turnaround_max_ns = turnaround_ns;
+    }
+    if (f->role == REPLAY_ROLE_SCOUT) {
+        _stats.scouts_acked++;
+    } else {
+        _stats.data_acked++;
+    }
+    f->acked = true;
+
+    _awaiting = -1;
+    line_cancel(_on_timeout, NULL);
+    _on_next(NULL, frame->end_ns);
+}
+
+static void _on_start(void* ctx, uint64_t now_ns) {
+    _transactions_at_start = pio_host_stats()->transactions;
+    _on_next(NULL, now_ns);
+}
+
+void replay_start(uint64_t at_ns, uint64_t turnaround_ns) {
+    static const line_endpoint_t endpoint = {
+        .ctx = NULL,
+        .frame_start = NULL,
+        .frame_end = _on_frame_end,
+        .frame_sent = NULL
+    };
+
+    _endpoint = line_attach(&endpoint);
+    _turnaround_ns = turnaround_ns;
+    _start_ns = at_ns;
+    _awaiting = -1;
+    _stats.start_ns = at_ns;
+    line_schedule(at_ns, _on_start, NULL);
+}
+
+const replay_stats_t* replay_stats(void) {
+    return &_stats;
+}
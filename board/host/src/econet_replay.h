@@ -0,0 +1,46 @@
+#ifndef _PICONET_HOST_ECONET_REPLAY_H_
+#define _PICONET_HOST_ECONET_REPLAY_H_
+
+#include "pico.h"
+
+/*
+ * Replays a capture of MONITOR events onto the simulated line, as though Piconet had been one
+ * of the stations captured, to see how the firmware copes with real traffic in LISTEN mode.
+ *
+ * Each line of the capture is a MONITOR event as sent by the board, optionally preceded by a
+ * timestamp in seconds (e.g. "1686492345.123456 MONITOR DAD+AICZ"); other lines are ignored.
+ * Frames are replayed with their original spacing, divided by the speed, or back to back with a
+ * turnaround's gap if the capture has no timestamps or the speed is 0. Frames sent by the
+ * replayed station are left out, since Piconet is to send them: each scout and data frame to
+ * it waits for Piconet's acknowledgement (or a timeout) before the replay moves on, later
+ * frames being put back by however late it was, and the data frame of a handshake whose scout
+ * wasn't acknowledged isn't sent.
+ *
+ * Compressed frames (with SET_COMPRESSION LZ) and frames truncated by SET_SNAPLEN can't be
+ * replayed and are counted as skipped.
+ */
+
+typedef struct {
+    uint64_t    frames;             // MONITOR events in the capture
+    uint64_t    skipped;            // compressed, malformed, or sent by or replying to the
+                                    // replayed station
+    uint64_t    replayed;           // frames put on the line
+    uint64_t    broadcasts;
+    uint64_t    scouts;             // scouts to the replayed station
+    uint64_t    scouts_acked;
+    uint64_t    data_frames;        // data frames to the replayed station, once a scout was acked
+    uint64_t    data_acked;
+    uint64_t    data_not_sent;      // data frames left out because their scout wasn't acked
+    uint64_t    turnaround_total_ns;    // frame end to the start of Piconet's ack, over acks
+    uint64_t    turnaround_max_ns;
+    uint64_t    bus_transactions;   // made by the firmware whilst replaying
+    uint64_t    start_ns;
+    uint64_t    end_ns;
+    bool        complete;
+} replay_stats_t;
+
+bool                    replay_load(const char* path, uint8_t station, uint32_t speed);
+void                    replay_start(uint64_t at_ns, uint64_t turnaround_ns);
+const replay_stats_t*   replay_stats(void);
+
+#endif
@@ -0,0 +1,490 @@
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "econet_line.h"
+#include "econet_stations.h"
+
+#define STATION_QUEUE_MAX       64
+#define PROFILE_LINE_MAX        512
+
+#define DEFAULT_PORT            0x99
+#define DEFAULT_RATE            1
+#define DEFAULT_SIZE            64
+#define DEFAULT_RETRIES         3
+#define DEFAULT_QUEUE           8
+#define DEFAULT_BACKOFF_MS      10
+#define DEFAULT_TIMEOUT_MS      20
+
+typedef enum {
+    STATION_IDLE = 0L,
+    STATION_AWAIT_LINE,
+    STATION_AWAIT_SCOUT_ACK,
+    STATION_AWAIT_DATA_ACK,
+    STATION_AWAIT_SENT,
+    STATION_BACKOFF
+} station_state_t;
+
+typedef struct {
+    station_profile_t   profile;
+    station_stats_t     stats;
+    station_state_t     state;
+    uint32_t            attempts;       // of the payload at the head of the queue
+    uint32_t            payload_seq;
+    uint64_t            start_ns;
+    uint64_t            arrivals[STATION_QUEUE_MAX];
+    uint                queue_head;
+    uint                queue_len;
+} station_t;
+
+static station_t        _stations[STATIONS_MAX];
+static uint             _station_count;
+static int16_t          _index_of[256];         // station number to index, or -1
+static int              _endpoint;
+static uint64_t         _turnaround_ns;
+static uint32_t         _random;
+
+static uint8_t          _frame[LINE_MAX_FRAME_SZ];
+
+static void _try_send(uint index, uint64_t now_ns);
+
+// xorshift32, so that runs with the same seed are repeatable
+static uint32_t _next_random(void) {
+    _random ^= _random << 13;
+    _random ^= _random >> 17;
+    _random ^= _random << 5;
+    return _random;
+}
+
+// uniformly distributed in [0, 1)
+static double _uniform(void) {
+    return (_next_random() >> 8) / 16777216.0;
+}
+
+static size_t _build_frame(const station_t* s, bool scout) {
+    const station_profile_t* p = &s->profile;
+    bool broadcast = p->kind == STATION_KIND_BROADCAST;
+    size_t len = 0;
+
+    _frame[len++] = broadcast ? 0xff : p->target;
+    _frame[len++] = broadcast ? 0xff : 0;
+    _frame[len++] = p->station;
+    _frame[len++] = 0;
+    if (scout || broadcast) {
+        _frame[len++] = 0x80;
+        _frame[len++] = p->port;
+    }
+    if (!scout) {
+        for (size_t i = 0; i < p->size && len < sizeof(_frame); i++) {
+            _frame[len++] = (uint8_t) (s->payload_seq + i);
+        }
+    }
+    return len;
+}
+
+// sends a frame starting at start_ns, returning the time it ends
+static uint64_t _send(size_t len, uint64_t start_ns) {
+    line_transmit(_endpoint, _frame, len, start_ns);
+    return start_ns + line_frame_duration_ns(len);
+}
+
+static void _on_wake(void* ctx, uint64_t now_ns) {
+    _try_send((uintptr_t) ctx, now_ns);
+}
+
+static void _on_timeout(void* ctx, uint64_t now_ns);
+
+// each state has at most one timer pending, which is cancelled on leaving it
+static void _set_state(uint index, station_state_t state) {
+    void* ctx = (void*) (uintptr_t) index;
+    line_cancel(_on_wake, ctx);
+    line_cancel(_on_timeout, ctx);
+    _stations[index].state = state;
+}
+
+static void _schedule(uint index, uint64_t at_ns, line_timer_fn_t fn) {
+    if (!line_schedule(at_ns, fn, (void*) (uintptr_t) index)) {
+        fprintf(stderr, "Out of line timers for station %u\n", _stations[index].profile.station);
+    }
+}
+
+// moves on to the next payload, once the line has been seen idle
+static void _next_payload(uint index, uint64_t now_ns) {
+    station_t* s = &_stations[index];
+    s->queue_head = (s->queue_head + 1) % STATION_QUEUE_MAX;
+    s->queue_len--;
+    s->attempts = 0;
+    s->payload_seq++;
+
+    if (s->queue_len == 0) {
+        _set_state(index, STATION_IDLE);
+        return;
+    }
+
+    _set_state(index, STATION_AWAIT_LINE);
+    uint64_t idle_at_ns = line_sensed_idle_at(now_ns);
+    _schedule(index, idle_at_ns > now_ns ? idle_at_ns : now_ns, _on_wake);
+}
+
+static void _deliver(uint index, uint64_t now_ns) {
+    station_t* s = &_stations[index];
+    uint64_t latency_ns = now_ns - s->arrivals[s->queue_head];
+    s->stats.delivered++;
+    s->stats.bytes_delivered += s->profile.size;
+    s->stats.latency_total_ns += latency_ns;
+    if (latency_ns > s->stats.latency_max_ns) {
+        s->stats.latency_max_ns = latency_ns;
+    }
+    _next_payload(index, now_ns);
+}
+
+static void _fail(uint index, uint64_t now_ns) {
+    station_t* s = &_stations[index];
+    if (s->attempts > s->profile.retries) {
+        s->stats.abandoned++;
+        _next_payload(index, now_ns);
+        return;
+    }
+
+    _set_state(index, STATION_BACKOFF);
+    _schedule(index, now_ns + (uint64_t) (_uniform() * s->profile.backoff_ns), _on_wake);
+}
+
+static void _on_timeout(void* ctx, uint64_t now_ns) {
+    station_t* s = &_stations[(uintptr_t) ctx];
+    if (s->state == STATION_AWAIT_SCOUT_ACK) {
+        s->stats.no_scout_ack++;
+    } else if (s->state == STATION_AWAIT_DATA_ACK) {
+        s->stats.no_data_ack++;
+    } else {
+        return;
+    }
+    _fail((uintptr_t) ctx, now_ns);
+}
+
+static void _try_send(uint index, uint64_t now_ns) {
+    station_t* s = &_stations[index];
+    if (!s->profile.ignore_carrier) {
+        uint64_t idle_at_ns = line_sensed_idle_at(now_ns);
+        if (idle_at_ns > now_ns) {
+            s->stats.deferrals++;
+            _set_state(index, STATION_AWAIT_LINE);
+            _schedule(index, idle_at_ns, _on_wake);
+            return;
+        }
+    }
+
+    s->attempts++;
+    s->stats.attempts++;
+    uint64_t end_ns = _send(_build_frame(s, s->profile.kind == STATION_KIND_TRANSMIT), now_ns);
+    if (s->profile.kind == STATION_KIND_BROADCAST) {
+        _set_state(index, STATION_AWAIT_SENT);
+        return;
+    }
+
+    _set_state(index, STATION_AWAIT_SCOUT_ACK);
+    _schedule(index, end_ns + s->profile.timeout_ns, _on_timeout);
+}
+
+static void _on_arrival(void* ctx, uint64_t now_ns) {
+    uint index = (uintptr_t) ctx;
+    station_t* s = &_stations[index];
+    const station_profile_t* p = &s->profile;
+    if (p->stop_ns != 0 && now_ns >= s->start_ns + p->stop_ns) {
+        return;
+    }
+
+    s->stats.offered++;
+    if (s->queue_len >= p->queue) {
+        s->stats.overflowed++;
+    } else {
+        s->arrivals[(s->queue_head + s->queue_len) % STATION_QUEUE_MAX] = now_ns;
+        s->queue_len++;
+        if (s->state == STATION_IDLE) {
+            _try_send(index, now_ns);
+        }
+    }
+
+    double interval_s = p->poisson ? -log(1.0 - _uniform()) / p->rate : 1.0 / p->rate;
+    line_schedule(now_ns + (uint64_t) (interval_s * 1e9), _on_arrival, ctx);
+}
+
+static void _on_frame_end(void* ctx, const line_frame_t* frame) {
+    if (frame->corrupt || frame->len != 4 || frame->data[1] != 0 || _index_of[frame->data[0]] < 0) {
+        return;
+    }
+
+    uint index = _index_of[frame->data[0]];
+    station_t* s = &_stations[index];
+    if (frame->data[2] != s->profile.target || frame->data[3] != 0) {
+        return;
+    }
+
+    if (s->state == STATION_AWAIT_SCOUT_ACK) {
+        uint64_t end_ns = _send(_build_frame(s, false), frame->end_ns + _turnaround_ns);
+        _set_state(index, STATION_AWAIT_DATA_ACK);
+        _schedule(index, end_ns + s->profile.timeout_ns, _on_timeout);
+    } else if (s->state == STATION_AWAIT_DATA_ACK) {
+        _deliver(index, frame->end_ns);
+    }
+}
+
+static void _on_frame_sent(void* ctx, const line_frame_t* frame) {
+    if (frame->len < 4 || _index_of[frame->data[2]] < 0) {
+        return;
+    }
+
+    uint index = _index_of[frame->data[2]];
+    station_t* s = &_stations[index];
+    if (frame->corrupt) {
+        s->stats.collisions++;
+    }
+
+    if (s->state == STATION_AWAIT_SENT) {
+        if (frame->corrupt) {
+            _fail(index, frame->end_ns);
+        } else {
+            _deliver(index, frame->end_ns);
+        }
+    }
+}
+
+void stations_init(uint64_t turnaround_ns, uint32_t seed) {
+    static const line_endpoint_t endpoint = {
+        .ctx = NULL,
+        .frame_start = NULL,
+        .frame_end = _on_frame_end,
+        .frame_sent = _on_frame_sent
+    };
+
+    memset(_stations, 0, sizeof(_stations));
+    memset(_index_of, 0xff, sizeof(_index_of));
+    _station_count = 0;
+    _turnaround_ns = turnaround_ns;
+    _random = seed != 0 ? seed : 1;
+    _endpoint = line_attach(&endpoint);
+}
+
+static bool _parse_uint(const char* value, unsigned long min, unsigned long max, unsigned long* result) {
+    char* end;
+    errno = 0;
+    *result = strtoul(value, &end, 0);
+    return errno == 0 && *end == '\0' && *value != '\0' && *result >= min && *result <= max;
+}
+
+static bool _parse_ms(const char* value, uint64_t* result_ns) {
+    char* end;
+    errno = 0;
+    double ms = strtod(value, &end);
+    if (errno != 0 || *end != '\0' || *value == '\0' || ms < 0 || ms > 3600000) {
+        return false;
+    }
+    *result_ns = (uint64_t) (ms * 1000000);
+    return true;
+}
+
+static bool _parse_term(station_profile_t* p, uint* first, uint* last, const char* key, const char* value) {
+    unsigned long n;
+    if (strcmp(key, "station") == 0) {
+        char* dash = strchr(value, '-');
+        if (dash != NULL) {
+            *dash = '\0';
+            unsigned long to;
+            if (!_parse_uint(value, 1, 254, &n) || !_parse_uint(dash + 1, n, 254, &to)) {
+                return false;
+            }
+            *first = n;
+            *last = to;
+            return true;
+        }
+        if (!_parse_uint(value, 1, 254, &n)) {
+            return false;
+        }
+        *first = *last = n;
+    } else if (strcmp(key, "kind") == 0) {
+        if (strcmp(value, "transmit") == 0) {
+            p->kind = STATION_KIND_TRANSMIT;
+        } else if (strcmp(value, "broadcast") == 0) {
+            p->kind = STATION_KIND_BROADCAST;
+        } else {
+            return false;
+        }
+    } else if (strcmp(key, "target") == 0) {
+        if (!_parse_uint(value, 1, 254, &n)) {
+            return false;
+        }
+        p->target = n;
+    } else if (strcmp(key, "port") == 0) {
+        if (!_parse_uint(value, 1, 255, &n)) {
+            return false;
+        }
+        p->port = n;
+    } else if (strcmp(key, "rate") == 0) {
+        if (!_parse_uint(value, 0, 1000000, &n)) {
+            return false;
+        }
+        p->rate = n;
+    } else if (strcmp(key, "size") == 0) {
+        if (!_parse_uint(value, 0, LINE_MAX_FRAME_SZ - 6, &n)) {
+            return false;
+        }
+        p->size = n;
+    } else if (strcmp(key, "arrival") == 0) {
+        if (strcmp(value, "poisson") == 0) {
+            p->poisson = true;
+        } else if (strcmp(value, "periodic") == 0) {
+            p->poisson = false;
+        } else {
+            return false;
+        }
+    } else if (strcmp(key, "carrier") == 0) {
+        if (strcmp(value, "sense") == 0) {
+            p->ignore_carrier = false;
+        } else if (strcmp(value, "ignore") == 0) {
+            p->ignore_carrier = true;
+        } else {
+            return false;
+        }
+    } else if (strcmp(key, "retries") == 0) {
+        if (!_parse_uint(value, 0, 1000, &n)) {
+            return false;
+        }
+        p->retries = n;
+    } else if (strcmp(key, "queue") == 0) {
+        if (!_parse_uint(value, 1, STATION_QUEUE_MAX, &n)) {
+            return false;
+        }
+        p->queue = n;
+    } else if (strcmp(key, "backoff-ms") == 0) {
+        return _parse_ms(value, &p->backoff_ns);
+    } else if (strcmp(key, "timeout-ms") == 0) {
+        return _parse_ms(value, &p->timeout_ns);
+    } else if (strcmp(key, "start-ms") == 0) {
+        return _parse_ms(value, &p->start_ns);
+    } else if (strcmp(key, "stop-ms") == 0) {
+        return _parse_ms(value, &p->stop_ns);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Reads station profiles from a file. Each line describes one station, or a range of them
+ * sharing a profile, as whitespace separated key=value terms; '#' starts a comment:
+ *
+ *   station=N or station=N-M   station number(s), required
+ *   kind=transmit|broadcast    four-way handshake to target (default) or broadcast frame
+ *   target=N                   station to transmit to, required for kind=transmit
+ *   port=N                     Econet port (default 0x99)
+ *   rate=N                     payloads per second (default 1)
+ *   size=N                     payload bytes (default 64)
+ *   arrival=poisson|periodic   payload arrival process (default poisson)
+ *   carrier=sense|ignore       wait for the line to be idle before sending (default sense)
+ *   retries=N                  retries of a failed handshake (default 3)
+ *   queue=N                    payloads held whilst busy, up to 64 (default 8)
+ *   backoff-ms=T               maximum random delay before a retry (default 10)
+ *   timeout-ms=T               wait for each acknowledgement (default 20)
+ *   start-ms=T, stop-ms=T      when arrivals begin and end, from start-up (default 0, never)
+ */
+bool stations_load(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Failed to open profile '%s': %s\n", path, strerror(errno));
+        return false;
+    }
+
+    char line[PROFILE_LINE_MAX];
+    uint line_number = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file) != NULL) {
+        line_number++;
+        char* comment = strchr(line, '#');
+        if (comment != NULL) {
+            *comment = '\0';
+        }
+
+        station_profile_t profile = {
+            .kind = STATION_KIND_TRANSMIT,
+            .port = DEFAULT_PORT,
+            .rate = DEFAULT_RATE,
+            .size = DEFAULT_SIZE,
+            .poisson = true,
+            .retries = DEFAULT_RETRIES,
+            .queue = DEFAULT_QUEUE,
+            .backoff_ns = DEFAULT_BACKOFF_MS * 1000000ull,
+            .timeout_ns = DEFAULT_TIMEOUT_MS * 1000000ull
+        };
+        uint first = 0;
+        uint last = 0;
+        bool empty = true;
+
+        for (char* term = strtok(line, " \t\r\n"); term != NULL; term = strtok(NULL, " \t\r\n")) {
+            empty = false;
+            char* equals = strchr(term, '=');
+            if (equals == NULL) {
+                fprintf(stderr, "%s:%u: expected key=value but found '%s'\n", path, line_number, term);
+                ok = false;
+                break;
+            }
+            *equals = '\0';
+            if (!_parse_term(&profile, &first, &last, term, equals + 1)) {
+                fprintf(stderr, "%s:%u: invalid term '%s=%s'\n", path, line_number, term, equals + 1);
+                ok = false;
+                break;
+            }
+        }
+
+        if (!ok || empty) {
+            continue;
+        }
+
+        if (first == 0 || (profile.kind == STATION_KIND_TRANSMIT && profile.target == 0)) {
+            fprintf(stderr, "%s:%u: station%s required\n", path, line_number, first == 0 ? "" : " target");
+            ok = false;
+            break;
+        }
+
+        for (uint station = first; station <= last; station++) {
+            if (_index_of[station] >= 0 || _station_count >= STATIONS_MAX) {
+                fprintf(stderr, "%s:%u: station %u %s\n", path, line_number, station,
+                    _index_of[station] >= 0 ? "defined twice" : "exceeds the maximum number of stations");
+                ok = false;
+                break;
+            }
+            station_t* s = &_stations[_station_count];
+            s->profile = profile;
+            s->profile.station = station;
+            s->stats.station = station;
+            _index_of[station] = _station_count++;
+        }
+    }
+
+    fclose(file);
+    return ok;
+}
+
+void stations_start(uint64_t now_ns) {
+    for (uint i = 0; i < _station_count; i++) {
+        station_t* s = &_stations[i];
+        s->start_ns = now_ns;
+        if (s->profile.rate == 0) {
+            continue;
+        }
+
+        // stations on the same period would otherwise all want the line at once, every time
+        uint64_t phase_ns = (uint64_t) (_uniform() * 1e9 / s->profile.rate);
+        line_schedule(now_ns + s->profile.start_ns + phase_ns, _on_arrival, (void*) (uintptr_t) i);
+    }
+}
+
+uint stations_count(void) {
+    return _station_count;
+}
+
+const station_stats_t* stations_stats(uint index) {
+    return index < _station_count ? &_stations[index].stats : NULL;
+}
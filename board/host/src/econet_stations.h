@@ -0,0 +1,65 @@
+#ifndef _PICONET_HOST_ECONET_STATIONS_H_
+#define _PICONET_HOST_ECONET_STATIONS_H_
+
+#include "pico.h"
+
+/*
+ * Contending virtual Econet stations, each following a traffic profile, for load testing the
+ * firmware with many stations sharing the line.
+ *
+ * Unlike the stations in econet_peers.h, which assume the line is theirs, these wait for the
+ * line to be seen idle before starting a handshake (unless told to ignore it), so stations
+ * which start together collide. A failed handshake is retried after a random backoff. Payloads
+ * arrive periodically or as a Poisson process and queue at the station whilst it's busy.
+ *
+ * Profiles are read from a file, one line per station or range of stations, of key=value
+ * terms; see stations_load() and the --profile option of piconet-emu.
+ */
+
+#define STATIONS_MAX                64
+
+typedef enum {
+    STATION_KIND_TRANSMIT = 0L,     // four-way handshake to the target
+    STATION_KIND_BROADCAST          // single broadcast frame
+} station_kind_t;
+
+typedef struct {
+    uint8_t         station;
+    station_kind_t  kind;
+    uint8_t         target;
+    uint8_t         port;
+    uint32_t        rate;           // payloads per second
+    size_t          size;           // payload bytes in each data frame
+    bool            poisson;        // exponentially distributed arrivals rather than periodic
+    bool            ignore_carrier; // transmit without waiting for the line to be idle
+    uint32_t        retries;        // times a failed handshake is retried
+    uint32_t        queue;          // payloads waiting, beyond which arrivals are dropped
+    uint64_t        backoff_ns;     // maximum random delay before a retry
+    uint64_t        timeout_ns;     // wait for an acknowledgement
+    uint64_t        start_ns;       // offsets from stations_start() of the first and last
+    uint64_t        stop_ns;        // arrivals; 0 to never stop
+} station_profile_t;
+
+typedef struct {
+    uint8_t     station;
+    uint64_t    offered;            // payloads arriving
+    uint64_t    overflowed;         // payloads dropped because the queue was full
+    uint64_t    attempts;           // handshakes (or broadcasts) started, including retries
+    uint64_t    deferrals;          // times the line was busy when the station wanted it
+    uint64_t    collisions;         // frames sent by the station which were corrupted
+    uint64_t    no_scout_ack;
+    uint64_t    no_data_ack;
+    uint64_t    delivered;          // payloads acknowledged (or broadcast intact)
+    uint64_t    abandoned;          // payloads given up on after the last retry
+    uint64_t    bytes_delivered;
+    uint64_t    latency_total_ns;   // arrival to delivery, over delivered payloads
+    uint64_t    latency_max_ns;
+} station_stats_t;
+
+void                    stations_init(uint64_t turnaround_ns, uint32_t seed);
+bool                    stations_load(const char* path);
+void                    stations_start(uint64_t now_ns);
+uint                    stations_count(void);
+const station_stats_t*  stations_stats(uint index);
+
+#endif
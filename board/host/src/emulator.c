@@ -0,0 +1,555 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "adlc_model.h"
+#include "econet_line.h"
+#include "econet_peers.h"
+#include "econet_replay.h"
+#include "econet_stations.h"
+#include "host.h"
+#include "buffer_pool.h"
+#include "pico/util/queue.h"
+
+#define DEFAULT_BITRATE             200000
+#define DEFAULT_BUS_CYCLE_NS        500
+#define DEFAULT_TURNAROUND_US       50
+#define DEFAULT_RESPONDER           254
+#define DEFAULT_TRAFFIC_SIZE        64
+#define DEFAULT_TRAFFIC_SRC         100
+#define DEFAULT_TRAFFIC_DEST        101
+#define DEFAULT_SENDER_TARGET       2
+#define DEFAULT_SENDER_PORT         0x99
+#define DEFAULT_SENDER_SIZE         64
+#define DEFAULT_SEED                1
+#define DEFAULT_REPLAY_SPEED        1
+#define DEFAULT_REPLAY_DELAY_MS     1000
+#define FIRMWARE_SAMPLE_NS          1000000ull
+
+typedef struct {
+    uint64_t    samples;
+    uint64_t    event_queue_total;
+    uint        event_queue_max;
+    uint64_t    rx_buffers_total;
+    uint        rx_buffers_max;
+} firmware_stats_t;
+
+// main() of piconet.c, renamed by the build
+int piconet_main(void);
+
+// globals of piconet.c, sampled to report how full the firmware's queues get
+extern queue_t event_queue;
+extern pool_t rx_buffer_pool;
+
+static const char* _link_path;
+static const char* _data_link_path;
+static const char* _bulk_link_path;
+static uint64_t _start_ns;
+static uint64_t _bus_cycle_ns;
+static bool _replaying;
+static firmware_stats_t _firmware;
+
+static void _usage(const char* argv0) {
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "\n"
+        "Runs the Piconet firmware against a simulated ADLC and Econet line, exposing its USB\n"
+        "serial interfaces as pseudo-terminals.\n"
+        "\n"
+        "  -l, --link PATH            create a symlink to the control pseudo-terminal at PATH\n"
+        "  -L, --data-link PATH       also expose the data channel, as a symlink at PATH\n"
+        "                             (without it, all output goes to the control channel)\n"
+        "  -B, --bulk-link PATH       also expose the vendor bulk interface, as a symlink at PATH\n"
+        "                             (opening it stands in for the host's request to open it)\n"
+        "  -b, --bitrate BPS          line bit rate (default %u)\n"
+        "  -c, --bus-cycle-ns NS      minimum time per ADLC bus access (default %u)\n"
+        "  -s, --strict-timing        model FIFO overrun/underrun and frames lost in rx reset\n"
+        "  -t, --turnaround-us US     virtual station turnaround time (default %u)\n"
+        "  -r, --responder STATION    add a virtual station which acknowledges transmissions\n"
+        "                             (repeatable, default %u)\n"
+        "  -m, --monitor-rate FPS     frames per second of traffic between two other virtual\n"
+        "                             stations (default 0)\n"
+        "  -z, --monitor-size BYTES   payload of each generated data frame (default %u)\n"
+        "  -x, --sender STATION       virtual station which transmits to Piconet (default none)\n"
+        "  -X, --sender-rate TPS      transmissions per second by the sender (default 1)\n"
+        "  -T, --sender-target STN    Piconet station targeted by the sender (default %u)\n"
+        "  -Z, --sender-size BYTES    payload of each sender data frame (default %u)\n"
+        "  -R, --sender-repeats N     times the sender sends each payload, as if its acks were\n"
+        "                             lost (default 1)\n"
+        "  -p, --profile FILE         add contending virtual stations, each following the\n"
+        "                             traffic profile given by a line of FILE (see README)\n"
+        "  -S, --seed N               seed for the stations' random arrivals and backoff\n"
+        "                             (default %u)\n"
+        "  -e, --frame-errors PPM     frames per million corrupted on the line (default 0)\n"
+        "  -y, --replay FILE          replay the MONITOR events captured in FILE onto the line,\n"
+        "                             as though Piconet were the station given by -n (see README)\n"
+        "  -n, --replay-station N     station whose frames are left for Piconet to send\n"
+        "  -Y, --replay-speed N       times faster than captured, or 0 for back to back\n"
+        "                             (default %u)\n"
+        "  -d, --replay-delay-ms MS   wait before replaying, e.g. for LISTEN mode (default %u)\n"
+        "\n"
+        "Statistics are written to stderr as a JSON object on SIGUSR1 and on exit.\n",
+        argv0,
+        DEFAULT_BITRATE,
+        DEFAULT_BUS_CYCLE_NS,
+        DEFAULT_TURNAROUND_US,
+        DEFAULT_RESPONDER,
+        DEFAULT_TRAFFIC_SIZE,
+        DEFAULT_SENDER_TARGET,
+        DEFAULT_SENDER_SIZE,
+        DEFAULT_SEED,
+        DEFAULT_REPLAY_SPEED,
+        DEFAULT_REPLAY_DELAY_MS);
+}
+
+static long _parse_number(const char* option, const char* value, long min, long max) {
+    char* end;
+    errno = 0;
+    long result = strtol(value, &end, 0);
+    if (errno != 0 || *end != '\0' || result < min || result > max) {
+        fprintf(stderr, "Invalid value '%s' for %s (expected %ld-%ld)\n", value, option, min, max);
+        exit(2);
+    }
+    return result;
+}
+
+// Creates a pseudo-terminal, holding the slave open if `hold_open` so that it looks as though a
+// client always has it open
+static int _open_pty(const char** slave_path, bool hold_open) {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        perror("Failed to create pseudo-terminal");
+        exit(1);
+    }
+
+    *slave_path = strdup(ptsname(master));
+
+    // hold the slave open so reads of the master don't fail whilst no client is connected,
+    // and make it raw so nothing is echoed or translated before a client configures it
+    int slave = open(*slave_path, O_RDWR | O_NOCTTY);
+    if (slave < 0) {
+        perror("Failed to open pseudo-terminal");
+        exit(1);
+    }
+
+    struct termios tio;
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+    if (!hold_open) {
+        close(slave);
+    }
+
+    return master;
+}
+
+// Samples the firmware's event queue and receive buffers once a millisecond of line time. This
+// runs on core 1 (whose bus accesses advance the line) but reads without locking, so a sample
+// may be momentarily out of date.
+static void _sample_firmware(void* ctx, uint64_t now_ns) {
+    uint events = queue_get_level(&event_queue);
+    uint rx_buffers = 0;
+    for (size_t i = 0; i < rx_buffer_pool.buffer_count; i++) {
+        if (rx_buffer_pool.buffers[i].in_use) {
+            rx_buffers++;
+        }
+    }
+
+    _firmware.samples++;
+    _firmware.event_queue_total += events;
+    _firmware.rx_buffers_total += rx_buffers;
+    if (events > _firmware.event_queue_max) {
+        _firmware.event_queue_max = events;
+    }
+    if (rx_buffers > _firmware.rx_buffers_max) {
+        _firmware.rx_buffers_max = rx_buffers;
+    }
+
+    line_schedule(now_ns + FIRMWARE_SAMPLE_NS, _sample_firmware, NULL);
+}
+
+static double _mean(uint64_t total, uint64_t count) {
+    return count > 0 ? (double) total / count : 0;
+}
+
+static void _print_station_stats(uint64_t elapsed_ns) {
+    for (uint i = 0; i < stations_count(); i++) {
+        const station_stats_t* s = stations_stats(i);
+        uint64_t failures = s->no_scout_ack + s->no_data_ack;
+        fprintf(stderr,
+            "%s{\"station\":%u,\"offered\":%llu,\"overflowed\":%llu,\"attempts\":%llu"
+            ",\"deferrals\":%llu,\"collisions\":%llu,\"no_scout_ack\":%llu,\"no_data_ack\":%llu"
+            ",\"delivered\":%llu,\"abandoned\":%llu,\"bytes_delivered\":%llu,\"goodput_bps\":%.0f"
+            ",\"failure_rate\":%.4f,\"mean_latency_us\":%.0f,\"max_latency_us\":%llu}",
+            i == 0 ? "" : ",",
+            s->station,
+            (unsigned long long) s->offered,
+            (unsigned long long) s->overflowed,
+            (unsigned long long) s->attempts,
+            (unsigned long long) s->deferrals,
+            (unsigned long long) s->collisions,
+            (unsigned long long) s->no_scout_ack,
+            (unsigned long long) s->no_data_ack,
+            (unsigned long long) s->delivered,
+            (unsigned long long) s->abandoned,
+            (unsigned long long) s->bytes_delivered,
+            elapsed_ns > 0 ? s->bytes_delivered * 8e9 / elapsed_ns : 0,
+            _mean(failures, s->attempts),
+            _mean(s->latency_total_ns, s->delivered) / 1000,
+            (unsigned long long) (s->latency_max_ns / 1000));
+    }
+}
+
+// "Core 1 time" per frame is given as the bus transactions the firmware made and the time they
+// occupy the bus; core 1 spins whilst waiting on the host, so its CPU time means nothing here.
+static void _print_replay_stats(void) {
+    const replay_stats_t* r = replay_stats();
+    uint64_t acks = r->scouts_acked + r->data_acked;
+    uint64_t elapsed_ns = (r->complete ? r->end_ns : host_time_ns()) - r->start_ns;
+    fprintf(stderr,
+        ",\"replay\":{\"frames\":%llu,\"skipped\":%llu,\"replayed\":%llu,\"broadcasts\":%llu"
+        ",\"scouts\":%llu,\"scouts_acked\":%llu,\"data_frames\":%llu,\"data_acked\":%llu"
+        ",\"data_not_sent\":%llu,\"mean_turnaround_us\":%.1f,\"max_turnaround_us\":%.1f"
+        ",\"bus_transactions\":%llu,\"transactions_per_frame\":%.1f,\"bus_us_per_frame\":%.1f"
+        ",\"elapsed_us\":%llu,\"complete\":%s}",
+        (unsigned long long) r->frames,
+        (unsigned long long) r->skipped,
+        (unsigned long long) r->replayed,
+        (unsigned long long) r->broadcasts,
+        (unsigned long long) r->scouts,
+        (unsigned long long) r->scouts_acked,
+        (unsigned long long) r->data_frames,
+        (unsigned long long) r->data_acked,
+        (unsigned long long) r->data_not_sent,
+        _mean(r->turnaround_total_ns, acks) / 1000,
+        r->turnaround_max_ns / 1000.0,
+        (unsigned long long) r->bus_transactions,
+        _mean(r->bus_transactions, r->replayed),
+        _mean(r->bus_transactions * _bus_cycle_ns, r->replayed) / 1000,
+        (unsigned long long) (_replaying && r->start_ns < host_time_ns() ? elapsed_ns / 1000 : 0),
+        r->complete ? "true" : "false");
+}
+
+static void _print_stats(void) {
+    const line_stats_t* line = line_stats();
+    const adlc_model_stats_t* adlc = adlc_model_stats();
+    const peers_stats_t* peers = peers_stats();
+    const host_core0_stats_t* core0 = host_core0_stats();
+    const host_pio_stats_t* pio = pio_host_stats();
+
+    fprintf(stderr,
+        "{\"time_us\":%llu"
+        ",\"line\":{\"frames\":%llu,\"bytes\":%llu,\"collisions\":%llu,\"errors\":%llu,\"dropped\":%llu"
+        ",\"busy_us\":%llu}"
+        ",\"adlc\":{\"bus_reads\":%llu,\"bus_writes\":%llu,\"frames_received\":%llu,\"frames_discarded\":%llu"
+        ",\"frames_missed\":%llu,\"frames_sent\":%llu,\"rx_overruns\":%llu,\"tx_underruns\":%llu"
+        ",\"empty_fifo_reads\":%llu}"
+        ",\"peers\":{\"scouts_acked\":%llu,\"data_acked\":%llu,\"peeks_answered\":%llu"
+        ",\"traffic_frames\":%llu,\"traffic_handshakes\":%llu,\"sender_attempts\":%llu,\"sender_ok\":%llu"
+        ",\"sender_no_scout_ack\":%llu,\"sender_no_data_ack\":%llu}"
+        ",\"core0\":{\"wfe\":%llu,\"idle_us\":%llu}"
+        ",\"pio\":{\"transactions\":%llu,\"snoop_reads\":%llu}"
+        ",\"firmware\":{\"samples\":%llu,\"event_queue_mean\":%.2f,\"event_queue_max\":%u"
+        ",\"rx_buffers_mean\":%.2f,\"rx_buffers_max\":%u}"
+        ",\"stations\":[",
+        (unsigned long long) (host_time_ns() / 1000),
+        (unsigned long long) line->frames,
+        (unsigned long long) line->bytes,
+        (unsigned long long) line->collisions,
+        (unsigned long long) line->errors,
+        (unsigned long long) line->dropped,
+        (unsigned long long) (line->busy_ns / 1000),
+        (unsigned long long) adlc->bus_reads,
+        (unsigned long long) adlc->bus_writes,
+        (unsigned long long) adlc->frames_received,
+        (unsigned long long) adlc->frames_discarded,
+        (unsigned long long) adlc->frames_missed,
+        (unsigned long long) adlc->frames_sent,
+        (unsigned long long) adlc->rx_overruns,
+        (unsigned long long) adlc->tx_underruns,
+        (unsigned long long) adlc->empty_fifo_reads,
+        (unsigned long long) peers->scouts_acked,
+        (unsigned long long) peers->data_acked,
+        (unsigned long long) peers->peeks_answered,
+        (unsigned long long) peers->traffic_frames,
+        (unsigned long long) peers->traffic_handshakes,
+        (unsigned long long) peers->sender_attempts,
+        (unsigned long long) peers->sender_ok,
+        (unsigned long long) peers->sender_no_scout_ack,
+        (unsigned long long) peers->sender_no_data_ack,
+        (unsigned long long) core0->wfe_count,
+        (unsigned long long) (core0->idle_ns / 1000),
+        (unsigned long long) pio->transactions,
+        (unsigned long long) pio->snoop_reads,
+        (unsigned long long) _firmware.samples,
+        _mean(_firmware.event_queue_total, _firmware.samples),
+        _firmware.event_queue_max,
+        _mean(_firmware.rx_buffers_total, _firmware.samples),
+        _firmware.rx_buffers_max);
+    _print_station_stats(host_time_ns() - _start_ns);
+    fprintf(stderr, "]");
+    if (_replaying) {
+        _print_replay_stats();
+    }
+    fprintf(stderr, "}\n");
+}
+
+static void* _core0_entry(void* arg) {
+    exit(piconet_main());
+}
+
+int main(int argc, char** argv) {
+    static const struct option options[] = {
+        { "link",           required_argument,  NULL, 'l' },
+        { "data-link",      required_argument,  NULL, 'L' },
+        { "bulk-link",      required_argument,  NULL, 'B' },
+        { "bitrate",        required_argument,  NULL, 'b' },
+        { "bus-cycle-ns",   required_argument,  NULL, 'c' },
+        { "strict-timing",  no_argument,        NULL, 's' },
+        { "turnaround-us",  required_argument,  NULL, 't' },
+        { "responder",      required_argument,  NULL, 'r' },
+        { "monitor-rate",   required_argument,  NULL, 'm' },
+        { "monitor-size",   required_argument,  NULL, 'z' },
+        { "sender",         required_argument,  NULL, 'x' },
+        { "sender-rate",    required_argument,  NULL, 'X' },
+        { "sender-target",  required_argument,  NULL, 'T' },
+        { "sender-size",    required_argument,  NULL, 'Z' },
+        { "sender-repeats", required_argument,  NULL, 'R' },
+        { "profile",        required_argument,  NULL, 'p' },
+        { "seed",           required_argument,  NULL, 'S' },
+        { "frame-errors",   required_argument,  NULL, 'e' },
+        { "replay",         required_argument,  NULL, 'y' },
+        { "replay-station", required_argument,  NULL, 'n' },
+        { "replay-speed",   required_argument,  NULL, 'Y' },
+        { "replay-delay-ms", required_argument, NULL, 'd' },
+        { "help",           no_argument,        NULL, 'h' },
+        { NULL,             0,                  NULL, 0 }
+    };
+
+    uint32_t bitrate = DEFAULT_BITRATE;
+    uint64_t bus_cycle_ns = DEFAULT_BUS_CYCLE_NS;
+    bool strict_timing = false;
+    bool responder_given = false;
+    const char* profile_path = NULL;
+    uint32_t seed = DEFAULT_SEED;
+    uint32_t frame_errors_ppm = 0;
+    const char* replay_path = NULL;
+    uint8_t replay_station = 0;
+    uint32_t replay_speed = DEFAULT_REPLAY_SPEED;
+    uint64_t replay_delay_ns = DEFAULT_REPLAY_DELAY_MS * 1000000ull;
+    peers_config_t peers = {
+        .turnaround_ns = DEFAULT_TURNAROUND_US * 1000ull,
+        .traffic_size = DEFAULT_TRAFFIC_SIZE,
+        .traffic_src = DEFAULT_TRAFFIC_SRC,
+        .traffic_dest = DEFAULT_TRAFFIC_DEST,
+        .sender_target = DEFAULT_SENDER_TARGET,
+        .sender_port = DEFAULT_SENDER_PORT,
+        .sender_rate = 1,
+        .sender_size = DEFAULT_SENDER_SIZE,
+        .sender_repeats = 1
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "l:L:B:b:c:st:r:m:z:x:X:T:Z:R:p:S:e:y:n:Y:d:h", options, NULL)) != -1) {
+        switch (opt) {
+            case 'l':
+                _link_path = optarg;
+                break;
+            case 'L':
+                _data_link_path = optarg;
+                break;
+            case 'B':
+                _bulk_link_path = optarg;
+                break;
+            case 'b':
+                bitrate = _parse_number("--bitrate", optarg, 1000, 100000000);
+                break;
+            case 'c':
+                bus_cycle_ns = _parse_number("--bus-cycle-ns", optarg, 0, 1000000);
+                break;
+            case 's':
+                strict_timing = true;
+                break;
+            case 't':
+                peers.turnaround_ns = _parse_number("--turnaround-us", optarg, 0, 1000000) * 1000ull;
+                break;
+            case 'r':
+                peers.responders[_parse_number("--responder", optarg, 1, 254)] = true;
+                responder_given = true;
+                break;
+            case 'm':
+                peers.traffic_rate = _parse_number("--monitor-rate", optarg, 0, 1000000);
+                break;
+            case 'z':
+                peers.traffic_size = _parse_number("--monitor-size", optarg, 0, LINE_MAX_FRAME_SZ - 4);
+                break;
+            case 'x':
+                peers.sender_station = _parse_number("--sender", optarg, 1, 254);
+                break;
+            case 'X':
+                peers.sender_rate = _parse_number("--sender-rate", optarg, 1, 1000000);
+                break;
+            case 'T':
+                peers.sender_target = _parse_number("--sender-target", optarg, 1, 254);
+                break;
+            case 'Z':
+                peers.sender_size = _parse_number("--sender-size", optarg, 0, LINE_MAX_FRAME_SZ - 4);
+                break;
+            case 'R':
+                peers.sender_repeats = _parse_number("--sender-repeats", optarg, 1, 1000);
+                break;
+            case 'p':
+                profile_path = optarg;
+                break;
+            case 'S':
+                seed = _parse_number("--seed", optarg, 1, UINT32_MAX);
+                break;
+            case 'e':
+                frame_errors_ppm = _parse_number("--frame-errors", optarg, 0, 1000000);
+                break;
+            case 'y':
+                replay_path = optarg;
+                break;
+            case 'n':
+                replay_station = _parse_number("--replay-station", optarg, 1, 254);
+                break;
+            case 'Y':
+                replay_speed = _parse_number("--replay-speed", optarg, 0, 1000000);
+                break;
+            case 'd':
+                replay_delay_ns = _parse_number("--replay-delay-ms", optarg, 0, 3600000) * 1000000ull;
+                break;
+            case 'h':
+                _usage(argv[0]);
+                return 0;
+            default:
+                _usage(argv[0]);
+                return 2;
+        }
+    }
+
+    if (!responder_given) {
+        peers.responders[DEFAULT_RESPONDER] = true;
+    }
+
+    line_init(bitrate);
+    line_set_error_rate(frame_errors_ppm);
+    if (profile_path != NULL) {
+        stations_init(peers.turnaround_ns, seed);
+        if (!stations_load(profile_path)) {
+            return 2;
+        }
+    }
+
+    if (replay_path != NULL) {
+        if (replay_station == 0) {
+            fprintf(stderr, "--replay needs --replay-station\n");
+            return 2;
+        }
+        if (!replay_load(replay_path, replay_station, replay_speed)) {
+            return 2;
+        }
+        _replaying = true;
+    }
+
+    _start_ns = host_time_ns();
+
+    const char* slave_path;
+    int master = _open_pty(&slave_path, true);
+    if (_link_path != NULL) {
+        unlink(_link_path);
+        if (symlink(slave_path, _link_path) != 0) {
+            perror("Failed to create symlink");
+            return 1;
+        }
+    }
+
+    int data_master = -1;
+    if (_data_link_path != NULL) {
+        const char* data_slave_path;
+        data_master = _open_pty(&data_slave_path, false);
+        unlink(_data_link_path);
+        if (symlink(data_slave_path, _data_link_path) != 0) {
+            perror("Failed to create symlink");
+            return 1;
+        }
+    }
+
+    int bulk_master = -1;
+    if (_bulk_link_path != NULL) {
+        const char* bulk_slave_path;
+        bulk_master = _open_pty(&bulk_slave_path, false);
+        unlink(_bulk_link_path);
+        if (symlink(bulk_slave_path, _bulk_link_path) != 0) {
+            perror("Failed to create symlink");
+            return 1;
+        }
+    }
+
+    adlc_model_init(strict_timing);
+    peers_init(&peers);
+    peers_start(_start_ns);
+    stations_start(_start_ns);
+    line_schedule(_start_ns, _sample_firmware, NULL);
+    if (_replaying) {
+        replay_start(_start_ns + replay_delay_ns, peers.turnaround_ns);
+    }
+    _bus_cycle_ns = bus_cycle_ns;
+    pio_host_set_bus_cycle_ns(bus_cycle_ns);
+    host_usb_attach(0, master);
+    if (data_master >= 0) {
+        host_usb_attach(1, data_master);
+    }
+    if (bulk_master >= 0) {
+        host_usb_attach_vendor(bulk_master);
+    }
+
+    // signals are handled synchronously below rather than interrupting the firmware threads
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGHUP);
+    sigaddset(&signals, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+    pthread_t core0;
+    if (pthread_create(&core0, NULL, _core0_entry, NULL) != 0) {
+        fprintf(stderr, "Failed to start core 0 thread\n");
+        return 1;
+    }
+
+    fprintf(stderr, "Piconet emulator listening on %s\n", _link_path != NULL ? _link_path : slave_path);
+
+    while (true) {
+        int sig;
+        if (sigwait(&signals, &sig) != 0) {
+            continue;
+        }
+
+        _print_stats();
+        if (sig != SIGUSR1) {
+            break;
+        }
+    }
+
+    if (_link_path != NULL) {
+        unlink(_link_path);
+    }
+    if (_data_link_path != NULL) {
+        unlink(_data_link_path);
+    }
+    if (_bulk_link_path != NULL) {
+        unlink(_bulk_link_path);
+    }
+    return 0;
+}
@@ -0,0 +1,33 @@
+#ifndef _PICONET_HOST_HOST_H_
+#define _PICONET_HOST_HOST_H_
+
+#include "pico.h"
+
+// GPIOs of the ADLC bus interface, matching adlc.c
+#define HOST_GPIO_DATA_7            2
+#define HOST_GPIO_DATA_LED          10
+#define HOST_GPIO_BUFF_A0           11
+#define HOST_GPIO_BUFF_A1           12
+#define HOST_GPIO_BUFF_nRST         22
+
+typedef struct {
+    uint64_t    wfe_count;
+    uint64_t    idle_ns;            // time spent in WFE
+} host_core0_stats_t;
+
+typedef struct {
+    uint64_t    transactions;       // command words executed for the CPU
+    uint64_t    snoop_reads;        // reads made whilst snooping
+} host_pio_stats_t;
+
+uint64_t    host_time_ns(void);
+void        host_irq_enter(void);
+void        host_irq_exit(void);
+const host_core0_stats_t* host_core0_stats(void);
+void        host_gpio_changed(uint gpio, bool value);
+void        host_usb_attach(uint8_t itf, int fd);
+void        host_usb_attach_vendor(int fd);
+void        pio_host_set_bus_cycle_ns(uint64_t bus_cycle_ns);
+const host_pio_stats_t* pio_host_stats(void);
+
+#endif
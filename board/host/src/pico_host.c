@@ -0,0 +1,364 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "pico/mutex.h"
+#include "pico/util/queue.h"
+#include "hardware/clocks.h"
+#include "hardware/gpio.h"
+#include "hardware/sync.h"
+
+#include "host.h"
+
+#define GPIO_COUNT      30
+#define FIFO_DEPTH      8
+
+static bool _gpio_values[GPIO_COUNT];
+
+// core 0's event register and "interrupts"; see hardware/sync.h
+static pthread_mutex_t  _irq_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+static pthread_mutex_t  _event_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   _event_cond = PTHREAD_COND_INITIALIZER;
+static bool             _event_register;
+static host_core0_stats_t _core0_stats;
+
+// inter-core FIFO from core 1 to core 0
+static pthread_mutex_t  _fifo_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   _fifo_cond = PTHREAD_COND_INITIALIZER;
+static uint32_t         _fifo[FIFO_DEPTH];
+static uint             _fifo_rptr;
+static uint             _fifo_level;
+
+static uint64_t _monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+uint64_t host_time_ns(void) {
+    static uint64_t boot_ns;
+    if (boot_ns == 0) {
+        boot_ns = _monotonic_ns();
+    }
+    return _monotonic_ns() - boot_ns;
+}
+
+absolute_time_t get_absolute_time(void) {
+    return time_us_64();
+}
+
+uint32_t to_ms_since_boot(absolute_time_t t) {
+    return (uint32_t) (t / 1000);
+}
+
+uint64_t time_us_64(void) {
+    return host_time_ns() / 1000;
+}
+
+uint32_t time_us_32(void) {
+    return (uint32_t) time_us_64();
+}
+
+void sleep_us(uint64_t us) {
+    struct timespec ts = {
+        .tv_sec = us / 1000000,
+        .tv_nsec = (us % 1000000) * 1000
+    };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+void sleep_ms(uint32_t ms) {
+    sleep_us((uint64_t) ms * 1000);
+}
+
+void busy_wait_us(uint64_t delay_us) {
+    uint64_t end = time_us_64() + delay_us;
+    while (time_us_64() < end) {
+    }
+}
+
+void gpio_init(uint gpio) {
+    if (gpio < GPIO_COUNT) {
+        _gpio_values[gpio] = false;
+    }
+}
+
+void gpio_set_dir(uint gpio, bool out) {
+    (void) gpio;
+    (void) out;
+}
+
+void gpio_put(uint gpio, bool value) {
+    if (gpio >= GPIO_COUNT) {
+        return;
+    }
+
+    _gpio_values[gpio] = value;
+    host_gpio_changed(gpio, value);
+}
+
+bool gpio_get(uint gpio) {
+    return gpio < GPIO_COUNT ? _gpio_values[gpio] : false;
+}
+
+void clock_gpio_init(uint gpio, uint src, float div) {
+    (void) gpio;
+    (void) src;
+    (void) div;
+}
+
+uint32_t clock_get_hz(enum clock_index clk_index) {
+    return clk_index == clk_usb ? 48000000 : 125000000;
+}
+
+static void* _core1_entry(void* arg) {
+    void (*entry)(void) = (void (*)(void)) arg;
+    entry();
+    return NULL;
+}
+
+void multicore_launch_core1(void (*entry)(void)) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, _core1_entry, (void*) entry) != 0) {
+        fprintf(stderr, "Failed to start core 1 thread\n");
+        exit(1);
+    }
+    pthread_detach(thread);
+}
+
+bool multicore_fifo_rvalid(void) {
+    pthread_mutex_lock(&_fifo_lock);
+    bool valid = _fifo_level > 0;
+    pthread_mutex_unlock(&_fifo_lock);
+    return valid;
+}
+
+bool multicore_fifo_wready(void) {
+    pthread_mutex_lock(&_fifo_lock);
+    bool ready = _fifo_level < FIFO_DEPTH;
+    pthread_mutex_unlock(&_fifo_lock);
+    return ready;
+}
+
+void multicore_fifo_push_blocking(uint32_t data) {
+    pthread_mutex_lock(&_fifo_lock);
+    while (_fifo_level == FIFO_DEPTH) {
+        pthread_cond_wait(&_fifo_cond, &_fifo_lock);
+    }
+    _fifo[(_fifo_rptr + _fifo_level++) % FIFO_DEPTH] = data;
+    pthread_cond_broadcast(&_fifo_cond);
+    pthread_mutex_unlock(&_fifo_lock);
+
+    __sev();
+}
+
+uint32_t multicore_fifo_pop_blocking(void) {
+    pthread_mutex_lock(&_fifo_lock);
+    while (_fifo_level == 0) {
+        pthread_cond_wait(&_fifo_cond, &_fifo_lock);
+    }
+    uint32_t data = _fifo[_fifo_rptr];
+    _fifo_rptr = (_fifo_rptr + 1) % FIFO_DEPTH;
+    _fifo_level--;
+    pthread_cond_broadcast(&_fifo_cond);
+    pthread_mutex_unlock(&_fifo_lock);
+    return data;
+}
+
+void __wfe(void) {
+    uint64_t start_ns = host_time_ns();
+
+    pthread_mutex_lock(&_event_lock);
+    while (!_event_register) {
+        pthread_cond_wait(&_event_cond, &_event_lock);
+    }
+    _event_register = false;
+    _core0_stats.wfe_count++;
+    _core0_stats.idle_ns += host_time_ns() - start_ns;
+    pthread_mutex_unlock(&_event_lock);
+}
+
+void __sev(void) {
+    pthread_mutex_lock(&_event_lock);
+    _event_register = true;
+    pthread_cond_signal(&_event_cond);
+    pthread_mutex_unlock(&_event_lock);
+}
+
+uint32_t save_and_disable_interrupts(void) {
+    pthread_mutex_lock(&_irq_lock);
+    return 0;
+}
+
+void restore_interrupts(uint32_t status) {
+    (void) status;
+    pthread_mutex_unlock(&_irq_lock);
+}
+
+void host_irq_enter(void) {
+    pthread_mutex_lock(&_irq_lock);
+}
+
+void host_irq_exit(void) {
+    pthread_mutex_unlock(&_irq_lock);
+
+    // as exception return on the RP2040, wakes core 0 from WFE
+    __sev();
+}
+
+const host_core0_stats_t* host_core0_stats(void) {
+    return &_core0_stats;
+}
+
+static void* _timer_thread(void* arg) {
+    repeating_timer_t *timer = arg;
+    uint64_t interval_us = timer->delay_us < 0 ? -timer->delay_us : timer->delay_us;
+    bool repeat = true;
+
+    while (repeat) {
+        sleep_us(interval_us);
+        host_irq_enter();
+        repeat = timer->callback(timer);
+        host_irq_exit();
+    }
+    return NULL;
+}
+
+bool add_repeating_timer_us(
+        int64_t delay_us,
+        repeating_timer_callback_t callback,
+        void *user_data,
+        repeating_timer_t *out) {
+    out->delay_us = delay_us;
+    out->callback = callback;
+    out->user_data = user_data;
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, _timer_thread, out) != 0) {
+        return false;
+    }
+    pthread_detach(thread);
+    return true;
+}
+
+void mutex_init(mutex_t *mtx) {
+    pthread_mutex_init(&mtx->lock, NULL);
+}
+
+void mutex_enter_blocking(mutex_t *mtx) {
+    pthread_mutex_lock(&mtx->lock);
+}
+
+void mutex_exit(mutex_t *mtx) {
+    pthread_mutex_unlock(&mtx->lock);
+}
+
+void queue_init(queue_t *q, uint element_size, uint element_count) {
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->changed, NULL);
+    q->data = calloc(element_count, element_size);
+    q->element_size = element_size;
+    q->element_count = element_count;
+    q->rptr = 0;
+    q->level = 0;
+}
+
+void queue_free(queue_t *q) {
+    free(q->data);
+    q->data = NULL;
+    pthread_cond_destroy(&q->changed);
+    pthread_mutex_destroy(&q->lock);
+}
+
+uint queue_get_level(queue_t *q) {
+    pthread_mutex_lock(&q->lock);
+    uint level = q->level;
+    pthread_mutex_unlock(&q->lock);
+    return level;
+}
+
+bool queue_is_empty(queue_t *q) {
+    return queue_get_level(q) == 0;
+}
+
+bool queue_is_full(queue_t *q) {
+    return queue_get_level(q) == q->element_count;
+}
+
+static void _queue_put(queue_t *q, const void *data) {
+    uint wptr = (q->rptr + q->level) % q->element_count;
+    memcpy(q->data + wptr * q->element_size, data, q->element_size);
+    q->level++;
+    pthread_cond_broadcast(&q->changed);
+}
+
+static void _queue_take(queue_t *q, void *data, bool remove) {
+    memcpy(data, q->data + q->rptr * q->element_size, q->element_size);
+    if (remove) {
+        q->rptr = (q->rptr + 1) % q->element_count;
+        q->level--;
+        pthread_cond_broadcast(&q->changed);
+    }
+}
+
+bool queue_try_add(queue_t *q, const void *data) {
+    pthread_mutex_lock(&q->lock);
+    bool added = q->level < q->element_count;
+    if (added) {
+        _queue_put(q, data);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return added;
+}
+
+bool queue_try_remove(queue_t *q, void *data) {
+    pthread_mutex_lock(&q->lock);
+    bool removed = q->level > 0;
+    if (removed) {
+        _queue_take(q, data, true);
+    }
+    pthread_mutex_unlock(&q->lock);
+
+    // both cores poll their queues continuously; see pio_sm_put_blocking()
+    if (!removed) {
+        sched_yield();
+    }
+    return removed;
+}
+
+bool queue_try_peek(queue_t *q, void *data) {
+    pthread_mutex_lock(&q->lock);
+    bool peeked = q->level > 0;
+    if (peeked) {
+        _queue_take(q, data, false);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return peeked;
+}
+
+void queue_add_blocking(queue_t *q, const void *data) {
+    pthread_mutex_lock(&q->lock);
+    while (q->level == q->element_count) {
+        pthread_cond_wait(&q->changed, &q->lock);
+    }
+    _queue_put(q, data);
+    pthread_mutex_unlock(&q->lock);
+}
+
+void queue_remove_blocking(queue_t *q, void *data) {
+    pthread_mutex_lock(&q->lock);
+    while (q->level == 0) {
+        pthread_cond_wait(&q->changed, &q->lock);
+    }
+    _queue_take(q, data, true);
+    pthread_mutex_unlock(&q->lock);
+}
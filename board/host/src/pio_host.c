@@ -0,0 +1,225 @@
+#include <sched.h>
+
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+
+#include "adlc_model.h"
+#include "host.h"
+
+// as the command words built by adlc.c for pinctl.pio
+#define CMD_WRITE       0x100
+#define CMD_SNOOP_TAG   0x200
+
+#define DREQ_PIO0_RX0   4
+#define DMA_CHANNELS    2
+
+typedef struct {
+    bool                claimed;
+    bool                busy;
+    uint                dreq;
+    volatile uint32_t*  write_addr;
+    uint                transfers_left;
+} dma_channel_t;
+
+pio_hw_t host_pio0;
+
+static uint32_t _rx_fifo;
+static bool     _rx_ready;
+static bool     _snooping;
+static uint     _snoop_reg;
+static uint32_t _snoop_tag;
+static uint64_t _bus_cycle_ns;
+static uint64_t _last_cycle_ns;
+static host_pio_stats_t _stats;
+static dma_channel_t _dma[DMA_CHANNELS];
+
+static uint8_t _reverse(uint8_t n) {
+    static const uint8_t lookup[16] = {
+        0x0, 0x8, 0x4, 0xc, 0x2, 0xa, 0x6, 0xe,
+        0x1, 0x9, 0x5, 0xd, 0x3, 0xb, 0x7, 0xf
+    };
+    return (lookup[n & 0x0f] << 4) | lookup[n >> 4];
+}
+
+/*
+ * Sets the minimum time between bus cycles. On the board, each access waits for an edge of
+ * the 2MHz ADLC clock so polling loops cannot spin faster than this.
+ */
+void pio_host_set_bus_cycle_ns(uint64_t bus_cycle_ns) {
+    _bus_cycle_ns = bus_cycle_ns;
+}
+
+const host_pio_stats_t* pio_host_stats(void) {
+    return &_stats;
+}
+
+static uint _register(void) {
+    return (gpio_get(HOST_GPIO_BUFF_A0) ? 1 : 0) | (gpio_get(HOST_GPIO_BUFF_A1) ? 2 : 0);
+}
+
+// a read bus cycle, latching the JMP pin in IRQ 0 as pinctl.pio does
+static uint32_t _read(uint reg) {
+    uint32_t pins = _reverse(adlc_model_read(reg));
+    uint jmp_pin = (host_pio0.sm[0].execctrl & PIO_SM0_EXECCTRL_JMP_PIN_BITS) >> PIO_SM0_EXECCTRL_JMP_PIN_LSB;
+    if (jmp_pin >= HOST_GPIO_DATA_7 && (pins & (1u << (jmp_pin - HOST_GPIO_DATA_7)))) {
+        host_pio0.irq |= 1;
+    }
+    return pins;
+}
+
+// moves the RX FIFO word to memory if a DMA channel is waiting for it
+static void _dma_service(void) {
+    for (uint channel = 0; channel < DMA_CHANNELS; channel++) {
+        dma_channel_t* c = &_dma[channel];
+        if (!_rx_ready || !c->busy || c->dreq != DREQ_PIO0_RX0) {
+            continue;
+        }
+
+        *c->write_addr = _rx_fifo;
+        _rx_ready = false;
+        if (--c->transfers_left == 0) {
+            c->busy = false;
+        }
+    }
+}
+
+// makes the reads that a snooping state machine would have made since last time (at most one,
+// as only the latest value matters)
+static void _catch_up(void) {
+    if (_snooping) {
+        uint64_t now_ns = host_time_ns();
+        if (now_ns >= _last_cycle_ns + _bus_cycle_ns) {
+            _last_cycle_ns = now_ns;
+            _rx_fifo = _snoop_tag | _read(_snoop_reg);
+            _rx_ready = true;
+            _stats.snoop_reads++;
+        }
+    }
+    _dma_service();
+}
+
+int pio_claim_unused_sm(PIO pio, bool required) {
+    for (uint sm = 0; sm < 4; sm++) {
+        if (!(pio->claimed_sm_mask & (1u << sm))) {
+            pio->claimed_sm_mask |= 1u << sm;
+            return sm;
+        }
+    }
+    return -1;
+}
+
+uint pio_add_program(PIO pio, const pio_program_t *program) {
+    (void) pio;
+    (void) program;
+    return 0;
+}
+
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data) {
+    if (_bus_cycle_ns > 0) {
+        while (host_time_ns() < _last_cycle_ns + _bus_cycle_ns) {
+        }
+        _last_cycle_ns = host_time_ns();
+    }
+
+    // the firmware polls the ADLC continuously so give other threads a chance to run on
+    // hosts with fewer CPUs than the emulator and driver have busy threads
+    sched_yield();
+
+    _stats.transactions++;
+    _snooping = false;
+
+    uint reg = _register();
+    if (data & CMD_WRITE) {
+        adlc_model_write(reg, _reverse(data & 0xff));
+        _rx_fifo = data & 0xff;
+    } else if (data & 0xff) {
+        _snooping = true;
+        _snoop_reg = reg;
+        _snoop_tag = (data & CMD_SNOOP_TAG) ? 0x100 : 0;
+        _rx_fifo = _snoop_tag | _read(reg);
+        _stats.snoop_reads++;
+    } else {
+        _rx_fifo = _read(reg);
+    }
+    _rx_ready = true;
+    _dma_service();
+}
+
+uint32_t pio_sm_get_blocking(PIO pio, uint sm) {
+    _rx_ready = false;
+    return _rx_fifo;
+}
+
+// bus cycles complete within pio_sm_put_blocking, so the result is always waiting
+bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm) {
+    return !_rx_ready;
+}
+
+uint32_t pio_sm_get(PIO pio, uint sm) {
+    return pio_sm_get_blocking(pio, sm);
+}
+
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx) {
+    return is_tx ? sm : DREQ_PIO0_RX0 + sm;
+}
+
+bool pio_interrupt_get(PIO pio, uint pio_interrupt_num) {
+    _catch_up();
+    return pio->irq & (1u << pio_interrupt_num);
+}
+
+void pio_interrupt_clear(PIO pio, uint pio_interrupt_num) {
+    pio->irq &= ~(1u << pio_interrupt_num);
+}
+
+void tight_loop_contents(void) {
+    _catch_up();
+
+    // as in pio_sm_put_blocking, don't starve other threads whilst the firmware spins
+    sched_yield();
+}
+
+int dma_claim_unused_channel(bool required) {
+    for (uint channel = 0; channel < DMA_CHANNELS; channel++) {
+        if (!_dma[channel].claimed) {
+            _dma[channel].claimed = true;
+            return channel;
+        }
+    }
+    return -1;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel) {
+    dma_channel_config config = { .dreq = 0x3f };
+    return config;
+}
+
+void dma_channel_configure(
+        uint channel,
+        const dma_channel_config *config,
+        volatile void *write_addr,
+        const volatile void *read_addr,
+        uint transfer_count,
+        bool trigger) {
+    dma_channel_t* c = &_dma[channel];
+    c->dreq = config->dreq;
+    c->write_addr = write_addr;
+    c->transfers_left = transfer_count;
+    c->busy = trigger && transfer_count > 0;
+}
+
+bool dma_channel_is_busy(uint channel) {
+    return _dma[channel].busy;
+}
+
+void dma_channel_abort(uint channel) {
+    _dma[channel].busy = false;
+}
+
+void host_gpio_changed(uint gpio, bool value) {
+    if (gpio == HOST_GPIO_BUFF_nRST) {
+        adlc_model_set_reset(!value);
+    }
+}
@@ -0,0 +1,278 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "pico/stdlib.h"
+#include "tusb.h"
+
+#include "usb_io.h"
+
+#include "host.h"
+
+// the CDC interfaces, then the vendor interface
+#define PORT_VENDOR     CFG_TUD_CDC
+#define PORT_COUNT      (CFG_TUD_CDC + CFG_TUD_VENDOR)
+
+typedef struct {
+    int         fd;                 // -1 if the interface isn't attached
+    uint8_t     tx_fifo[CFG_TUD_VENDOR_TX_BUFSIZE];
+    size_t      tx_size;            // as CFG_TUD_xxx_TX_BUFSIZE
+    size_t      tx_packet;          // as CFG_TUD_xxx_EP_BUFSIZE
+    size_t      rx_size;            // as CFG_TUD_xxx_RX_BUFSIZE
+    size_t      tx_len;
+    bool        tx_flushing;        // sending until the FIFO is empty, as a USB transfer would
+    bool        opened;             // last seen open by a client (vendor interface only)
+} port_host_t;
+
+static port_host_t _port[PORT_COUNT] = {
+    [0 ... CFG_TUD_CDC - 1] = {
+        .fd = -1,
+        .tx_size = CFG_TUD_CDC_TX_BUFSIZE,
+        .tx_packet = CFG_TUD_CDC_EP_BUFSIZE,
+        .rx_size = CFG_TUD_CDC_RX_BUFSIZE
+    },
+    [PORT_VENDOR] = {
+        .fd = -1,
+        .tx_size = CFG_TUD_VENDOR_TX_BUFSIZE,
+        .tx_packet = CFG_TUD_VENDOR_EPSIZE,
+        .rx_size = CFG_TUD_VENDOR_RX_BUFSIZE
+    }
+};
+
+// input arriving on the first CDC interface or the vendor interface raises the "USB interrupt"
+// once, as a packet arriving does, then not again until core 0 has drained the input
+static pthread_mutex_t  _rx_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   _rx_drained = PTHREAD_COND_INITIALIZER;
+static bool             _rx_armed = true;
+static volatile bool    _rx_pending[PORT_COUNT];
+
+static stdio_driver_t   *_stdio_driver;
+
+static void _attach(port_host_t *port, int fd) {
+    port->fd = fd;
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+void host_usb_attach(uint8_t itf, int fd) {
+    _attach(&_port[itf], fd);
+}
+
+void host_usb_attach_vendor(int fd) {
+    _attach(&_port[PORT_VENDOR], fd);
+}
+
+// Whether a client has a pseudo-terminal open, the slave not having been held open
+static bool _client_open(const port_host_t *port) {
+    if (port->fd < 0) {
+        return false;
+    }
+
+    struct pollfd pfd = { .fd = port->fd, .events = POLLOUT };
+    return poll(&pfd, 1, 0) >= 0 && (pfd.revents & POLLHUP) == 0;
+}
+
+static void _rx_arm(void) {
+    pthread_mutex_lock(&_rx_lock);
+    _rx_armed = true;
+    pthread_cond_signal(&_rx_drained);
+    pthread_mutex_unlock(&_rx_lock);
+}
+
+static void* _rx_thread(void* arg) {
+    (void) arg;
+
+    while (true) {
+        pthread_mutex_lock(&_rx_lock);
+        while (!_rx_armed) {
+            pthread_cond_wait(&_rx_drained, &_rx_lock);
+        }
+        _rx_armed = false;
+        pthread_mutex_unlock(&_rx_lock);
+
+        // the vendor interface is only watched whilst a client has it open, as otherwise it
+        // reports a hang up continually; a client opening it is noticed within 10ms
+        while (true) {
+            struct pollfd pfds[2] = {
+                { .fd = _port[0].fd, .events = POLLIN },
+                { .fd = _client_open(&_port[PORT_VENDOR]) ? _port[PORT_VENDOR].fd : -1, .events = POLLIN }
+            };
+            if (poll(pfds, 2, _port[PORT_VENDOR].fd >= 0 ? 10 : -1) > 0 && ((pfds[0].revents | pfds[1].revents) & POLLIN) != 0) {
+                host_irq_enter();
+                _rx_pending[0] = (pfds[0].revents & POLLIN) != 0;
+                _rx_pending[PORT_VENDOR] = (pfds[1].revents & POLLIN) != 0;
+                host_irq_exit();
+                break;
+            }
+        }
+    }
+    return NULL;
+}
+
+bool tusb_init(void) {
+    pthread_t thread;
+    if (_port[0].fd < 0 || pthread_create(&thread, NULL, _rx_thread, NULL) != 0) {
+        return false;
+    }
+    pthread_detach(thread);
+    return true;
+}
+
+static void _send(port_host_t *port) {
+    ssize_t written = write(port->fd, port->tx_fifo, port->tx_len);
+    if (written < 0 && errno != EAGAIN && errno != EINTR) {
+        // the pseudo-terminal has gone, as though the cable were pulled
+        written = port->tx_len;
+    }
+    if (written > 0) {
+        memmove(port->tx_fifo, port->tx_fifo + written, port->tx_len - written);
+        port->tx_len -= written;
+    }
+    port->tx_flushing = (port->tx_len > 0);
+}
+
+void tud_task(void) {
+    for (uint8_t i = 0; i < PORT_COUNT; i++) {
+        if (_port[i].tx_flushing) {
+            _send(&_port[i]);
+        }
+    }
+
+    // a client opening or closing the vendor interface's pseudo-terminal stands in for the
+    // host's vendor request to open or close it
+    port_host_t *vendor = &_port[PORT_VENDOR];
+    bool opened = _client_open(vendor);
+    if (opened != vendor->opened) {
+        vendor->opened = opened;
+        if (!opened) {
+            // anything the client didn't read goes with the pseudo-terminal
+            vendor->tx_len = 0;
+            vendor->tx_flushing = false;
+        }
+        usb_set_bulk_open(opened);
+    }
+
+    if (_rx_pending[0]) {
+        _rx_pending[0] = false;
+        tud_cdc_rx_cb(0);
+    }
+    if (_rx_pending[PORT_VENDOR]) {
+        _rx_pending[PORT_VENDOR] = false;
+        tud_vendor_rx_cb(0, NULL, 0);
+    }
+}
+
+// As DTR: the first interface is always open, its pseudo-terminal being held open by the
+// emulator, whereas any other counts as open whilst a client has it open.
+bool tud_cdc_n_connected(uint8_t itf) {
+    if (_port[itf].fd < 0) {
+        return false;
+    }
+    return (itf == 0) || _client_open(&_port[itf]);
+}
+
+static uint32_t _read(port_host_t *port, void *buffer, uint32_t bufsize) {
+    if (port->fd < 0) {
+        return 0;
+    }
+
+    // the most a single read from the RX FIFO can return
+    ssize_t count = read(port->fd, buffer, bufsize < port->rx_size ? bufsize : port->rx_size);
+    if (count <= 0) {
+        _rx_arm();
+        return 0;
+    }
+    return count;
+}
+
+static uint32_t _write_flush(port_host_t *port) {
+    size_t before = port->tx_len;
+    if (port->fd >= 0 && port->tx_len > 0) {
+        _send(port);
+    }
+    return before - port->tx_len;
+}
+
+static uint32_t _write(port_host_t *port, const void *buffer, uint32_t bufsize) {
+    if (port->fd < 0) {
+        return 0;
+    }
+
+    uint32_t count = port->tx_size - port->tx_len;
+    if (count > bufsize) {
+        count = bufsize;
+    }
+    memcpy(port->tx_fifo + port->tx_len, buffer, count);
+    port->tx_len += count;
+
+    // as TinyUSB, a packet's worth goes out without waiting for a flush
+    if (port->tx_len >= port->tx_packet) {
+        _write_flush(port);
+    }
+    return count;
+}
+
+uint32_t tud_cdc_n_read(uint8_t itf, void *buffer, uint32_t bufsize) {
+    return _read(&_port[itf], buffer, bufsize);
+}
+
+void tud_cdc_n_read_flush(uint8_t itf) {
+}
+
+uint32_t tud_cdc_n_write(uint8_t itf, const void *buffer, uint32_t bufsize) {
+    return _write(&_port[itf], buffer, bufsize);
+}
+
+uint32_t tud_cdc_n_write_flush(uint8_t itf) {
+    return _write_flush(&_port[itf]);
+}
+
+uint32_t tud_cdc_n_write_available(uint8_t itf) {
+    return _port[itf].tx_size - _port[itf].tx_len;
+}
+
+uint32_t tud_vendor_n_read(uint8_t itf, void *buffer, uint32_t bufsize) {
+    return _read(&_port[PORT_VENDOR + itf], buffer, bufsize);
+}
+
+uint32_t tud_vendor_n_write(uint8_t itf, const void *buffer, uint32_t bufsize) {
+    return _write(&_port[PORT_VENDOR + itf], buffer, bufsize);
+}
+
+uint32_t tud_vendor_n_write_flush(uint8_t itf) {
+    return _write_flush(&_port[PORT_VENDOR + itf]);
+}
+
+uint32_t tud_vendor_n_write_available(uint8_t itf) {
+    port_host_t *port = &_port[PORT_VENDOR + itf];
+    return port->tx_size - port->tx_len;
+}
+
+static ssize_t _stdout_write(void *cookie, const char *buf, size_t size) {
+    (void) cookie;
+
+    if (_stdio_driver != NULL) {
+        _stdio_driver->out_chars(buf, size);
+    }
+    return size;
+}
+
+void stdio_set_driver_enabled(stdio_driver_t *driver, bool enabled) {
+    static bool attached;
+
+    _stdio_driver = enabled ? driver : NULL;
+    if (!attached) {
+        cookie_io_functions_t functions = { .write = _stdout_write };
+        FILE *out = fopencookie(NULL, "w", functions);
+        if (out != NULL) {
+            setvbuf(out, NULL, _IOLBF, 0);
+            stdout = out;
+            attached = true;
+        }
+    }
+}
@@ -4,6 +4,7 @@
 #include "pico/multicore.h"
 #include "hardware/gpio.h"
 #include "hardware/pio.h"
+#include "hardware/dma.h"
 #include "hardware/clocks.h"
 #include "pinctl.pio.h"
 #include "util.h"
@@ -30,9 +31,33 @@ const uint GPIO_BUFF_nRST = 22;
 
 const uint CMD_READ = 0x000;
 const uint CMD_WRITE = 0x100;
+const uint CMD_SNOOP = 0x201;   // read repeatedly, tagging each value, until the next command
+
+#define SNOOP_TAG       0x100   // marks values read by snooping in the RX FIFO
+#define SNOOP_NONE      -1
+
+// The MC6854 needs nRST held low for only a few of its clock cycles (1us at 2MHz); these leave
+// a wide margin. Power-on reset is held for longer, whilst supplies and the clock settle.
+#define RESET_HOLD_US           10
+#define RESET_RELEASE_US        10
+#define POWER_ON_RESET_MS       100
 
 static PIO pio;
 static uint sm;
+static uint snoop_dma_channel;
+static dma_channel_config snoop_dma_config;
+static int snoop_reg = SNOOP_NONE;
+static uint snoop_latch_bit;
+static volatile uint32_t snoop_value;
+static bool flag_fill_active;
+
+// bus transaction trace, written by the core running the Econet protocol
+static adlc_trace_entry_t trace_ring[ADLC_TRACE_SZ];
+static volatile bool trace_enabled;
+static uint32_t trace_recorded;
+static adlc_trace_phase_t trace_phase;
+static uint32_t bus_cycles;
+static adlc_recovery_stats_t recovery_stats;
 
 static unsigned char lookup[16] = {
     0x0, 0x8, 0x4, 0xc, 0x2, 0xa, 0x6, 0xe,
@@ -43,24 +68,160 @@ static uint8_t reverse(uint8_t n) {
    return (lookup[n&0b1111] << 4) | lookup[n>>4];
 }
 
+static inline void trace_record(uint op, uint reg, uint value, uint32_t wait, uint32_t time_us) {
+    adlc_trace_entry_t* entry = &trace_ring[trace_recorded++ & (ADLC_TRACE_SZ - 1)];
+    entry->time_us = time_us;
+    entry->op_reg = (op << 2) | (reg & 0x03);
+    entry->value = value;
+    entry->wait = (wait > 0xffff) ? 0xffff : wait;
+}
+
+// performs a bus cycle, recording it if tracing (outside the idle phase, whose polling would
+// soon fill the ring)
+static inline uint32_t bus_cycle(uint32_t command, uint reg) {
+    bus_cycles++;
+    if (!trace_enabled || trace_phase == ADLC_TRACE_PHASE_IDLE) {
+        pio_sm_put_blocking(pio, sm, command);
+        return pio_sm_get_blocking(pio, sm);
+    }
+
+    uint32_t time_us = time_us_32();
+    pio_sm_put_blocking(pio, sm, command);
+    uint32_t wait = 0;
+    while (pio_sm_is_rx_fifo_empty(pio, sm)) {
+        wait++;
+    }
+    uint32_t result = pio_sm_get(pio, sm);
+
+    trace_record(
+        (command & CMD_WRITE) ? ADLC_TRACE_OP_WRITE : ADLC_TRACE_OP_READ,
+        reg,
+        reverse((command & CMD_WRITE) ? command : result),
+        wait,
+        time_us);
+    return result;
+}
+
 uint adlc_read(uint reg) {
+    adlc_snoop_stop();
+
     gpio_put(GPIO_BUFF_A0, reg & 0x01);
     gpio_put(GPIO_BUFF_A1, reg & 0x02);
 
-    pio_sm_put_blocking(pio, sm, CMD_READ);
-    uint result = pio_sm_get_blocking(pio, sm);
+    uint result = bus_cycle(CMD_READ, reg);
 
     // note that pin bit order is reversed for board layout reasons
     return reverse(result);
 }
 
 void adlc_write(uint reg, uint data_val) {
+    adlc_snoop_stop();
+
     gpio_put(GPIO_BUFF_A0, reg & 0x01);
     gpio_put(GPIO_BUFF_A1, reg & 0x02);
 
     // note that pin bit order is reversed for board layout reasons
-    pio_sm_put_blocking(pio, sm, CMD_WRITE | reverse(data_val));
-    pio_sm_get_blocking(pio, sm);
+    bus_cycle(CMD_WRITE | reverse(data_val), reg);
+}
+
+/*
+ * Starts the PIO reading the specified status register on every ADLC clock cycle until the next
+ * command, with DMA copying each value to RAM. Waiting for a status bit then costs a memory read
+ * rather than a bus round trip per poll.
+ *
+ * As the latest value may be overwritten before it is seen, the PIO also latches whether bit
+ * `latch_bit` (e.g. `STATUS_1_FRAME_COMPLETE`) has been set (see adlc_snoop_latched).
+ *
+ * Does nothing if already snooping the same register and bit, so it's cheap to call in a loop.
+ * Snooping stops automatically on the next call to adlc_read/adlc_write.
+ */
+void adlc_snoop_start(uint reg, uint latch_bit) {
+    if (snoop_reg == (int) reg && snoop_latch_bit == latch_bit) {
+        if (dma_channel_is_busy(snoop_dma_channel)) {
+            return;
+        }
+        // DMA transfer count exhausted (after half an hour or so): restart
+    }
+    adlc_snoop_stop();
+
+    gpio_put(GPIO_BUFF_A0, reg & 0x01);
+    gpio_put(GPIO_BUFF_A1, reg & 0x02);
+
+    // data pin order is reversed, as for the values read
+    uint bit_index = 0;
+    while (bit_index < 7 && !(latch_bit & (1u << bit_index))) {
+        bit_index++;
+    }
+    pinctl_set_latch_pin(pio, sm, GPIO_DATA_0 - bit_index);
+    pio_interrupt_clear(pio, 0);
+
+    snoop_value = SNOOP_TAG;   // tagged, so not mistaken for the result of an ordinary read
+    dma_channel_configure(
+        snoop_dma_channel,
+        &snoop_dma_config,
+        &snoop_value,
+        &pio->rxf[sm],
+        0xffffffff,
+        true);
+
+    pio_sm_put_blocking(pio, sm, CMD_SNOOP);
+    snoop_reg = reg;
+    snoop_latch_bit = latch_bit;
+
+    if (trace_enabled && trace_phase != ADLC_TRACE_PHASE_IDLE) {
+        trace_record(ADLC_TRACE_OP_SNOOP, reg, latch_bit, 0, time_us_32());
+    }
+}
+
+/*
+ * Returns the latest value of the register being snooped, or 0 if none has been read yet.
+ */
+uint adlc_snoop_read(void) {
+    return reverse(snoop_value & 0xff);
+}
+
+/*
+ * Determines whether the latch bit has been seen set since snooping started.
+ */
+bool adlc_snoop_latched(void) {
+    return pio_interrupt_get(pio, 0);
+}
+
+/*
+ * Stops snooping, leaving the bus free for other commands. Returns a final value of the snooped
+ * register, read after any returned by adlc_snoop_read, or 0 if not snooping.
+ */
+uint adlc_snoop_stop(void) {
+    if (snoop_reg == SNOOP_NONE) {
+        return 0;
+    }
+    uint reg = snoop_reg;
+    snoop_reg = SNOOP_NONE;
+
+    // an ordinary read of the same register ends the snoop loop, after which the address lines
+    // may change; DMA keeps the RX FIFO drained (so no value is dropped) until its untagged
+    // result arrives
+    uint32_t time_us = time_us_32();
+    pio_sm_put_blocking(pio, sm, CMD_READ);
+    uint32_t result;
+    uint32_t wait = 0;
+    if (dma_channel_is_busy(snoop_dma_channel)) {
+        while ((result = snoop_value) & SNOOP_TAG) {
+            tight_loop_contents();
+            wait++;
+        }
+        dma_channel_abort(snoop_dma_channel);
+    } else {
+        do {
+            result = pio_sm_get_blocking(pio, sm);
+        } while (result & SNOOP_TAG);
+    }
+
+    if (trace_enabled && trace_phase != ADLC_TRACE_PHASE_IDLE) {
+        trace_record(ADLC_TRACE_OP_READ, reg, reverse(result), wait, time_us);
+    }
+
+    return reverse(result);
 }
 
 void adlc_write_cr1(uint data_val) {
@@ -70,6 +231,7 @@ void adlc_write_cr1(uint data_val) {
 void adlc_write_cr2(uint data_val) {
     adlc_write(0, 0b00000000); // Select CR2
     adlc_write(1, data_val);
+    flag_fill_active = (data_val & CR2_FLAG_FILL) != 0;
 }
 
 void adlc_write_cr3(uint data_val) {
@@ -86,11 +248,75 @@ void adlc_write_fifo(uint data_val) {
     adlc_write(REG_FIFO, data_val);
 }
 
+/*
+ * Pulses nRST, leaving every register as the datasheet describes after reset (CR2-CR4 cleared,
+ * transmitter and receiver held reset). See adlc_recover to reset and reprogram.
+ */
 void adlc_reset(void) {
-  gpio_put(GPIO_BUFF_nRST, 0);
-  sleep_ms(100);
-  gpio_put(GPIO_BUFF_nRST, 1);
-  sleep_ms(100);
+    adlc_snoop_stop();
+    gpio_put(GPIO_BUFF_nRST, 0);
+    sleep_us(RESET_HOLD_US);
+    gpio_put(GPIO_BUFF_nRST, 1);
+    sleep_us(RESET_RELEASE_US);
+    flag_fill_active = false;
+}
+
+static void program_registers(void) {
+    adlc_write_cr3(0);
+    adlc_write_cr4(CR4_TX_WORD_LEN_1 | CR4_TX_WORD_LEN_2 | CR4_RX_WORD_LEN_1 | CR4_RX_WORD_LEN_2);
+}
+
+// Whether the ADLC looks ready for use: no transmitter underrun or receiver overrun left
+// latched and not in loop mode (e.g. after a benchmark was cut short)
+static bool is_healthy(void) {
+    uint sr1 = adlc_read(REG_STATUS_1);
+    uint sr2 = adlc_read(REG_STATUS_2);
+    return !(sr1 & (STATUS_1_TX_UNDERRUN | STATUS_1_LOOP)) && !(sr2 & STATUS_2_RX_OVERRUN);
+}
+
+static bool recover_tier(adlc_recovery_tier_t tier) {
+    adlc_recovery_tier_stats_t* stats = &recovery_stats.tiers[tier - ADLC_RECOVERY_SOFT];
+    uint32_t start_us = time_us_32();
+
+    if (tier == ADLC_RECOVERY_HARD) {
+        adlc_reset();
+    }
+    adlc_write_cr1(CR1_TX_RESET | CR1_RX_RESET);
+    if (tier != ADLC_RECOVERY_SOFT) {
+        program_registers();
+    }
+    adlc_irq_reset();
+    bool healthy = is_healthy();
+
+    uint32_t elapsed_us = time_us_32() - start_us;
+    stats->attempts++;
+    stats->last_us = elapsed_us;
+    if (elapsed_us > stats->max_us) {
+        stats->max_us = elapsed_us;
+    }
+    if (healthy) {
+        stats->successes++;
+    }
+    return healthy;
+}
+
+/*
+ * Brings the ADLC back to its idle, listening state, starting with `first_tier` and escalating
+ * until it looks healthy: a CR1 reset of the transmitter and receiver takes a few bus cycles,
+ * rewriting CR3 and CR4 a few more, and only if those fail is nRST pulsed. Any frame in
+ * progress is lost. Returns the tier that succeeded, or ADLC_RECOVERY_FAILED.
+ */
+adlc_recovery_tier_t adlc_recover(adlc_recovery_tier_t first_tier) {
+    adlc_recovery_tier_t tier = (first_tier < ADLC_RECOVERY_SOFT) ? ADLC_RECOVERY_SOFT : first_tier;
+    while (tier <= ADLC_RECOVERY_HARD && !recover_tier(tier)) {
+        tier++;
+    }
+    recovery_stats.last = tier;
+    return tier;
+}
+
+const adlc_recovery_stats_t* adlc_recovery_stats(void) {
+    return &recovery_stats;
 }
 
 void adlc_init(void) {
@@ -115,7 +341,9 @@ void adlc_init(void) {
     gpio_put(PICO_DEFAULT_LED_PIN, 1);
     gpio_put(GPIO_DATA_LED, 0);
 
-    adlc_reset();
+    gpio_put(GPIO_BUFF_nRST, 0);
+    sleep_ms(POWER_ON_RESET_MS);
+    gpio_put(GPIO_BUFF_nRST, 1);
 
     // todo get free sm
     pio = pio0;
@@ -126,19 +354,88 @@ void adlc_init(void) {
 	// => can sample upto 16 points in each of low and high clock states
     pinctl_program_init(pio, sm, offset, GPIO_DATA_7, GPIO_BUFF_CS, 64000000);
 
+    // snooped status register values are copied from the RX FIFO to RAM, overwriting the last
+    snoop_dma_channel = dma_claim_unused_channel(true);
+    snoop_dma_config = dma_channel_get_default_config(snoop_dma_channel);
+    channel_config_set_transfer_data_size(&snoop_dma_config, DMA_SIZE_32);
+    channel_config_set_read_increment(&snoop_dma_config, false);
+    channel_config_set_write_increment(&snoop_dma_config, false);
+    channel_config_set_dreq(&snoop_dma_config, pio_get_dreq(pio, sm, false));
+
     // Init Control Register 1 (CR1)
     adlc_write_cr1(CR1_TX_RESET | CR1_RX_RESET);
-    adlc_write_cr3(0);
-    adlc_write_cr4(CR4_TX_WORD_LEN_1 | CR4_TX_WORD_LEN_2 | CR4_RX_WORD_LEN_1 | CR4_RX_WORD_LEN_2);
+    program_registers();
 }
 
 void adlc_irq_reset(void) {
   adlc_write_cr1(CR1_RIE);
   adlc_write(1, CR2_CLEAR_TX_STATUS | CR2_CLEAR_RX_STATUS | CR2_PRIO_STATUS_ENABLE);
+  flag_fill_active = false;
 }
 
 void adlc_flag_fill(void) {
   adlc_write(REG_CONTROL_2, 0b11100100); // Set CR2 to RTS, TX Status Clear, RX Status clear, Flag fill on idle)
+  flag_fill_active = true;
+}
+
+bool adlc_flag_fill_active(void) {
+    return flag_fill_active;
+}
+
+/*
+ * Starts or stops recording bus transactions in the trace ring. Entries already recorded are
+ * kept, so tracing may be paused whilst they are read by another core (although a transaction
+ * in progress as tracing stops may still be recorded).
+ */
+void adlc_trace_enable(bool enabled) {
+    trace_enabled = enabled;
+}
+
+bool adlc_trace_enabled(void) {
+    return trace_enabled;
+}
+
+void adlc_trace_clear(void) {
+    trace_recorded = 0;
+}
+
+/*
+ * Marks the start of a stage of protocol handling in the trace. Nothing is recorded if the
+ * phase is unchanged, so this is cheap to call from polling loops.
+ */
+void adlc_trace_phase(adlc_trace_phase_t phase) {
+    if (phase == trace_phase) {
+        return;
+    }
+    trace_phase = phase;
+
+    if (trace_enabled) {
+        trace_record(ADLC_TRACE_OP_PHASE, 0, phase, 0, time_us_32());
+    }
+}
+
+/*
+ * Returns the number of entries recorded since the trace was cleared, including any which have
+ * since been overwritten.
+ */
+uint32_t adlc_trace_recorded(void) {
+    return trace_recorded;
+}
+
+/*
+ * Returns the entry with sequence number `seq`, which should be one of the last ADLC_TRACE_SZ
+ * recorded.
+ */
+const adlc_trace_entry_t* adlc_trace_entry(uint32_t seq) {
+    return &trace_ring[seq & (ADLC_TRACE_SZ - 1)];
+}
+
+/*
+ * Returns the number of bus transactions requested by the CPU (i.e. excluding snooped status
+ * reads), wrapping at 2^32.
+ */
+uint32_t adlc_bus_cycles(void) {
+    return bus_cycles;
 }
 
 void adlc_update_data_led(bool is_on) {
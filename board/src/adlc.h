@@ -63,8 +63,64 @@
 #define CR4_ABORT_EXTEND          64
 #define CR4_NRZI_NRZ              128
 
+// Entries held by the bus transaction trace (a power of two)
+#define ADLC_TRACE_SZ             1024
+
+#define ADLC_TRACE_OP_READ        0
+#define ADLC_TRACE_OP_WRITE       1
+#define ADLC_TRACE_OP_SNOOP       2     // snooping started; value is the latch bit
+#define ADLC_TRACE_OP_PHASE       3     // protocol phase started; value is adlc_trace_phase_t
+
+// Stages of Econet protocol handling, marked in the trace so that its bus transactions may be
+// attributed to them
+typedef enum {
+    ADLC_TRACE_PHASE_IDLE = 0L,         // bus transactions not recorded
+    ADLC_TRACE_PHASE_TX_SCOUT,
+    ADLC_TRACE_PHASE_TX_SCOUT_ACK,
+    ADLC_TRACE_PHASE_TX_DATA,
+    ADLC_TRACE_PHASE_TX_DATA_ACK,
+    ADLC_TRACE_PHASE_TX_BROADCAST,
+    ADLC_TRACE_PHASE_RX_SCOUT,
+    ADLC_TRACE_PHASE_RX_SCOUT_ACK,
+    ADLC_TRACE_PHASE_RX_DATA,
+    ADLC_TRACE_PHASE_RX_DATA_ACK,
+    ADLC_TRACE_PHASE_MONITOR
+} adlc_trace_phase_t;
+
+// Ways of bringing the ADLC back to a working state, cheapest first (see adlc_recover)
+typedef enum {
+    ADLC_RECOVERY_NONE = 0L,            // not needed
+    ADLC_RECOVERY_SOFT,                 // transmitter and receiver reset through CR1
+    ADLC_RECOVERY_REPROGRAM,            // as soft, then CR3 and CR4 written again
+    ADLC_RECOVERY_HARD,                 // nRST pulsed, then all registers written again
+    ADLC_RECOVERY_FAILED                // still unhealthy after a hard reset
+} adlc_recovery_tier_t;
+
+#define ADLC_RECOVERY_TIER_COUNT  3     // soft, reprogram and hard
+
+typedef struct {
+    uint32_t    attempts;
+    uint32_t    successes;              // attempts after which the ADLC was healthy
+    uint32_t    last_us;                // time taken by the latest attempt
+    uint32_t    max_us;
+} adlc_recovery_tier_stats_t;
+
+typedef struct {
+    adlc_recovery_tier_t        last;   // tier at which the latest recovery succeeded
+    adlc_recovery_tier_stats_t  tiers[ADLC_RECOVERY_TIER_COUNT];    // indexed by tier - 1
+} adlc_recovery_stats_t;
+
+typedef struct {
+    uint32_t    time_us;
+    uint8_t     op_reg;     // ADLC_TRACE_OP_xxx in bits 2-3, register in bits 0-1
+    uint8_t     value;
+    uint16_t    wait;       // polls of the PIO RX FIFO (or snooped value) before the result arrived
+} adlc_trace_entry_t;
+
 void adlc_init(void);
 void adlc_reset(void);
+adlc_recovery_tier_t adlc_recover(adlc_recovery_tier_t first_tier);
+const adlc_recovery_stats_t* adlc_recovery_stats(void);
 uint adlc_read(uint reg);
 void adlc_write(uint reg, uint data_val);
 void adlc_write_cr1(uint data_val);
@@ -72,8 +128,20 @@ void adlc_write_cr2(uint data_val);
 void adlc_write_cr3(uint data_val);
 void adlc_write_cr4(uint data_val);
 void adlc_write_fifo(uint data_val);
+void adlc_snoop_start(uint reg, uint latch_bit);
+uint adlc_snoop_read(void);
+bool adlc_snoop_latched(void);
+uint adlc_snoop_stop(void);
 void adlc_irq_reset(void);
 void adlc_flag_fill(void);
+bool adlc_flag_fill_active(void);
+void adlc_trace_enable(bool enabled);
+bool adlc_trace_enabled(void);
+void adlc_trace_clear(void);
+void adlc_trace_phase(adlc_trace_phase_t phase);
+uint32_t adlc_trace_recorded(void);
+const adlc_trace_entry_t* adlc_trace_entry(uint32_t seq);
+uint32_t adlc_bus_cycles(void);
 void adlc_update_data_led(bool new_activity);
 
 #endif
@@ -0,0 +1,230 @@
+#include "base64.h"
+
+#define PAD         0xfe
+#define INVALID     0xff
+
+static inline char*     _encode_group(char* output, uint32_t group);
+static inline uint8_t*  _decode_group(uint8_t* output, uint32_t quantum);
+
+// Both tables are read once per character, so they're kept in RAM along with the functions
+// using them rather than being fetched through the flash cache
+static const char __not_in_flash("base64") _alphabet[64] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// sextet value of each character, PAD for '=' and INVALID for anything else
+static const uint8_t __not_in_flash("base64") _sextets[256] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x3e, 0xff, 0xff, 0xff, 0x3f,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0xff, 0xff, 0xff, 0xfe, 0xff, 0xff,
+    0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+    0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+void base64_encoder_init(base64_encoder_t* encoder) {
+    encoder->pending_len = 0;
+}
+
+// Appends the characters for all of the whole groups made up by the bytes held over from the
+// last call and those given, holding over any remainder. Fails, writing nothing, if they won't
+// fit in the output buffer.
+bool __not_in_flash_func(base64_encode_update)(
+        base64_encoder_t* encoder,
+        const uint8_t* input,
+        size_t len,
+        char* output,
+        size_t capacity,
+        size_t* output_len) {
+    size_t groups = (encoder->pending_len + len) / 3;
+    if (*output_len > capacity || groups > (capacity - *output_len) / 4) {
+        return false;
+    }
+
+    char* o = output + *output_len;
+    size_t i = 0;
+    if (encoder->pending_len > 0) {
+        if (groups == 0) {
+            while (i < len) {
+                encoder->pending[encoder->pending_len++] = input[i++];
+            }
+            return true;
+        }
+
+        uint32_t group = encoder->pending[0] << 16;
+        if (encoder->pending_len == 2) {
+            group |= encoder->pending[1] << 8;
+        } else {
+            group |= input[i++] << 8;
+        }
+        group |= input[i++];
+        o = _encode_group(o, group);
+        encoder->pending_len = 0;
+    }
+
+    for (; i + 3 <= len; i += 3) {
+        o = _encode_group(o, (input[i] << 16) | (input[i + 1] << 8) | input[i + 2]);
+    }
+    while (i < len) {
+        encoder->pending[encoder->pending_len++] = input[i++];
+    }
+
+    *output_len = o - output;
+    return true;
+}
+
+// Appends the final, padded group (if any) and a terminator, which isn't counted in output_len
+bool base64_encode_final(base64_encoder_t* encoder, char* output, size_t capacity, size_t* output_len) {
+    size_t needed = (encoder->pending_len > 0) ? 5 : 1;
+    if (*output_len > capacity || needed > capacity - *output_len) {
+        return false;
+    }
+
+    char* o = output + *output_len;
+    if (encoder->pending_len > 0) {
+        uint32_t group = encoder->pending[0] << 16;
+        if (encoder->pending_len == 2) {
+            group |= encoder->pending[1] << 8;
+        }
+        _encode_group(o, group);
+        o[3] = '=';
+        if (encoder->pending_len == 1) {
+            o[2] = '=';
+        }
+        o += 4;
+        encoder->pending_len = 0;
+    }
+    *o = 0;
+
+    *output_len = o - output;
+    return true;
+}
+
+// Encodes a whole buffer as a terminated string
+bool base64_encode(const uint8_t* input, size_t len, char* output, size_t capacity) {
+    base64_encoder_t encoder;
+    size_t output_len = 0;
+
+    base64_encoder_init(&encoder);
+    return base64_encode_update(&encoder, input, len, output, capacity, &output_len)
+        && base64_encode_final(&encoder, output, capacity, &output_len);
+}
+
+void base64_decoder_init(base64_decoder_t* decoder) {
+    decoder->quantum = 0;
+    decoder->sextets = 0;
+    decoder->padding = 0;
+}
+
+// Appends the bytes carried by the characters given to the output, adding to output_len. Fails
+// on a character outside the base64 alphabet, misplaced padding or the output buffer filling up.
+bool __not_in_flash_func(base64_decode_update)(
+        base64_decoder_t* decoder,
+        const uint8_t* input,
+        size_t len,
+        uint8_t* output,
+        size_t capacity,
+        size_t* output_len) {
+    if (*output_len > capacity) {
+        return false;
+    }
+
+    uint8_t* o = output + *output_len;
+    uint8_t* const end = output + capacity;
+    size_t i = 0;
+    while (i < len) {
+        if (decoder->sextets == 0 && decoder->padding == 0) {
+            // whole groups of 4 valid characters, with one check covering all of them; anything
+            // else (padding, an error or a full buffer) is left to the character by character path
+            while (len - i >= 4 && end - o >= 3) {
+                uint32_t a = _sextets[input[i]];
+                uint32_t b = _sextets[input[i + 1]];
+                uint32_t c = _sextets[input[i + 2]];
+                uint32_t d = _sextets[input[i + 3]];
+                if ((a | b | c | d) & 0x80) {
+                    break;
+                }
+                o = _decode_group(o, (a << 18) | (b << 12) | (c << 6) | d);
+                i += 4;
+            }
+            if (i == len) {
+                break;
+            }
+        }
+
+        uint8_t value = _sextets[input[i++]];
+        if (value == PAD) {
+            // one or two '=' complete a final group of 3 or 2 characters
+            uint count = decoder->sextets + decoder->padding;
+            if (decoder->sextets < 2 || count >= 4) {
+                return false;
+            }
+            decoder->padding++;
+            continue;
+        }
+        if (value == INVALID || decoder->padding > 0) {
+            return false;
+        }
+
+        decoder->quantum = (decoder->quantum << 6) | value;
+        if (++decoder->sextets < 4) {
+            continue;
+        }
+        if (end - o < 3) {
+            return false;
+        }
+        o = _decode_group(o, decoder->quantum);
+        decoder->quantum = 0;
+        decoder->sextets = 0;
+    }
+
+    *output_len = o - output;
+    return true;
+}
+
+// Appends the bytes carried by a final group of 2 or 3 characters. Padding is optional but if
+// present must complete the group; a lone character carries no whole byte and is an error.
+bool base64_decode_final(base64_decoder_t* decoder, uint8_t* output, size_t capacity, size_t* output_len) {
+    if (decoder->sextets == 1
+            || (decoder->padding > 0 && decoder->sextets + decoder->padding != 4)) {
+        return false;
+    }
+
+    size_t count = (decoder->sextets > 0) ? decoder->sextets - 1 : 0;
+    if (*output_len > capacity || count > capacity - *output_len) {
+        return false;
+    }
+
+    uint32_t quantum = decoder->quantum << (6 * (4 - decoder->sextets));
+    uint8_t* o = output + *output_len;
+    for (size_t i = 0; i < count; i++) {
+        o[i] = quantum >> (16 - 8 * i);
+    }
+    *output_len += count;
+    base64_decoder_init(decoder);
+    return true;
+}
+
+static inline char* _encode_group(char* output, uint32_t group) {
+    output[0] = _alphabet[(group >> 18) & 0x3f];
+    output[1] = _alphabet[(group >> 12) & 0x3f];
+    output[2] = _alphabet[(group >> 6) & 0x3f];
+    output[3] = _alphabet[group & 0x3f];
+    return output + 4;
+}
+
+static inline uint8_t* _decode_group(uint8_t* output, uint32_t quantum) {
+    output[0] = quantum >> 16;
+    output[1] = quantum >> 8;
+    output[2] = quantum;
+    return output + 3;
+}
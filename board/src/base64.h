@@ -0,0 +1,51 @@
+#ifndef _PICONET_BASE64_H_
+#define _PICONET_BASE64_H_
+
+#include "pico/stdlib.h"
+
+// characters produced by encoding len bytes, excluding the terminator
+#define BASE64_ENCODED_LEN(len)     ((((len) + 2) / 3) * 4)
+
+/**
+ * Base64 (RFC 4648, with padding) encoder and decoder for frame data passing to and from the
+ * host. Input is handled a 3 byte or 4 character group at a time using lookup tables kept in
+ * RAM, so that the hot loop runs without flash cache misses. Every call is given the capacity of
+ * its output buffer and fails rather than overrunning it.
+ *
+ * Both directions may be fed in pieces (e.g. as characters arrive from USB, or from either side
+ * of a ring buffer's wrap point) by way of the encoder/decoder state; a piece needn't end on a
+ * group boundary.
+ */
+typedef struct {
+    uint8_t     pending[2];     // input bytes not yet making up a whole group
+    uint        pending_len;
+} base64_encoder_t;
+
+typedef struct {
+    uint32_t    quantum;        // sextets of the group in progress
+    uint        sextets;
+    uint        padding;        // '=' characters seen, after which only more padding may follow
+} base64_decoder_t;
+
+void    base64_encoder_init(base64_encoder_t* encoder);
+bool    base64_encode_update(
+            base64_encoder_t* encoder,
+            const uint8_t* input,
+            size_t len,
+            char* output,
+            size_t capacity,
+            size_t* output_len);
+bool    base64_encode_final(base64_encoder_t* encoder, char* output, size_t capacity, size_t* output_len);
+bool    base64_encode(const uint8_t* input, size_t len, char* output, size_t capacity);
+
+void    base64_decoder_init(base64_decoder_t* decoder);
+bool    base64_decode_update(
+            base64_decoder_t* decoder,
+            const uint8_t* input,
+            size_t len,
+            uint8_t* output,
+            size_t capacity,
+            size_t* output_len);
+bool    base64_decode_final(base64_decoder_t* decoder, uint8_t* output, size_t capacity, size_t* output_len);
+
+#endif
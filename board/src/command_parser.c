@@ -0,0 +1,472 @@
+#include "command_parser.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define CMD_STATUS              "STATUS"
+#define CMD_RESTART             "RESTART"
+#define CMD_SET_MODE            "SET_MODE"
+#define CMD_SET_STATION         "SET_STATION"
+#define CMD_TX                  "TX"
+#define CMD_REPLY               "REPLY"
+#define CMD_BCAST               "BCAST"
+#define CMD_TEST                "TEST"
+#define CMD_SET_COMPRESSION     "SET_COMPRESSION"
+#define CMD_COMPRESSION         "COMPRESSION"
+#define CMD_SET_DEDUP           "SET_DEDUP"
+#define CMD_DEDUP               "DEDUP"
+#define CMD_SET_TRACE           "SET_TRACE"
+#define CMD_TRACE               "TRACE"
+#define CMD_SET_FLOW            "SET_FLOW"
+#define CMD_CREDIT              "CREDIT"
+#define CMD_FLOW                "FLOW"
+#define CMD_BENCH               "BENCH"
+#define CMD_RECOVER             "RECOVER"
+#define CMD_RECOVERY            "RECOVERY"
+#define CMD_SET_TRAFFIC         "SET_TRAFFIC"
+#define CMD_TRAFFIC             "TRAFFIC"
+#define CMD_SET_SNAPLEN         "SET_SNAPLEN"
+#define CMD_SCAN                "SCAN"
+#define CMD_SET_USB_FLUSH       "SET_USB_FLUSH"
+#define CMD_USB                 "USB"
+
+#define CMD_PARAM_MODE_STOP     "STOP"
+#define CMD_PARAM_MODE_LISTEN   "LISTEN"
+#define CMD_PARAM_MODE_MONITOR  "MONITOR"
+#define CMD_PARAM_MODE_TRAFFIC  "TRAFFIC"
+
+#define CMD_PARAM_COMPRESSION_NONE  "NONE"
+#define CMD_PARAM_COMPRESSION_LZ    "LZ"
+
+typedef enum {
+    ARG_UINT8 = 0L,
+    ARG_UINT16,
+    ARG_MODE,
+    ARG_COMPRESSION,
+    ARG_BASE64
+} arg_type_t;
+
+typedef struct {
+    arg_type_t              type;
+    bool                    optional;   // only trailing arguments may be optional
+    size_t                  offset;     // of the value within command_t
+    size_t                  len_offset; // of the decoded length within command_t (ARG_BASE64 only)
+    size_t                  capacity;   // of the value (ARG_BASE64 only)
+} arg_spec_t;
+
+struct cmd_spec {
+    const char*             name;
+    cmd_type_t              type;
+    const arg_spec_t*       args;
+    uint                    arg_count;
+};
+
+#define ARG(arg_type, field) \
+    { arg_type, false, offsetof(command_t, field), 0, 0 }
+#define ARG_DATA(field, len_field) \
+    { ARG_BASE64, true, offsetof(command_t, field), offsetof(command_t, len_field), TX_DATA_BUFFER_SZ }
+
+static const arg_spec_t _set_mode_args[] = {
+    ARG(ARG_MODE, set_mode),
+};
+
+static const arg_spec_t _set_compression_args[] = {
+    ARG(ARG_COMPRESSION, compression),
+};
+
+static const arg_spec_t _set_dedup_args[] = {
+    ARG(ARG_UINT16, dedup_window_ms),
+};
+
+static const arg_spec_t _set_trace_args[] = {
+    ARG(ARG_UINT8, trace_enabled),
+};
+
+static const arg_spec_t _credits_args[] = {
+    ARG(ARG_UINT16, credits),
+};
+
+static const arg_spec_t _bench_args[] = {
+    ARG(ARG_UINT16, bench.frame_len),
+    ARG(ARG_UINT16, bench.count),
+};
+
+static const arg_spec_t _set_traffic_args[] = {
+    ARG(ARG_UINT16, traffic_interval_ms),
+};
+
+static const arg_spec_t _set_snaplen_args[] = {
+    ARG(ARG_UINT16, snaplen),
+};
+
+static const arg_spec_t _scan_args[] = {
+    ARG(ARG_UINT8, scan.first_station),
+    ARG(ARG_UINT8, scan.last_station),
+    ARG(ARG_UINT16, scan.timeout_ms),
+};
+
+static const arg_spec_t _set_usb_flush_args[] = {
+    ARG(ARG_UINT16, usb_flush_us),
+};
+
+static const arg_spec_t _set_station_args[] = {
+    ARG(ARG_UINT8, station),
+};
+
+static const arg_spec_t _tx_args[] = {
+    ARG(ARG_UINT8, tx.dest_station),
+    ARG(ARG_UINT8, tx.dest_network),
+    ARG(ARG_UINT8, tx.control_byte),
+    ARG(ARG_UINT8, tx.port),
+    ARG_DATA(tx.data, tx.data_len),
+    ARG_DATA(tx.scout_extra_data, tx.scout_extra_data_len),
+};
+
+static const arg_spec_t _bcast_args[] = {
+    ARG_DATA(bcast.data, bcast.data_len),
+};
+
+static const arg_spec_t _reply_args[] = {
+    ARG(ARG_UINT16, reply.reply_id),
+    ARG(ARG_UINT8, reply.control_byte),
+    ARG(ARG_UINT8, reply.port),
+    ARG_DATA(reply.data, reply.data_len),
+};
+
+#define ARGS(args) args, sizeof(args) / sizeof(args[0])
+
+static const cmd_spec_t _cmd_specs[] = {
+    { CMD_STATUS,             PICONET_CMD_STATUS,             NULL, 0 },
+    { CMD_RESTART,            PICONET_CMD_RESTART,            NULL, 0 },
+    { CMD_SET_MODE,           PICONET_CMD_SET_MODE,           ARGS(_set_mode_args) },
+    { CMD_SET_STATION,        PICONET_CMD_SET_STATION,        ARGS(_set_station_args) },
+    { CMD_TX,                 PICONET_CMD_TX,                 ARGS(_tx_args) },
+    { CMD_BCAST,              PICONET_CMD_BCAST,              ARGS(_bcast_args) },
+    { CMD_REPLY,              PICONET_CMD_REPLY,              ARGS(_reply_args) },
+    { CMD_TEST,               PICONET_CMD_TEST,               NULL, 0 },
+    { CMD_SET_COMPRESSION,    PICONET_CMD_SET_COMPRESSION,    ARGS(_set_compression_args) },
+    { CMD_COMPRESSION,        PICONET_CMD_COMPRESSION,        NULL, 0 },
+    { CMD_SET_DEDUP,          PICONET_CMD_SET_DEDUP,          ARGS(_set_dedup_args) },
+    { CMD_DEDUP,              PICONET_CMD_DEDUP,              NULL, 0 },
+    { CMD_SET_TRACE,          PICONET_CMD_SET_TRACE,          ARGS(_set_trace_args) },
+    { CMD_TRACE,              PICONET_CMD_TRACE,              NULL, 0 },
+    { CMD_SET_FLOW,           PICONET_CMD_SET_FLOW,           ARGS(_credits_args) },
+    { CMD_CREDIT,             PICONET_CMD_CREDIT,             ARGS(_credits_args) },
+    { CMD_FLOW,               PICONET_CMD_FLOW,               NULL, 0 },
+    { CMD_BENCH,              PICONET_CMD_BENCH,              ARGS(_bench_args) },
+    { CMD_RECOVER,            PICONET_CMD_RECOVER,            NULL, 0 },
+    { CMD_RECOVERY,           PICONET_CMD_RECOVERY,           NULL, 0 },
+    { CMD_SET_TRAFFIC,        PICONET_CMD_SET_TRAFFIC,        ARGS(_set_traffic_args) },
+    { CMD_TRAFFIC,            PICONET_CMD_TRAFFIC,            NULL, 0 },
+    { CMD_SET_SNAPLEN,        PICONET_CMD_SET_SNAPLEN,        ARGS(_set_snaplen_args) },
+    { CMD_SCAN,               PICONET_CMD_SCAN,               ARGS(_scan_args) },
+    { CMD_SET_USB_FLUSH,      PICONET_CMD_SET_USB_FLUSH,      ARGS(_set_usb_flush_args) },
+    { CMD_USB,                PICONET_CMD_USB,                NULL, 0 },
+};
+
+static void             _reset(parser_t* parser);
+static void             _fail(parser_t* parser);
+static void             _append_token(parser_t* parser, char c);
+static void             _end_name(parser_t* parser);
+static void             _begin_arg(parser_t* parser, char c);
+static void             _end_token(parser_t* parser);
+static void             _next_arg(parser_t* parser);
+static parser_result_t  _end_line(parser_t* parser);
+static bool             _parse_uint(const char* token, size_t len, uint32_t max, uint32_t* value);
+static bool             _parse_mode(const char* token, piconet_mode_t* mode);
+static bool             _parse_compression(const char* token, compression_scheme_t* scheme);
+static bool             _decode_base64(parser_t* parser, const uint8_t* input, size_t len);
+static bool             _end_base64(parser_t* parser);
+
+void parser_init(parser_t* parser, command_t* cmd) {
+    parser->cmd = cmd;
+    _reset(parser);
+}
+
+parser_result_t parser_feed(parser_t* parser, const uint8_t* input, size_t len, size_t* consumed) {
+    size_t i = 0;
+    while (i < len) {
+        uint8_t c = input[i];
+
+        if (c == '\r' || c == '\n') {
+            i++;
+            parser_result_t result = _end_line(parser);
+            if (result != PARSER_RESULT_NONE) {
+                *consumed = i;
+                return result;
+            }
+            continue;
+        }
+
+        if (parser->state == PARSER_STATE_BASE64 && c != ' ') {
+            // decode the whole run of base64 characters available rather than byte by byte
+            size_t end = i + 1;
+            while (end < len && input[end] != ' ' && input[end] != '\r' && input[end] != '\n') {
+                end++;
+            }
+            if (!_decode_base64(parser, input + i, end - i)) {
+                _fail(parser);
+            }
+            i = end;
+            continue;
+        }
+
+        i++;
+        switch (parser->state) {
+            case PARSER_STATE_NAME:
+                if (c != ' ') {
+                    _append_token(parser, c);
+                } else if (parser->token_len > 0) {
+                    _end_name(parser);
+                }
+                break;
+            case PARSER_STATE_SEPARATOR:
+                if (c != ' ') {
+                    _begin_arg(parser, c);
+                }
+                break;
+            case PARSER_STATE_TOKEN:
+                if (c != ' ') {
+                    _append_token(parser, c);
+                } else {
+                    _end_token(parser);
+                }
+                break;
+            case PARSER_STATE_BASE64:
+                if (!_end_base64(parser)) {
+                    _fail(parser);
+                    break;
+                }
+                _next_arg(parser);
+                break;
+            case PARSER_STATE_DISCARD:
+                break;
+        }
+    }
+
+    *consumed = len;
+    return PARSER_RESULT_NONE;
+}
+
+static void _reset(parser_t* parser) {
+    parser->state = PARSER_STATE_NAME;
+    parser->spec = NULL;
+    parser->arg_index = 0;
+    parser->token_len = 0;
+    parser->error = false;
+}
+
+static void _fail(parser_t* parser) {
+    parser->error = true;
+    parser->state = PARSER_STATE_DISCARD;
+}
+
+static void _append_token(parser_t* parser, char c) {
+    if (parser->token_len >= CMD_TOKEN_MAXLEN) {
+        _fail(parser);
+        return;
+    }
+    parser->token[parser->token_len++] = c;
+}
+
+static void _end_name(parser_t* parser) {
+    parser->token[parser->token_len] = 0;
+
+    parser->spec = NULL;
+    for (uint i = 0; i < sizeof(_cmd_specs) / sizeof(_cmd_specs[0]); i++) {
+        if (strcmp(parser->token, _cmd_specs[i].name) == 0) {
+            parser->spec = &_cmd_specs[i];
+            break;
+        }
+    }
+    if (parser->spec == NULL) {
+        _fail(parser);
+        return;
+    }
+
+    parser->cmd->type = parser->spec->type;
+    for (uint i = 0; i < parser->spec->arg_count; i++) {
+        const arg_spec_t* arg = &parser->spec->args[i];
+        if (arg->type == ARG_BASE64) {
+            *(size_t*) ((uint8_t*) parser->cmd + arg->len_offset) = 0;
+        }
+    }
+
+    parser->arg_index = 0;
+    _next_arg(parser);
+}
+
+static void _begin_arg(parser_t* parser, char c) {
+    const arg_spec_t* arg = &parser->spec->args[parser->arg_index];
+
+    if (arg->type != ARG_BASE64) {
+        parser->state = PARSER_STATE_TOKEN;
+        parser->token_len = 0;
+        _append_token(parser, c);
+        return;
+    }
+
+    parser->state = PARSER_STATE_BASE64;
+    parser->b64_output = (uint8_t*) parser->cmd + arg->offset;
+    parser->b64_output_len = (size_t*) ((uint8_t*) parser->cmd + arg->len_offset);
+    parser->b64_output_capacity = arg->capacity;
+    base64_decoder_init(&parser->b64_decoder);
+    if (!_decode_base64(parser, (const uint8_t*) &c, 1)) {
+        _fail(parser);
+    }
+}
+
+static void _end_token(parser_t* parser) {
+    const arg_spec_t* arg = &parser->spec->args[parser->arg_index];
+    void* value = (uint8_t*) parser->cmd + arg->offset;
+    uint32_t number;
+
+    parser->token[parser->token_len] = 0;
+    switch (arg->type) {
+        case ARG_UINT8:
+            if (!_parse_uint(parser->token, parser->token_len, 0xff, &number)) {
+                _fail(parser);
+                return;
+            }
+            *(uint8_t*) value = number;
+            break;
+        case ARG_UINT16:
+            if (!_parse_uint(parser->token, parser->token_len, 0xffff, &number)) {
+                _fail(parser);
+                return;
+            }
+            *(uint16_t*) value = number;
+            break;
+        case ARG_MODE:
+            if (!_parse_mode(parser->token, (piconet_mode_t*) value)) {
+                _fail(parser);
+                return;
+            }
+            break;
+        case ARG_COMPRESSION:
+            if (!_parse_compression(parser->token, (compression_scheme_t*) value)) {
+                _fail(parser);
+                return;
+            }
+            break;
+        default:
+            _fail(parser);
+            return;
+    }
+
+    _next_arg(parser);
+}
+
+static void _next_arg(parser_t* parser) {
+    if (parser->state != PARSER_STATE_NAME) {
+        parser->arg_index++;
+    }
+
+    // surplus arguments are ignored
+    parser->state = (parser->arg_index < parser->spec->arg_count)
+        ? PARSER_STATE_SEPARATOR
+        : PARSER_STATE_DISCARD;
+}
+
+static parser_result_t _end_line(parser_t* parser) {
+    switch (parser->state) {
+        case PARSER_STATE_NAME:
+            if (parser->token_len == 0) {
+                // empty line
+                return PARSER_RESULT_NONE;
+            }
+            _end_name(parser);
+            break;
+        case PARSER_STATE_TOKEN:
+            _end_token(parser);
+            break;
+        case PARSER_STATE_BASE64:
+            if (_end_base64(parser)) {
+                _next_arg(parser);
+            } else {
+                _fail(parser);
+            }
+            break;
+        default:
+            break;
+    }
+
+    bool missing_arg = !parser->error
+        && parser->arg_index < parser->spec->arg_count
+        && !parser->spec->args[parser->arg_index].optional;
+    bool error = parser->error || missing_arg;
+
+    // a line in error still records the command it named, so that a command the host expects a
+    // result from can be answered with an error
+    if (parser->spec == NULL) {
+        parser->cmd->type = PICONET_CMD_UNKNOWN;
+    }
+    parser->cmd->invalid = error;
+
+    _reset(parser);
+    return error ? PARSER_RESULT_ERROR : PARSER_RESULT_COMMAND;
+}
+
+static bool _parse_uint(const char* token, size_t len, uint32_t max, uint32_t* value) {
+    if (len == 0) {
+        return false;
+    }
+
+    uint32_t result = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (token[i] < '0' || token[i] > '9') {
+            return false;
+        }
+        result = result * 10 + (token[i] - '0');
+        if (result > max) {
+            return false;
+        }
+    }
+
+    *value = result;
+    return true;
+}
+
+static bool _parse_mode(const char* token, piconet_mode_t* mode) {
+    if (strcmp(token, CMD_PARAM_MODE_STOP) == 0) {
+        *mode = PICONET_CMD_SET_MODE_STOP;
+    } else if (strcmp(token, CMD_PARAM_MODE_LISTEN) == 0) {
+        *mode = PICONET_CMD_SET_MODE_LISTEN;
+    } else if (strcmp(token, CMD_PARAM_MODE_MONITOR) == 0) {
+        *mode = PICONET_CMD_SET_MODE_MONITOR;
+    } else if (strcmp(token, CMD_PARAM_MODE_TRAFFIC) == 0) {
+        *mode = PICONET_CMD_SET_MODE_TRAFFIC;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool _parse_compression(const char* token, compression_scheme_t* scheme) {
+    if (strcmp(token, CMD_PARAM_COMPRESSION_NONE) == 0) {
+        *scheme = PICONET_COMPRESSION_NONE;
+    } else if (strcmp(token, CMD_PARAM_COMPRESSION_LZ) == 0) {
+        *scheme = PICONET_COMPRESSION_LZ;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool _decode_base64(parser_t* parser, const uint8_t* input, size_t len) {
+    return base64_decode_update(
+        &parser->b64_decoder,
+        input,
+        len,
+        parser->b64_output,
+        parser->b64_output_capacity,
+        parser->b64_output_len);
+}
+
+static bool _end_base64(parser_t* parser) {
+    return base64_decode_final(
+        &parser->b64_decoder,
+        parser->b64_output,
+        parser->b64_output_capacity,
+        parser->b64_output_len);
+}
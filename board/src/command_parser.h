@@ -0,0 +1,145 @@
+#ifndef _PICONET_COMMAND_PARSER_H_
+#define _PICONET_COMMAND_PARSER_H_
+
+#include "pico/stdlib.h"
+#include "base64.h"
+
+#define TX_DATA_BUFFER_SZ       3500
+#define CMD_TOKEN_MAXLEN        16
+
+typedef enum {
+    PICONET_CMD_SET_MODE_STOP = 0L,
+    PICONET_CMD_SET_MODE_LISTEN,
+    PICONET_CMD_SET_MODE_MONITOR,
+    PICONET_CMD_SET_MODE_TRAFFIC
+} piconet_mode_t;
+
+typedef enum {
+    PICONET_COMPRESSION_NONE = 0L,
+    PICONET_COMPRESSION_LZ
+} compression_scheme_t;
+
+typedef enum {
+    PICONET_CMD_STATUS = 0L,
+    PICONET_CMD_RESTART,
+    PICONET_CMD_SET_MODE,
+    PICONET_CMD_SET_STATION,
+    PICONET_CMD_TX,
+    PICONET_CMD_REPLY,
+    PICONET_CMD_BCAST,
+    PICONET_CMD_TEST,
+    PICONET_CMD_SET_COMPRESSION,
+    PICONET_CMD_COMPRESSION,
+    PICONET_CMD_SET_DEDUP,
+    PICONET_CMD_DEDUP,
+    PICONET_CMD_SET_TRACE,
+    PICONET_CMD_TRACE,
+    PICONET_CMD_SET_FLOW,
+    PICONET_CMD_CREDIT,
+    PICONET_CMD_FLOW,
+    PICONET_CMD_BENCH,
+    PICONET_CMD_RECOVER,
+    PICONET_CMD_RECOVERY,
+    PICONET_CMD_SET_TRAFFIC,
+    PICONET_CMD_TRAFFIC,
+    PICONET_CMD_SET_SNAPLEN,
+    PICONET_CMD_SCAN,
+    PICONET_CMD_SET_USB_FLUSH,
+    PICONET_CMD_USB,
+    PICONET_CMD_UNKNOWN,                // a line in error which didn't name a command
+} cmd_type_t;
+
+typedef struct {
+    uint8_t                 dest_station;
+    uint8_t                 dest_network;
+    uint8_t                 control_byte;
+    uint8_t                 port;
+    uint8_t                 data[TX_DATA_BUFFER_SZ];
+    size_t                  data_len;
+    uint8_t                 scout_extra_data[TX_DATA_BUFFER_SZ]; // TODO: really this long?
+    size_t                  scout_extra_data_len;
+} cmd_tx_t;
+
+typedef struct {
+    uint8_t                 data[TX_DATA_BUFFER_SZ];
+    size_t                  data_len;
+} cmd_bcast_t;
+
+typedef struct {
+    uint16_t                reply_id;
+    uint8_t                 control_byte;
+    uint8_t                 port;
+    uint8_t                 data[TX_DATA_BUFFER_SZ];
+    size_t                  data_len;
+} cmd_reply_t;
+
+typedef struct {
+    uint16_t                frame_len;
+    uint16_t                count;
+} cmd_bench_t;
+
+typedef struct {
+    uint8_t                 first_station;
+    uint8_t                 last_station;
+    uint16_t                timeout_ms;
+} cmd_scan_t;
+
+typedef struct {
+    cmd_type_t type;
+    bool invalid;                       // the line was in error, so only the type is meaningful
+    union {
+        piconet_mode_t      set_mode;   // if type == PICONET_CMD_SET_MODE
+        cmd_tx_t            tx;         // if type == PICONET_CMD_TX
+        cmd_reply_t         reply;      // if type == PICONET_CMD_REPLY
+        cmd_bcast_t         bcast;      // if type == PICONET_CMD_BCAST
+        uint8_t             station;    // if type == PICONET_CMD_SET_STATION
+        compression_scheme_t compression; // if type == PICONET_CMD_SET_COMPRESSION
+        uint16_t            dedup_window_ms; // if type == PICONET_CMD_SET_DEDUP
+        uint8_t             trace_enabled; // if type == PICONET_CMD_SET_TRACE
+        uint16_t            credits;    // if type == PICONET_CMD_SET_FLOW or PICONET_CMD_CREDIT
+        cmd_bench_t         bench;      // if type == PICONET_CMD_BENCH
+        uint16_t            traffic_interval_ms; // if type == PICONET_CMD_SET_TRAFFIC
+        uint16_t            snaplen;    // if type == PICONET_CMD_SET_SNAPLEN
+        cmd_scan_t          scan;       // if type == PICONET_CMD_SCAN
+        uint16_t            usb_flush_us; // if type == PICONET_CMD_SET_USB_FLUSH
+    };
+} command_t;
+
+typedef enum {
+    PARSER_STATE_NAME = 0L,     // accumulating the command name
+    PARSER_STATE_SEPARATOR,     // skipping spaces before the next argument
+    PARSER_STATE_TOKEN,         // accumulating a keyword or numeric argument
+    PARSER_STATE_BASE64,        // decoding a base64 argument straight into the command
+    PARSER_STATE_DISCARD        // skipping the remainder of a line in error
+} parser_state_t;
+
+typedef enum {
+    PARSER_RESULT_NONE = 0L,    // all input consumed, command incomplete
+    PARSER_RESULT_COMMAND,      // command complete, remaining input not yet consumed
+    PARSER_RESULT_ERROR         // line in error, remaining input not yet consumed
+} parser_result_t;
+
+typedef struct cmd_spec cmd_spec_t;
+
+/**
+ * Parses commands incrementally as bytes arrive from the host, so that no line buffer is
+ * needed and a command is ready to execute as soon as its terminating CR has been received.
+ */
+typedef struct {
+    parser_state_t          state;
+    command_t*              cmd;
+    const cmd_spec_t*       spec;
+    uint                    arg_index;
+    char                    token[CMD_TOKEN_MAXLEN + 1];
+    size_t                  token_len;
+    bool                    error;
+    uint8_t*                b64_output;
+    size_t*                 b64_output_len;
+    size_t                  b64_output_capacity;
+    base64_decoder_t        b64_decoder;
+} parser_t;
+
+void                parser_init(parser_t* parser, command_t* cmd);
+parser_result_t     parser_feed(parser_t* parser, const uint8_t* input, size_t len, size_t* consumed);
+
+#endif
@@ -0,0 +1,144 @@
+#include "compress.h"
+
+#include <string.h>
+
+#define WINDOW_MASK     (COMPRESS_WINDOW_SZ - 1)
+#define MAX_DISTANCE    (COMPRESS_WINDOW_SZ - 1)
+
+static void     _reset(compressor_t* c);
+static uint32_t _hash(const uint8_t* p);
+static uint8_t* _write_length(uint8_t* output, size_t len);
+static uint8_t* _write_sequence(
+                    uint8_t*        output,
+                    const uint8_t*  literals,
+                    size_t          literals_len,
+                    uint32_t        distance,
+                    size_t          match_len);
+
+void compressor_init(compressor_t* c) {
+    c->pos = 0;
+    c->seq = 0;
+    c->bytes_in = 0;
+    c->bytes_out = 0;
+    _reset(c);
+}
+
+size_t compress_frame(compressor_t* c, const uint8_t* input, size_t len, uint8_t* output) {
+    uint8_t* o = output;
+    uint8_t flags = 0;
+
+    if (c->seq % COMPRESS_RESET_INTERVAL == 0) {
+        _reset(c);
+        flags |= COMPRESS_FLAG_RESET;
+    }
+    *o++ = flags;
+    *o++ = c->seq++;
+
+    const uint32_t frame_start = c->pos;
+    size_t anchor = 0;
+    size_t i = 0;
+    while (i + COMPRESS_MIN_MATCH <= len) {
+        const uint32_t p = frame_start + i;
+        const uint32_t h = _hash(&input[i]);
+        const uint32_t candidate = c->table[h];
+        c->table[h] = p;
+
+        // unsigned arithmetic: rejects a zero distance as well as those beyond the window or
+        // reaching back before the last reset
+        const uint32_t distance = p - candidate;
+        const uint32_t limit = (p - c->base < MAX_DISTANCE) ? p - c->base : MAX_DISTANCE;
+        if (distance - 1 >= limit) {
+            i++;
+            continue;
+        }
+
+        // candidate bytes are in the history until we reach the start of this frame
+        size_t match_len = 0;
+        uint32_t q = candidate;
+        while (q < frame_start && i + match_len < len
+                && c->history[q & WINDOW_MASK] == input[i + match_len]) {
+            q++;
+            match_len++;
+        }
+        if (q >= frame_start) {
+            const uint8_t* s = &input[q - frame_start];
+            while (i + match_len < len && *s == input[i + match_len]) {
+                s++;
+                match_len++;
+            }
+        }
+
+        if (match_len < COMPRESS_MIN_MATCH) {
+            i++;
+            continue;
+        }
+
+        o = _write_sequence(o, &input[anchor], i - anchor, distance, match_len);
+        i += match_len;
+        anchor = i;
+    }
+
+    // trailing literals, with no match
+    if (anchor < len) {
+        o = _write_sequence(o, &input[anchor], len - anchor, 0, 0);
+    }
+
+    // keep the last window's worth of the frame for matching against in the next
+    const size_t keep = (len < COMPRESS_WINDOW_SZ) ? len : COMPRESS_WINDOW_SZ;
+    for (size_t k = len - keep; k < len; k++) {
+        c->history[(frame_start + k) & WINDOW_MASK] = input[k];
+    }
+    c->pos += len;
+
+    c->bytes_in += len;
+    c->bytes_out += o - output;
+    return o - output;
+}
+
+static void _reset(compressor_t* c) {
+    memset(c->table, 0, sizeof(c->table));
+    c->base = c->pos;
+}
+
+static uint32_t _hash(const uint8_t* p) {
+    uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+    return (v * 2654435761u) >> (32 - COMPRESS_HASH_BITS);
+}
+
+static uint8_t* _write_length(uint8_t* output, size_t len) {
+    while (len >= 255) {
+        *output++ = 255;
+        len -= 255;
+    }
+    *output++ = len;
+    return output;
+}
+
+static uint8_t* _write_sequence(
+        uint8_t*        output,
+        const uint8_t*  literals,
+        size_t          literals_len,
+        uint32_t        distance,
+        size_t          match_len) {
+    const size_t extra_match = (match_len > 0) ? match_len - COMPRESS_MIN_MATCH : 0;
+    uint8_t* token = output++;
+
+    *token = (literals_len < 15 ? literals_len : 15) << 4;
+    if (literals_len >= 15) {
+        output = _write_length(output, literals_len - 15);
+    }
+    memcpy(output, literals, literals_len);
+    output += literals_len;
+
+    if (match_len == 0) {
+        return output;
+    }
+
+    *output++ = distance;
+    *output++ = distance >> 8;
+    *token |= (extra_match < 15) ? extra_match : 15;
+    if (extra_match >= 15) {
+        output = _write_length(output, extra_match - 15);
+    }
+    return output;
+}
@@ -0,0 +1,37 @@
+#ifndef _PICONET_COMPRESS_H_
+#define _PICONET_COMPRESS_H_
+
+#include "pico/stdlib.h"
+
+#define COMPRESS_WINDOW_SZ          4096        // must be a power of 2
+#define COMPRESS_HASH_BITS          10
+#define COMPRESS_MIN_MATCH          4
+#define COMPRESS_RESET_INTERVAL     256         // frames between history resets
+
+// frame header: flags byte, then sequence number
+#define COMPRESS_HEADER_SZ          2
+#define COMPRESS_FLAG_RESET         1
+
+// worst case size of a compressed frame (i.e. incompressible data)
+#define COMPRESS_MAX_OUTPUT(len)    (COMPRESS_HEADER_SZ + (len) + (len) / 255 + 16)
+
+/**
+ * LZ77 compressor producing LZ4 block format sequences. Matches may refer back into previous
+ * frames, which is where most of the gain comes from on Econet (repeated headers, retransmits,
+ * zero-filled blocks), so frames must be decompressed in order. Every COMPRESS_RESET_INTERVAL
+ * frames the history is discarded, allowing a decompressor that has lost its place to resync.
+ */
+typedef struct {
+    uint8_t     history[COMPRESS_WINDOW_SZ];
+    uint32_t    table[1 << COMPRESS_HASH_BITS];
+    uint32_t    pos;            // stream position of the next byte
+    uint32_t    base;           // stream position at the last reset
+    uint8_t     seq;
+    uint64_t    bytes_in;
+    uint64_t    bytes_out;
+} compressor_t;
+
+void    compressor_init(compressor_t* c);
+size_t  compress_frame(compressor_t* c, const uint8_t* input, size_t len, uint8_t* output);
+
+#endif
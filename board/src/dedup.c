@@ -0,0 +1,65 @@
+#include "dedup.h"
+
+#include <string.h>
+
+static uint32_t _hash(uint32_t h, const uint8_t* data, size_t len);
+
+void dedup_init(dedup_cache_t* cache, uint32_t window_ms) {
+    memset(cache, 0, sizeof(*cache));
+    cache->window_ms = window_ms;
+}
+
+bool dedup_check(
+        dedup_cache_t*  cache,
+        dedup_kind_t    kind,
+        uint8_t         src_station,
+        uint8_t         src_net,
+        uint8_t         ctrl,
+        uint8_t         port,
+        const uint8_t*  scout_data,
+        size_t          scout_data_len,
+        const uint8_t*  payload,
+        size_t          len,
+        uint32_t        now_ms) {
+    if (cache->window_ms == 0) {
+        return false;
+    }
+
+    const uint32_t hash = _hash(_hash(2166136261u, scout_data, scout_data_len), payload, len);
+    for (uint i = 0; i < DEDUP_CACHE_SZ; i++) {
+        const dedup_entry_t* e = &cache->entries[i];
+        if (e->valid
+                && now_ms - e->time_ms < cache->window_ms
+                && e->hash == hash
+                && e->len == len
+                && e->src_station == src_station
+                && e->src_net == src_net
+                && e->ctrl == ctrl
+                && e->port == port
+                && e->kind == kind) {
+            cache->suppressed[kind]++;
+            return true;
+        }
+    }
+
+    dedup_entry_t* e = &cache->entries[cache->next];
+    cache->next = (cache->next + 1) % DEDUP_CACHE_SZ;
+    e->hash = hash;
+    e->time_ms = now_ms;
+    e->len = len;
+    e->src_station = src_station;
+    e->src_net = src_net;
+    e->ctrl = ctrl;
+    e->port = port;
+    e->kind = kind;
+    e->valid = true;
+    return false;
+}
+
+// FNV-1a
+static uint32_t _hash(uint32_t h, const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ data[i]) * 16777619u;
+    }
+    return h;
+}
@@ -0,0 +1,56 @@
+#ifndef _PICONET_DEDUP_H_
+#define _PICONET_DEDUP_H_
+
+#include "pico/stdlib.h"
+
+#define DEDUP_CACHE_SZ          16
+
+typedef enum {
+    DEDUP_KIND_TRANSMIT = 0L,
+    DEDUP_KIND_IMMEDIATE,
+    DEDUP_KIND_BROADCAST,
+    DEDUP_KIND_COUNT
+} dedup_kind_t;
+
+typedef struct {
+    uint32_t    hash;           // of the payload
+    uint32_t    time_ms;        // when first seen
+    uint16_t    len;
+    uint8_t     src_station;
+    uint8_t     src_net;
+    uint8_t     ctrl;
+    uint8_t     port;
+    uint8_t     kind;
+    bool        valid;
+} dedup_entry_t;
+
+/**
+ * Recognises copies of a recently received packet: retransmissions by a sender whose ack was
+ * lost, or broadcasts repeated by an over-eager station. A packet is identified by its source,
+ * port, control byte, length and a hash of its payload (preceded by any data carried in the
+ * scout, e.g. the address of an immediate operation), and is a duplicate if seen within the
+ * last `window_ms`. The first copy's time is kept, so a packet repeated indefinitely is still
+ * let through once per window. A window of zero disables the check.
+ */
+typedef struct {
+    dedup_entry_t   entries[DEDUP_CACHE_SZ];
+    uint            next;       // entry to replace next
+    uint32_t        window_ms;
+    uint32_t        suppressed[DEDUP_KIND_COUNT];
+} dedup_cache_t;
+
+void    dedup_init(dedup_cache_t* cache, uint32_t window_ms);
+bool    dedup_check(
+            dedup_cache_t*  cache,
+            dedup_kind_t    kind,
+            uint8_t         src_station,
+            uint8_t         src_net,
+            uint8_t         ctrl,
+            uint8_t         port,
+            const uint8_t*  scout_data,
+            size_t          scout_data_len,
+            const uint8_t*  payload,
+            size_t          len,
+            uint32_t        now_ms);
+
+#endif
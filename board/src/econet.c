@@ -5,6 +5,8 @@
 #include "econet.h"
 
 #include "adlc.h"
+#include "dedup.h"
+#include "traffic.h"
 #include "util.h"
 
 #define TIMEOUT_READ_FIRST_FRAME_MS 2000
@@ -13,6 +15,16 @@
 #define TIMEOUT_WRITE_READY_MS 10000
 #define TIMEOUT_WRITE_COMPLETE_MS 10000
 #define TIMEOUT_READ_DATA_MS 10000
+#define TIMEOUT_REPLY_MS 2000
+#define TIMEOUT_BENCH_FRAME_MS 100
+#define BENCH_FLUSH_FRAMES_MAX 32
+
+// consecutive symptoms after which the ADLC is taken to be stuck and recovered
+#define STALL_JAMMED_LIMIT 2
+#define STALL_STRAY_DATA_LIMIT 8
+
+// a power of two, so that slots stay in step with reply IDs as they wrap
+#define REPLY_TABLE_SZ 8
 
 typedef struct {
     uint8_t     dest_station;
@@ -55,6 +67,7 @@ typedef enum e_frame_read_status {
 typedef struct {
     t_frame_read_status status;
     size_t bytes_read;
+    size_t frame_len;       // bytes_read plus any discarded through truncation
 } t_frame_read_result;
 
 typedef enum eFrameWriteStatus {
@@ -66,15 +79,23 @@ typedef enum eFrameWriteStatus {
     FRAME_WRITE_OVERFLOW
 } tFrameWriteStatus;
 
+typedef enum {
+    LOOP_FRAME_OK = 0L,
+    LOOP_FRAME_UNDERRUN,
+    LOOP_FRAME_OVERRUN,
+    LOOP_FRAME_CORRUPT,
+    LOOP_FRAME_TIMEOUT
+} loop_frame_status_t;
+
 typedef struct {
     bool        valid;
     uint32_t    expiry;
-    uint32_t    reply_id;
+    uint16_t    reply_id;
     uint8_t     station;
     uint8_t     net;
 } pending_reply_t;
 
-static t_frame_read_result      _read_frame(uint8_t* buffer, size_t buffer_len, uint8_t* addr, size_t addr_len, uint timeout_ms, bool flag_fill);
+static t_frame_read_result      _read_frame(uint8_t* buffer, size_t buffer_len, uint8_t* addr, size_t addr_len, uint timeout_ms, bool flag_fill, bool truncate);
 static t_frame_parse_result     _parse_frame(uint8_t* buffer, size_t len, bool is_opening_frame);
 static econet_rx_result_t       _handle_first_frame();
 static econet_rx_result_t       _rx_data_for_scout(t_frame_parse_result* scout_frame);
@@ -83,19 +104,32 @@ static econet_rx_result_t       _handle_transmit_scout(t_frame_parse_result* tra
 static econet_rx_result_t       _handle_broadcast(t_frame_parse_result* broadcast_frame);
 static tFrameWriteStatus        _tx_frame(uint8_t* buffer, size_t len, bool flag_fill);
 static tFrameWriteStatus        _send_ack(t_frame_parse_result* incoming_frame, const uint8_t* extra_data, size_t extra_data_len, bool flag_fill);
-static bool                     _wait_ack(uint8_t from_station, uint8_t from_network, uint8_t to_station, uint8_t to_network);
+static bool                     _wait_ack(uint8_t from_station, uint8_t from_network, uint8_t to_station, uint8_t to_network, uint timeout_ms, uint8_t* extra_data, size_t extra_data_len);
+static uint                     _wait_status(uint reg, uint latch_bit, uint mask, uint32_t deadline_ms);
 static econet_rx_result_t       _rx_result_for_error(econet_rx_error_t error);
 static econet_tx_result_t       _tx_result_for_frame_status(tFrameWriteStatus status);
-static void                     _check_reply_timeout(void);
+static void                     _expire_replies(void);
 static econet_rx_result_t       _map_read_frame_result(t_frame_read_status status);
 static void                     _abort_read(void);
 static void                     _clear_rx(bool flag_fill);
 static void                     _finish_tx(bool flag_fill);
+static void                     _note_tx_result(econet_tx_result_t result);
+static void                     _note_stray_data(bool stray);
+static loop_frame_status_t      _loop_frame(const uint8_t* frame, size_t len);
 
 
 static bool                     _initialised;
 uint8_t                         _listen_addresses[] = { 0x02, 0xFF };
-pending_reply_t                 _pending_reply;
+static pending_reply_t          _pending_replies[REPLY_TABLE_SZ];
+static uint16_t                 _oldest_reply_id;
+static uint16_t                 _next_reply_id;
+static dedup_cache_t            _dedup;
+static econet_flow_stats_t      _flow_stats;
+static econet_stall_stats_t     _stall_stats;
+static uint                     _jammed_count;
+static uint                     _stray_data_count;
+static traffic_stats_t*         _traffic;
+static size_t                   _snaplen;
 
 static uint8_t* _rx_scout_buffer;
 static size_t   _rx_scout_buffer_sz;
@@ -115,6 +149,7 @@ bool econet_init(void) {
 
     adlc_init();
     adlc_irq_reset();
+    dedup_init(&_dedup, 0);
 
     _initialised = true;
 
@@ -138,7 +173,10 @@ econet_tx_result_t broadcast(
     _tx_data_buffer[3] = 0x00;
     memcpy(_tx_data_buffer + 4, data, data_len);
 
-    return _tx_result_for_frame_status(_tx_frame(_tx_data_buffer, data_frame_len, false));
+    adlc_trace_phase(ADLC_TRACE_PHASE_TX_BROADCAST);
+    econet_tx_result_t result = _tx_result_for_frame_status(_tx_frame(_tx_data_buffer, data_frame_len, false));
+    _note_tx_result(result);
+    return result;
 }
 
 econet_tx_result_t transmit(
@@ -177,24 +215,30 @@ econet_tx_result_t transmit(
     memcpy(_tx_scout_buffer + 6, scout_extra_data, scout_extra_data_len);
 
     adlc_update_data_led(true);
+    adlc_trace_phase(ADLC_TRACE_PHASE_TX_SCOUT);
     econet_tx_result_t scout_result = _tx_result_for_frame_status(_tx_frame(_tx_scout_buffer, scout_frame_len, true));
+    _note_tx_result(scout_result);
     if (scout_result != PICONET_TX_RESULT_OK) {
         adlc_update_data_led(false);
         return scout_result;
     }
 
-    if (!_wait_ack(station, network, _listen_addresses[0], 0x00)) {
+    adlc_trace_phase(ADLC_TRACE_PHASE_TX_SCOUT_ACK);
+    if (!_wait_ack(station, network, _listen_addresses[0], 0x00, TIMEOUT_WAIT_ACK_MS, NULL, 0)) {
         adlc_update_data_led(false);
         return PICONET_TX_RESULT_ERROR_NO_SCOUT_ACK;
     }
 
+    adlc_trace_phase(ADLC_TRACE_PHASE_TX_DATA);
     econet_tx_result_t data_result = _tx_result_for_frame_status(_tx_frame(_tx_data_buffer, data_frame_len, true));
+    _note_tx_result(data_result);
     if (data_result != PICONET_TX_RESULT_OK) {
         adlc_update_data_led(false);
         return data_result;
     }
 
-    if (!_wait_ack(station, network, _listen_addresses[0], 0x00)) {
+    adlc_trace_phase(ADLC_TRACE_PHASE_TX_DATA_ACK);
+    if (!_wait_ack(station, network, _listen_addresses[0], 0x00, TIMEOUT_WAIT_ACK_MS, NULL, 0)) {
         adlc_update_data_led(false);
         return PICONET_TX_RESULT_ERROR_NO_DATA_ACK;
     }
@@ -203,35 +247,62 @@ econet_tx_result_t transmit(
     return PICONET_TX_RESULT_OK;
 }
 
-econet_tx_result_t reply(uint16_t reply_id, const uint8_t* data, size_t data_len) {
+econet_tx_result_t reply(uint16_t reply_id, uint8_t control, uint8_t port, const uint8_t* data, size_t data_len) {
     if (!_initialised) {
         return PICONET_TX_RESULT_ERROR_UNINITIALISED;
     }
 
-    if (!_pending_reply.valid || _pending_reply.reply_id != reply_id) {
+    _expire_replies();
+
+    pending_reply_t* pending = &_pending_replies[reply_id % REPLY_TABLE_SZ];
+    if (!pending->valid || pending->reply_id != reply_id) {
         return PICONET_TX_RESULT_ERROR_INVALID_RECEIVE_ID;
     }
 
-    size_t data_frame_len = data_len + 2;
-    if (data_frame_len > _tx_data_buffer_sz) {
-        return PICONET_TX_RESULT_ERROR_OVERFLOW;
-    }
-    _tx_data_buffer[0] = _pending_reply.station;
-    _tx_data_buffer[1] = _pending_reply.net;
-    memcpy(_tx_data_buffer + 2, data, data_len);
+    // free the slot whatever the outcome: the requester retries with a new reply ID if it must
+    pending->valid = false;
 
-    _pending_reply.valid = false;
+    return transmit(pending->station, pending->net, control, port, data, data_len, NULL, 0);
+}
 
-    econet_tx_result_t data_result = _tx_result_for_frame_status(_tx_frame(_tx_data_buffer, data_frame_len, false));
-    if (data_result != PICONET_TX_RESULT_OK) {
-        return data_result;
+/*
+ * Asks a station for its machine type with an immediate operation (control byte 0x88, as
+ * answered by _handle_immediate_scout), waiting up to `timeout_ms` for the reply: a scout ack
+ * carrying the machine type, manufacturer and minor and major version numbers, which are
+ * copied to `machine_type`. An absent station gives PICONET_TX_RESULT_ERROR_NO_SCOUT_ACK.
+ */
+econet_tx_result_t peek_machine_type(
+        uint8_t         station,
+        uint8_t         network,
+        uint            timeout_ms,
+        uint8_t*        machine_type,
+        uint32_t*       response_us) {
+    if (!_initialised) {
+        return PICONET_TX_RESULT_ERROR_UNINITIALISED;
     }
 
-    if (!_wait_ack(_pending_reply.station, _pending_reply.net, _listen_addresses[0], 0x00)) {
-        return PICONET_TX_RESULT_ERROR_NO_DATA_ACK;
+    _tx_scout_buffer[0] = station;
+    _tx_scout_buffer[1] = network;
+    _tx_scout_buffer[2] = _listen_addresses[0];
+    _tx_scout_buffer[3] = 0x00;
+    _tx_scout_buffer[4] = 0x88;
+    _tx_scout_buffer[5] = 0x00;
+
+    adlc_update_data_led(true);
+    adlc_trace_phase(ADLC_TRACE_PHASE_TX_SCOUT);
+    econet_tx_result_t result = _tx_result_for_frame_status(_tx_frame(_tx_scout_buffer, 6, true));
+    _note_tx_result(result);
+    if (result == PICONET_TX_RESULT_OK) {
+        uint32_t sent_us = time_us_32();
+        adlc_trace_phase(ADLC_TRACE_PHASE_TX_SCOUT_ACK);
+        if (!_wait_ack(station, network, _listen_addresses[0], 0x00, timeout_ms, machine_type, ECONET_MACHINE_TYPE_SZ)) {
+            result = PICONET_TX_RESULT_ERROR_NO_SCOUT_ACK;
+        }
+        *response_us = time_us_32() - sent_us;
     }
 
-    return PICONET_TX_RESULT_OK;
+    adlc_update_data_led(false);
+    return result;
 }
 
 econet_rx_result_t receive() {
@@ -239,29 +310,38 @@ econet_rx_result_t receive() {
         return _rx_result_for_error(ECONET_RX_ERROR_UNINITIALISED);
     }
 
-    _check_reply_timeout();
+    adlc_trace_phase(ADLC_TRACE_PHASE_IDLE);
+    _expire_replies();
+
+    // an exchange which failed part way may have left the line held in flag fill
+    if (adlc_flag_fill_active()) {
+        adlc_write_cr2(CR2_CLEAR_TX_STATUS | CR2_CLEAR_RX_STATUS | CR2_PRIO_STATUS_ENABLE);
+    }
 
     econet_rx_result_t result;
     result.type = PICONET_RX_RESULT_NONE;
     result.error = ECONET_RX_ERROR_NONE;
 
     uint status_reg_1 = adlc_read(REG_STATUS_1);
+    bool stray_data = !(status_reg_1 & STATUS_1_S2_RD_REQ) && (status_reg_1 & STATUS_1_RDA);
 
     if (status_reg_1 & STATUS_1_S2_RD_REQ) {
         uint status_reg_2 = adlc_read(REG_STATUS_2);
 
         if (status_reg_2 & STATUS_2_ADDR_PRESENT) {
             adlc_update_data_led(true);
+            adlc_trace_phase(ADLC_TRACE_PHASE_RX_SCOUT);
             result = _handle_first_frame();
             adlc_update_data_led(false);
         }
 
         adlc_irq_reset();
-    } else if (status_reg_1 & STATUS_1_RDA) {
+    } else if (stray_data) {
         _abort_read();
         adlc_irq_reset();
     }
 
+    _note_stray_data(stray_data);
     return result;
 }
 
@@ -277,17 +357,49 @@ econet_rx_result_t monitor() {
     result.detail.scout = NULL;
     result.detail.scout_len = 0;
 
-    uint status_reg_1 = adlc_read(REG_STATUS_1);
+    adlc_trace_phase(ADLC_TRACE_PHASE_IDLE);
+
+    // whilst idle, SR1 is snooped so that polling for a frame doesn't occupy the bus
+    adlc_snoop_start(REG_STATUS_1, STATUS_1_S2_RD_REQ);
+    if (!adlc_snoop_latched() && !(adlc_snoop_read() & (STATUS_1_S2_RD_REQ | STATUS_1_RDA))) {
+        _stray_data_count = 0;
+        return result;
+    }
+    uint status_reg_1 = adlc_snoop_stop();
+    _note_stray_data(!(status_reg_1 & STATUS_1_S2_RD_REQ) && (status_reg_1 & STATUS_1_RDA));
 
     if (status_reg_1 & STATUS_1_S2_RD_REQ) {
+        uint32_t start_us = time_us_32();
         uint status_reg_2 = adlc_read(REG_STATUS_2);
 
-        if (status_reg_2 & STATUS_2_ADDR_PRESENT) {
+        if ((status_reg_2 & STATUS_2_ADDR_PRESENT) && _rx_data_buffer == NULL) {
+            // no room to report the frame: take its address so that it's discarded as a whole
+            adlc_read(REG_FIFO);
+            _flow_stats.dropped_frames++;
+            _abort_read();
+            if (_traffic != NULL) {
+                traffic_record(_traffic, NULL, 0, false, time_us_32() - start_us);
+            }
+        } else if (status_reg_2 & STATUS_2_ADDR_PRESENT) {
             adlc_update_data_led(true);
-            t_frame_read_result read_frame_result = _read_frame(_rx_data_buffer, _rx_data_buffer_sz, _listen_addresses, 0, 2000, false);
+            adlc_trace_phase(ADLC_TRACE_PHASE_MONITOR);
+
+            // frames are only counted in TRAFFIC mode, for which the addresses will do
+            size_t snaplen = (_traffic != NULL) ? TRAFFIC_HEADER_SZ : _snaplen;
+            size_t store_len = (snaplen > 0 && snaplen < _rx_data_buffer_sz) ? snaplen : _rx_data_buffer_sz;
+            t_frame_read_result read_frame_result = _read_frame(_rx_data_buffer, store_len, _listen_addresses, 0, 2000, false, snaplen > 0);
 
             adlc_update_data_led(false);
 
+            if (_traffic != NULL) {
+                traffic_record(
+                    _traffic,
+                    _rx_data_buffer,
+                    read_frame_result.frame_len,
+                    read_frame_result.status != FRAME_READ_OK,
+                    time_us_32() - start_us);
+            }
+
             if (read_frame_result.status != FRAME_READ_OK) {
                 return _map_read_frame_result(read_frame_result.status);
             }
@@ -295,6 +407,7 @@ econet_rx_result_t monitor() {
             result.type = PICONET_RX_RESULT_MONITOR;
             result.detail.data = _rx_data_buffer;
             result.detail.data_len = read_frame_result.bytes_read;
+            result.detail.frame_len = (_snaplen > 0) ? read_frame_result.frame_len : 0;
         }
 
         adlc_irq_reset();
@@ -306,6 +419,80 @@ econet_rx_result_t monitor() {
     return result;
 }
 
+/*
+ * Sends `count` frames of `frame_len` bytes (from the TX data buffer) through the ADLC in loop
+ * mode, where the transmitter feeds the receiver rather than the line, reading each back and
+ * checking it. Measures the firmware's frame handling against the line clock without
+ * disturbing other stations, though frames arriving from the network meanwhile are missed.
+ *
+ * Returns false, without running, if the frame length is out of range.
+ */
+bool econet_bench(size_t frame_len, uint count, econet_bench_stats_t* stats) {
+    memset(stats, 0, sizeof(econet_bench_stats_t));
+    if (!_initialised || frame_len < 2 || frame_len > _tx_data_buffer_sz) {
+        return false;
+    }
+
+    for (size_t i = 0; i < frame_len; i++) {
+        _tx_data_buffer[i] = i * 7 + 1;
+    }
+
+    adlc_trace_phase(ADLC_TRACE_PHASE_IDLE);
+    adlc_write_cr1(CR1_TX_RESET | CR1_RX_RESET);
+    adlc_write_cr3(CR3_LOOP_MODE);
+
+    // discard anything received from the line before loop mode took effect
+    for (uint i = 0; i < BENCH_FLUSH_FRAMES_MAX && (adlc_read(REG_STATUS_1) & (STATUS_1_S2_RD_REQ | STATUS_1_RDA)); i++) {
+        adlc_read(REG_FIFO);
+        _abort_read();
+    }
+
+    uint32_t start_us = time_us_32();
+    uint32_t start_bus_cycles = adlc_bus_cycles();
+    for (uint i = 0; i < count; i++) {
+        // numbered, so that a stale frame can't pass for the current one
+        _tx_data_buffer[0] = i;
+
+        loop_frame_status_t status = _loop_frame(_tx_data_buffer, frame_len);
+        if (status == LOOP_FRAME_OK) {
+            stats->frames++;
+            _finish_tx(false);
+            continue;
+        }
+
+        stats->errors++;
+        if (status == LOOP_FRAME_UNDERRUN) {
+            stats->underruns++;
+        } else if (status == LOOP_FRAME_OVERRUN) {
+            stats->overruns++;
+        }
+        _abort_read();
+    }
+    stats->elapsed_us = time_us_32() - start_us;
+    stats->bus_cycles = adlc_bus_cycles() - start_bus_cycles;
+
+    adlc_write_cr1(CR1_TX_RESET | CR1_RX_RESET);
+    adlc_write_cr3(0);
+    _abort_read();
+    adlc_irq_reset();
+    return true;
+}
+
+/*
+ * Recovers the ADLC (see adlc_recover), leaving it listening. Called for the host's RESTART
+ * and RECOVER commands and when a stall is detected; any exchange in progress is abandoned.
+ */
+adlc_recovery_tier_t econet_recover(adlc_recovery_tier_t first_tier) {
+    adlc_trace_phase(ADLC_TRACE_PHASE_IDLE);
+    _jammed_count = 0;
+    _stray_data_count = 0;
+    return adlc_recover(first_tier);
+}
+
+const econet_stall_stats_t* get_stall_stats(void) {
+    return &_stall_stats;
+}
+
 uint8_t get_station() {
     return _listen_addresses[0];
 }
@@ -314,6 +501,26 @@ void set_station(uint8_t station) {
     _listen_addresses[0] = station;
 }
 
+void set_dedup_window(uint32_t window_ms) {
+    dedup_init(&_dedup, window_ms);
+}
+
+const dedup_cache_t* get_dedup_cache(void) {
+    return &_dedup;
+}
+
+const econet_flow_stats_t* get_flow_stats(void) {
+    return &_flow_stats;
+}
+
+void set_traffic_stats(traffic_stats_t* stats) {
+    _traffic = stats;
+}
+
+void set_snaplen(size_t snaplen) {
+    _snaplen = snaplen;
+}
+
 void set_tx_scout_buffer(
         uint8_t*    tx_scout_buffer,
         size_t      tx_scout_buffer_sz) {
@@ -418,20 +625,18 @@ static tFrameWriteStatus _tx_frame(uint8_t* buffer, size_t len, bool flag_fill)
 
     for (uint ptr = 0; ptr < len; ptr++) {
         // While not FC/TDRA set, loop until it is - or we get an error
-        while (true) {
-            uint sr1 = adlc_read(REG_STATUS_1);
-            if (sr1 & STATUS_1_TX_UNDERRUN) {
-                _finish_tx(false);
-                return FRAME_WRITE_UNDERRUN;
-            }
-            if (sr1 & STATUS_1_FRAME_COMPLETE) {
-                break; // We have TDRA
-            }
-
-            if (time_ms() > time_start_ms + TIMEOUT_WRITE_READY_MS) {
-                _finish_tx(false);
-                return FRAME_WRITE_READY_TIMEOUT;
-            }
+        sr1 = _wait_status(
+            REG_STATUS_1,
+            STATUS_1_FRAME_COMPLETE,
+            STATUS_1_FRAME_COMPLETE | STATUS_1_TX_UNDERRUN,
+            time_start_ms + TIMEOUT_WRITE_READY_MS);
+        if (sr1 & STATUS_1_TX_UNDERRUN) {
+            _finish_tx(false);
+            return FRAME_WRITE_UNDERRUN;
+        }
+        if (!(sr1 & STATUS_1_FRAME_COMPLETE)) {
+            _finish_tx(false);
+            return FRAME_WRITE_READY_TIMEOUT;
         }
 
         adlc_write_fifo(buffer[ptr]);
@@ -441,16 +646,11 @@ static tFrameWriteStatus _tx_frame(uint8_t* buffer, size_t len, bool flag_fill)
     adlc_write_cr1(CR1_TIE);
 
     // wait for IRQ
-    while (true) {
-        sr1 = adlc_read(REG_STATUS_1);
-        if (sr1 & STATUS_1_IRQ) {
-            break;
-        }
-        if (time_ms() > time_start_ms + TIMEOUT_WRITE_COMPLETE_MS) {
-            _finish_tx(false);
-            return FRAME_WRITE_READY_TIMEOUT;
-        }
-    };
+    sr1 = _wait_status(REG_STATUS_1, STATUS_1_IRQ, STATUS_1_IRQ, time_start_ms + TIMEOUT_WRITE_COMPLETE_MS);
+    if (!(sr1 & STATUS_1_IRQ)) {
+        _finish_tx(false);
+        return FRAME_WRITE_READY_TIMEOUT;
+    }
 
     _finish_tx(false);
 
@@ -484,12 +684,10 @@ static bool _wait_frame_start(uint32_t timeout_ms) {
     uint32_t time_start_ms = time_ms();
 
     while (true) {
-        while (!(adlc_read(REG_STATUS_1) & STATUS_1_S2_RD_REQ)) {
-            if (time_ms() > time_start_ms + timeout_ms) {
-                return false;
-            }
+        if (!_wait_status(REG_STATUS_1, STATUS_1_S2_RD_REQ, STATUS_1_S2_RD_REQ, time_start_ms + timeout_ms)) {
+            return false;
         }
-        
+
         if (adlc_read(REG_STATUS_2) & STATUS_2_ADDR_PRESENT) {
             break;
         }
@@ -499,6 +697,28 @@ static bool _wait_frame_start(uint32_t timeout_ms) {
     return true;
 }
 
+/*
+ * Waits for any of the bits in `mask` to be set in a status register, returning its value (or 0
+ * on timeout). The register is snooped rather than polled, with `latch_bit` catching any
+ * momentary change.
+ */
+static uint _wait_status(uint reg, uint latch_bit, uint mask, uint32_t deadline_ms) {
+    while (true) {
+        adlc_snoop_start(reg, latch_bit);
+        while (!adlc_snoop_latched() && !(adlc_snoop_read() & mask)) {
+            if (time_ms() > deadline_ms) {
+                return 0;
+            }
+            tight_loop_contents();
+        }
+
+        uint value = adlc_snoop_stop();
+        if (value & mask) {
+            return value;
+        }
+    }
+}
+
 static econet_rx_result_t _rx_result_for_error(econet_rx_error_t error) {
     econet_rx_result_t result;
     result.type = PICONET_RX_RESULT_ERROR;
@@ -519,16 +739,18 @@ static econet_tx_result_t _tx_result_for_frame_status(tFrameWriteStatus status)
     }
 }
 
-static bool _wait_ack(uint8_t from_station, uint8_t from_network, uint8_t to_station, uint8_t to_network) {
+// Waits for an ack from the given station, which must carry exactly `extra_data_len` bytes
+// after its addresses (copied to `extra_data`): none, except in reply to a peek.
+static bool _wait_ack(uint8_t from_station, uint8_t from_network, uint8_t to_station, uint8_t to_network, uint timeout_ms, uint8_t* extra_data, size_t extra_data_len) {
     t_frame_read_result ack_frame_result;
     while (true) {
         adlc_irq_reset();
 
-        if (!_wait_frame_start(TIMEOUT_WAIT_ACK_MS)) {
+        if (!_wait_frame_start(timeout_ms)) {
             return false;
         }
 
-        ack_frame_result = _read_frame(_ack_buffer, _ack_buffer_sz, _listen_addresses, 1, 2000, false);
+        ack_frame_result = _read_frame(_ack_buffer, _ack_buffer_sz, _listen_addresses, 1, 2000, false, false);
         if (ack_frame_result.status == FRAME_READ_OK) {
             break;
         }
@@ -537,7 +759,8 @@ static bool _wait_ack(uint8_t from_station, uint8_t from_network, uint8_t to_sta
     }
 
     t_frame_parse_result ack_frame = _parse_frame(_ack_buffer, ack_frame_result.bytes_read, false);
-    if (ack_frame.type != FRAME_TYPE_ACK
+    if (ack_frame.type == FRAME_TYPE_UNKNOWN
+            || ack_frame.frame.data_len != extra_data_len
             || ack_frame.frame.src_station != from_station || ack_frame.frame.src_net != from_network
             || ack_frame.frame.dest_station != to_station || ack_frame.frame.dest_net != to_network) {
         printf("ERROR [_wait_ack] unexpected frame! type %d from station %u to station %u\n",
@@ -547,16 +770,32 @@ static bool _wait_ack(uint8_t from_station, uint8_t from_network, uint8_t to_sta
         return false;
     }
 
+    if (extra_data_len > 0) {
+        memcpy(extra_data, ack_frame.frame.data, extra_data_len);
+    }
     return true;
 }
 
 static econet_rx_result_t _rx_data_for_scout(t_frame_parse_result* scout_frame) {
+    if (_rx_data_buffer == NULL) {
+        // no room to report the packet: leave the scout unacknowledged so that the sender backs
+        // off and retries, rather than stalling part way through the handshake
+        _flow_stats.declined_scouts++;
+        _abort_read();
+
+        econet_rx_result_t result;
+        result.type = PICONET_RX_RESULT_NONE;
+        return result;
+    }
+
+    adlc_trace_phase(ADLC_TRACE_PHASE_RX_SCOUT_ACK);
     tFrameWriteStatus scout_ack_result = _send_ack(scout_frame, NULL, 0, true);
     if (scout_ack_result != FRAME_WRITE_OK) {
         printf("ERROR [_rx_data_for_scout] scout ack failed code=%u\n", scout_ack_result);
         return _rx_result_for_error(ECONET_RX_ERROR_SCOUT_ACK);
     }
 
+    adlc_trace_phase(ADLC_TRACE_PHASE_RX_DATA);
     adlc_irq_reset();
 
     if (!_wait_frame_start(TIMEOUT_DATA_FRAME_MS)) {
@@ -570,6 +809,7 @@ static econet_rx_result_t _rx_data_for_scout(t_frame_parse_result* scout_frame)
         _listen_addresses,
         sizeof(_listen_addresses),
         TIMEOUT_READ_DATA_MS,
+        false,
         false);
     if (data_frame_result.status != FRAME_READ_OK) {
         printf("ERROR [_rx_data_for_scout] error reading data following scout ack, error code=%u\n", data_frame_result.status);
@@ -583,14 +823,35 @@ static econet_rx_result_t _rx_data_for_scout(t_frame_parse_result* scout_frame)
         return _rx_result_for_error(ECONET_RX_ERROR_MISC);
     }
 
+    adlc_trace_phase(ADLC_TRACE_PHASE_RX_DATA_ACK);
     tFrameWriteStatus data_ack_result = _send_ack(&data_frame, NULL, 0, false);
     if (data_ack_result != FRAME_WRITE_OK) {
         printf("ERROR [_rx_data_for_scout] data ack failed code=%u\n", data_ack_result);
         return _rx_result_for_error(ECONET_RX_ERROR_DATA_ACK);
     }
 
-    econet_rx_result_t result;
-    result.type = PICONET_RX_RESULT_TRANSMIT;
+    // zeroed so that nothing reported for an immediate operation looks like a reply ID, which
+    // only _handle_transmit_scout allocates
+    econet_rx_result_t result = { 0 };
+
+    // acked all the same, so that the sender stops retrying
+    if (dedup_check(
+            &_dedup,
+            (scout_frame->type == FRAME_TYPE_IMMEDIATE) ? DEDUP_KIND_IMMEDIATE : DEDUP_KIND_TRANSMIT,
+            scout_frame->frame.src_station,
+            scout_frame->frame.src_net,
+            scout_frame->frame.ctrl,
+            scout_frame->frame.port,
+            scout_frame->frame.data,
+            scout_frame->frame.data_len,
+            data_frame.frame.data,
+            data_frame.frame.data_len,
+            time_ms())) {
+        result.type = PICONET_RX_RESULT_NONE;
+        return result;
+    }
+
+    result.type = (scout_frame->type == FRAME_TYPE_IMMEDIATE) ? PICONET_RX_RESULT_IMMEDIATE_OP : PICONET_RX_RESULT_TRANSMIT;
     result.detail.scout = scout_frame->frame.frame;
     result.detail.scout_len = scout_frame->frame.frame_len;
     result.detail.data = data_frame.frame.frame;
@@ -632,18 +893,22 @@ static econet_rx_result_t _handle_immediate_scout(t_frame_parse_result* immediat
 static econet_rx_result_t _handle_transmit_scout(t_frame_parse_result* transmit_scout_frame) {
     econet_rx_result_t result = _rx_data_for_scout(transmit_scout_frame);
     if (result.type == PICONET_RX_RESULT_TRANSMIT) {
-        // set flag fill while we wait a reply
-        // adlc_write_cr2(CR2_CLEAR_TX_STATUS | CR2_CLEAR_RX_STATUS | CR2_FLAG_FILL | CR2_PRIO_STATUS_ENABLE);
+        // IDs are allocated in order, so the slot reused is always that of the oldest entry
+        uint16_t reply_id = _next_reply_id++;
+        if ((uint16_t) (_next_reply_id - _oldest_reply_id) > REPLY_TABLE_SZ) {
+            _oldest_reply_id++;
+        }
 
-        // _pending_reply.reply_id++;
-        // _pending_reply.expiry = time_ms() + 250; // TODO constant
-        // _pending_reply.station = transmit_scout_frame->frame.src_station;
-        // _pending_reply.net = transmit_scout_frame->frame.src_net;
-        // _pending_reply.valid = true;
+        pending_reply_t* pending = &_pending_replies[reply_id % REPLY_TABLE_SZ];
+        pending->reply_id = reply_id;
+        pending->expiry = time_ms() + TIMEOUT_REPLY_MS;
+        pending->station = transmit_scout_frame->frame.src_station;
+        pending->net = transmit_scout_frame->frame.src_net;
+        pending->valid = true;
 
-        // result.detail.needs_reply = true;
-        // result.detail.reply_id = _pending_reply.reply_id;
-    } else {
+        result.detail.needs_reply = true;
+        result.detail.reply_id = reply_id;
+    } else if (result.type != PICONET_RX_RESULT_NONE) {
         printf("ERROR [_handle_transmit_scout] unexpected result type=%u\n", result.type);
     }
 
@@ -651,12 +916,19 @@ static econet_rx_result_t _handle_transmit_scout(t_frame_parse_result* transmit_
 }
 
 static econet_rx_result_t _handle_broadcast(t_frame_parse_result* broadcast_frame) {
+    // the frame was read into the scout buffer, but is reported from the data buffer
+    size_t len = broadcast_frame->frame.frame_len;
+    if (len > _rx_data_buffer_sz) {
+        len = _rx_data_buffer_sz;
+    }
+    memcpy(_rx_data_buffer, broadcast_frame->frame.frame, len);
+
     econet_rx_result_t result;
     result.type = PICONET_RX_RESULT_BROADCAST;
     result.detail.scout = NULL;
     result.detail.scout_len = 0;
-    result.detail.data = broadcast_frame->frame.frame;
-    result.detail.data_len = broadcast_frame->frame.frame_len;
+    result.detail.data = _rx_data_buffer;
+    result.detail.data_len = len;
     return result;
 }
 
@@ -667,7 +939,8 @@ static econet_rx_result_t _handle_first_frame() {
         _listen_addresses,
         sizeof(_listen_addresses),
         TIMEOUT_READ_FIRST_FRAME_MS,
-        true);
+        true,
+        false);
 
     if (read_frame_result.status != FRAME_READ_OK) {
         printf("ERROR [_handle_first_frame] read failed code=%u - aborting\n", read_frame_result.status);
@@ -683,6 +956,26 @@ static econet_rx_result_t _handle_first_frame() {
             return _handle_immediate_scout(&result);
         case FRAME_TYPE_BROADCAST :
             _abort_read();
+            // before the duplicate check, so that a broadcast dropped for want of room isn't
+            // recorded as delivered and its repeat suppressed
+            if (_rx_data_buffer == NULL) {
+                _flow_stats.dropped_frames++;
+                break;
+            }
+            if (dedup_check(
+                    &_dedup,
+                    DEDUP_KIND_BROADCAST,
+                    result.frame.src_station,
+                    result.frame.src_net,
+                    result.frame.ctrl,
+                    result.frame.port,
+                    NULL,
+                    0,
+                    result.frame.data,
+                    result.frame.data_len,
+                    time_ms())) {
+                break;
+            }
             return _handle_broadcast(&result);
         default :
             printf("ERROR [_handle_first_frame] unexpected type=%u bytes_read=%u - aborting\n", result.type, read_frame_result.bytes_read);
@@ -695,9 +988,13 @@ static econet_rx_result_t _handle_first_frame() {
     return retval;
 }
 
-static t_frame_read_result _read_frame(uint8_t* buffer, size_t buffer_len, uint8_t* addr, size_t addr_len, uint timeout_ms, bool flag_fill) {
+// Reads a frame into `buffer`. If `truncate` is set, bytes beyond `buffer_len` are drained from
+// the FIFO and discarded, the frame still being checked to its end, rather than the read
+// failing with an overflow.
+static t_frame_read_result _read_frame(uint8_t* buffer, size_t buffer_len, uint8_t* addr, size_t addr_len, uint timeout_ms, bool flag_fill, bool truncate) {
     t_frame_read_result result = {
         FRAME_READ_ERROR_UNEXPECTED,
+        0,
         0
     };
     uint stat = 0;
@@ -710,6 +1007,7 @@ static t_frame_read_result _read_frame(uint8_t* buffer, size_t buffer_len, uint8
 
     // First byte should be address
     buffer[result.bytes_read++] = adlc_read(REG_FIFO);
+    result.frame_len++;
     if (addr_len > 0) {
         bool discard = true;
         for (uint i = 0; i < addr_len; i++) {
@@ -730,15 +1028,16 @@ static t_frame_read_result _read_frame(uint8_t* buffer, size_t buffer_len, uint8
 
     bool frame_valid = false;
     while (!frame_valid) {
-        do {
-            if (time_ms() > time_start_ms + timeout_ms) {
-                _abort_read();
-                result.status = FRAME_READ_ERROR_TIMEOUT;
-                return result;
-            }
-
-            stat = adlc_read(REG_STATUS_2);
-        } while (!(stat & (STATUS_2_RDA | STATUS_2_FRAME_VALID | STATUS_2_ABORT_RX | STATUS_2_FCS_ERROR | STATUS_2_RX_OVERRUN)));
+        stat = _wait_status(
+            REG_STATUS_2,
+            STATUS_2_RDA,
+            STATUS_2_RDA | STATUS_2_FRAME_VALID | STATUS_2_ABORT_RX | STATUS_2_FCS_ERROR | STATUS_2_RX_OVERRUN,
+            time_start_ms + timeout_ms);
+        if (stat == 0) {
+            _abort_read();
+            result.status = FRAME_READ_ERROR_TIMEOUT;
+            return result;
+        }
 
         if (stat & (STATUS_2_ABORT_RX | STATUS_2_FCS_ERROR | STATUS_2_RX_OVERRUN)) {
             if (stat & STATUS_2_ABORT_RX) {
@@ -753,13 +1052,17 @@ static t_frame_read_result _read_frame(uint8_t* buffer, size_t buffer_len, uint8
         }
 
         if (stat & (STATUS_2_FRAME_VALID | STATUS_2_RDA)) {
-            if (result.bytes_read >= buffer_len) {
+            if (result.bytes_read >= buffer_len && !truncate) {
                 _abort_read();
                 result.status = FRAME_READ_ERROR_OVERFLOW;
                 return result;
             }
 
-            buffer[result.bytes_read++] = adlc_read(REG_FIFO);
+            uint8_t value = adlc_read(REG_FIFO);
+            if (result.bytes_read < buffer_len) {
+                buffer[result.bytes_read++] = value;
+            }
+            result.frame_len++;
         }
 
         frame_valid = (stat & STATUS_2_FRAME_VALID);
@@ -771,14 +1074,21 @@ static t_frame_read_result _read_frame(uint8_t* buffer, size_t buffer_len, uint8
     return result;
 }
 
-static void _check_reply_timeout(void) {
-    if (_pending_reply.valid && (time_ms() < _pending_reply.expiry)) {
+static void _expire_replies(void) {
+    if (_oldest_reply_id == _next_reply_id) {
         return;
     }
 
-    // client failed to reply in time - stop idle flag to avoid jamming network
-    _pending_reply.valid = false;
-    adlc_write_cr2(CR2_CLEAR_TX_STATUS | CR2_CLEAR_RX_STATUS | CR2_PRIO_STATUS_ENABLE);
+    // entries share a timeout and are armed in ID order, so they expire in ID order too
+    uint32_t now = time_ms();
+    while (_oldest_reply_id != _next_reply_id) {
+        pending_reply_t* pending = &_pending_replies[_oldest_reply_id % REPLY_TABLE_SZ];
+        if (pending->valid && (int32_t) (pending->expiry - now) > 0) {
+            break;
+        }
+        pending->valid = false;
+        _oldest_reply_id++;
+    }
 }
 
 static econet_rx_result_t _map_read_frame_result(t_frame_read_status status) {
@@ -819,6 +1129,95 @@ static econet_rx_result_t _map_read_frame_result(t_frame_read_status status) {
     return result;
 }
 
+/*
+ * Transmits a frame in loop mode whilst reading it back. The receiver starts filling as soon as
+ * the first byte goes out, so unlike _tx_frame and _read_frame (whose register sequences these
+ * follow) the two have to be serviced together: each wait is for whichever side is ready first.
+ * RTS isn't raised, as the frame needn't reach the line.
+ */
+static loop_frame_status_t _loop_frame(const uint8_t* frame, size_t len) {
+    uint32_t deadline_ms = time_ms() + TIMEOUT_BENCH_FRAME_MS;
+    size_t tx_pos = 0;
+    size_t rx_pos = 0;
+    bool mismatch = false;
+
+    adlc_write_cr2(CR2_CLEAR_TX_STATUS | CR2_CLEAR_RX_STATUS | CR2_PRIO_STATUS_ENABLE);
+    adlc_write_cr1(0);
+
+    while (true) {
+        bool sending = tx_pos < len;
+        uint sr1 = _wait_status(
+            REG_STATUS_1,
+            sending ? STATUS_1_FRAME_COMPLETE : STATUS_1_S2_RD_REQ,
+            STATUS_1_S2_RD_REQ | STATUS_1_RDA | STATUS_1_TX_UNDERRUN | (sending ? STATUS_1_FRAME_COMPLETE : 0),
+            deadline_ms);
+        if (sr1 == 0) {
+            return LOOP_FRAME_TIMEOUT;
+        }
+        if (sr1 & STATUS_1_TX_UNDERRUN) {
+            return LOOP_FRAME_UNDERRUN;
+        }
+
+        if (sr1 & (STATUS_1_S2_RD_REQ | STATUS_1_RDA)) {
+            uint sr2 = (sr1 & STATUS_1_S2_RD_REQ) ? adlc_read(REG_STATUS_2) : STATUS_2_RDA;
+            if (sr2 & STATUS_2_RX_OVERRUN) {
+                return LOOP_FRAME_OVERRUN;
+            }
+            if (sr2 & (STATUS_2_ABORT_RX | STATUS_2_FCS_ERROR)) {
+                return LOOP_FRAME_CORRUPT;
+            }
+
+            if (sr2 & (STATUS_2_ADDR_PRESENT | STATUS_2_RDA | STATUS_2_FRAME_VALID)) {
+                uint8_t value = adlc_read(REG_FIFO);
+                mismatch |= (rx_pos >= len || value != frame[rx_pos]);
+                rx_pos++;
+
+                if (sr2 & STATUS_2_FRAME_VALID) {
+                    return (mismatch || rx_pos != len) ? LOOP_FRAME_CORRUPT : LOOP_FRAME_OK;
+                }
+            } else {
+                // some other condition (e.g. idle) requesting a status 2 read
+                adlc_write_cr2(CR2_CLEAR_RX_STATUS | CR2_PRIO_STATUS_ENABLE);
+            }
+        }
+
+        if (sending && (sr1 & STATUS_1_FRAME_COMPLETE)) {
+            adlc_write_fifo(frame[tx_pos++]);
+            if (tx_pos == len) {
+                adlc_write_cr2(CR2_TX_LAST_DATA | CR2_FRAME_COMPLETE | CR2_PRIO_STATUS_ENABLE);
+            }
+        }
+    }
+}
+
+// A transmitter which can't start a frame is usually held off by a busy line, but one which
+// fails several times running may itself be stuck
+static void _note_tx_result(econet_tx_result_t result) {
+    if (result != PICONET_TX_RESULT_ERROR_LINE_JAMMED) {
+        _jammed_count = 0;
+        return;
+    }
+
+    if (++_jammed_count >= STALL_JAMMED_LIMIT) {
+        _stall_stats.line_jammed++;
+        econet_recover(ADLC_RECOVERY_SOFT);
+    }
+}
+
+// Received data without an address is discarded, so seeing it on each of several polls running
+// means the receiver isn't taking notice
+static void _note_stray_data(bool stray) {
+    if (!stray) {
+        _stray_data_count = 0;
+        return;
+    }
+
+    if (++_stray_data_count >= STALL_STRAY_DATA_LIMIT) {
+        _stall_stats.stuck_fifo++;
+        econet_recover(ADLC_RECOVERY_SOFT);
+    }
+}
+
 static void _abort_read(void) {
     adlc_write_cr2(CR2_PRIO_STATUS_ENABLE | CR2_CLEAR_RX_STATUS | CR2_CLEAR_TX_STATUS | CR2_FLAG_FILL | CR2_2_BYTE_TRANSFER);
     adlc_write_cr1(CR1_RX_FRAME_DISCONTINUE | CR1_RIE | CR1_RX_RESET | CR1_TX_RESET);
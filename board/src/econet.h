@@ -3,6 +3,13 @@
 
 #include "pico/stdlib.h"
 
+#include "adlc.h"
+#include "dedup.h"
+#include "traffic.h"
+
+// Bytes of a reply to a machine type peek: machine type, manufacturer, minor and major version
+#define ECONET_MACHINE_TYPE_SZ  4
+
 typedef enum {
     PICONET_TX_RESULT_OK = 0L,
     PICONET_TX_RESULT_ERROR_UNINITIALISED,
@@ -13,6 +20,7 @@ typedef enum {
     PICONET_TX_RESULT_ERROR_NO_DATA_ACK,
     PICONET_TX_RESULT_ERROR_TIMEOUT,
     PICONET_TX_RESULT_ERROR_INVALID_RECEIVE_ID,
+    PICONET_TX_RESULT_ERROR_INVALID_COMMAND,
     PICONET_TX_RESULT_ERROR_MISC
 } econet_tx_result_t;
 
@@ -43,6 +51,8 @@ typedef struct {
     size_t      scout_len;
     uint8_t*    data;
     size_t      data_len;
+    size_t      frame_len;      // before truncation to the snap length, or 0 if none is set
+                                // (PICONET_RX_RESULT_MONITOR only)
     bool        needs_reply;
     uint16_t    reply_id;
 } econet_rx_result_detail_t;
@@ -56,6 +66,29 @@ typedef struct
     };
 } econet_rx_result_t;
 
+// Frames turned away because no receive buffer was provided (see set_rx_data_buffer)
+typedef struct {
+    uint32_t    declined_scouts;        // transmit/immediate scouts left unacknowledged
+    uint32_t    dropped_frames;         // broadcast (or monitored) frames discarded
+} econet_flow_stats_t;
+
+// Stalls detected whilst handling frames, each of which triggered recovery of the ADLC (see
+// econet_recover)
+typedef struct {
+    uint32_t    line_jammed;            // transmissions failing LINE_JAMMED several times running
+    uint32_t    stuck_fifo;             // receive FIFO still holding data after discarding it
+} econet_stall_stats_t;
+
+// Results of a loop mode self-benchmark (see econet_bench)
+typedef struct {
+    uint32_t    frames;                 // frames read back intact
+    uint32_t    errors;                 // frames read back corrupt or not at all, including...
+    uint32_t    underruns;              // ...those lost to transmitter underrun
+    uint32_t    overruns;               // ...and receiver overrun
+    uint32_t    elapsed_us;
+    uint32_t    bus_cycles;             // bus transactions requested by the CPU
+} econet_bench_stats_t;
+
 bool                    econet_init(void);
 econet_tx_result_t      broadcast(
                             const uint8_t*  data,
@@ -72,12 +105,27 @@ econet_tx_result_t      transmit(
 econet_rx_result_t      receive();
 econet_tx_result_t      reply(
                             uint16_t        reply_id,
+                            uint8_t         control,
+                            uint8_t         port,
                             const uint8_t*  data,
                             size_t          data_len);
-void                    check_reply_timeout(void);
 econet_rx_result_t      monitor();
+econet_tx_result_t      peek_machine_type(
+                            uint8_t         station,
+                            uint8_t         network,
+                            uint            timeout_ms,
+                            uint8_t*        machine_type,
+                            uint32_t*       response_us);
+bool                    econet_bench(size_t frame_len, uint count, econet_bench_stats_t* stats);
+adlc_recovery_tier_t    econet_recover(adlc_recovery_tier_t first_tier);
+const econet_stall_stats_t* get_stall_stats(void);
 uint8_t                 get_station();
 void                    set_station(uint8_t station);
+void                    set_dedup_window(uint32_t window_ms);
+const dedup_cache_t*    get_dedup_cache(void);
+const econet_flow_stats_t* get_flow_stats(void);
+void                    set_traffic_stats(traffic_stats_t* stats);
+void                    set_snaplen(size_t snaplen);
 void                    set_tx_scout_buffer(uint8_t* tx_scout_buffer, size_t tx_scout_buffer_sz);
 void                    set_tx_data_buffer(uint8_t* tx_data_buffer, size_t tx_data_buffer_sz);
 void                    set_rx_scout_buffer(uint8_t* rx_scout_buffer, size_t rx_scout_buffer_sz);
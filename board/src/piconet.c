@@ -7,57 +7,57 @@
 #include "pico/multicore.h"
 #include "hardware/gpio.h"
 #include "hardware/clocks.h"
+#include "hardware/sync.h"
 
 #include "econet.h"
 #include "adlc.h"
 #include "util.h"
 #include "buffer_pool.h"
-#include "./lib/b64/cencode.h"
-#include "./lib/b64/cdecode.h"
+#include "command_parser.h"
+#include "compress.h"
+#include "base64.h"
+#include "usb_io.h"
 
 #define VERSION_MAJOR           2
 #define VERSION_MINOR           0
 #define VERSION_REV             20
 #define VERSION_STR_MAXLEN      17
 
-#define TX_DATA_BUFFER_SZ       3500
 #define RX_DATA_BUFFER_SZ       16536
 #define TX_SCOUT_BUFFER_SZ      32
 #define RX_SCOUT_BUFFER_SZ      32
 #define ACK_BUFFER_SZ           32
-#define B64_SCOUT_BUFFER_SZ     RX_SCOUT_BUFFER_SZ * 2
-#define B64_DATA_BUFFER_SZ      RX_DATA_BUFFER_SZ * 2
-#define CMD_BUFFER_SZ           TX_DATA_BUFFER_SZ * 2
+#define B64_SCOUT_BUFFER_SZ     (BASE64_ENCODED_LEN(RX_SCOUT_BUFFER_SZ) + 1)
+#define B64_DATA_BUFFER_SZ      (BASE64_ENCODED_LEN(COMPRESS_MAX_OUTPUT(RX_DATA_BUFFER_SZ)) + 2)  // incl. '~'
+#define B64_REPORT_BUFFER_SZ    (BASE64_ENCODED_LEN(ADLC_TRACE_SZ * sizeof(adlc_trace_entry_t)) + 1)  // TRACE, the longest
+#define RX_HEADER_SZ            (B64_SCOUT_BUFFER_SZ + 32)      // of an RX_xxx, MONITOR or ERROR line
+#define INPUT_RING_SZ           1024
 
+#define RX_BUFFER_COUNT         6
 #define QUEUE_SZ_CMD            1
-#define QUEUE_SZ_EVENT          6
+#define QUEUE_SZ_EVENT          (RX_BUFFER_COUNT + 2)   // room for every RX buffer plus errors
+#define QUEUE_SZ_CONTROL        4                       // results and reports, apart from frames
 
-#define CMD_STATUS              "STATUS"
-#define CMD_RESTART             "RESTART"
-#define CMD_SET_MODE            "SET_MODE"
-#define CMD_SET_STATION         "SET_STATION"
-#define CMD_TX                  "TX"
-#define CMD_REPLY               "REPLY"
-#define CMD_BCAST               "BCAST"
-#define CMD_TEST                "TEST"
+// Event queue occupancy at which the host is warned that it's falling behind, and at which it's
+// told it has caught up again
+#define FLOW_HIGH_WATERMARK     (RX_BUFFER_COUNT - 1)
+#define FLOW_LOW_WATERMARK      1
 
-#define CMD_PARAM_MODE_STOP     "STOP"
-#define CMD_PARAM_MODE_LISTEN   "LISTEN"
-#define CMD_PARAM_MODE_MONITOR  "MONITOR"
+#define CORE0_TICK_US           1000
 
 typedef enum ePiconetEventType {
     PICONET_STATUS_EVENT = 0L,
     PICONET_RX_EVENT,
     PICONET_TX_EVENT,
-    PICONET_REPLY_EVENT
+    PICONET_REPLY_EVENT,
+    PICONET_DEDUP_EVENT,
+    PICONET_BENCH_EVENT,
+    PICONET_RECOVERY_EVENT,
+    PICONET_TRAFFIC_EVENT,
+    PICONET_SCAN_STATION_EVENT,
+    PICONET_SCAN_EVENT
 } tPiconetEventType;
 
-typedef enum {
-    PICONET_CMD_SET_MODE_STOP = 0L,
-    PICONET_CMD_SET_MODE_LISTEN,
-    PICONET_CMD_SET_MODE_MONITOR
-} piconet_mode_t;
-
 typedef struct {
     econet_rx_result_type_t type;
     econet_rx_error_t       error;
@@ -65,6 +65,7 @@ typedef struct {
     size_t                  scout_len;
     uint                    data_buffer_handle;
     size_t                  data_len;
+    size_t                  frame_len;      // before truncation, if SET_SNAPLEN is in effect
     uint16_t                reply_id;
 } econet_rx_event_t;
 
@@ -79,6 +80,41 @@ typedef struct {
     piconet_mode_t          mode;
 } event_status_t;
 
+typedef struct {
+    uint32_t                window_ms;
+    uint32_t                suppressed[DEDUP_KIND_COUNT];
+} event_dedup_t;
+
+typedef struct {
+    bool                    valid;      // false if the frame length was out of range
+    uint16_t                frame_len;
+    econet_bench_stats_t    stats;
+} event_bench_t;
+
+typedef struct {
+    adlc_recovery_stats_t   adlc;
+    econet_stall_stats_t    stalls;
+} event_recovery_t;
+
+typedef struct {
+    const traffic_stats_t*  stats;      // owned by core0 until it clears traffic_report
+    uint32_t                elapsed_us;
+} event_traffic_t;
+
+typedef struct {
+    uint8_t                 station;
+    uint8_t                 network;
+    uint8_t                 machine_type[ECONET_MACHINE_TYPE_SZ];
+    uint32_t                response_us;
+} event_scan_station_t;
+
+typedef struct {
+    econet_tx_result_t      result;     // OK unless the scan was cut short
+    uint16_t                probed;
+    uint16_t                found;
+    uint32_t                elapsed_us;
+} event_scan_t;
+
 typedef struct
 {
     tPiconetEventType type;
@@ -87,190 +123,363 @@ typedef struct
         econet_tx_event_t   tx_event_detail;    // if type == PICONET_TX_EVENT
         econet_tx_event_t   reply_event_detail;    // if type == PICONET_REPLY_EVENT
         event_status_t      status;             // if type == PICONET_STATUS_EVENT
+        event_dedup_t       dedup;              // if type == PICONET_DEDUP_EVENT
+        event_bench_t       bench;              // if type == PICONET_BENCH_EVENT
+        event_recovery_t    recovery;           // if type == PICONET_RECOVERY_EVENT
+        event_traffic_t     traffic;            // if type == PICONET_TRAFFIC_EVENT
+        event_scan_station_t scan_station;      // if type == PICONET_SCAN_STATION_EVENT
+        event_scan_t        scan;               // if type == PICONET_SCAN_EVENT
     };
 } event_t;
 
+// Work serviced by core0, highest priority first
 typedef enum {
-    PICONET_CMD_STATUS = 0L,
-    PICONET_CMD_RESTART,
-    PICONET_CMD_SET_MODE,
-    PICONET_CMD_SET_STATION,
-    PICONET_CMD_TX,
-    PICONET_CMD_REPLY,
-    PICONET_CMD_BCAST,
-    PICONET_CMD_TEST,
-} cmd_type_t;
+    WORK_COMMAND_INPUT = 0L,
+    WORK_CONTROL_OUTPUT,
+    WORK_EVENT_OUTPUT,
+    WORK_ITEM_COUNT
+} work_item_t;
 
-typedef struct {
-    uint8_t                 dest_station;
-    uint8_t                 dest_network;
-    uint8_t                 control_byte;
-    uint8_t                 port;
-    uint8_t                 data[TX_DATA_BUFFER_SZ];
-    size_t                  data_len;
-    uint8_t                 scout_extra_data[TX_DATA_BUFFER_SZ]; // TODO: really this long?
-    size_t                  scout_extra_data_len;
-} cmd_tx_t;
+#define WORK_BIT(item)          (1u << (item))
+#define WORK_ALL                (WORK_BIT(WORK_ITEM_COUNT) - 1)
 
-typedef struct {
-    uint8_t                 data[TX_DATA_BUFFER_SZ];
-    size_t                  data_len;
-} cmd_bcast_t;
-
-typedef struct {
-    uint16_t                reply_id;
-    uint8_t                 data[TX_DATA_BUFFER_SZ];
-    size_t                  data_len;
-} cmd_reply_t;
-
-typedef struct {
-    cmd_type_t type;
-    union {
-        piconet_mode_t      set_mode;   // if type == PICONET_CMD_SET_MODE
-        cmd_tx_t            tx;         // if type == PICONET_CMD_TX
-        cmd_reply_t         reply;      // if type == PICONET_CMD_REPLY
-        cmd_bcast_t         bcast;      // if type == PICONET_CMD_BCAST
-        uint8_t             station;    // if type == PICONET_CMD_ACK
-    };
-} command_t;
+// Doorbells rung by core1 through the inter-core FIFO, each being the work it creates for core0
+#define DOORBELL_EVENT          WORK_BIT(WORK_EVENT_OUTPUT)
+#define DOORBELL_CONTROL        WORK_BIT(WORK_CONTROL_OUTPUT)
+#define DOORBELL_COMMAND_TAKEN  WORK_BIT(WORK_COMMAND_INPUT)
 
 queue_t     command_queue;
-queue_t     event_queue;
+queue_t     event_queue;         // frames received (and receive errors) for the data channel
+queue_t     control_queue;       // everything else, for the control channel
 command_t   cmd;
+parser_t    cmd_parser;
 char*       b64_scout_buffer;
-char*       b64_data_buffer;
+char*       b64_data_buffer;     // the frame going out on the data channel (see usb_start_line)
+char*       b64_report_buffer;
+char        rx_header[RX_HEADER_SZ];
+compressor_t* compressor;
+uint8_t*    compressed_buffer;
+uint64_t    compression_us;
+bool        compression_enabled;
 pool_t      rx_buffer_pool;
+volatile uint32_t core0_work;
+
+// Event credits for flow control. Each count has a single writer (granted: core0, consumed:
+// core1), so neither needs a lock.
+volatile bool     flow_enabled;
+volatile uint32_t credits_granted;
+volatile uint32_t credits_consumed;
+volatile bool     rx_starved;         // core1 had no room for another frame when it last looked
+bool              flow_high;
+econet_flow_stats_t flow_baseline;    // counters when SET_FLOW was last sent
+volatile uint32_t dropped_errors;     // RX errors not reported for want of room (written by core1)
+uint32_t          dropped_errors_baseline;
+
+// Traffic counted in TRAFFIC mode. Core1 counts into one set whilst core0 reports the other,
+// core1 handing them over in a TRAFFIC event and core0 handing them back by clearing the
+// pointer once done.
+traffic_stats_t   traffic_stats[2];
+traffic_stats_t* volatile traffic_report;
 
 void    _core0_loop(void);
 void    _core1_loop(void);
 char*   _tx_error_to_str(econet_tx_result_t error);
 char*   _rx_error_to_str(econet_rx_error_t error);
-void    _read_command_input(void);
-char*   _encode_base64(char* output_buffer, const uint8_t* input, size_t len);
-size_t  _decode_base64(const char* input, uint8_t* output_buffer);
+void    _post_work(uint32_t work);
+void    _on_usb_rx(void);
+bool    _on_core0_tick(repeating_timer_t* timer);
+bool    _service_command_input(void);
+bool    _service_control_output(void);
+bool    _service_event_output(void);
+void    _print_event(const event_t* event);
+void    _post_event(event_t* event);
+void    _ring_doorbell(uint32_t doorbell);
+char*   _encode_base64(char* output_buffer, size_t capacity, const uint8_t* input, size_t len);
+char*   _encode_data(const uint8_t* input, size_t len);
+bool    _expects_tx_result(cmd_type_t type);
+bool    _handle_core0_command(const command_t* command);
+void    _print_compression_status(void);
+void    _print_trace(void);
+void    _print_flow_status(void);
+void    _print_usb_status(void);
+void    _print_bench(const event_bench_t* bench);
+void    _print_recovery(const event_recovery_t* recovery);
+void    _print_traffic(const event_traffic_t* traffic);
+void    _scan_stations(const cmd_scan_t* scan);
+void    _update_watermark(void);
+bool    _rx_room(void);
 void    _test_board(void);
 
 int main() {
-    stdio_init_all();
+    usb_init(_on_usb_rx);
 
-    if (!pool_init(&rx_buffer_pool, RX_DATA_BUFFER_SZ, QUEUE_SZ_EVENT)) {
-        printf("ERROR Failed to allocate memory for RX data buffers\n");
+    if (!pool_init(&rx_buffer_pool, RX_DATA_BUFFER_SZ, RX_BUFFER_COUNT)) {
+        usb_printf(USB_CHANNEL_CONTROL, "ERROR Failed to allocate memory for RX data buffers\n");
         return 1;
     }
 
     b64_scout_buffer = malloc(B64_SCOUT_BUFFER_SZ);
     if (b64_scout_buffer == NULL) {
-        printf("ERROR Failed to allocate memory for base64 scout buffer\n");
+        usb_printf(USB_CHANNEL_CONTROL, "ERROR Failed to allocate memory for base64 scout buffer\n");
         return 1;
     }
 
     b64_data_buffer = malloc(B64_DATA_BUFFER_SZ);
     if (b64_data_buffer == NULL) {
-        printf("ERROR Failed to allocate memory for base64 data buffer\n");
+        usb_printf(USB_CHANNEL_CONTROL, "ERROR Failed to allocate memory for base64 data buffer\n");
         return 1;
     }
 
+    b64_report_buffer = malloc(B64_REPORT_BUFFER_SZ);
+    if (b64_report_buffer == NULL) {
+        usb_printf(USB_CHANNEL_CONTROL, "ERROR Failed to allocate memory for base64 report buffer\n");
+        return 1;
+    }
+
+    parser_init(&cmd_parser, &cmd);
     queue_init(&command_queue, sizeof(command_t), QUEUE_SZ_CMD);
     queue_init(&event_queue, sizeof(event_t), QUEUE_SZ_EVENT);
+    queue_init(&control_queue, sizeof(event_t), QUEUE_SZ_CONTROL);
     multicore_launch_core1(_core1_loop);
 
     _core0_loop();
 }
 
 void _core0_loop(void) {
-    event_t event;
+    static bool (* const handlers[WORK_ITEM_COUNT])(void) = {
+        [WORK_COMMAND_INPUT]    = _service_command_input,
+        [WORK_CONTROL_OUTPUT]   = _service_control_output,
+        [WORK_EVENT_OUTPUT]     = _service_event_output,
+    };
+    repeating_timer_t tick_timer;
+
+    add_repeating_timer_us(-CORE0_TICK_US, _on_core0_tick, NULL, &tick_timer);
+    _post_work(WORK_ALL);
+
     while (true) {
-        _read_command_input();
+        // runs the USB stack's callbacks, e.g. _on_usb_rx()
+        usb_task();
+
+        while (multicore_fifo_rvalid()) {
+            _post_work(multicore_fifo_pop_blocking());
+        }
+
+        uint32_t irq_status = save_and_disable_interrupts();
+        uint32_t work = core0_work;
+        core0_work = 0;
+        restore_interrupts(irq_status);
 
-        if (!queue_try_remove(&event_queue, &event)) {
+        if (work == 0) {
+            // woken by a doorbell from core1 (which executes SEV), or by the USB or tick IRQs
+            __wfe();
             continue;
         }
-        switch (event.type) {
-            case PICONET_STATUS_EVENT: {
-                printf(
-                    "STATUS %s %d %02x %d\n",
-                    event.status.version,
-                    event.status.station,
-                    event.status.status_register_1,
-                    event.status.mode);
-                break;
-            }
 
-            case PICONET_TX_EVENT: {
-                printf("TX_RESULT %s\n", _tx_error_to_str(event.tx_event_detail.type));
-                break;
-            }
+        // service only the most important item before looking for new work, so that a burst
+        // of events from core1 can't hold up command input
+        work_item_t item = __builtin_ctz(work);
+        work &= ~WORK_BIT(item);
+        if (handlers[item]()) {
+            work |= WORK_BIT(item);
+        }
+        _post_work(work);
+    }
+}
 
-            case PICONET_REPLY_EVENT: {
-                printf("REPLY_RESULT %s\n", _tx_error_to_str(event.reply_event_detail.type));
-                break;
-            }
+void _post_work(uint32_t work) {
+    uint32_t irq_status = save_and_disable_interrupts();
+    core0_work |= work;
+    restore_interrupts(irq_status);
+}
 
-            case PICONET_RX_EVENT: {
-                if (event.rx_event_detail.type == PICONET_RX_RESULT_ERROR) {
-                    printf("ERROR %s\n", _rx_error_to_str(event.rx_event_detail.error));
-                    break;
-                }
+void _on_usb_rx(void) {
+    _post_work(WORK_BIT(WORK_COMMAND_INPUT));
+}
 
-                buffer_t* buffer = pool_buffer_get(&rx_buffer_pool, event.rx_event_detail.data_buffer_handle);
-                if (buffer == NULL) {
-                    printf("ERROR Failed to get RX data buffer - logic error\n");
-                    break;
-                }
- 
-                switch (event.rx_event_detail.type) {
-                    case PICONET_RX_RESULT_MONITOR :
-                        printf("MONITOR %s\n", _encode_base64(
-                            b64_data_buffer,
-                            buffer->data,
-                            event.rx_event_detail.data_len));
-                        break;
-                    case PICONET_RX_RESULT_BROADCAST :
-                        printf("RX_BROADCAST %s\n", _encode_base64(
-                            b64_data_buffer,
-                            buffer->data,
-                            event.rx_event_detail.data_len));
-                        break;
-                    case PICONET_RX_RESULT_IMMEDIATE_OP :
-                        printf(
-                            "RX_IMMEDIATE %s %s\n",
-                            _encode_base64(
-                                b64_scout_buffer,
-                                event.rx_event_detail.scout,
-                                event.rx_event_detail.scout_len),
-                            _encode_base64(
-                                b64_data_buffer,
-                                buffer->data,
-                                event.rx_event_detail.data_len));
-                        break;
-                    case PICONET_RX_RESULT_TRANSMIT :
-                        printf(
-                            "RX_TRANSMIT %s %s\n",
-                            _encode_base64(
-                                b64_scout_buffer,
-                                event.rx_event_detail.scout,
-                                event.rx_event_detail.scout_len),
-                            _encode_base64(
-                                b64_data_buffer,
-                                buffer->data,
-                                event.rx_event_detail.data_len));
-                        break;
-                    default :
-                        // do nothing if no data or error (latter handled above)
-                        break;
-                }
+bool _on_core0_tick(repeating_timer_t* timer) {
+    // catches up with anything missed, e.g. if core1 found the FIFO full
+    _post_work(WORK_ALL);
+    __sev();
+    return true;
+}
+
+bool _service_control_output(void) {
+    event_t event;
+    if (!queue_try_remove(&control_queue, &event)) {
+        return false;
+    }
+
+    _print_event(&event);
+    return !queue_is_empty(&control_queue);
+}
+
+bool _service_event_output(void) {
+    _update_watermark();
+
+    // usb_task() carries on writing the last frame as the host makes room for it, and the tick
+    // brings core0 back to try again. A host slow to read frames thus holds them up in the event
+    // queue rather than core0 in a USB write.
+    if (usb_line_pending(USB_CHANNEL_DATA)) {
+        return false;
+    }
+
+    event_t event;
+    if (!queue_try_remove(&event_queue, &event)) {
+        return false;
+    }
+
+    _print_event(&event);
+    return !queue_is_empty(&event_queue);
+}
+
+void _print_event(const event_t* event) {
+    switch (event->type) {
+        case PICONET_STATUS_EVENT: {
+            usb_printf(
+                USB_CHANNEL_CONTROL,
+                "STATUS %s %d %02x %d\n",
+                event->status.version,
+                event->status.station,
+                event->status.status_register_1,
+                event->status.mode);
+            break;
+        }
+
+        case PICONET_TX_EVENT: {
+            usb_printf(USB_CHANNEL_CONTROL, "TX_RESULT %s\n", _tx_error_to_str(event->tx_event_detail.type));
+            break;
+        }
+
+        case PICONET_REPLY_EVENT: {
+            usb_printf(USB_CHANNEL_CONTROL, "REPLY_RESULT %s\n", _tx_error_to_str(event->reply_event_detail.type));
+            break;
+        }
+
+        case PICONET_DEDUP_EVENT: {
+            usb_printf(
+                USB_CHANNEL_CONTROL,
+                "DEDUP %lu %lu %lu %lu\n",
+                (unsigned long) event->dedup.window_ms,
+                (unsigned long) event->dedup.suppressed[DEDUP_KIND_TRANSMIT],
+                (unsigned long) event->dedup.suppressed[DEDUP_KIND_IMMEDIATE],
+                (unsigned long) event->dedup.suppressed[DEDUP_KIND_BROADCAST]);
+            break;
+        }
+
+        case PICONET_BENCH_EVENT: {
+            _print_bench(&event->bench);
+            break;
+        }
+
+        case PICONET_RECOVERY_EVENT: {
+            _print_recovery(&event->recovery);
+            break;
+        }
 
-                pool_buffer_release(
-                    &rx_buffer_pool,
-                    event.rx_event_detail.data_buffer_handle);
+        case PICONET_TRAFFIC_EVENT: {
+            _print_traffic(&event->traffic);
+            break;
+        }
 
+        case PICONET_SCAN_STATION_EVENT: {
+            const uint8_t* machine_type = event->scan_station.machine_type;
+            usb_printf(
+                USB_CHANNEL_CONTROL,
+                "SCAN_STATION %u %u %02x%02x%02x%02x %lu\n",
+                event->scan_station.station,
+                event->scan_station.network,
+                machine_type[0],
+                machine_type[1],
+                machine_type[2],
+                machine_type[3],
+                (unsigned long) event->scan_station.response_us);
+            break;
+        }
+
+        case PICONET_SCAN_EVENT: {
+            usb_printf(
+                USB_CHANNEL_CONTROL,
+                "SCAN %u %u %lu %s\n",
+                event->scan.probed,
+                event->scan.found,
+                (unsigned long) event->scan.elapsed_us,
+                _tx_error_to_str(event->scan.result));
+            break;
+        }
+
+        // written in the background by usb_task(), so rx_header and the frame's encoding in
+        // b64_data_buffer are left alone until it's done (see _service_event_output)
+        case PICONET_RX_EVENT: {
+            if (event->rx_event_detail.type == PICONET_RX_RESULT_ERROR) {
+                snprintf(rx_header, RX_HEADER_SZ, "ERROR %s", _rx_error_to_str(event->rx_event_detail.error));
+                usb_start_line(USB_CHANNEL_DATA, rx_header, NULL);
                 break;
             }
 
-            default: {
-                printf("ERROR Unexpected event type %u\n", event.type);
+            buffer_t* buffer = pool_buffer_get(&rx_buffer_pool, event->rx_event_detail.data_buffer_handle);
+            if (buffer == NULL) {
+                usb_printf(USB_CHANNEL_CONTROL, "ERROR Failed to get RX data buffer - logic error\n");
                 break;
             }
+ 
+            switch (event->rx_event_detail.type) {
+                case PICONET_RX_RESULT_MONITOR :
+                    if (event->rx_event_detail.frame_len > 0) {
+                        snprintf(
+                            rx_header,
+                            RX_HEADER_SZ,
+                            "MONITOR %lu ",
+                            (unsigned long) event->rx_event_detail.frame_len);
+                    } else {
+                        snprintf(rx_header, RX_HEADER_SZ, "MONITOR ");
+                    }
+                    usb_start_line(USB_CHANNEL_DATA, rx_header, _encode_data(buffer->data, event->rx_event_detail.data_len));
+                    break;
+                case PICONET_RX_RESULT_BROADCAST :
+                    snprintf(rx_header, RX_HEADER_SZ, "RX_BROADCAST ");
+                    usb_start_line(USB_CHANNEL_DATA, rx_header, _encode_data(buffer->data, event->rx_event_detail.data_len));
+                    break;
+                case PICONET_RX_RESULT_IMMEDIATE_OP :
+                    snprintf(
+                        rx_header,
+                        RX_HEADER_SZ,
+                        "RX_IMMEDIATE %s ",
+                        _encode_base64(
+                            b64_scout_buffer,
+                            B64_SCOUT_BUFFER_SZ,
+                            event->rx_event_detail.scout,
+                            event->rx_event_detail.scout_len));
+                    usb_start_line(USB_CHANNEL_DATA, rx_header, _encode_data(buffer->data, event->rx_event_detail.data_len));
+                    break;
+                case PICONET_RX_RESULT_TRANSMIT :
+                    snprintf(
+                        rx_header,
+                        RX_HEADER_SZ,
+                        "RX_TRANSMIT %u %s ",
+                        event->rx_event_detail.reply_id,
+                        _encode_base64(
+                            b64_scout_buffer,
+                            B64_SCOUT_BUFFER_SZ,
+                            event->rx_event_detail.scout,
+                            event->rx_event_detail.scout_len));
+                    usb_start_line(USB_CHANNEL_DATA, rx_header, _encode_data(buffer->data, event->rx_event_detail.data_len));
+                    break;
+                default :
+                    // do nothing if no data or error (latter handled above)
+                    break;
+            }
+
+            // the frame's encoding is all that's written from here on
+            pool_buffer_release(
+                &rx_buffer_pool,
+                event->rx_event_detail.data_buffer_handle);
+
+            break;
+        }
+
+        default: {
+            usb_printf(USB_CHANNEL_CONTROL, "ERROR Unexpected event type %u\n", event->type);
+            break;
         }
     }
 }
@@ -282,6 +491,10 @@ void _core1_loop(void) {
     uint8_t         tx_buffer[TX_DATA_BUFFER_SZ];
     uint8_t         ack_buffer[ACK_BUFFER_SZ];
     piconet_mode_t  mode = PICONET_CMD_SET_MODE_STOP;
+    traffic_stats_t* traffic_live = &traffic_stats[0];
+    uint32_t        traffic_interval_ms = 1000;
+    uint32_t        traffic_due_us = 0;
+    bool            traffic_requested = false;
 
     if (!econet_init()) {
         printf("ERROR Failed to init econet module. Game over, man.\n");
@@ -295,6 +508,7 @@ void _core1_loop(void) {
 
     while (true) {
         if (queue_try_remove(&command_queue, &received_command)) {
+            _ring_doorbell(DOORBELL_COMMAND_TAKEN);
             switch (received_command.type) {
                 case PICONET_CMD_STATUS:
                     event.type = PICONET_STATUS_EVENT;
@@ -302,205 +516,639 @@ void _core1_loop(void) {
                     event.status.station = get_station();
                     event.status.status_register_1 = adlc_read(REG_STATUS_2);
                     event.status.mode = mode;
-                    queue_add_blocking(&event_queue, &event);
+                    _post_event(&event);
                     break;
                 case PICONET_CMD_RESTART:
-                    adlc_reset();
+                    econet_recover(ADLC_RECOVERY_HARD);
                     break;
                 case PICONET_CMD_SET_MODE:
+                    if (received_command.set_mode == PICONET_CMD_SET_MODE_TRAFFIC
+                            && mode != PICONET_CMD_SET_MODE_TRAFFIC) {
+                        traffic_init(traffic_live, time_us_32());
+                        traffic_due_us = time_us_32() + traffic_interval_ms * 1000;
+                    }
                     mode = received_command.set_mode;
+                    set_traffic_stats((mode == PICONET_CMD_SET_MODE_TRAFFIC) ? traffic_live : NULL);
                     break;
                 case PICONET_CMD_SET_STATION:
                     set_station(received_command.station);
                     break;
+                case PICONET_CMD_SET_SNAPLEN:
+                    set_snaplen(received_command.snaplen);
+                    break;
                 case PICONET_CMD_TX: {
-                    econet_tx_result_t result = transmit(
-                        received_command.tx.dest_station,
-                        received_command.tx.dest_network,
-                        received_command.tx.control_byte,
-                        received_command.tx.port,
-                        received_command.tx.data,
-                        received_command.tx.data_len,
-                        received_command.tx.scout_extra_data,
-                        received_command.tx.scout_extra_data_len);
+                    econet_tx_result_t result = PICONET_TX_RESULT_ERROR_INVALID_COMMAND;
+                    if (!received_command.invalid) {
+                        result = transmit(
+                            received_command.tx.dest_station,
+                            received_command.tx.dest_network,
+                            received_command.tx.control_byte,
+                            received_command.tx.port,
+                            received_command.tx.data,
+                            received_command.tx.data_len,
+                            received_command.tx.scout_extra_data,
+                            received_command.tx.scout_extra_data_len);
+                    }
                     event.type = PICONET_TX_EVENT;
                     event.tx_event_detail.type = result;
-                    queue_add_blocking(&event_queue, &event);
+                    _post_event(&event);
                     break;
                 }
                 case PICONET_CMD_REPLY: {
-                    econet_tx_result_t result = reply(
-                        received_command.reply.reply_id,
-                        received_command.reply.data,
-                        received_command.reply.data_len);
+                    econet_tx_result_t result = PICONET_TX_RESULT_ERROR_INVALID_COMMAND;
+                    if (!received_command.invalid) {
+                        result = reply(
+                            received_command.reply.reply_id,
+                            received_command.reply.control_byte,
+                            received_command.reply.port,
+                            received_command.reply.data,
+                            received_command.reply.data_len);
+                    }
                     event.type = PICONET_REPLY_EVENT;
                     event.reply_event_detail.type = result;
-                    queue_add_blocking(&event_queue, &event);
+                    _post_event(&event);
                     break;
                 }
                 case PICONET_CMD_BCAST: {
-                    econet_tx_result_t result = broadcast(
-                        received_command.bcast.data,
-                        received_command.bcast.data_len);
+                    econet_tx_result_t result = PICONET_TX_RESULT_ERROR_INVALID_COMMAND;
+                    if (!received_command.invalid) {
+                        result = broadcast(
+                            received_command.bcast.data,
+                            received_command.bcast.data_len);
+                    }
                     event.type = PICONET_TX_EVENT;
                     event.tx_event_detail.type = result;
-                    queue_add_blocking(&event_queue, &event);
+                    _post_event(&event);
                     break;
                 }
                 case PICONET_CMD_TEST: {
                     _test_board();
                     break;
                 }
+                case PICONET_CMD_BENCH: {
+                    event.type = PICONET_BENCH_EVENT;
+                    event.bench.frame_len = received_command.bench.frame_len;
+                    event.bench.valid = econet_bench(
+                        received_command.bench.frame_len,
+                        received_command.bench.count,
+                        &event.bench.stats);
+                    _post_event(&event);
+                    break;
+                }
+                case PICONET_CMD_SCAN: {
+                    _scan_stations(&received_command.scan);
+                    break;
+                }
+                case PICONET_CMD_RECOVER:
+                case PICONET_CMD_RECOVERY: {
+                    if (received_command.type == PICONET_CMD_RECOVER) {
+                        econet_recover(ADLC_RECOVERY_SOFT);
+                    }
+                    event.type = PICONET_RECOVERY_EVENT;
+                    event.recovery.adlc = *adlc_recovery_stats();
+                    event.recovery.stalls = *get_stall_stats();
+                    _post_event(&event);
+                    break;
+                }
+                case PICONET_CMD_SET_DEDUP:
+                case PICONET_CMD_DEDUP: {
+                    if (received_command.type == PICONET_CMD_SET_DEDUP) {
+                        set_dedup_window(received_command.dedup_window_ms);
+                    }
+                    const dedup_cache_t* dedup = get_dedup_cache();
+                    event.type = PICONET_DEDUP_EVENT;
+                    event.dedup.window_ms = dedup->window_ms;
+                    memcpy(event.dedup.suppressed, dedup->suppressed, sizeof(event.dedup.suppressed));
+                    _post_event(&event);
+                    break;
+                }
+                case PICONET_CMD_SET_TRAFFIC:
+                    traffic_interval_ms = received_command.traffic_interval_ms;
+                    traffic_requested = true;
+                    break;
+                case PICONET_CMD_TRAFFIC:
+                    traffic_requested = true;
+                    break;
+                default:
+                    // handled by core0
+                    break;
             }
         }
 
+        if (mode == PICONET_CMD_SET_MODE_TRAFFIC
+                && traffic_interval_ms > 0
+                && (int32_t) (time_us_32() - traffic_due_us) >= 0) {
+            traffic_requested = true;
+        }
+
+        // each report covers the time since the last; if core0 is still busy with that one,
+        // counting carries on until it's done
+        if (traffic_requested && traffic_report == NULL) {
+            uint32_t now_us = time_us_32();
+            traffic_report = traffic_live;
+            traffic_live = (traffic_live == &traffic_stats[0]) ? &traffic_stats[1] : &traffic_stats[0];
+            traffic_init(traffic_live, now_us);
+            traffic_due_us = now_us + traffic_interval_ms * 1000;
+            if (mode == PICONET_CMD_SET_MODE_TRAFFIC) {
+                set_traffic_stats(traffic_live);
+            }
+            traffic_requested = false;
+
+            event.type = PICONET_TRAFFIC_EVENT;
+            event.traffic.stats = traffic_report;
+            event.traffic.elapsed_us = now_us - traffic_report->start_us;
+            _post_event(&event);
+        }
+
         if (mode == PICONET_CMD_SET_MODE_STOP) {
+            rx_starved = false;
             continue;
         }
 
-        buffer_t* rx_data_buffer = pool_buffer_claim(&rx_buffer_pool);
-        if (rx_data_buffer == NULL) {
-            printf("ERROR Packet rate too high, rx buffers exhausted. Increase buffer count/reduce buffer size.\n");
-            continue;
+        // without room for another event, the line is still serviced but frames which would
+        // need reporting are turned away (see econet_flow_stats_t). Frames are only counted in
+        // TRAFFIC mode, needing no event.
+        bool counting = (mode == PICONET_CMD_SET_MODE_TRAFFIC);
+        buffer_t* rx_data_buffer = (counting || _rx_room()) ? pool_buffer_claim(&rx_buffer_pool) : NULL;
+        rx_starved = (rx_data_buffer == NULL) && !counting;
+        if (rx_data_buffer != NULL) {
+            set_rx_data_buffer(rx_data_buffer->data, rx_data_buffer->size);
+        } else {
+            set_rx_data_buffer(NULL, 0);
         }
-        set_rx_data_buffer(rx_data_buffer->data, rx_data_buffer->size);
 
-        econet_rx_result_t rx_result = (mode == PICONET_CMD_SET_MODE_MONITOR) ? monitor() : receive();
+        econet_rx_result_t rx_result = (mode == PICONET_CMD_SET_MODE_LISTEN) ? receive() : monitor();
+
+        if (counting) {
+            if (rx_data_buffer != NULL) {
+                pool_buffer_release(&rx_buffer_pool, rx_data_buffer->handle);
+            }
+            continue;
+        }
 
         switch (rx_result.type) {
             case PICONET_RX_RESULT_NONE:
-                pool_buffer_release(&rx_buffer_pool, rx_data_buffer->handle);
+                if (rx_data_buffer != NULL) {
+                    pool_buffer_release(&rx_buffer_pool, rx_data_buffer->handle);
+                }
                 break;
             case PICONET_RX_RESULT_ERROR:
                 event.type = PICONET_RX_EVENT;
                 event.rx_event_detail.type = rx_result.type;
                 event.rx_event_detail.error = rx_result.error;
-                queue_add_blocking(&event_queue, &event);
-                pool_buffer_release(&rx_buffer_pool, rx_data_buffer->handle);
+                _post_event(&event);
+                if (rx_data_buffer != NULL) {
+                    pool_buffer_release(&rx_buffer_pool, rx_data_buffer->handle);
+                }
                 break;
             default:
                 event.type = PICONET_RX_EVENT;
                 event.rx_event_detail.type = rx_result.type;
                 event.rx_event_detail.scout_len = rx_result.detail.scout_len;       // scout itself populated by econet module
                 event.rx_event_detail.data_len = rx_result.detail.data_len;
+                event.rx_event_detail.frame_len = (rx_result.type == PICONET_RX_RESULT_MONITOR) ? rx_result.detail.frame_len : 0;
+                event.rx_event_detail.reply_id = (rx_result.type == PICONET_RX_RESULT_TRANSMIT) ? rx_result.detail.reply_id : 0;
                 event.rx_event_detail.data_buffer_handle = rx_data_buffer->handle;
-                queue_add_blocking(&event_queue, &event);
+                credits_consumed++;
+                _post_event(&event);
                 break;
         }
     }
 }
 
-char* _encode_base64(char* output_buffer, const uint8_t* input, size_t len) {
-    // TODO: check for buffer overflow
-    char* c = output_buffer;
-	size_t cnt = 0;
-	base64_encodestate s;
+// Peeks at the machine type of each station in a range on the local network, reporting each
+// that answers as it does, then a summary. Piconet's own station and the broadcast addresses
+// are skipped, and the scan is cut short if a peek can't be sent at all (e.g. no clock).
+void _scan_stations(const cmd_scan_t* scan) {
+    event_t event;
+    uint32_t start_us = time_us_32();
+    uint16_t probed = 0;
+    uint16_t found = 0;
+    econet_tx_result_t result = PICONET_TX_RESULT_OK;
 
-	base64_init_encodestate(&s);
-	cnt = base64_encode_block((const char *) input, len, c, &s);
-	c += cnt;
-	cnt = base64_encode_blockend(c, &s);
-	c += cnt;
-	*c = 0;
+    for (uint station = scan->first_station; station <= scan->last_station; station++) {
+        if (station == 0x00 || station == 0xff || station == get_station()) {
+            continue;
+        }
 
-    return output_buffer;
+        probed++;
+        econet_tx_result_t peek_result = peek_machine_type(
+            station,
+            0x00,
+            scan->timeout_ms,
+            event.scan_station.machine_type,
+            &event.scan_station.response_us);
+        if (peek_result == PICONET_TX_RESULT_OK) {
+            found++;
+            event.type = PICONET_SCAN_STATION_EVENT;
+            event.scan_station.station = station;
+            event.scan_station.network = 0x00;
+            _post_event(&event);
+        } else if (peek_result != PICONET_TX_RESULT_ERROR_NO_SCOUT_ACK) {
+            result = peek_result;
+            break;
+        }
+    }
+
+    event.type = PICONET_SCAN_EVENT;
+    event.scan.result = result;
+    event.scan.probed = probed;
+    event.scan.found = found;
+    event.scan.elapsed_us = time_us_32() - start_us;
+    _post_event(&event);
 }
 
-size_t _decode_base64(const char* input, uint8_t* output_buffer) {
-    if (input == NULL) {
-        return 0;
+// Whether core1 may take on another frame for the host: it needs a credit (if flow control is
+// enabled) as well as a free RX buffer.
+bool _rx_room(void) {
+    return !flow_enabled || (int32_t) (credits_granted - credits_consumed) > 0;
+}
+
+// Frames received go to the data channel and everything else to the control channel, each
+// having its own queue so that results aren't held up behind frames. A frame always has room,
+// having claimed a buffer or credit first, but an RX error doesn't: rather than hold up core1
+// whilst the host isn't reading, it's dropped and counted if the queue is full.
+void _post_event(event_t* event) {
+    if (event->type == PICONET_RX_EVENT) {
+        if (event->rx_event_detail.type == PICONET_RX_RESULT_ERROR) {
+            if (!queue_try_add(&event_queue, event)) {
+                dropped_errors++;
+                return;
+            }
+        } else {
+            queue_add_blocking(&event_queue, event);
+        }
+        _ring_doorbell(DOORBELL_EVENT);
+    } else {
+        queue_add_blocking(&control_queue, event);
+        _ring_doorbell(DOORBELL_CONTROL);
     }
+}
 
-    // TODO: check for buffer overflow
-    uint8_t* c = output_buffer;
-    base64_decodestate s;    
-    base64_init_decodestate(&s);
-    return base64_decode_block(input, strlen(input), c, &s);
+void _ring_doorbell(uint32_t doorbell) {
+    // never stall core1 on a full FIFO: core0 has doorbells waiting already and its tick
+    // catches up with any work they don't cover
+    if (multicore_fifo_wready()) {
+        multicore_fifo_push_blocking(doorbell);
+    }
 }
 
-void _read_command_input(void) {
-    static char buffer[CMD_BUFFER_SZ];
-    static int buffer_pos = 0;
+// Encodes frame data for output, compressing it first if the host has asked for that. The
+// compressed form is marked by a leading '~'.
+char* _encode_data(const uint8_t* input, size_t len) {
+    if (!compression_enabled) {
+        return _encode_base64(b64_data_buffer, B64_DATA_BUFFER_SZ, input, len);
+    }
 
-    int c = getchar_timeout_us(0);
-    if (c == PICO_ERROR_TIMEOUT) {
-        return;
+    uint64_t start_us = time_us_64();
+    size_t compressed_len = compress_frame(compressor, input, len, compressed_buffer);
+    compression_us += time_us_64() - start_us;
+
+    b64_data_buffer[0] = '~';
+    _encode_base64(b64_data_buffer + 1, B64_DATA_BUFFER_SZ - 1, compressed_buffer, compressed_len);
+    return b64_data_buffer;
+}
+
+// The buffers are sized for the largest frames, so failure means a bug; an empty string is
+// returned rather than a truncated encoding, which the host would take to be a shorter frame
+char* _encode_base64(char* output_buffer, size_t capacity, const uint8_t* input, size_t len) {
+    if (!base64_encode(input, len, output_buffer, capacity)) {
+        output_buffer[0] = 0;
     }
+    return output_buffer;
+}
 
-    if (c == '\r') {
-        buffer[buffer_pos] = 0;
-        buffer_pos = 0;
+bool _service_command_input(void) {
+    static uint8_t  ring[INPUT_RING_SZ];
+    static size_t   head = 0;           // next byte to parse
+    static size_t   tail = 0;           // next free byte, head == tail when empty
+    static bool     cmd_pending = false;
 
-        char delim[] = " ";
-        char *ptr = strtok(buffer, delim);
+    // a complete command waits here if core1 is still busy with the last one; input is left
+    // buffered (and ultimately in the USB FIFO) meanwhile, so that events keep flowing. Core1
+    // rings DOORBELL_COMMAND_TAKEN when it's ready for another.
+    if (cmd_pending) {
+        if (!queue_try_add(&command_queue, &cmd)) {
+            return false;
+        }
+        cmd_pending = false;
+    }
 
-        if (ptr == NULL) {
-            return;
+    // top up the ring with as much as the CDC FIFO will give us, in up to two contiguous reads
+    bool ring_full = (tail + 1) % INPUT_RING_SZ == head;
+    while (!ring_full) {
+        size_t space = (head > tail) ? head - tail - 1 : INPUT_RING_SZ - tail - (head == 0 ? 1 : 0);
+        int count = usb_read((char*) &ring[tail], space);
+        if (count <= 0) {
+            break;
         }
+        tail = (tail + count) % INPUT_RING_SZ;
+        ring_full = (tail + 1) % INPUT_RING_SZ == head;
+    }
 
-        bool error = false;
-        if (strcmp(ptr, CMD_STATUS) == 0) {
-            cmd.type = PICONET_CMD_STATUS;
-        } else if (strcmp(ptr, CMD_RESTART) == 0) {
-            cmd.type = PICONET_CMD_RESTART;
-        } else if (strcmp(ptr, CMD_SET_MODE) == 0) {
-            cmd.type = PICONET_CMD_SET_MODE;
-            const char *mode = strtok(NULL, delim);
-            if (mode == NULL) {
-                error = true;
-            } else if (strcmp(mode, CMD_PARAM_MODE_STOP) == 0) {
-                cmd.set_mode = PICONET_CMD_SET_MODE_STOP;
-            } else if (strcmp(mode, CMD_PARAM_MODE_LISTEN) == 0) {
-                cmd.set_mode = PICONET_CMD_SET_MODE_LISTEN;
-            } else if (strcmp(mode, CMD_PARAM_MODE_MONITOR) == 0) {
-                cmd.set_mode = PICONET_CMD_SET_MODE_MONITOR;
-            } else {
-                error = true;
+    while (head != tail) {
+        size_t available = (tail > head) ? tail - head : INPUT_RING_SZ - head;
+        size_t consumed;
+        parser_result_t result = parser_feed(&cmd_parser, &ring[head], available, &consumed);
+        head = (head + consumed) % INPUT_RING_SZ;
+
+        if (result == PARSER_RESULT_ERROR && !_expects_tx_result(cmd.type)) {
+            usb_printf(USB_CHANNEL_CONTROL, "ERROR WHAT??\n");
+        } else if (result != PARSER_RESULT_NONE && !_handle_core0_command(&cmd)) {
+            if (!queue_try_add(&command_queue, &cmd)) {
+                cmd_pending = true;
+                return false;
             }
-        } else if (strcmp(ptr, CMD_SET_STATION) == 0) {
-            cmd.type = PICONET_CMD_SET_STATION;
-            const char *station_str = strtok(NULL, delim);
-            if (station_str == NULL) {
-                error = true;
-            } else {
-                long station = strtol(station_str, NULL, 10);
-                if (station < 0 || station > 0xff) {
-                    error = true;
-                } else {
-                    cmd.station = station;
+        }
+    }
+
+    // the USB FIFO may hold more than there was room for
+    return ring_full;
+}
+
+// Whether the host pairs a TX_RESULT or REPLY_RESULT with each command of this type, in which
+// case an invalid one is passed to core1 to be answered with INVALID_COMMAND in its turn
+bool _expects_tx_result(cmd_type_t type) {
+    return type == PICONET_CMD_TX || type == PICONET_CMD_REPLY || type == PICONET_CMD_BCAST;
+}
+
+// Handles commands which concern only core0, returning false for those to be passed to core1.
+bool _handle_core0_command(const command_t* command) {
+    if (command->invalid) {
+        return false;
+    }
+
+    switch (command->type) {
+        case PICONET_CMD_SET_COMPRESSION:
+            if (command->compression == PICONET_COMPRESSION_LZ) {
+                if (compressor == NULL) {
+                    compressor = malloc(sizeof(compressor_t));
+                    compressed_buffer = malloc(COMPRESS_MAX_OUTPUT(RX_DATA_BUFFER_SZ));
                 }
+                if (compressor == NULL || compressed_buffer == NULL) {
+                    usb_printf(USB_CHANNEL_CONTROL, "ERROR Failed to allocate memory for compression\n");
+                    free(compressor);
+                    free(compressed_buffer);
+                    compressor = NULL;
+                    compressed_buffer = NULL;
+                    return true;
+                }
+                compressor_init(compressor);
+                compression_us = 0;
+                compression_enabled = true;
+            } else {
+                compression_enabled = false;
             }
-        } else if (strcmp(ptr, CMD_TX) == 0) {
-            cmd.type = PICONET_CMD_TX;
-            cmd.tx.dest_station = strtol(strtok(NULL, delim), NULL, 10);
-            cmd.tx.dest_network = strtol(strtok(NULL, delim), NULL, 10);
-            cmd.tx.control_byte = strtol(strtok(NULL, delim), NULL, 10);
-            cmd.tx.port = strtol(strtok(NULL, delim), NULL, 10);
-            cmd.tx.data_len = _decode_base64(strtok(NULL, delim), cmd.tx.data);
-            cmd.tx.scout_extra_data_len = _decode_base64(strtok(NULL, delim), cmd.tx.scout_extra_data);
-        } else if (strcmp(ptr, CMD_BCAST) == 0) {
-            cmd.type = PICONET_CMD_BCAST;
-            cmd.tx.data_len = _decode_base64(strtok(NULL, delim), cmd.tx.data);
-        } else if (strcmp(ptr, CMD_REPLY) == 0) {
-            cmd.type = PICONET_CMD_REPLY;
-            cmd.reply.reply_id = strtol(strtok(NULL, delim), NULL, 10);
-            cmd.reply.data_len = _decode_base64(strtok(NULL, delim), cmd.reply.data);
-        } else if (strcmp(ptr, CMD_TEST) == 0) {
-            cmd.type = PICONET_CMD_TEST;
-        } else {
-            error = true;
-        }
+            _print_compression_status();
+            return true;
+        case PICONET_CMD_COMPRESSION:
+            _print_compression_status();
+            return true;
+        case PICONET_CMD_SET_TRACE:
+            adlc_trace_enable(false);
+            if (command->trace_enabled) {
+                adlc_trace_clear();
+                adlc_trace_enable(true);
+            }
+            _print_trace();
+            return true;
+        case PICONET_CMD_TRACE:
+            _print_trace();
+            return true;
+        case PICONET_CMD_SET_FLOW:
+            // core1 may consume a credit meanwhile, costing the host one at worst
+            flow_enabled = false;
+            credits_granted = credits_consumed + command->credits;
+            flow_baseline = *get_flow_stats();
+            dropped_errors_baseline = dropped_errors;
+            flow_enabled = (command->credits > 0);
+            _print_flow_status();
+            return true;
+        case PICONET_CMD_CREDIT:
+            credits_granted += command->credits;
+            return true;
+        case PICONET_CMD_FLOW:
+            _print_flow_status();
+            return true;
+        case PICONET_CMD_SET_USB_FLUSH:
+            usb_set_flush_us(command->usb_flush_us);
+            _print_usb_status();
+            return true;
+        case PICONET_CMD_USB:
+            _print_usb_status();
+            return true;
+        default:
+            return false;
+    }
+}
 
-        if (error) {
-            printf("ERROR WHAT??\n");
-        } else {
-            queue_add_blocking(&command_queue, &cmd);
-        }
-    } else {
-        if (buffer_pos >= sizeof(buffer)) {
-            return;
+void _print_compression_status(void) {
+    uint64_t bytes_in = (compressor != NULL) ? compressor->bytes_in : 0;
+    uint64_t bytes_out = (compressor != NULL) ? compressor->bytes_out : 0;
+    uint64_t cycles = compression_us * (clock_get_hz(clk_sys) / 1000000);
+
+    usb_printf(
+        USB_CHANNEL_CONTROL,
+        "COMPRESSION %s %llu %llu %llu\n",
+        compression_enabled ? "LZ" : "NONE",
+        (unsigned long long) bytes_in,
+        (unsigned long long) bytes_out,
+        (unsigned long long) cycles);
+}
+
+// Reports the bus transactions traced by core1, oldest first, as raw adlc_trace_entry_t records
+// (B64_DATA_BUFFER_SZ comfortably holds ADLC_TRACE_SZ of them once encoded). Tracing is paused
+// whilst the ring is read.
+void _print_trace(void) {
+    bool enabled = adlc_trace_enabled();
+    adlc_trace_enable(false);
+
+    uint32_t recorded = adlc_trace_recorded();
+    uint32_t count = (recorded < ADLC_TRACE_SZ) ? recorded : ADLC_TRACE_SZ;
+    uint32_t first = recorded - count;
+    uint32_t before_wrap = ADLC_TRACE_SZ - (first & (ADLC_TRACE_SZ - 1));
+    if (before_wrap > count) {
+        before_wrap = count;
+    }
+
+    base64_encoder_t encoder;
+    size_t encoded_len = 0;
+    base64_encoder_init(&encoder);
+    base64_encode_update(
+        &encoder,
+        (const uint8_t*) adlc_trace_entry(first),
+        before_wrap * sizeof(adlc_trace_entry_t),
+        b64_report_buffer,
+        B64_REPORT_BUFFER_SZ,
+        &encoded_len);
+    base64_encode_update(
+        &encoder,
+        (const uint8_t*) adlc_trace_entry(first + before_wrap),
+        (count - before_wrap) * sizeof(adlc_trace_entry_t),
+        b64_report_buffer,
+        B64_REPORT_BUFFER_SZ,
+        &encoded_len);
+    base64_encode_final(&encoder, b64_report_buffer, B64_REPORT_BUFFER_SZ, &encoded_len);
+
+    usb_printf(USB_CHANNEL_CONTROL, "TRACE %u %lu%s", enabled ? 1 : 0, (unsigned long) recorded, (count > 0) ? " " : "");
+    usb_puts(USB_CHANNEL_CONTROL, b64_report_buffer);
+
+    adlc_trace_enable(enabled);
+}
+
+// Reports a loop mode benchmark: the raw counts, then rates and the bus transactions made per
+// byte sent and received (to 2 decimal places) worked out from them
+void _print_bench(const event_bench_t* bench) {
+    if (!bench->valid) {
+        usb_printf(USB_CHANNEL_CONTROL, "ERROR Invalid benchmark frame length %u\n", bench->frame_len);
+        return;
+    }
+
+    const econet_bench_stats_t* stats = &bench->stats;
+    uint64_t elapsed_us = stats->elapsed_us;
+    uint64_t bytes = (uint64_t) stats->frames * bench->frame_len;
+    uint64_t bytes_attempted = (uint64_t) (stats->frames + stats->errors) * bench->frame_len;
+    uint64_t cycles_per_byte_x100 = (bytes_attempted > 0) ? (uint64_t) stats->bus_cycles * 100 / bytes_attempted : 0;
+
+    usb_printf(
+        USB_CHANNEL_CONTROL,
+        "BENCH %u %lu %lu %lu %lu %lu %lu %lu %lu.%02lu\n",
+        bench->frame_len,
+        (unsigned long) stats->frames,
+        (unsigned long) stats->errors,
+        (unsigned long) stats->underruns,
+        (unsigned long) stats->overruns,
+        (unsigned long) stats->elapsed_us,
+        (unsigned long) ((elapsed_us > 0) ? stats->frames * 1000000ull / elapsed_us : 0),
+        (unsigned long) ((elapsed_us > 0) ? bytes * 1000000ull / elapsed_us : 0),
+        (unsigned long) (cycles_per_byte_x100 / 100),
+        (unsigned long) (cycles_per_byte_x100 % 100));
+}
+
+// Reports the tier at which the latest recovery of the ADLC succeeded, stalls detected, then
+// attempts, successes and the latest and longest times for each tier in turn
+void _print_recovery(const event_recovery_t* recovery) {
+    static const char* tier_names[] = { "NONE", "SOFT", "REPROGRAM", "HARD", "FAILED" };
+
+    usb_printf(
+        USB_CHANNEL_CONTROL,
+        "RECOVERY %s %lu %lu",
+        tier_names[recovery->adlc.last],
+        (unsigned long) recovery->stalls.line_jammed,
+        (unsigned long) recovery->stalls.stuck_fifo);
+    for (uint i = 0; i < ADLC_RECOVERY_TIER_COUNT; i++) {
+        const adlc_recovery_tier_stats_t* tier = &recovery->adlc.tiers[i];
+        usb_printf(
+            USB_CHANNEL_CONTROL,
+            " %lu %lu %lu %lu",
+            (unsigned long) tier->attempts,
+            (unsigned long) tier->successes,
+            (unsigned long) tier->last_us,
+            (unsigned long) tier->max_us);
+    }
+    usb_printf(USB_CHANNEL_CONTROL, "\n");
+}
+
+// Reports traffic counted in TRAFFIC mode: the totals and how many talkers and station pairs
+// follow, then as base64 the frame size histogram (TRAFFIC_SIZE_BUCKETS uint32_t counts), the
+// talkers as raw traffic_talker_t records and the pairs in use as traffic_pair_t records. The
+// stats are handed back to core1 afterwards.
+void _print_traffic(const event_traffic_t* traffic) {
+    const traffic_stats_t* stats = traffic->stats;
+    base64_encoder_t encoder;
+    size_t encoded_len = 0;
+
+    base64_encoder_init(&encoder);
+    base64_encode_update(
+        &encoder,
+        (const uint8_t*) stats->sizes,
+        sizeof(stats->sizes),
+        b64_report_buffer,
+        B64_REPORT_BUFFER_SZ,
+        &encoded_len);
+    base64_encode_update(
+        &encoder,
+        (const uint8_t*) stats->talkers,
+        stats->talker_count * sizeof(traffic_talker_t),
+        b64_report_buffer,
+        B64_REPORT_BUFFER_SZ,
+        &encoded_len);
+    for (uint i = 0; i < TRAFFIC_PAIRS_SZ; i++) {
+        if (stats->pairs[i].frames > 0) {
+            base64_encode_update(
+                &encoder,
+                (const uint8_t*) &stats->pairs[i],
+                sizeof(traffic_pair_t),
+                b64_report_buffer,
+                B64_REPORT_BUFFER_SZ,
+                &encoded_len);
         }
-        buffer[buffer_pos++] = c;
+    }
+    base64_encode_final(&encoder, b64_report_buffer, B64_REPORT_BUFFER_SZ, &encoded_len);
+
+    usb_printf(
+        USB_CHANNEL_CONTROL,
+        "TRAFFIC %lu %lu %lu %lu %lu %lu %u %u ",
+        (unsigned long) traffic->elapsed_us,
+        (unsigned long) stats->busy_us,
+        (unsigned long) stats->frames,
+        (unsigned long) stats->bytes,
+        (unsigned long) stats->errors,
+        (unsigned long) stats->untracked,
+        stats->talker_count,
+        stats->pair_count);
+    usb_puts(USB_CHANNEL_CONTROL, b64_report_buffer);
+
+    traffic_report = NULL;
+}
+
+void _print_flow_status(void) {
+    const econet_flow_stats_t* stats = get_flow_stats();
+    int32_t credits = (int32_t) (credits_granted - credits_consumed);
+
+    usb_printf(
+        USB_CHANNEL_CONTROL,
+        "FLOW %u %ld %u %lu %lu %lu\n",
+        flow_enabled ? 1 : 0,
+        (long) ((flow_enabled && credits > 0) ? credits : 0),
+        queue_get_level(&event_queue),
+        (unsigned long) (stats->declined_scouts - flow_baseline.declined_scouts),
+        (unsigned long) (stats->dropped_frames - flow_baseline.dropped_frames),
+        (unsigned long) (dropped_errors - dropped_errors_baseline));
+}
+
+void _print_usb_status(void) {
+    const usb_output_stats_t* stats = usb_get_output_stats();
+
+    usb_printf(
+        USB_CHANNEL_CONTROL,
+        "USB %u %llu %llu %llu %llu %llu %llu\n",
+        usb_get_flush_us(),
+        (unsigned long long) stats->lines,
+        (unsigned long long) stats->bytes,
+        (unsigned long long) stats->packets,
+        (unsigned long long) stats->full_packets,
+        (unsigned long long) stats->deadline_flushes,
+        (unsigned long long) stats->urgent_flushes);
+}
+
+// Tells the host when events back up (or core1 has turned frames away) and again once it has
+// caught up, with hysteresis between the two.
+void _update_watermark(void) {
+    static uint32_t turned_away_seen;
+    const econet_flow_stats_t* stats = get_flow_stats();
+    uint32_t turned_away = stats->declined_scouts + stats->dropped_frames;
+    bool turning_away = (turned_away != turned_away_seen);
+    turned_away_seen = turned_away;
+
+    uint backlog = queue_get_level(&event_queue);
+
+    if (!flow_high && (backlog >= FLOW_HIGH_WATERMARK || turning_away)) {
+        flow_high = true;
+        usb_printf(USB_CHANNEL_CONTROL, "WATERMARK HIGH %u\n", backlog);
+    } else if (flow_high && backlog <= FLOW_LOW_WATERMARK && !rx_starved) {
+        flow_high = false;
+        usb_printf(USB_CHANNEL_CONTROL, "WATERMARK LOW %u\n", backlog);
     }
 }
 
@@ -549,6 +1197,8 @@ char* _tx_error_to_str(econet_tx_result_t error) {
             return "TIMEOUT";
         case PICONET_TX_RESULT_ERROR_INVALID_RECEIVE_ID:
             return "INVALID_RECEIVE_ID";
+        case PICONET_TX_RESULT_ERROR_INVALID_COMMAND:
+            return "INVALID_COMMAND";
         case PICONET_TX_RESULT_ERROR_MISC:
             return "MISC";
         default:
@@ -557,7 +1207,7 @@ char* _tx_error_to_str(econet_tx_result_t error) {
 }
 
 void _test_board() {
-    printf("TESTING BOARD (REBOOT TO STOP)");
+    printf("TESTING BOARD (REBOOT TO STOP)\n");
     while (true) {
         for (uint adlc_register = 0; adlc_register < 4; adlc_register++) {
             for (uint data_bit = 0; data_bit < 8; data_bit++) {
@@ -0,0 +1,100 @@
+#include "traffic.h"
+
+#include <string.h>
+
+static uint _size_bucket(size_t len);
+static traffic_pair_t* _find_pair(traffic_stats_t* stats, const uint8_t* frame);
+static void _count_talker(traffic_stats_t* stats, uint8_t station, uint8_t net, size_t len);
+
+void traffic_init(traffic_stats_t* stats, uint32_t now_us) {
+    memset(stats, 0, sizeof(*stats));
+    stats->start_us = now_us;
+}
+
+void traffic_record(
+        traffic_stats_t*    stats,
+        const uint8_t*      frame,
+        size_t              len,
+        bool                error,
+        uint32_t            busy_us) {
+    stats->frames++;
+    stats->bytes += len;
+    stats->busy_us += busy_us;
+    stats->sizes[_size_bucket(len)]++;
+    if (error) {
+        stats->errors++;
+    }
+
+    if (len < TRAFFIC_HEADER_SZ) {
+        stats->untracked++;
+        return;
+    }
+
+    traffic_pair_t* pair = _find_pair(stats, frame);
+    if (pair == NULL) {
+        stats->untracked++;
+    } else {
+        pair->frames++;
+        pair->bytes += len;
+        if (error) {
+            pair->errors++;
+        }
+    }
+
+    _count_talker(stats, frame[2], frame[3], len);
+}
+
+static uint _size_bucket(size_t len) {
+    uint bucket = 0;
+    for (size_t limit = 8; len >= limit && bucket < TRAFFIC_SIZE_BUCKETS - 1; limit <<= 1) {
+        bucket++;
+    }
+    return bucket;
+}
+
+// open addressing by a hash of the four address bytes; pairs are only ever added
+static traffic_pair_t* _find_pair(traffic_stats_t* stats, const uint8_t* frame) {
+    uint32_t key = frame[0] | (frame[1] << 8) | (frame[2] << 16) | ((uint32_t) frame[3] << 24);
+    uint i = ((key * 2654435761u) >> 16) & (TRAFFIC_PAIRS_SZ - 1);
+
+    for (uint probes = 0; probes < TRAFFIC_PAIRS_SZ; probes++) {
+        traffic_pair_t* p = &stats->pairs[i];
+        if (p->frames == 0) {
+            p->dest_station = frame[0];
+            p->dest_net = frame[1];
+            p->src_station = frame[2];
+            p->src_net = frame[3];
+            stats->pair_count++;
+            return p;
+        }
+        if (p->dest_station == frame[0] && p->dest_net == frame[1]
+                && p->src_station == frame[2] && p->src_net == frame[3]) {
+            return p;
+        }
+        i = (i + 1) & (TRAFFIC_PAIRS_SZ - 1);
+    }
+    return NULL;
+}
+
+static void _count_talker(traffic_stats_t* stats, uint8_t station, uint8_t net, size_t len) {
+    traffic_talker_t* least = NULL;
+    for (uint i = 0; i < stats->talker_count; i++) {
+        traffic_talker_t* t = &stats->talkers[i];
+        if (t->station == station && t->net == net) {
+            t->bytes += len;
+            return;
+        }
+        if (least == NULL || t->bytes < least->bytes) {
+            least = t;
+        }
+    }
+
+    if (stats->talker_count < TRAFFIC_TALKERS_SZ) {
+        least = &stats->talkers[stats->talker_count++];
+        least->bytes = 0;
+    }
+    least->station = station;
+    least->net = net;
+    least->error = least->bytes;
+    least->bytes += len;
+}
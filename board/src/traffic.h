@@ -0,0 +1,64 @@
+#ifndef _PICONET_TRAFFIC_H_
+#define _PICONET_TRAFFIC_H_
+
+#include "pico/stdlib.h"
+
+#define TRAFFIC_PAIRS_SZ        64      // power of two
+#define TRAFFIC_TALKERS_SZ      8
+#define TRAFFIC_SIZE_BUCKETS    12      // <8, <16, <32 ... <8192, >=8192 bytes
+#define TRAFFIC_HEADER_SZ       4       // of each frame needed to count it
+
+typedef struct {
+    uint8_t     dest_station;
+    uint8_t     dest_net;
+    uint8_t     src_station;
+    uint8_t     src_net;
+    uint32_t    frames;                 // zero if the entry is unused
+    uint32_t    bytes;
+    uint32_t    errors;
+} traffic_pair_t;
+
+typedef struct {
+    uint8_t     station;
+    uint8_t     net;
+    uint16_t    reserved;
+    uint32_t    bytes;
+    uint32_t    error;                  // by which bytes may overstate the station's traffic
+} traffic_talker_t;
+
+/**
+ * Traffic seen on the line since `start_us`, as counted in MONITOR mode without sending each
+ * frame over USB: frames, bytes and errors between each pair of stations (the first
+ * TRAFFIC_PAIRS_SZ pairs seen; frames between any others are counted as untracked), a sketch
+ * of the stations sending the most bytes, a histogram of frame sizes and the time the line
+ * spent carrying frames, from each address byte to the end of its frame.
+ *
+ * The talkers are kept as a "space saving" sketch: a station not already tracked replaces the
+ * one with the fewest bytes, inheriting its count as the error. Any station that sent more
+ * than 1 / TRAFFIC_TALKERS_SZ of the bytes is sure to be there.
+ */
+typedef struct {
+    uint32_t            start_us;
+    uint32_t            busy_us;
+    uint32_t            frames;
+    uint32_t            bytes;
+    uint32_t            errors;         // frames with a bad CRC, overrun etc.
+    uint32_t            untracked;      // frames too short to address or with the pairs full
+    uint32_t            sizes[TRAFFIC_SIZE_BUCKETS];
+    uint                pair_count;
+    traffic_pair_t      pairs[TRAFFIC_PAIRS_SZ];
+    uint                talker_count;
+    traffic_talker_t    talkers[TRAFFIC_TALKERS_SZ];
+} traffic_stats_t;
+
+void    traffic_init(traffic_stats_t* stats, uint32_t now_us);
+
+// `frame` need only hold the first TRAFFIC_HEADER_SZ bytes of a frame `len` bytes long
+void    traffic_record(
+            traffic_stats_t*    stats,
+            const uint8_t*      frame,
+            size_t              len,
+            bool                error,
+            uint32_t            busy_us);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef _PICONET_TUSB_CONFIG_H_
+#define _PICONET_TUSB_CONFIG_H_
+
+/*
+ * TinyUSB configuration: a full speed device with two CDC ACM interfaces, the first carrying
+ * commands and their results, the second frames received, and a vendor interface with a pair of
+ * bulk endpoints which, once the host opens it, carries both (see usb_io.h).
+ */
+
+#define CFG_TUSB_RHPORT0_MODE       OPT_MODE_DEVICE
+#define CFG_TUSB_OS                 OPT_OS_PICO
+
+#ifndef CFG_TUSB_MEM_SECTION
+#define CFG_TUSB_MEM_SECTION
+#endif
+
+#ifndef CFG_TUSB_MEM_ALIGN
+#define CFG_TUSB_MEM_ALIGN          __attribute__ ((aligned(4)))
+#endif
+
+#define CFG_TUD_ENDPOINT0_SIZE      64
+
+#define CFG_TUD_CDC                 2
+#define CFG_TUD_MSC                 0
+#define CFG_TUD_HID                 0
+#define CFG_TUD_MIDI                0
+#define CFG_TUD_VENDOR              1
+
+// a command line fits the RX FIFO many times over; the TX FIFO is sized so that a burst of
+// small events doesn't hold up core0 whilst the host catches up
+#define CFG_TUD_CDC_RX_BUFSIZE      256
+#define CFG_TUD_CDC_TX_BUFSIZE      1024
+#define CFG_TUD_CDC_EP_BUFSIZE      64
+
+// the bulk interface carries frames as well as results, so has the larger TX FIFO
+#define CFG_TUD_VENDOR_RX_BUFSIZE   256
+#define CFG_TUD_VENDOR_TX_BUFSIZE   2048
+#define CFG_TUD_VENDOR_EPSIZE       64
+
+#endif
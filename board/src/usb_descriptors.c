@@ -0,0 +1,222 @@
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/bootrom.h"
+#include "pico/unique_id.h"
+#include "tusb.h"
+
+#include "usb_io.h"
+
+// as the Pico SDK's USB stdio, so that hosts (and drivers) which know the board still find it;
+// other Picos share these, so the driver also checks the product string before claiming one
+#define USB_VID                 0x2e8a
+#define USB_PID                 0x000a
+
+// distinct from the SDK's 0x0100 because the interfaces differ, so that Windows doesn't reuse
+// what it cached for a plain stdio Pico and fetches the Microsoft OS 2.0 descriptor afresh
+#define USB_BCD_DEVICE          0x0200
+#define USB_BCD                 0x0210      // 2.1, for the BOS descriptor
+#define USB_MAX_POWER_MA        250
+
+#define EPNUM_CDC_NOTIF(n)      (0x81 + 2 * (n))
+#define EPNUM_CDC_OUT(n)        (0x02 + 2 * (n))
+#define EPNUM_CDC_IN(n)         (0x82 + 2 * (n))
+#define CDC_NOTIF_EP_SZ         8
+#define CDC_DATA_EP_SZ          64
+#define EPNUM_VENDOR_OUT        0x05
+#define EPNUM_VENDOR_IN         0x85
+
+// the CDC functions' notification and data interfaces, then the bulk interface
+#define ITF_NUM_VENDOR          (USB_CHANNEL_COUNT * 2)
+#define ITF_NUM_TOTAL           (ITF_NUM_VENDOR + 1)
+
+#define USB_CONFIG_TOTAL_LEN    (TUD_CONFIG_DESC_LEN + USB_CHANNEL_COUNT * TUD_CDC_DESC_LEN + TUD_VENDOR_DESC_LEN)
+
+// Vendor requests. The Microsoft OS 2.0 descriptor binds WinUSB to the bulk interface, so that
+// libusb can open it on Windows without a driver being installed; elsewhere none is needed.
+#define VENDOR_REQUEST_MICROSOFT    1
+#define VENDOR_REQUEST_BULK_OPEN    2       // wValue 1 to open the bulk interface, 0 to close
+#define MS_OS_20_DESC_LEN           0xb2
+#define BOS_TOTAL_LEN               (TUD_BOS_DESC_LEN + TUD_BOS_MICROSOFT_OS_DESC_LEN)
+
+// as PICO_STDIO_USB_RESET_MAGIC_BAUD_RATE: opening the control channel at this rate reboots
+// into the USB bootloader, for flashing without pressing BOOTSEL
+#define RESET_MAGIC_BAUD_RATE   1200
+
+enum {
+    STRID_LANGID = 0,
+    STRID_MANUFACTURER,
+    STRID_PRODUCT,
+    STRID_SERIAL,
+    STRID_CDC_CONTROL,
+    STRID_CDC_DATA,
+    STRID_VENDOR,
+    STRID_COUNT
+};
+
+static const tusb_desc_device_t _device_descriptor = {
+    .bLength            = sizeof(tusb_desc_device_t),
+    .bDescriptorType    = TUSB_DESC_DEVICE,
+    .bcdUSB             = USB_BCD,
+
+    // a composite of CDC functions, each grouped by an interface association descriptor
+    .bDeviceClass       = TUSB_CLASS_MISC,
+    .bDeviceSubClass    = MISC_SUBCLASS_COMMON,
+    .bDeviceProtocol    = MISC_PROTOCOL_IAD,
+    .bMaxPacketSize0    = CFG_TUD_ENDPOINT0_SIZE,
+
+    .idVendor           = USB_VID,
+    .idProduct          = USB_PID,
+    .bcdDevice          = USB_BCD_DEVICE,
+
+    .iManufacturer      = STRID_MANUFACTURER,
+    .iProduct           = STRID_PRODUCT,
+    .iSerialNumber      = STRID_SERIAL,
+    .bNumConfigurations = 1
+};
+
+static const uint8_t _config_descriptor[] = {
+    TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, USB_CONFIG_TOTAL_LEN, 0, USB_MAX_POWER_MA),
+
+    // each CDC function has a notification and a data interface
+    TUD_CDC_DESCRIPTOR(
+        USB_CHANNEL_CONTROL * 2,
+        STRID_CDC_CONTROL,
+        EPNUM_CDC_NOTIF(USB_CHANNEL_CONTROL),
+        CDC_NOTIF_EP_SZ,
+        EPNUM_CDC_OUT(USB_CHANNEL_CONTROL),
+        EPNUM_CDC_IN(USB_CHANNEL_CONTROL),
+        CDC_DATA_EP_SZ),
+    TUD_CDC_DESCRIPTOR(
+        USB_CHANNEL_DATA * 2,
+        STRID_CDC_DATA,
+        EPNUM_CDC_NOTIF(USB_CHANNEL_DATA),
+        CDC_NOTIF_EP_SZ,
+        EPNUM_CDC_OUT(USB_CHANNEL_DATA),
+        EPNUM_CDC_IN(USB_CHANNEL_DATA),
+        CDC_DATA_EP_SZ),
+    TUD_VENDOR_DESCRIPTOR(
+        ITF_NUM_VENDOR,
+        STRID_VENDOR,
+        EPNUM_VENDOR_OUT,
+        EPNUM_VENDOR_IN,
+        CFG_TUD_VENDOR_EPSIZE),
+};
+
+static const uint8_t _bos_descriptor[] = {
+    TUD_BOS_DESCRIPTOR(BOS_TOTAL_LEN, 1),
+    TUD_BOS_MS_OS_20_DESCRIPTOR(MS_OS_20_DESC_LEN, VENDOR_REQUEST_MICROSOFT)
+};
+
+static const uint8_t _ms_os_20_descriptor[MS_OS_20_DESC_LEN] = {
+    // set header: length, type, Windows version (8.1 onwards), total length
+    U16_TO_U8S_LE(0x000a), U16_TO_U8S_LE(MS_OS_20_SET_HEADER_DESCRIPTOR), U32_TO_U8S_LE(0x06030000),
+    U16_TO_U8S_LE(MS_OS_20_DESC_LEN),
+
+    // configuration subset header: length, type, configuration index, reserved, subset length
+    U16_TO_U8S_LE(0x0008), U16_TO_U8S_LE(MS_OS_20_SUBSET_HEADER_CONFIGURATION), 0, 0,
+    U16_TO_U8S_LE(MS_OS_20_DESC_LEN - 0x0a),
+
+    // function subset header: length, type, first interface, reserved, subset length
+    U16_TO_U8S_LE(0x0008), U16_TO_U8S_LE(MS_OS_20_SUBSET_HEADER_FUNCTION), ITF_NUM_VENDOR, 0,
+    U16_TO_U8S_LE(MS_OS_20_DESC_LEN - 0x0a - 0x08),
+
+    // compatible ID: WinUSB
+    U16_TO_U8S_LE(0x0014), U16_TO_U8S_LE(MS_OS_20_FEATURE_COMPATBLE_ID),
+    'W', 'I', 'N', 'U', 'S', 'B', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+
+    // registry property: DeviceInterfaceGUIDs (REG_MULTI_SZ), through which libusb finds it
+    U16_TO_U8S_LE(MS_OS_20_DESC_LEN - 0x0a - 0x08 - 0x08 - 0x14),
+    U16_TO_U8S_LE(MS_OS_20_FEATURE_REG_PROPERTY),
+    U16_TO_U8S_LE(0x0007), U16_TO_U8S_LE(0x002a),
+    'D', 0, 'e', 0, 'v', 0, 'i', 0, 'c', 0, 'e', 0, 'I', 0, 'n', 0,
+    't', 0, 'e', 0, 'r', 0, 'f', 0, 'a', 0, 'c', 0, 'e', 0, 'G', 0,
+    'U', 0, 'I', 0, 'D', 0, 's', 0,
+    0, 0,
+    U16_TO_U8S_LE(0x0050),
+    '{', 0, '5', 0, '0', 0, '4', 0, '9', 0, '4', 0, '3', 0, '4', 0,
+    'f', 0, '-', 0, '4', 0, 'e', 0, '4', 0, '5', 0, '-', 0, '5', 0,
+    '4', 0, '4', 0, '2', 0, '-', 0, '9', 0, 'd', 0, '1', 0, 'a', 0,
+    '-', 0, '7', 0, 'f', 0, '5', 0, 'b', 0, '7', 0, 'c', 0, '3', 0,
+    'a', 0, '0', 0, 'c', 0, '6', 0, 'e', 0, '}', 0,
+    0, 0, 0, 0
+};
+
+static const char* _strings[STRID_COUNT] = {
+    [STRID_MANUFACTURER]    = "Raspberry Pi",
+    [STRID_PRODUCT]         = "Piconet",          // matched by the driver's usbBulk.ts
+    [STRID_SERIAL]          = NULL,             // the flash chip's unique ID
+    [STRID_CDC_CONTROL]     = "Piconet Control",
+    [STRID_CDC_DATA]        = "Piconet Data",
+    [STRID_VENDOR]          = "Piconet Bulk",
+};
+
+const uint8_t* tud_descriptor_device_cb(void) {
+    return (const uint8_t*) &_device_descriptor;
+}
+
+const uint8_t* tud_descriptor_configuration_cb(uint8_t index) {
+    (void) index;
+    return _config_descriptor;
+}
+
+const uint8_t* tud_descriptor_bos_cb(void) {
+    return _bos_descriptor;
+}
+
+const uint16_t* tud_descriptor_string_cb(uint8_t index, uint16_t langid) {
+    static uint16_t descriptor[1 + 32];
+    static char serial[2 * PICO_UNIQUE_BOARD_ID_SIZE_BYTES + 1];
+    (void) langid;
+
+    uint len;
+    if (index == STRID_LANGID) {
+        descriptor[1] = 0x0409;     // English
+        len = 1;
+    } else if (index < STRID_COUNT) {
+        const char* str = _strings[index];
+        if (index == STRID_SERIAL) {
+            pico_get_unique_board_id_string(serial, sizeof(serial));
+            str = serial;
+        }
+
+        len = strlen(str);
+        if (len > 32) {
+            len = 32;
+        }
+        for (uint i = 0; i < len; i++) {
+            descriptor[1 + i] = str[i];
+        }
+    } else {
+        return NULL;
+    }
+
+    descriptor[0] = (TUSB_DESC_STRING << 8) | (2 * len + 2);
+    return descriptor;
+}
+
+void tud_cdc_line_coding_cb(uint8_t itf, const cdc_line_coding_t* line_coding) {
+    if (itf == USB_CHANNEL_CONTROL && line_coding->bit_rate == RESET_MAGIC_BAUD_RATE) {
+        reset_usb_boot(0, 0);
+    }
+}
+
+bool tud_vendor_control_xfer_cb(uint8_t rhport, uint8_t stage, const tusb_control_request_t* request) {
+    if (stage != CONTROL_STAGE_SETUP || request->bmRequestType_bit.type != TUSB_REQ_TYPE_VENDOR) {
+        return true;
+    }
+
+    switch (request->bRequest) {
+        case VENDOR_REQUEST_MICROSOFT:
+            if (request->wIndex != 7) {     // MS_OS_20_DESCRIPTOR_INDEX
+                return false;
+            }
+            return tud_control_xfer(rhport, request, (void*) _ms_os_20_descriptor, sizeof(_ms_os_20_descriptor));
+
+        case VENDOR_REQUEST_BULK_OPEN:
+            usb_set_bulk_open(request->wValue != 0);
+            return tud_control_status(rhport, request);
+
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,562 @@
+#include "usb_io.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "pico/mutex.h"
+#include "pico/stdio/driver.h"
+#include "tusb.h"
+
+#define CONSOLE_RING_SZ         512     // printf() output awaiting usb_task()
+#define TX_RING_SZ              2048    // output awaiting whole packets, per port
+#define BULK_HEADER_SZ          2
+#define LINE_PARTS              3       // of a line written by usb_task(): two, then its ending
+#define CANCEL_MARKER           "\x18\r\n"
+#define CANCEL_MARKER_LEN       3
+
+// where output goes: a CDC interface (numbered as the channels) or the bulk interface
+#define PORT_BULK               USB_CHANNEL_COUNT
+#define PORT_COUNT              (USB_CHANNEL_COUNT + 1)
+
+typedef struct {
+    uint8_t             data[TX_RING_SZ];
+    size_t              head;
+    size_t              used;
+    uint64_t            flush_at_us;    // when the partly filled packet at its end must go out
+} tx_ring_t;
+
+// A line left for usb_task() to write as the host makes room for it (see usb_start_line)
+typedef struct {
+    const char*         parts[LINE_PARTS];
+    size_t              lens[LINE_PARTS];
+    uint                part;
+    bool                active;
+} pending_line_t;
+
+static void             (*_on_rx)(void);
+static uint8_t          _port[USB_CHANNEL_COUNT];       // to which each channel's line goes
+static bool             _mid_line[USB_CHANNEL_COUNT];
+static bool             _dropping[USB_CHANNEL_COUNT];   // the rest of an abandoned line
+static pending_line_t   _pending[USB_CHANNEL_COUNT];
+static volatile bool    _bulk_open;
+static bool             _bulk_abandoned;    // the host may hold part of a line never finished
+static bool             _cancelled[USB_CHANNEL_COUNT];  // likewise, on each CDC interface
+static tx_ring_t        _tx[PORT_COUNT];
+static uint16_t         _flush_us = USB_FLUSH_US_DEFAULT;
+static usb_output_stats_t _stats;
+
+// printf() output, written by either core and read by core0. Output that doesn't fit is lost.
+static mutex_t          _console_lock;
+static char             _console_ring[CONSOLE_RING_SZ];
+static size_t           _console_head;
+static size_t           _console_tail;
+
+static void _console_out_chars(const char* buf, int len);
+
+static stdio_driver_t _console_driver = {
+    .out_chars = _console_out_chars,
+};
+
+bool usb_init(void (*on_rx)(void)) {
+    _on_rx = on_rx;
+    mutex_init(&_console_lock);
+    stdio_set_driver_enabled(&_console_driver, true);
+    return tusb_init();
+}
+
+static bool _connected(uint8_t port) {
+    return (port == PORT_BULK) ? _bulk_open : tud_cdc_n_connected(port);
+}
+
+static uint32_t _fifo_write(uint8_t port, const void* data, uint32_t len) {
+    return (port == PORT_BULK) ? tud_vendor_n_write(0, data, len) : tud_cdc_n_write(port, data, len);
+}
+
+static void _fifo_flush(uint8_t port) {
+    if (port == PORT_BULK) {
+        tud_vendor_n_write_flush(0);
+    } else {
+        tud_cdc_n_write_flush(port);
+    }
+}
+
+static uint32_t _fifo_available(uint8_t port) {
+    return (port == PORT_BULK) ? tud_vendor_n_write_available(0) : tud_cdc_n_write_available(port);
+}
+
+// The port a channel's output goes to, chosen afresh at the start of each line so that lines
+// aren't split between two if the host opens or closes the data channel or bulk interface
+static uint8_t _route(usb_channel_t channel) {
+    if (!_mid_line[channel]) {
+        if (_bulk_open) {
+            _port[channel] = PORT_BULK;
+        } else if (channel == USB_CHANNEL_DATA && !tud_cdc_n_connected(USB_CHANNEL_DATA)) {
+            _port[channel] = USB_CHANNEL_CONTROL;
+        } else {
+            _port[channel] = channel;
+        }
+    }
+    return _port[channel];
+}
+
+static size_t _ring_put(tx_ring_t* ring, const uint8_t* data, size_t len) {
+    if (len > TX_RING_SZ - ring->used) {
+        len = TX_RING_SZ - ring->used;
+    }
+    if (len == 0) {
+        return 0;
+    }
+
+    // the ring holds whole packets from its head, so the last starts at a multiple of their size
+    size_t last_packet = ((ring->used + len - 1) / USB_PACKET_SZ) * USB_PACKET_SZ;
+    if (last_packet >= ring->used) {
+        ring->flush_at_us = time_us_64() + _flush_us;
+    }
+    size_t tail = (ring->head + ring->used) % TX_RING_SZ;
+    size_t first = (len < TX_RING_SZ - tail) ? len : TX_RING_SZ - tail;
+    memcpy(&ring->data[tail], data, first);
+    memcpy(ring->data, data + first, len - first);
+    ring->used += len;
+    return len;
+}
+
+// Hands as many whole packets from a port's ring to the USB stack as it has room for and, if
+// `force`, the remainder too, then starts sending. Returns whether a partly filled packet went.
+static bool _pump(uint8_t port, bool force) {
+    tx_ring_t* ring = &_tx[port];
+    uint32_t room = _fifo_available(port);
+    size_t len = (ring->used < room) ? ring->used : room;
+    if (!force) {
+        len -= len % USB_PACKET_SZ;
+    }
+    if (len == 0) {
+        return false;
+    }
+
+    size_t first = (len < TX_RING_SZ - ring->head) ? len : TX_RING_SZ - ring->head;
+    _fifo_write(port, &ring->data[ring->head], first);
+    _fifo_write(port, ring->data, len - first);
+    ring->head = (ring->head + len) % TX_RING_SZ;
+    ring->used -= len;
+    _fifo_flush(port);
+
+    bool partial = (len % USB_PACKET_SZ) != 0;
+    _stats.bytes += len;
+    _stats.full_packets += len / USB_PACKET_SZ;
+    _stats.packets += len / USB_PACKET_SZ + (partial ? 1 : 0);
+    return partial;
+}
+
+static void _discard(uint8_t port) {
+    _tx[port].head = 0;
+    _tx[port].used = 0;
+}
+
+// Room for a channel's output in a port's ring. Data may not take the last USB_CONTROL_RESERVE
+// bytes of a ring it shares with the control channel, so that results and reports still fit
+// whilst the host holds frames up.
+static size_t _room(uint8_t port, usb_channel_t channel) {
+    size_t room = TX_RING_SZ - _tx[port].used;
+    bool shared = (channel == USB_CHANNEL_DATA && port != USB_CHANNEL_DATA);
+    size_t reserve = shared ? USB_CONTROL_RESERVE : 0;
+    return (room > reserve) ? room - reserve : 0;
+}
+
+// Makes room for at least `needed` bytes of a channel's output by sending whole packets. If
+// `wait`, keeps trying until the host has read nothing for USB_WRITE_TIMEOUT_US; otherwise stops
+// as soon as the USB stack takes no more. Returns the room, or 0 if there isn't enough or the
+// port has closed.
+static size_t _await_room(uint8_t port, usb_channel_t channel, size_t needed, bool wait) {
+    uint64_t deadline_us = time_us_64() + USB_WRITE_TIMEOUT_US;
+    size_t room;
+
+    while ((room = _room(port, channel)) < needed) {
+        if (!_connected(port) || time_us_64() > deadline_us) {
+            return 0;
+        }
+        // short of room, the ring holds at least a whole packet
+        size_t used = _tx[port].used;
+        _pump(port, false);
+        if (_tx[port].used != used) {
+            deadline_us = time_us_64() + USB_WRITE_TIMEOUT_US;
+        } else if (!wait) {
+            return 0;
+        }
+        tud_task();
+    }
+    return room;
+}
+
+static size_t _write_raw(uint8_t port, usb_channel_t channel, const void* data, size_t len, bool wait) {
+    size_t total = 0;
+
+    while (total < len) {
+        size_t room = _await_room(port, channel, 1, wait);
+        if (room == 0) {
+            break;
+        }
+        total += _ring_put(&_tx[port], (const uint8_t*) data + total, (len - total < room) ? len - total : room);
+    }
+    return total;
+}
+
+static void _put_chunk_header(uint16_t header) {
+    uint8_t header_bytes[BULK_HEADER_SZ] = { header & 0xff, header >> 8 };
+    _ring_put(&_tx[PORT_BULK], header_bytes, sizeof(header_bytes));
+}
+
+// Gives up on the rest of a line which a port has had no room for, skipping whatever of it is
+// still to be written. If the host hasn't read a result or report from the bulk interface for
+// USB_WRITE_TIMEOUT_US, it's taken to have gone: without DTR there's no other way to tell.
+// Otherwise, if part of the line has gone out, the host is told to discard it before the next
+// line on the port, rather than take what it has for a complete (and shorter) line.
+static void _abandon_line(uint8_t port, usb_channel_t channel, const char* data, size_t len) {
+    if (port == PORT_BULK && (channel == USB_CHANNEL_CONTROL || !_bulk_open)) {
+        _bulk_open = false;
+        _discard(PORT_BULK);
+    } else if (_mid_line[channel]) {
+        if (port == PORT_BULK) {
+            _bulk_abandoned = true;
+        } else {
+            _cancelled[port] = true;
+        }
+    }
+    _dropping[channel] = (len == 0 || data[len - 1] != '\n');
+    _mid_line[channel] = false;
+}
+
+// Writes part of a line to the bulk interface as chunks, ending the line's last at `\n`. Chunks
+// are sized to the room in the ring, so that a line given up on is never left mid-chunk. Returns
+// how much of the part was taken, which is less than `len` only if `wait` is false.
+static size_t _write_chunks(usb_channel_t channel, const char* data, size_t len, bool wait) {
+    size_t total = 0;
+
+    while (total < len) {
+        const char* newline = memchr(data + total, '\n', len - total);
+        size_t chunk = (newline != NULL) ? (size_t) (newline - (data + total)) : len - total;
+        bool end = (newline != NULL);
+
+        bool marker = _bulk_abandoned && !_mid_line[channel];
+        size_t overhead = (marker ? BULK_HEADER_SZ : 0) + BULK_HEADER_SZ;
+        size_t room = _await_room(PORT_BULK, channel, overhead + ((chunk > 0) ? 1 : 0), wait);
+        if (room == 0) {
+            if (!wait && _connected(PORT_BULK)) {
+                return total;
+            }
+            _abandon_line(PORT_BULK, channel, data + total, len - total);
+            return len;
+        }
+        if (marker) {
+            _put_chunk_header(0);
+            _bulk_abandoned = false;
+        }
+        if (chunk > room - overhead) {
+            chunk = room - overhead;
+            end = false;
+        }
+        if (chunk > USB_BULK_CHUNK_MAX) {
+            chunk = USB_BULK_CHUNK_MAX;
+            end = false;
+        }
+
+        _put_chunk_header(chunk | (end ? USB_BULK_CHUNK_END : 0));
+        _ring_put(&_tx[PORT_BULK], (const uint8_t*) data + total, chunk);
+        if (end) {
+            chunk++;
+        }
+        total += chunk;
+        _mid_line[channel] = !end;
+        if (end) {
+            _stats.lines++;
+        }
+    }
+    return total;
+}
+
+// Writes part of a line to a CDC interface, translating `\n` to `\r\n`. Returns how much of the
+// part was taken, which is less than `len` only if `wait` is false.
+static size_t _write_cdc(uint8_t port, usb_channel_t channel, const char* data, size_t len, bool wait) {
+    size_t total = 0;
+    bool stalled = false;
+
+    if (!_mid_line[channel] && _cancelled[port]) {
+        if (_await_room(port, channel, CANCEL_MARKER_LEN, wait) > 0) {
+            _ring_put(&_tx[port], (const uint8_t*) CANCEL_MARKER, CANCEL_MARKER_LEN);
+            _cancelled[port] = false;
+        } else {
+            stalled = true;
+        }
+    }
+
+    while (!stalled && total < len) {
+        const char* newline = memchr(data + total, '\n', len - total);
+        size_t chunk = (newline != NULL) ? (size_t) (newline - (data + total)) : len - total;
+        size_t written = _write_raw(port, channel, data + total, chunk, wait);
+        total += written;
+        if (written > 0) {
+            _mid_line[channel] = true;
+        }
+
+        if (written < chunk) {
+            stalled = true;
+        } else if (newline != NULL) {
+            if (_await_room(port, channel, 2, wait) > 0) {
+                _ring_put(&_tx[port], (const uint8_t*) "\r\n", 2);
+                _stats.lines++;
+                _mid_line[channel] = false;
+                total++;
+            } else {
+                stalled = true;
+            }
+        }
+    }
+
+    if (stalled && (wait || !_connected(port))) {
+        _abandon_line(port, channel, data + total, len - total);
+        return len;
+    }
+    return total;
+}
+
+// Another channel part way through a line on a port, which must finish before a line of
+// `channel` starts there
+static int _line_holder(uint8_t port, usb_channel_t channel) {
+    for (int other = 0; other < USB_CHANNEL_COUNT; other++) {
+        if (other != (int) channel && _mid_line[other] && _port[other] == port) {
+            return other;
+        }
+    }
+    return -1;
+}
+
+static void _write_pending(usb_channel_t channel, bool wait);
+
+// Writes part of a line, then sends the whole packets written, or everything if the line is
+// complete and can't wait. If `wait`, what the host has no room for is waited for and given up
+// on after USB_WRITE_TIMEOUT_US; otherwise, writing stops there and the number of characters
+// taken is returned, so that the caller can carry on later. Output for a channel the host hasn't
+// opened is dropped, as the SDK's USB stdio does.
+static size_t _write(usb_channel_t channel, const char* data, size_t len, bool wait) {
+    size_t skipped = 0;
+
+    if (_dropping[channel]) {
+        const char* newline = memchr(data, '\n', len);
+        if (newline == NULL) {
+            return len;
+        }
+        _dropping[channel] = false;
+        skipped = newline + 1 - data;
+        data += skipped;
+        len -= skipped;
+        if (len == 0) {
+            return skipped;
+        }
+    }
+
+    uint8_t port = _route(channel);
+    if (!_mid_line[channel]) {
+        int holder = _line_holder(port, channel);
+        if (holder >= 0) {
+            if (!wait) {
+                return skipped;
+            }
+            // lines can't be interleaved, so the other line must go first
+            _write_pending(holder, true);
+            if (_mid_line[holder]) {
+                _abandon_line(port, holder, NULL, 0);
+            }
+            port = _route(channel);
+        }
+    }
+
+    if (!_connected(port)) {
+        _abandon_line(port, channel, data, len);
+        return skipped + len;
+    }
+
+    size_t written = (port == PORT_BULK)
+        ? _write_chunks(channel, data, len, wait)
+        : _write_cdc(port, channel, data, len, wait);
+
+    bool urgent = !_mid_line[channel] && (channel == USB_CHANNEL_CONTROL || _flush_us == 0);
+    if (_pump(port, urgent)) {
+        _stats.urgent_flushes++;
+    }
+    if (urgent && _tx[port].used > 0) {
+        // what didn't fit goes as soon as there's room
+        _tx[port].flush_at_us = 0;
+    }
+    return skipped + written;
+}
+
+// Carries on writing a channel's pending line, if any, as far as the host has room for
+static void _write_pending(usb_channel_t channel, bool wait) {
+    pending_line_t* line = &_pending[channel];
+
+    while (line->active) {
+        uint part = line->part;
+        if (line->lens[part] > 0) {
+            size_t written = _write(channel, line->parts[part], line->lens[part], wait);
+            line->parts[part] += written;
+            line->lens[part] -= written;
+            if (line->lens[part] > 0) {
+                return;
+            }
+        }
+        line->part++;
+        line->active = (line->part < LINE_PARTS);
+    }
+}
+
+void usb_printf(usb_channel_t channel, const char* format, ...) {
+    char buffer[USB_PRINTF_MAX];
+    va_list args;
+
+    va_start(args, format);
+    int len = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+
+    if (len > 0) {
+        _write(channel, buffer, (len < (int) sizeof(buffer)) ? (size_t) len : sizeof(buffer) - 1, true);
+    }
+}
+
+void usb_puts(usb_channel_t channel, const char* str) {
+    _write(channel, str, strlen(str), true);
+    _write(channel, "\n", 1, true);
+}
+
+void usb_start_line(usb_channel_t channel, const char* header, const char* body) {
+    pending_line_t* line = &_pending[channel];
+
+    line->parts[0] = header;
+    line->lens[0] = strlen(header);
+    line->parts[1] = body;
+    line->lens[1] = (body != NULL) ? strlen(body) : 0;
+    line->parts[2] = "\n";
+    line->lens[2] = 1;
+    line->part = 0;
+    line->active = true;
+    _write_pending(channel, false);
+}
+
+bool usb_line_pending(usb_channel_t channel) {
+    return _pending[channel].active;
+}
+
+int usb_read(char* buffer, size_t len) {
+    uint32_t count = tud_cdc_n_read(USB_CHANNEL_CONTROL, buffer, len);
+    if (count == 0) {
+        count = tud_vendor_n_read(0, buffer, len);
+    }
+    return (int) count;
+}
+
+void usb_set_bulk_open(bool open) {
+    if (open && !_bulk_open) {
+        // the host may still hold part of a line from before the interface was closed
+        _bulk_abandoned = true;
+    }
+    _bulk_open = open;
+}
+
+void usb_set_flush_us(uint16_t flush_us) {
+    _flush_us = flush_us;
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+uint16_t usb_get_flush_us(void) {
+    return _flush_us;
+}
+
+const usb_output_stats_t* usb_get_output_stats(void) {
+    return &_stats;
+}
+
+static void _console_out_chars(const char* buf, int len) {
+    mutex_enter_blocking(&_console_lock);
+    for (int i = 0; i < len; i++) {
+        size_t next = (_console_tail + 1) % CONSOLE_RING_SZ;
+        if (next == _console_head) {
+            break;
+        }
+        _console_ring[_console_tail] = buf[i];
+        _console_tail = next;
+    }
+    mutex_exit(&_console_lock);
+}
+
+// Writes out printf() output a line at a time, so that it doesn't land in the middle of an
+// event
+static void _drain_console(void) {
+    char line[CONSOLE_RING_SZ];
+    size_t len = 0;
+
+    mutex_enter_blocking(&_console_lock);
+    size_t used = (_console_tail + CONSOLE_RING_SZ - _console_head) % CONSOLE_RING_SZ;
+    for (size_t i = 0; i < used; i++) {
+        line[i] = _console_ring[(_console_head + i) % CONSOLE_RING_SZ];
+        if (line[i] == '\n') {
+            len = i + 1;
+            break;
+        }
+    }
+    if (len == 0 && used == CONSOLE_RING_SZ - 1) {
+        // a line longer than the ring goes out in pieces
+        len = used;
+    }
+    _console_head = (_console_head + len) % CONSOLE_RING_SZ;
+    mutex_exit(&_console_lock);
+
+    if (len > 0) {
+        _write(USB_CHANNEL_CONTROL, line, len, true);
+    }
+}
+
+// Sends what's been waiting in each port's ring for longer than the flush deadline
+static void _flush_due(void) {
+    uint64_t now_us = time_us_64();
+
+    for (uint8_t port = 0; port < PORT_COUNT; port++) {
+        if (_tx[port].used == 0) {
+            continue;
+        }
+        if (!_connected(port)) {
+            _discard(port);
+            continue;
+        }
+        // also sends whole packets held up since they were written, for want of room
+        if (_pump(port, now_us >= _tx[port].flush_at_us)) {
+            _stats.deadline_flushes++;
+        }
+    }
+}
+
+void usb_task(void) {
+    tud_task();
+    for (int channel = 0; channel < USB_CHANNEL_COUNT; channel++) {
+        _write_pending(channel, false);
+    }
+    _drain_console();
+    _flush_due();
+}
+
+void tud_cdc_rx_cb(uint8_t itf) {
+    if (itf == USB_CHANNEL_CONTROL) {
+        _on_rx();
+    } else {
+        // nothing is read from the data channel
+        tud_cdc_n_read_flush(itf);
+    }
+}
+
+void tud_vendor_rx_cb(uint8_t itf, const uint8_t* buffer, uint16_t bufsize) {
+    (void) itf;
+    (void) buffer;
+    (void) bufsize;
+    _on_rx();
+}
+
+void tud_umount_cb(void) {
+    _bulk_open = false;
+}
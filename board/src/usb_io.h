@@ -0,0 +1,89 @@
+#ifndef _PICONET_USB_IO_H_
+#define _PICONET_USB_IO_H_
+
+#include "pico/stdlib.h"
+
+/*
+ * The board's USB interface: a composite device with two CDC ACM serial ports, so that a flood
+ * of received frames can't hold up the results of commands. Commands are read from the control
+ * channel, which also carries their results, reports and errors; frames received (`MONITOR`
+ * and `RX_xxx` events) go out on the data channel. Until the host opens the data channel, its
+ * output goes to the control channel instead, so a host that opens only the first port (e.g.
+ * an older driver or a terminal) sees everything there.
+ *
+ * Lines are written with `\n` endings, which go out as `\r\n`. Output written with usb_printf()
+ * or usb_puts() to a channel the host isn't reading waits for room, as the SDK's USB stdio did,
+ * then is dropped after USB_WRITE_TIMEOUT_US. A line started with usb_start_line() never waits:
+ * usb_task() writes it as the host makes room, however long that takes, so that a frame many
+ * times the size of the output ring can't hold up commands and their results whilst the host is
+ * slow to read (or has paused) the data channel. Lines can't be interleaved, so one written to a
+ * port which another channel's line is part way through waits for that to finish first. On a CDC
+ * interface, a line given up on part way through is ended with CAN (0x18) before the next line
+ * goes out, telling the host to discard it. Only core0 may call these functions, apart from printf(), which
+ * either core may use for diagnostics: its output is buffered and written to the control channel
+ * by usb_task().
+ *
+ * The device also has a vendor interface with a pair of bulk endpoints, for hosts using libusb
+ * rather than a serial port. The host opens and closes it with a vendor request
+ * (VENDOR_REQUEST_BULK_OPEN in usb_descriptors.c); whilst it's open, output for both channels
+ * goes there and commands may be written to it as to the control channel. Each line goes out as
+ * one or more chunks, each a 16-bit little-endian header (the chunk's length in the bottom 15
+ * bits, the top bit set on the line's last chunk) followed by that many bytes of the line, with
+ * no line ending. A chunk with a header of 0 (empty, and not a line's last) tells the host to
+ * discard what it has received of a line, as the rest will never come. If the host reads no
+ * results or reports for USB_WRITE_TIMEOUT_US, the bulk interface is taken to have been closed,
+ * but frames merely wait, as the host may be holding them up. Frames may not fill the last
+ * USB_CONTROL_RESERVE bytes of output awaiting a port shared with the control channel, so that
+ * results and reports still fit meanwhile.
+ *
+ * Output is gathered in a ring per port and handed to the USB stack a whole packet at a time, so
+ * that a stream of short events shares packets rather than sending one each. A partly filled
+ * packet goes out once the line that completes it is a result on the control channel (so that
+ * commands aren't held up), or once it has waited the flush deadline set with
+ * usb_set_flush_us(), which usb_task() enforces. A deadline of 0 sends each line as it's
+ * completed.
+ */
+
+typedef enum {
+    USB_CHANNEL_CONTROL = 0L,
+    USB_CHANNEL_DATA,
+    USB_CHANNEL_COUNT
+} usb_channel_t;
+
+#define USB_WRITE_TIMEOUT_US    500000      // as PICO_STDIO_USB_STDOUT_TIMEOUT_US
+#define USB_PRINTF_MAX          256         // longest output of a single usb_printf()
+#define USB_BULK_CHUNK_MAX      0x7fff
+#define USB_BULK_CHUNK_END      0x8000
+#define USB_CONTROL_RESERVE     256         // of each output ring, for the control channel
+#define USB_PACKET_SZ           64          // as CFG_TUD_CDC_EP_BUFSIZE and CFG_TUD_VENDOR_EPSIZE
+#define USB_FLUSH_US_DEFAULT    1000
+
+// counts of output handed to the USB stack since usb_set_flush_us() was last called
+typedef struct {
+    uint64_t    lines;
+    uint64_t    bytes;
+    uint64_t    packets;            // including those partly filled
+    uint64_t    full_packets;
+    uint64_t    deadline_flushes;   // partly filled packets sent on their deadline
+    uint64_t    urgent_flushes;     // partly filled packets sent at the end of a line
+} usb_output_stats_t;
+
+bool    usb_init(void (*on_rx)(void));
+void    usb_task(void);
+int     usb_read(char* buffer, size_t len);
+void    usb_printf(usb_channel_t channel, const char* format, ...);
+void    usb_puts(usb_channel_t channel, const char* str);
+
+// Starts writing a line made up of `header` and `body` (which may be NULL), neither of which may
+// change until usb_line_pending() returns false. A channel has at most one such line at a time.
+void    usb_start_line(usb_channel_t channel, const char* header, const char* body);
+bool    usb_line_pending(usb_channel_t channel);
+
+void    usb_set_flush_us(uint16_t flush_us);
+uint16_t usb_get_flush_us(void);
+const usb_output_stats_t* usb_get_output_stats(void);
+
+// called on the host's vendor request to open or close the bulk interface
+void    usb_set_bulk_open(bool open);
+
+#endif
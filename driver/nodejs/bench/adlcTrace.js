@@ -0,0 +1,121 @@
+/*
+ * Profiles the firmware's ADLC register accesses: records a bus transaction trace whilst
+ * transmitting to and receiving from virtual stations, then prints the transactions and time
+ * spent in each protocol phase and a timeline of the last few exchanges.
+ *
+ * Runs against the firmware emulator (board/host) by default or a real board with --device,
+ * in which case another station should be sending to the board for receive phases to appear.
+ *
+ * Usage: npm run bench:trace [-- path/to/piconet-emu | --device /dev/ttyACM0]
+ */
+const { spawn } = require('child_process');
+const os = require('os');
+const path = require('path');
+
+const dist = path.join(__dirname, '..', 'dist', 'cjs');
+const { driver, summariseAdlcTrace, formatAdlcTimeline } = require(dist);
+
+const deviceIndex = process.argv.indexOf('--device');
+const boardPath = deviceIndex !== -1 ? process.argv[deviceIndex + 1] : undefined;
+const emulatorPath =
+  (deviceIndex === -1 && process.argv[2]) ||
+  path.resolve(__dirname, '../../../board/host/build/piconet-emu');
+const devicePath =
+  boardPath || path.join(os.tmpdir(), `piconet-trace-${process.pid}`);
+
+const transmitCount = 20;
+const transmitSize = 16;
+const responderStation = 254;
+const senderStation = 10;
+const timelineLines = 60;
+
+const sleepMs = ms => new Promise(resolve => setTimeout(resolve, ms));
+
+const startEmulator = async () => {
+  const emulator = spawn(
+    emulatorPath,
+    [
+      '--link',
+      devicePath,
+      '--responder',
+      `${responderStation}`,
+      '--sender',
+      `${senderStation}`,
+      '--sender-rate',
+      '20',
+      '--sender-size',
+      `${transmitSize}`,
+    ],
+    { stdio: ['ignore', 'ignore', 'pipe'] },
+  );
+
+  await new Promise((resolve, reject) => {
+    emulator.once('error', reject);
+    emulator.once('exit', code =>
+      reject(new Error(`Emulator exited with code ${code}`)),
+    );
+    emulator.stderr.on('data', chunk => {
+      if (chunk.toString().includes('Piconet emulator listening')) {
+        resolve();
+      }
+    });
+  });
+  emulator.removeAllListeners('exit');
+
+  return {
+    stop: () =>
+      new Promise(resolve => {
+        emulator.once('exit', resolve);
+        emulator.kill('SIGTERM');
+      }),
+  };
+};
+
+const main = async () => {
+  const emulator = boardPath ? undefined : await startEmulator();
+  try {
+    await driver.connect(devicePath);
+    await driver.setMode('LISTEN');
+    await driver.setAdlcTrace(true);
+
+    const data = Buffer.alloc(transmitSize, 0x55);
+    for (let i = 0; i < transmitCount; i++) {
+      await driver.transmit(responderStation, 0, 0x80, 0x99, data);
+      await sleepMs(25);
+    }
+    await sleepMs(250);
+
+    const trace = await driver.setAdlcTrace(false);
+    await driver.setMode('STOP');
+
+    console.log(
+      `${trace.recorded} entries recorded, last ${trace.entries.length} held\n`,
+    );
+    console.log(
+      'phase          count  reads/ea writes/ea snoops/ea  waits/ea  mean us   max us',
+    );
+    summariseAdlcTrace(trace.entries).forEach(s => {
+      const each = value => (value / s.occurrences).toFixed(1).padStart(9);
+      console.log(
+        `${s.name.padEnd(13)} ${`${s.occurrences}`.padStart(6)} ` +
+          `${each(s.reads)}${each(s.writes)}${each(s.snoops)} ` +
+          `${each(s.waitPolls)}${each(s.totalUs)}${`${s.maxUs}`.padStart(9)}`,
+      );
+    });
+
+    console.log('\ntimeline:');
+    formatAdlcTimeline(trace.entries)
+      .slice(-timelineLines)
+      .forEach(line => console.log(line));
+  } finally {
+    await driver.close();
+    if (emulator) {
+      await emulator.stop();
+    }
+  }
+};
+
+main().catch(e => {
+  console.error(e);
+  process.exit(1);
+});
@@ -0,0 +1,134 @@
+/*
+ * Load test of the firmware on a busy Econet: runs the firmware emulator (board/host) with
+ * contending virtual stations following a traffic profile, receives whatever they send to
+ * Piconet in LISTEN mode, then prints each station's goodput, handshake failure rate and
+ * latency, line utilisation and how full the firmware's queues got.
+ *
+ * Usage: npm run bench:contention [-- profile.txt [seconds [path/to/piconet-emu]]]
+ */
+const { spawn } = require('child_process');
+const os = require('os');
+const path = require('path');
+
+const dist = path.join(__dirname, '..', 'dist', 'cjs');
+const { driver } = require(dist);
+
+const profilePath =
+  process.argv[2] ||
+  path.resolve(__dirname, '../../../board/host/profiles/contention.txt');
+const durationS = parseInt(process.argv[3] || '10', 10);
+const emulatorPath =
+  process.argv[4] ||
+  path.resolve(__dirname, '../../../board/host/build/piconet-emu');
+const devicePath = path.join(os.tmpdir(), `piconet-contention-${process.pid}`);
+
+const piconetStation = 2;
+const responderStation = 254;
+
+const sleepMs = ms => new Promise(resolve => setTimeout(resolve, ms));
+
+const startEmulator = async () => {
+  const emulator = spawn(
+    emulatorPath,
+    [
+      '--link',
+      devicePath,
+      '--responder',
+      `${responderStation}`,
+      '--profile',
+      profilePath,
+    ],
+    { stdio: ['ignore', 'ignore', 'pipe'] },
+  );
+  const statsWaiters = [];
+  let stderr = '';
+
+  await new Promise((resolve, reject) => {
+    emulator.once('error', reject);
+    emulator.once('exit', code =>
+      reject(new Error(`Emulator exited with code ${code}: ${stderr}`)),
+    );
+    emulator.stderr.on('data', chunk => {
+      stderr += chunk.toString();
+      let newline = stderr.indexOf('\n');
+      while (newline !== -1) {
+        const line = stderr.substring(0, newline);
+        stderr = stderr.substring(newline + 1);
+        if (line.startsWith('{')) {
+          const waiter = statsWaiters.shift();
+          if (waiter) {
+            waiter(JSON.parse(line));
+          }
+        } else if (line.startsWith('Piconet emulator listening')) {
+          resolve();
+        }
+        newline = stderr.indexOf('\n');
+      }
+    });
+  });
+  emulator.removeAllListeners('exit');
+
+  return {
+    stats: () =>
+      new Promise(resolve => {
+        statsWaiters.push(resolve);
+        emulator.kill('SIGUSR1');
+      }),
+    stop: () =>
+      new Promise(resolve => {
+        emulator.once('exit', resolve);
+        emulator.kill('SIGTERM');
+      }),
+  };
+};
+
+const main = async () => {
+  console.log(`profile: ${profilePath}, ${durationS}s\n`);
+  const emulator = await startEmulator();
+  try {
+    await driver.connect(devicePath);
+    await driver.setEconetStation(piconetStation);
+    await driver.setMode('LISTEN');
+
+    let received = 0;
+    driver.addListener(() => {
+      received++;
+    });
+    await sleepMs(durationS * 1000);
+    const stats = await emulator.stats();
+
+    console.log(
+      'station  offered delivered  goodput b/s  fail rate  collisions  abandoned  mean ms   max ms',
+    );
+    stats.stations.forEach(s => {
+      console.log(
+        `${`${s.station}`.padStart(7)} ${`${s.offered}`.padStart(8)} ` +
+          `${`${s.delivered}`.padStart(9)} ${`${s.goodput_bps}`.padStart(12)} ` +
+          `${s.failure_rate.toFixed(3).padStart(10)} ` +
+          `${`${s.collisions}`.padStart(11)} ${`${s.abandoned}`.padStart(10)} ` +
+          `${(s.mean_latency_us / 1000).toFixed(1).padStart(8)} ` +
+          `${(s.max_latency_us / 1000).toFixed(1).padStart(8)}`,
+      );
+    });
+
+    const utilisation = (100 * stats.line.busy_us) / stats.time_us;
+    console.log(
+      `\nline: ${stats.line.frames} frames, ${stats.line.collisions} collisions, ` +
+        `${utilisation.toFixed(1)}% busy`,
+    );
+    console.log(
+      `firmware: event queue mean ${stats.firmware.event_queue_mean} ` +
+        `max ${stats.firmware.event_queue_max}, rx buffers mean ` +
+        `${stats.firmware.rx_buffers_mean} max ${stats.firmware.rx_buffers_max}, ` +
+        `${received} events received`,
+    );
+  } finally {
+    await driver.close();
+    await emulator.stop();
+  }
+};
+
+main().catch(e => {
+  console.error(e);
+  process.exit(1);
+});
@@ -0,0 +1,291 @@
+/*
+ * End-to-end benchmarks of the driver against the firmware emulator (board/host), which runs
+ * the real firmware over a pseudo-terminal with a simulated Econet:
+ *
+ * - transmit round trip time (p50/p99) to a virtual station which acknowledges everything;
+ * - transmitBulk throughput to the same station with increasing numbers of chunks in flight;
+ * - MONITOR events delivered versus frames offered on the line at increasing frame rates,
+ *   giving the maximum sustained rate and driver CPU time per event;
+ * - FLOW round trip time during a MONITOR flood, with frames sharing the control channel and
+ *   then on their own data channel.
+ *
+ * Usage: npm run bench:emulator [-- path/to/piconet-emu]
+ */
+const { spawn } = require('child_process');
+const os = require('os');
+const path = require('path');
+
+const dist = path.join(__dirname, '..', 'dist', 'cjs');
+const { driver, MonitorEvent } = require(dist);
+
+const emulatorPath =
+  process.argv[2] ||
+  path.resolve(__dirname, '../../../board/host/build/piconet-emu');
+const devicePath = path.join(os.tmpdir(), `piconet-bench-${process.pid}`);
+const dataDevicePath = `${devicePath}-data`;
+
+const transmitCount = 500;
+const transmitSize = 64;
+const responderStation = 254;
+const bulkSize = 256 * 1024;
+const bulkWindows = [1, 2, 4, 8];
+const bulkBitrate = 5000000;
+const monitorRates = [250, 500, 1000, 2000, 4000, 8000, 16000];
+const monitorBitrate = 5000000;
+const monitorWarmupMs = 500;
+const monitorDurationMs = 3000;
+const sustainedRatio = 0.99;
+const controlCount = 200;
+const controlMonitorRate = 8000;
+
+const sleepMs = ms => new Promise(resolve => setTimeout(resolve, ms));
+
+const percentile = (sorted, p) =>
+  sorted[Math.min(sorted.length - 1, Math.floor((sorted.length * p) / 100))];
+
+const startEmulator = async (args, dataChannel = false) => {
+  const links = ['--link', devicePath];
+  if (dataChannel) {
+    links.push('--data-link', dataDevicePath);
+  }
+  const emulator = spawn(emulatorPath, [...links, ...args], {
+    stdio: ['ignore', 'ignore', 'pipe'],
+  });
+  const statsWaiters = [];
+  let stderr = '';
+
+  await new Promise((resolve, reject) => {
+    emulator.once('error', reject);
+    emulator.once('exit', code =>
+      reject(new Error(`Emulator exited with code ${code}: ${stderr}`)),
+    );
+    emulator.stderr.on('data', chunk => {
+      stderr += chunk.toString();
+      let newline = stderr.indexOf('\n');
+      while (newline !== -1) {
+        const line = stderr.substring(0, newline);
+        stderr = stderr.substring(newline + 1);
+        if (line.startsWith('{')) {
+          const waiter = statsWaiters.shift();
+          if (waiter) {
+            waiter(JSON.parse(line));
+          }
+        } else if (line.startsWith('Piconet emulator listening')) {
+          resolve();
+        }
+        newline = stderr.indexOf('\n');
+      }
+    });
+  });
+  emulator.removeAllListeners('exit');
+
+  return {
+    stats: () =>
+      new Promise(resolve => {
+        statsWaiters.push(resolve);
+        emulator.kill('SIGUSR1');
+      }),
+    stop: () =>
+      new Promise(resolve => {
+        emulator.once('exit', resolve);
+        emulator.kill('SIGTERM');
+      }),
+  };
+};
+
+const benchTransmit = async () => {
+  const emulator = await startEmulator(['--responder', `${responderStation}`]);
+  try {
+    await driver.connect(devicePath);
+    await driver.setMode('LISTEN');
+
+    const data = Buffer.alloc(transmitSize, 0x55);
+    const rttsMs = [];
+    let failures = 0;
+    const start = process.hrtime.bigint();
+    for (let i = 0; i < transmitCount; i++) {
+      const txStart = process.hrtime.bigint();
+      const result = await driver.transmit(
+        responderStation,
+        0,
+        0x80,
+        0x99,
+        data,
+      );
+      rttsMs.push(Number(process.hrtime.bigint() - txStart) / 1e6);
+      if (!result.success) {
+        failures++;
+      }
+    }
+    const elapsedS = Number(process.hrtime.bigint() - start) / 1e9;
+
+    rttsMs.sort((a, b) => a - b);
+    const p50 = percentile(rttsMs, 50).toFixed(2);
+    const p99 = percentile(rttsMs, 99).toFixed(2);
+    const max = rttsMs[rttsMs.length - 1].toFixed(2);
+    const rate = (transmitCount / elapsedS).toFixed(0);
+    console.log(
+      `transmit ${transmitSize} bytes x ${transmitCount}: ` +
+        `p50 ${p50}ms p99 ${p99}ms max ${max}ms, ` +
+        `${rate} transmits/s, ${failures} failed`,
+    );
+  } finally {
+    await driver.close();
+    await emulator.stop();
+  }
+};
+
+const benchBulk = async () => {
+  // a fast line, so that time lost between chunks shows
+  const emulator = await startEmulator([
+    '--responder',
+    `${responderStation}`,
+    '--bitrate',
+    `${bulkBitrate}`,
+  ]);
+  try {
+    await driver.connect(devicePath);
+    await driver.setMode('LISTEN');
+
+    const data = Buffer.alloc(bulkSize, 0x55);
+    for (const window of bulkWindows) {
+      const result = await driver.transmitBulk(
+        responderStation,
+        0,
+        0x99,
+        data,
+        { window },
+      );
+      console.log(
+        `transmitBulk ${bulkSize} bytes window ${window}: ` +
+          `${result.bytesPerSecond.toFixed(0)} bytes/s, ` +
+          `chunk latency mean ${result.meanChunkLatencyMs.toFixed(1)}ms ` +
+          `max ${result.maxChunkLatencyMs}ms, ${result.retries} retries` +
+          (result.success ? '' : `, failed: ${result.description}`),
+      );
+    }
+  } finally {
+    await driver.close();
+    await emulator.stop();
+  }
+};
+
+const benchMonitorRate = async rate => {
+  const emulator = await startEmulator([
+    '--bitrate',
+    `${monitorBitrate}`,
+    '--monitor-rate',
+    `${rate}`,
+  ]);
+  try {
+    let events = 0;
+    const listener = () => {
+      events++;
+    };
+    await driver.connect(devicePath);
+    driver.addListener(listener, [MonitorEvent]);
+    await driver.setMode('MONITOR');
+    await sleepMs(monitorWarmupMs);
+
+    const statsBefore = await emulator.stats();
+    events = 0;
+    const cpuBefore = process.cpuUsage();
+    await sleepMs(monitorDurationMs);
+    const cpu = process.cpuUsage(cpuBefore);
+    const received = events;
+    const statsAfter = await emulator.stats();
+
+    driver.removeListener(listener);
+    await driver.setMode('STOP');
+
+    const offered =
+      statsAfter.peers.traffic_frames - statsBefore.peers.traffic_frames;
+    const missed =
+      statsAfter.adlc.frames_missed - statsBefore.adlc.frames_missed;
+    const ratio = offered > 0 ? received / offered : 0;
+    const cpuUsPerEvent =
+      received > 0 ? (cpu.user + cpu.system) / received : 0;
+
+    const delivered = ((received * 1000) / monitorDurationMs).toFixed(0);
+    console.log(
+      `monitor ${rate.toString().padStart(6)} frames/s offered: ` +
+        `${delivered.padStart(6)} events/s delivered ` +
+        `(${(ratio * 100).toFixed(1)}%), ${missed} missed by firmware, ` +
+        `${cpuUsPerEvent.toFixed(1)}us driver CPU/event`,
+    );
+
+    return ratio;
+  } finally {
+    await driver.close();
+    await emulator.stop();
+  }
+};
+
+const benchControlLatency = async dataChannel => {
+  const emulator = await startEmulator(
+    [
+      '--bitrate',
+      `${monitorBitrate}`,
+      '--monitor-rate',
+      `${controlMonitorRate}`,
+    ],
+    dataChannel,
+  );
+  try {
+    await driver.connect(devicePath, dataChannel ? dataDevicePath : undefined);
+    await driver.setMode('MONITOR');
+    await sleepMs(monitorWarmupMs);
+
+    const rttsMs = [];
+    for (let i = 0; i < controlCount; i++) {
+      const start = process.hrtime.bigint();
+      await driver.readFlowStatus();
+      rttsMs.push(Number(process.hrtime.bigint() - start) / 1e6);
+    }
+    await driver.setMode('STOP');
+
+    rttsMs.sort((a, b) => a - b);
+    const p50 = percentile(rttsMs, 50).toFixed(2);
+    const p99 = percentile(rttsMs, 99).toFixed(2);
+    const max = rttsMs[rttsMs.length - 1].toFixed(2);
+    console.log(
+      `FLOW during monitor at ${controlMonitorRate} frames/s, ` +
+        `${dataChannel ? 'separate data channel' : 'control channel only'}: ` +
+        `p50 ${p50}ms p99 ${p99}ms max ${max}ms`,
+    );
+  } finally {
+    await driver.close();
+    await emulator.stop();
+  }
+};
+
+const main = async () => {
+  console.log(`emulator: ${emulatorPath}\n`);
+
+  await benchTransmit();
+  await benchBulk();
+  console.log();
+
+  let maxSustained = 0;
+  for (const rate of monitorRates) {
+    const ratio = await benchMonitorRate(rate);
+    if (ratio >= sustainedRatio) {
+      maxSustained = rate;
+    }
+  }
+  const sustained =
+    maxSustained > 0 ? `${maxSustained}` : `< ${monitorRates[0]}`;
+  console.log(
+    `\nmax sustained MONITOR rate: ${sustained} frames/s ` +
+      `(>= ${sustainedRatio * 100}% delivered)`,
+  );
+  console.log();
+
+  await benchControlLatency(false);
+  await benchControlLatency(true);
+};
+
+main().catch(e => {
+  console.error(e);
+  process.exit(1);
+});
@@ -0,0 +1,80 @@
+/*
+ * Microbenchmark for parsing lines received from the board.
+ *
+ * Replays a capture of raw event lines (one per line, as logged with `setDebugEnabled(true)`)
+ * through the legacy approach (every parser tried against every line) and the dispatch table,
+ * with and without an event name filter.
+ *
+ * Usage: npm run bench:parser [-- path/to/capture.txt] [iterations]
+ */
+const fs = require('fs');
+const path = require('path');
+
+const dist = path.join(__dirname, '..', 'dist', 'cjs', 'parser');
+const { parseEvent } = require(path.join(dist, 'eventParser'));
+const legacyParsers = [
+  ['statusParser', 'parseStatusEvent'],
+  ['errorParser', 'parseErrorEvent'],
+  ['monitorParser', 'parseMonitorEvent'],
+  ['rxTransmitParser', 'parseRxTransmitEvent'],
+  ['rxImmediateParser', 'parseRxImmediateEvent'],
+  ['rxBroadcastParser', 'parseRxBroadcastEvent'],
+  ['txResultParser', 'parseTxResultEvent'],
+].map(([module, func]) => require(path.join(dist, module))[func]);
+
+const capturePath =
+  process.argv[2] || path.join(__dirname, 'fixtures', 'monitor-capture.txt');
+const iterations = parseInt(process.argv[3] || '200', 10);
+const lines = fs
+  .readFileSync(capturePath, 'utf8')
+  .split(/\r?\n/)
+  .filter(line => line.length > 0);
+
+const run = (name, parseLine) => {
+  let parsed = 0;
+  // warm up
+  lines.forEach(line => parseLine(line));
+
+  const start = process.hrtime.bigint();
+  for (let i = 0; i < iterations; i++) {
+    for (const line of lines) {
+      if (parseLine(line)) {
+        parsed++;
+      }
+    }
+  }
+  const elapsedNs = Number(process.hrtime.bigint() - start);
+  const events = lines.length * iterations;
+  const nsPerEvent = (elapsedNs / events).toFixed(0);
+  const eventsPerSec = Math.round((events * 1e9) / elapsedNs);
+
+  console.log(
+    `${name.padEnd(32)} ${nsPerEvent.padStart(6)} ns/event ${eventsPerSec
+      .toString()
+      .padStart(9)} events/s (${parsed} decoded)`,
+  );
+};
+
+console.log(
+  `${lines.length} lines from ${capturePath}, ${iterations} iterations\n`,
+);
+
+run('legacy (all parsers)', line => {
+  let result;
+  legacyParsers.forEach(parser => {
+    const event = parser(line);
+    if (event) {
+      result = event;
+    }
+  });
+  return result;
+});
+run('dispatch table', line => parseEvent(line));
+const monitorWanted = new Set(['MONITOR']);
+const statusWanted = new Set(['STATUS']);
+run('dispatch table, MONITOR wanted', line =>
+  parseEvent(line, monitorWanted),
+);
+run('dispatch table, STATUS wanted', line =>
+  parseEvent(line, statusWanted),
+);
@@ -0,0 +1,162 @@
+/*
+ * Regression benchmark built from real traffic: runs the firmware emulator (board/host)
+ * replaying a capture of MONITOR events onto its simulated line, with Piconet in LISTEN mode as
+ * one of the captured stations, then prints how many frames Piconet delivered, dropped or
+ * failed to acknowledge and the firmware's bus transactions per frame.
+ *
+ * Usage: npm run bench:replay [-- capture.txt [station [speed [path/to/piconet-emu]]]]
+ *
+ * The speed is how many times faster than captured to replay, or 0 for back to back (the
+ * default, and the only choice for captures without timestamps).
+ */
+const { spawn } = require('child_process');
+const os = require('os');
+const path = require('path');
+
+const dist = path.join(__dirname, '..', 'dist', 'cjs');
+const { driver, RxTransmitEvent, RxBroadcastEvent } = require(dist);
+
+const capturePath =
+  process.argv[2] || path.join(__dirname, 'fixtures', 'monitor-capture.txt');
+const station = parseInt(process.argv[3] || '33', 10);
+const speed = parseInt(process.argv[4] || '0', 10);
+const emulatorPath =
+  process.argv[5] ||
+  path.resolve(__dirname, '../../../board/host/build/piconet-emu');
+const devicePath = path.join(os.tmpdir(), `piconet-replay-${process.pid}`);
+
+// a responder must be given, or the emulator adds one at 254 which would answer the capture's
+// own frames; this one isn't in the fixture
+const responderStation = 200;
+const pollMs = 500;
+const timeoutMs = 600000;
+
+const sleepMs = ms => new Promise(resolve => setTimeout(resolve, ms));
+
+const startEmulator = async () => {
+  const emulator = spawn(
+    emulatorPath,
+    [
+      '--link',
+      devicePath,
+      '--responder',
+      `${responderStation}`,
+      '--replay',
+      capturePath,
+      '--replay-station',
+      `${station}`,
+      '--replay-speed',
+      `${speed}`,
+    ],
+    { stdio: ['ignore', 'ignore', 'pipe'] },
+  );
+  const statsWaiters = [];
+  let stderr = '';
+
+  await new Promise((resolve, reject) => {
+    emulator.once('error', reject);
+    emulator.once('exit', code =>
+      reject(new Error(`Emulator exited with code ${code}: ${stderr}`)),
+    );
+    emulator.stderr.on('data', chunk => {
+      stderr += chunk.toString();
+      let newline = stderr.indexOf('\n');
+      while (newline !== -1) {
+        const line = stderr.substring(0, newline);
+        stderr = stderr.substring(newline + 1);
+        if (line.startsWith('{')) {
+          const waiter = statsWaiters.shift();
+          if (waiter) {
+            waiter(JSON.parse(line));
+          }
+        } else if (line.startsWith('Piconet emulator listening')) {
+          resolve();
+        }
+        newline = stderr.indexOf('\n');
+      }
+    });
+  });
+  emulator.removeAllListeners('exit');
+
+  return {
+    stats: () =>
+      new Promise(resolve => {
+        statsWaiters.push(resolve);
+        emulator.kill('SIGUSR1');
+      }),
+    stop: () =>
+      new Promise(resolve => {
+        emulator.once('exit', resolve);
+        emulator.kill('SIGTERM');
+      }),
+  };
+};
+
+const main = async () => {
+  console.log(
+    `capture: ${capturePath}, station ${station}, ` +
+      `${speed === 0 ? 'back to back' : `${speed}x`}\n`,
+  );
+  const emulator = await startEmulator();
+  try {
+    await driver.connect(devicePath);
+    await driver.setEconetStation(station);
+    await driver.setMode('LISTEN');
+
+    let transmits = 0;
+    let broadcasts = 0;
+    driver.addListener(event => {
+      if (event instanceof RxTransmitEvent) {
+        transmits++;
+      } else if (event instanceof RxBroadcastEvent) {
+        broadcasts++;
+      }
+    });
+
+    let stats = await emulator.stats();
+    const deadline = Date.now() + timeoutMs;
+    while (!stats.replay.complete && Date.now() < deadline) {
+      await sleepMs(pollMs);
+      stats = await emulator.stats();
+    }
+    // let the last events through
+    await sleepMs(pollMs);
+
+    const r = stats.replay;
+    if (!r.complete) {
+      console.log('replay did not complete in time; results are partial\n');
+    }
+    console.log(
+      `frames: ${r.frames} captured, ${r.replayed} replayed, ${r.skipped} skipped`,
+    );
+    console.log(
+      `delivered: ${transmits}/${r.data_frames} transmissions, ` +
+        `${broadcasts}/${r.broadcasts} broadcasts`,
+    );
+    console.log(
+      `not acked: ${r.scouts - r.scouts_acked}/${r.scouts} scouts ` +
+        `(${r.data_not_sent} data frames not sent), ` +
+        `${r.data_frames - r.data_acked}/${r.data_frames} data frames`,
+    );
+    console.log(
+      `dropped: ${stats.adlc.frames_missed} missed, ` +
+        `${stats.adlc.rx_overruns} rx overruns`,
+    );
+    console.log(
+      `turnaround: mean ${r.mean_turnaround_us} us, max ${r.max_turnaround_us} us`,
+    );
+    console.log(
+      `firmware: ${r.transactions_per_frame} bus transactions ` +
+        `(${r.bus_us_per_frame} us of bus time) per replayed frame, ` +
+        `${(r.elapsed_us / 1000).toFixed(0)} ms elapsed`,
+    );
+  } finally {
+    await driver.close();
+    await emulator.stop();
+  }
+};
+
+main().catch(e => {
+  console.error(e);
+  process.exit(1);
+});
@@ -0,0 +1,205 @@
+/*
+ * Compares the board's USB transports: its serial ports (control and data) against its vendor
+ * bulk interface. For each, measures the round trip time of a small command (FLOW) with the
+ * board idle and during a MONITOR flood, then the MONITOR frames and bytes per second delivered
+ * to the driver at increasing frame rates, and how well the board filled USB packets.
+ *
+ * Runs against the firmware emulator (board/host) by default, whose bulk interface is a
+ * pseudo-terminal, or a real board with --board, for which the bulk transport needs the `usb`
+ * package; the MONITOR figures then depend on the traffic on its network.
+ *
+ * Usage: npm run bench:transport [-- path/to/piconet-emu | --board]
+ */
+const { spawn } = require('child_process');
+const os = require('os');
+const path = require('path');
+
+const dist = path.join(__dirname, '..', 'dist', 'cjs');
+const { driver, MonitorEvent } = require(dist);
+
+const useBoard = process.argv.includes('--board');
+const emulatorPath =
+  (!useBoard && process.argv[2]) ||
+  path.resolve(__dirname, '../../../board/host/build/piconet-emu');
+const devicePath = path.join(os.tmpdir(), `piconet-transport-${process.pid}`);
+const dataDevicePath = `${devicePath}-data`;
+const bulkDevicePath = `${devicePath}-bulk`;
+
+const transports = ['serial', 'bulk'];
+const commandCount = 500;
+const floodRate = 8000;
+const monitorRates = [2000, 8000, 32000];
+const monitorBitrate = 5000000;
+const monitorSize = 512;
+const monitorWarmupMs = 500;
+const monitorDurationMs = 3000;
+const usbFlushUs = 1000;
+
+const sleepMs = ms => new Promise(resolve => setTimeout(resolve, ms));
+
+const percentile = (sorted, p) =>
+  sorted[Math.min(sorted.length - 1, Math.floor((sorted.length * p) / 100))];
+
+const startEmulator = async monitorRate => {
+  const emulator = spawn(
+    emulatorPath,
+    [
+      '--link',
+      devicePath,
+      '--data-link',
+      dataDevicePath,
+      '--bulk-link',
+      bulkDevicePath,
+      '--bitrate',
+      `${monitorBitrate}`,
+      '--monitor-rate',
+      `${monitorRate}`,
+      '--monitor-size',
+      `${monitorSize}`,
+    ],
+    { stdio: ['ignore', 'ignore', 'pipe'] },
+  );
+  let stderr = '';
+
+  await new Promise((resolve, reject) => {
+    emulator.once('error', reject);
+    emulator.once('exit', code =>
+      reject(new Error(`Emulator exited with code ${code}: ${stderr}`)),
+    );
+    emulator.stderr.on('data', chunk => {
+      stderr += chunk.toString();
+      if (stderr.includes('Piconet emulator listening')) {
+        resolve();
+      }
+    });
+  });
+  emulator.removeAllListeners('exit');
+
+  return {
+    stop: () =>
+      new Promise(resolve => {
+        emulator.once('exit', resolve);
+        emulator.kill('SIGTERM');
+      }),
+  };
+};
+
+const connect = async transport => {
+  if (useBoard) {
+    await driver.connect(undefined, undefined, { transport });
+  } else if (transport === 'bulk') {
+    await driver.connect(bulkDevicePath, undefined, { transport });
+  } else {
+    await driver.connect(devicePath, dataDevicePath);
+  }
+};
+
+// runs `bench` connected over `transport`, with the emulator offering `monitorRate` frames/s
+const withConnection = async (transport, monitorRate, bench) => {
+  const emulator = useBoard ? undefined : await startEmulator(monitorRate);
+  try {
+    await connect(transport);
+    try {
+      return await bench();
+    } finally {
+      await driver.setMode('STOP');
+      await driver.close();
+    }
+  } finally {
+    await emulator?.stop();
+  }
+};
+
+const commandRtts = async () => {
+  const rttsMs = [];
+  for (let i = 0; i < commandCount; i++) {
+    const start = process.hrtime.bigint();
+    await driver.readFlowStatus();
+    rttsMs.push(Number(process.hrtime.bigint() - start) / 1e6);
+  }
+  rttsMs.sort((a, b) => a - b);
+  const p50 = percentile(rttsMs, 50).toFixed(2);
+  const p99 = percentile(rttsMs, 99).toFixed(2);
+  const max = rttsMs[rttsMs.length - 1].toFixed(2);
+  return `p50 ${p50}ms p99 ${p99}ms max ${max}ms`;
+};
+
+const benchCommand = async transport => {
+  const idle = await withConnection(transport, 0, commandRtts);
+  console.log(`${transport.padEnd(6)} FLOW idle: ${idle}`);
+
+  if (!useBoard) {
+    const flooded = await withConnection(transport, floodRate, async () => {
+      await driver.setMode('MONITOR');
+      await sleepMs(monitorWarmupMs);
+      return commandRtts();
+    });
+    console.log(
+      `${transport.padEnd(6)} FLOW during monitor at ${floodRate} frames/s: ${flooded}`,
+    );
+  }
+};
+
+const benchMonitor = async (transport, rate) => {
+  const { events, bytes, cpu, usb } = await withConnection(
+    transport,
+    rate,
+    async () => {
+      let eventCount = 0;
+      let byteCount = 0;
+      const listener = event => {
+        eventCount++;
+        byteCount += event.econetFrame.length;
+      };
+      driver.addListener(listener, [MonitorEvent]);
+      await driver.setUsbFlushDeadline(usbFlushUs);
+      await driver.setMode('MONITOR');
+      await sleepMs(monitorWarmupMs);
+
+      eventCount = 0;
+      byteCount = 0;
+      const cpuBefore = process.cpuUsage();
+      await sleepMs(monitorDurationMs);
+      const cpuUsed = process.cpuUsage(cpuBefore);
+      driver.removeListener(listener);
+      return {
+        events: eventCount,
+        bytes: byteCount,
+        cpu: cpuUsed,
+        usb: await driver.readUsbStatus(),
+      };
+    },
+  );
+
+  const eventsPerS = ((events * 1000) / monitorDurationMs).toFixed(0);
+  const bytesPerS = ((bytes * 1000) / monitorDurationMs).toFixed(0);
+  const cpuUsPerEvent =
+    events > 0 ? ((cpu.user + cpu.system) / events).toFixed(1) : '-';
+  const offered = useBoard ? 'network' : `${rate} frames/s offered`;
+  console.log(
+    `${transport.padEnd(6)} monitor (${offered}): ` +
+      `${eventsPerS} events/s, ${bytesPerS} frame bytes/s, ` +
+      `${cpuUsPerEvent}us driver CPU/event, ` +
+      `USB packets ${(usb.fillRatio * 100).toFixed(0)}% full`,
+  );
+};
+
+const main = async () => {
+  console.log(useBoard ? 'board\n' : `emulator: ${emulatorPath}\n`);
+
+  for (const transport of transports) {
+    await benchCommand(transport);
+  }
+  console.log();
+
+  for (const rate of useBoard ? [0] : monitorRates) {
+    for (const transport of transports) {
+      await benchMonitor(transport, rate);
+    }
+  }
+};
+
+main().catch(e => {
+  console.error(e);
+  process.exit(1);
+});
@@ -1,4 +1,5 @@
 export default {
   maxTxDataLength: 3500 - 4, // 4 bytes in header (src station/net, dst station/net)
   maxScoutExtraDataLength: 32 - 6, // 6 bytes in header (src station/net, dst station/net, control byte, port)
+  eventQueueCapacity: 1000, // default maximum number of events held by an EventQueue
 };
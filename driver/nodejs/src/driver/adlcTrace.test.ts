@@ -0,0 +1,84 @@
+import {
+  AdlcTraceOp,
+  AdlcTracePhase,
+  decodeAdlcTrace,
+  formatAdlcTimeline,
+  summariseAdlcTrace,
+} from './adlcTrace';
+
+const entry = (
+  timeUs: number,
+  op: AdlcTraceOp,
+  register: number,
+  value: number,
+  wait = 0,
+) => {
+  const buffer = Buffer.alloc(8);
+  buffer.writeUInt32LE(timeUs, 0);
+  buffer[4] = (op << 2) | register;
+  buffer[5] = value;
+  buffer.writeUInt16LE(wait, 6);
+  return buffer;
+};
+
+// a transmission's scout phase followed by its wait for the scout ack
+const trace = Buffer.concat([
+  entry(90, AdlcTraceOp.Read, 0, 0x40),
+  entry(100, AdlcTraceOp.Phase, 0, AdlcTracePhase.TxScout),
+  entry(102, AdlcTraceOp.Write, 0, 0x44, 3),
+  entry(105, AdlcTraceOp.Write, 2, 0xfe, 1),
+  entry(140, AdlcTraceOp.Phase, 0, AdlcTracePhase.TxScoutAck),
+  entry(141, AdlcTraceOp.Snoop, 1, 0x01),
+  entry(180, AdlcTraceOp.Read, 1, 0x01, 7),
+  entry(200, AdlcTraceOp.Phase, 0, AdlcTracePhase.Idle),
+  entry(0xfffffff0, AdlcTraceOp.Phase, 0, AdlcTracePhase.TxScout),
+  entry(0x10, AdlcTraceOp.Phase, 0, AdlcTracePhase.Idle),
+]);
+
+describe('ADLC trace', () => {
+  it('should decode trace entries', () => {
+    const entries = decodeAdlcTrace(trace);
+
+    expect(entries.length).toEqual(10);
+    expect(entries[2]).toEqual({
+      timeUs: 102,
+      op: AdlcTraceOp.Write,
+      register: 0,
+      value: 0x44,
+      wait: 3,
+    });
+    expect(() => decodeAdlcTrace(Buffer.alloc(7))).toThrow(
+      'Invalid ADLC trace length 7',
+    );
+  });
+
+  it('should summarise bus transactions and time by phase', () => {
+    const summaries = summariseAdlcTrace(decodeAdlcTrace(trace));
+
+    expect(summaries.map(s => s.name)).toEqual(['TX_SCOUT', 'TX_SCOUT_ACK']);
+    expect(summaries[0]).toMatchObject({
+      occurrences: 2,
+      reads: 0,
+      writes: 2,
+      waitPolls: 4,
+      totalUs: 40 + 0x20,
+      maxUs: 40,
+    });
+    expect(summaries[1]).toMatchObject({
+      occurrences: 1,
+      reads: 1,
+      snoops: 1,
+      waitPolls: 7,
+      totalUs: 60,
+    });
+  });
+
+  it('should format a timeline', () => {
+    const lines = formatAdlcTimeline(decodeAdlcTrace(trace));
+
+    expect(lines[1]).toEqual('    +10us TX_SCOUT');
+    expect(lines[2]).toEqual('     +2us   write CR1 0x44 wait 3');
+    expect(lines[5]).toEqual('     +1us   snoop SR2 until 0x01');
+    expect(lines[6]).toEqual('    +39us   read  SR2 0x01 wait 7');
+  });
+});
@@ -0,0 +1,202 @@
+/**
+ * Kinds of entry in an ADLC bus transaction trace.
+ */
+export enum AdlcTraceOp {
+  Read = 0,
+  Write = 1,
+  /** The board started snooping a status register; `value` is the bit it latches. */
+  Snoop = 2,
+  /** A stage of protocol handling started; `value` is an {@link AdlcTracePhase}. */
+  Phase = 3,
+}
+
+/**
+ * Stages of Econet protocol handling marked in the trace. Bus transactions made whilst idle
+ * (i.e. polling for the start of a frame) aren't recorded.
+ */
+export enum AdlcTracePhase {
+  Idle = 0,
+  TxScout,
+  TxScoutAck,
+  TxData,
+  TxDataAck,
+  TxBroadcast,
+  RxScout,
+  RxScoutAck,
+  RxData,
+  RxDataAck,
+  Monitor,
+}
+
+const phaseNames = [
+  'IDLE',
+  'TX_SCOUT',
+  'TX_SCOUT_ACK',
+  'TX_DATA',
+  'TX_DATA_ACK',
+  'TX_BROADCAST',
+  'RX_SCOUT',
+  'RX_SCOUT_ACK',
+  'RX_DATA',
+  'RX_DATA_ACK',
+  'MONITOR',
+];
+
+const readRegisterNames = ['SR1', 'SR2', 'RXFIFO', 'RXFIFO'];
+const writeRegisterNames = ['CR1', 'CR2/CR3', 'TXFIFO', 'TXLAST/CR4'];
+
+export type AdlcTraceEntry = {
+  /** Board time in microseconds (wrapping at 2^32). */
+  timeUs: number;
+  op: AdlcTraceOp;
+  /** ADLC register address (0-3) for reads, writes and snoops. */
+  register: number;
+  value: number;
+  /** Polls made by the firmware before the PIO state machine completed the bus cycle. */
+  wait: number;
+};
+
+export type AdlcTracePhaseSummary = {
+  phase: AdlcTracePhase;
+  name: string;
+  /** Number of times the phase was entered. */
+  occurrences: number;
+  reads: number;
+  writes: number;
+  snoops: number;
+  /** Total polls spent waiting for the PIO. */
+  waitPolls: number;
+  /** Total time spent in the phase. */
+  totalUs: number;
+  maxUs: number;
+};
+
+export const adlcTraceEntrySize = 8;
+
+/**
+ * Decodes the raw trace reported by the board (little-endian 8-byte records, oldest first).
+ */
+export const decodeAdlcTrace = (data: Buffer): Array<AdlcTraceEntry> => {
+  if (data.length % adlcTraceEntrySize !== 0) {
+    throw new Error(`Invalid ADLC trace length ${data.length}`);
+  }
+
+  const entries = new Array<AdlcTraceEntry>();
+  for (let offset = 0; offset < data.length; offset += adlcTraceEntrySize) {
+    const opReg = data[offset + 4];
+    entries.push({
+      timeUs: data.readUInt32LE(offset),
+      op: opReg >> 2,
+      register: opReg & 0x03,
+      value: data[offset + 5],
+      wait: data.readUInt16LE(offset + 6),
+    });
+  }
+  return entries;
+};
+
+export const adlcTracePhaseName = (phase: AdlcTracePhase): string =>
+  phaseNames[phase] ?? `PHASE_${phase}`;
+
+const elapsedUs = (from: number, to: number) => (to - from) >>> 0;
+
+/**
+ * Totals the bus transactions and time spent in each protocol phase. Entries preceding the first
+ * phase marker (e.g. because the ring has wrapped) are ignored, as is the idle phase. The last
+ * phase is taken to end with the last entry.
+ */
+export const summariseAdlcTrace = (
+  entries: Array<AdlcTraceEntry>,
+): Array<AdlcTracePhaseSummary> => {
+  const summaries = new Map<AdlcTracePhase, AdlcTracePhaseSummary>();
+  let current: AdlcTracePhaseSummary | undefined;
+  let phaseStartUs = 0;
+
+  const endPhase = (timeUs: number) => {
+    if (current) {
+      const durationUs = elapsedUs(phaseStartUs, timeUs);
+      current.totalUs += durationUs;
+      current.maxUs = Math.max(current.maxUs, durationUs);
+    }
+  };
+
+  entries.forEach(entry => {
+    if (entry.op === AdlcTraceOp.Phase) {
+      endPhase(entry.timeUs);
+      phaseStartUs = entry.timeUs;
+      if (entry.value === AdlcTracePhase.Idle) {
+        current = undefined;
+        return;
+      }
+
+      current = summaries.get(entry.value);
+      if (!current) {
+        current = {
+          phase: entry.value,
+          name: adlcTracePhaseName(entry.value),
+          occurrences: 0,
+          reads: 0,
+          writes: 0,
+          snoops: 0,
+          waitPolls: 0,
+          totalUs: 0,
+          maxUs: 0,
+        };
+        summaries.set(entry.value, current);
+      }
+      current.occurrences++;
+      return;
+    }
+
+    if (!current) {
+      return;
+    }
+    if (entry.op === AdlcTraceOp.Read) {
+      current.reads++;
+    } else if (entry.op === AdlcTraceOp.Write) {
+      current.writes++;
+    } else {
+      current.snoops++;
+    }
+    current.waitPolls += entry.wait;
+  });
+
+  if (entries.length > 0) {
+    endPhase(entries[entries.length - 1].timeUs);
+  }
+
+  return [...summaries.values()].sort((a, b) => a.phase - b.phase);
+};
+
+const hex = (value: number) => `0x${value.toString(16).padStart(2, '0')}`;
+
+/**
+ * Describes each entry on a line, with the time elapsed since the previous entry.
+ */
+export const formatAdlcTimeline = (
+  entries: Array<AdlcTraceEntry>,
+): Array<string> => {
+  let previousUs = entries.length > 0 ? entries[0].timeUs : 0;
+  return entries.map(entry => {
+    const delta = `+${elapsedUs(previousUs, entry.timeUs)}us`.padStart(9);
+    previousUs = entry.timeUs;
+
+    switch (entry.op) {
+      case AdlcTraceOp.Phase:
+        return `${delta} ${adlcTracePhaseName(entry.value)}`;
+      case AdlcTraceOp.Snoop: {
+        const register = readRegisterNames[entry.register];
+        return `${delta}   snoop ${register} until ${hex(entry.value)}`;
+      }
+      default: {
+        const read = entry.op === AdlcTraceOp.Read;
+        const op = read ? 'read ' : 'write';
+        const register = read
+          ? readRegisterNames[entry.register]
+          : writeRegisterNames[entry.register];
+        const wait = entry.wait > 0 ? ` wait ${entry.wait}` : '';
+        return `${delta}   ${op} ${register} ${hex(entry.value)}${wait}`;
+      }
+    }
+  });
+};
@@ -0,0 +1,305 @@
+import * as dgram from 'dgram';
+import { EconetEvent } from '../types/econetEvent';
+import { RxTransmitEvent } from '../types/rxTransmitEvent';
+import { TxResultEvent } from '../types/txResultEvent';
+import {
+  AunGateway,
+  AunGatewayOptions,
+  AunPacket,
+  AunPacketType,
+  decodeAunPacket,
+  encodeAunPacket,
+} from './aunGateway';
+
+type Transmission = {
+  station: number;
+  controlByte: number;
+  port: number;
+  data: Buffer;
+  complete: (result: TxResultEvent) => void;
+};
+
+// stands in for the driver and firmware, completing transmissions when told to
+const createBoard = () => {
+  const listeners = new Array<(event: EconetEvent) => void>();
+  const transmissions = new Array<Transmission>();
+  return {
+    transmissions,
+    transmit: jest.fn(
+      (
+        station: number,
+        network: number,
+        controlByte: number,
+        port: number,
+        data: Buffer,
+      ) =>
+        new Promise<TxResultEvent>(resolve => {
+          transmissions.push({
+            station,
+            controlByte,
+            port,
+            data,
+            complete: resolve,
+          });
+        }),
+    ),
+    addListener: (listener: (event: EconetEvent) => void) => {
+      listeners.push(listener);
+    },
+    removeListener: (listener: (event: EconetEvent) => void) => {
+      listeners.splice(listeners.indexOf(listener), 1);
+    },
+    receive: (event: EconetEvent) => {
+      listeners.forEach(listener => listener(event));
+    },
+  };
+};
+
+// an AUN host on the loopback interface
+const createHost = async () => {
+  const socket = dgram.createSocket('udp4');
+  const received = new Array<AunPacket>();
+  const waiters = new Array<() => void>();
+  socket.on('message', message => {
+    received.push(decodeAunPacket(message) as AunPacket);
+    waiters.splice(0).forEach(wake => wake());
+  });
+  await new Promise<void>(resolve => socket.bind(0, '127.0.0.1', resolve));
+
+  return {
+    socket,
+    received,
+    port: socket.address().port,
+    send: (packet: AunPacket, port: number) =>
+      new Promise<void>(resolve => {
+        socket.send(encodeAunPacket(packet), port, '127.0.0.1', () =>
+          resolve(),
+        );
+      }),
+    waitFor: async (count: number) => {
+      while (received.length < count) {
+        await new Promise<void>(resolve => waiters.push(resolve));
+      }
+    },
+    close: () => new Promise<void>(resolve => socket.close(resolve)),
+  };
+};
+
+const unicast = (sequence: number, data = 'hello'): AunPacket => ({
+  type: AunPacketType.Unicast,
+  port: 0x99,
+  controlByte: 0x00,
+  sequence,
+  data: Buffer.from(data),
+});
+
+const flush = () => new Promise(resolve => setTimeout(resolve, 20));
+
+const rxTransmitEvent = (fromStation: number, data: string) =>
+  new RxTransmitEvent(
+    Buffer.from([2, 0, fromStation, 0, 0x80, 0x99]),
+    Buffer.from([2, 0, fromStation, 0, ...Buffer.from(data)]),
+  );
+
+describe('AUN packets', () => {
+  it('should encode and decode AUN packets', () => {
+    const packet = { ...unicast(0x12345678), controlByte: 0x81 };
+    const buffer = encodeAunPacket(packet);
+
+    expect([...buffer.subarray(0, 8)]).toEqual([
+      2, 0x99, 0x01, 0, 0x78, 0x56, 0x34, 0x12,
+    ]);
+    expect(decodeAunPacket(buffer)).toEqual({ ...packet, controlByte: 0x01 });
+    expect(decodeAunPacket(Buffer.from([2, 0x99, 0]))).toBeUndefined();
+    expect(decodeAunPacket(Buffer.alloc(8, 9))).toBeUndefined();
+  });
+});
+
+describe('AUN gateway', () => {
+  let board: ReturnType<typeof createBoard>;
+  let host: Awaited<ReturnType<typeof createHost>>;
+  let gateway: AunGateway;
+  let stationPort: number;
+
+  const startGateway = async (options?: Partial<AunGatewayOptions>) => {
+    gateway = new AunGateway(board, {
+      stations: [{ station: 254, port: 0, address: '127.0.0.1' }],
+      ...options,
+    });
+    await gateway.start();
+    stationPort = gateway.addressOf(254).port;
+  };
+
+  beforeEach(async () => {
+    board = createBoard();
+    host = await createHost();
+  });
+
+  afterEach(async () => {
+    await gateway.stop();
+    await host.close();
+  });
+
+  it('should transmit AUN packet to Econet and acknowledge it once sent', async () => {
+    await startGateway();
+
+    await host.send(unicast(4), stationPort);
+    await flush();
+
+    expect(board.transmit).toHaveBeenCalledWith(
+      254,
+      0,
+      0x80,
+      0x99,
+      Buffer.from('hello'),
+    );
+    expect(host.received.length).toEqual(0);
+
+    board.transmissions[0].complete(new TxResultEvent(true, 'OK'));
+    await host.waitFor(1);
+
+    expect(host.received[0].type).toEqual(AunPacketType.Ack);
+    expect(host.received[0].sequence).toEqual(4);
+    expect(gateway.metrics.econetTransmits).toEqual(1);
+    expect(gateway.metrics.bytesToEconet).toEqual(5);
+  });
+
+  it('should reject AUN packet when Econet transmission fails', async () => {
+    await startGateway();
+
+    await host.send(unicast(8), stationPort);
+    await flush();
+    board.transmissions[0].complete(new TxResultEvent(false, 'NO_SCOUT_ACK'));
+    await host.waitFor(1);
+
+    expect(host.received[0].type).toEqual(AunPacketType.Reject);
+    expect(host.received[0].sequence).toEqual(8);
+    expect(gateway.metrics.econetTransmitFailures).toEqual(1);
+  });
+
+  it('should not transmit a retransmitted AUN packet twice', async () => {
+    await startGateway();
+
+    await host.send(unicast(4), stationPort);
+    await host.send(unicast(4), stationPort);
+    await flush();
+    expect(board.transmit).toHaveBeenCalledTimes(1);
+
+    board.transmissions[0].complete(new TxResultEvent(true, 'OK'));
+    await host.waitFor(1);
+
+    // the ack was lost, so the host tries again
+    await host.send(unicast(4), stationPort);
+    await host.waitFor(2);
+
+    expect(board.transmit).toHaveBeenCalledTimes(1);
+    expect(host.received[1].type).toEqual(AunPacketType.Ack);
+    expect(gateway.metrics.duplicatePackets).toEqual(2);
+  });
+
+  it('should limit transmissions in flight to each station', async () => {
+    await startGateway({ window: 3 });
+
+    for (let i = 1; i <= 8; i++) {
+      await host.send(unicast(i * 4, `packet ${i}`), stationPort);
+    }
+    await flush();
+
+    expect(board.transmissions.length).toEqual(3);
+    expect(gateway.metrics.inFlight).toEqual(3);
+    expect(gateway.metrics.queued).toEqual(5);
+
+    for (let i = 0; i < 8; i++) {
+      board.transmissions[i].complete(new TxResultEvent(true, 'OK'));
+      await flush();
+    }
+    await host.waitFor(8);
+
+    expect(board.transmissions.map(t => t.data.toString())).toEqual(
+      [1, 2, 3, 4, 5, 6, 7, 8].map(i => `packet ${i}`),
+    );
+    expect(host.received.map(p => p.sequence)).toEqual(
+      [1, 2, 3, 4, 5, 6, 7, 8].map(i => i * 4),
+    );
+    expect(gateway.metrics.inFlight).toEqual(0);
+  });
+
+  it('should cut back to one transmission at a time to a station which stops responding', async () => {
+    await startGateway({ window: 3 });
+
+    for (let i = 1; i <= 6; i++) {
+      await host.send(unicast(i * 4, `packet ${i}`), stationPort);
+    }
+    await flush();
+    expect(board.transmissions.length).toEqual(3);
+
+    // the first failure leaves the other two queued at the board but sends no more
+    board.transmissions[0].complete(new TxResultEvent(false, 'NO_SCOUT_ACK'));
+    await flush();
+    expect(board.transmissions.length).toEqual(3);
+    expect(gateway.metrics.inFlight).toEqual(2);
+
+    board.transmissions[1].complete(new TxResultEvent(false, 'NO_SCOUT_ACK'));
+    board.transmissions[2].complete(new TxResultEvent(false, 'NO_SCOUT_ACK'));
+    await flush();
+    expect(board.transmissions.length).toEqual(4);
+    expect(gateway.metrics.inFlight).toEqual(1);
+
+    // the station answers again, so the window opens back up
+    board.transmissions[3].complete(new TxResultEvent(true, 'OK'));
+    await flush();
+    expect(board.transmissions.length).toEqual(6);
+    expect(gateway.metrics.inFlight).toEqual(2);
+  });
+
+  it('should forward Econet packet to default route and retry until acknowledged', async () => {
+    await startGateway({
+      defaultRoute: { host: '127.0.0.1', port: host.port },
+      retryIntervalMs: 30,
+    });
+
+    board.receive(rxTransmitEvent(254, 'reply'));
+    await host.waitFor(2);
+
+    const [first, second] = host.received;
+    expect(first.type).toEqual(AunPacketType.Unicast);
+    expect(first.port).toEqual(0x99);
+    expect(first.data.toString()).toEqual('reply');
+    expect(second.sequence).toEqual(first.sequence);
+
+    const ack = { ...first, type: AunPacketType.Ack, data: Buffer.alloc(0) };
+    await host.send(ack, stationPort);
+    await flush();
+    const count = host.received.length;
+    await new Promise(resolve => setTimeout(resolve, 100));
+
+    expect(host.received.length).toEqual(count);
+    expect(gateway.metrics.aunDeliveries).toEqual(1);
+    expect(gateway.metrics.aunRetries).toBeGreaterThan(0);
+  });
+
+  it('should return Econet packet to the AUN host which last sent to the station', async () => {
+    await startGateway();
+
+    await host.send(unicast(4), stationPort);
+    await flush();
+    board.transmissions[0].complete(new TxResultEvent(true, 'OK'));
+    board.receive(rxTransmitEvent(254, 'reply'));
+    await host.waitFor(2);
+
+    const forwarded = host.received.find(
+      p => p.type === AunPacketType.Unicast,
+    );
+    expect(forwarded?.data.toString()).toEqual('reply');
+  });
+
+  it('should count Econet packets which cannot be routed', async () => {
+    await startGateway({
+      defaultRoute: { host: '127.0.0.1', port: host.port },
+    });
+
+    board.receive(rxTransmitEvent(253, 'from unknown station'));
+
+    expect(gateway.metrics.unroutablePackets).toEqual(1);
+  });
+});
@@ -0,0 +1,743 @@
+import * as dgram from 'dgram';
+import { AddressInfo } from 'net';
+import { EconetEvent } from '../types/econetEvent';
+import { RxBroadcastEvent } from '../types/rxBroadcastEvent';
+import { RxTransmitEvent } from '../types/rxTransmitEvent';
+import { TxResultEvent } from '../types/txResultEvent';
+
+/**
+ * Types of AUN (Acorn Universal Networking, i.e. Econet over UDP) packet.
+ */
+export enum AunPacketType {
+  Broadcast = 1,
+  Unicast = 2,
+  Ack = 3,
+  Reject = 4,
+  Immediate = 5,
+  ImmediateReply = 6,
+}
+
+/**
+ * A decoded AUN packet.
+ */
+export type AunPacket = {
+  type: AunPacketType;
+  port: number;
+
+  /**
+   * Econet control byte, which AUN carries without its top bit.
+   */
+  controlByte: number;
+  sequence: number;
+  data: Buffer;
+};
+
+/**
+ * Length of the header preceding the data of every AUN packet.
+ */
+export const aunHeaderLength = 8;
+
+/**
+ * Encodes an AUN packet ready for sending in a UDP datagram.
+ */
+export const encodeAunPacket = (packet: AunPacket): Buffer => {
+  const buffer = Buffer.alloc(aunHeaderLength + packet.data.length);
+  buffer[0] = packet.type;
+  buffer[1] = packet.port;
+  buffer[2] = packet.controlByte & 0x7f;
+  buffer.writeUInt32LE(packet.sequence >>> 0, 4);
+  packet.data.copy(buffer, aunHeaderLength);
+  return buffer;
+};
+
+/**
+ * Decodes a UDP datagram as an AUN packet.
+ *
+ * @returns The packet, or `undefined` if the datagram is too short or of an unknown type.
+ */
+export const decodeAunPacket = (buffer: Buffer): AunPacket | undefined => {
+  if (
+    buffer.length < aunHeaderLength ||
+    buffer[0] < AunPacketType.Broadcast ||
+    buffer[0] > AunPacketType.ImmediateReply
+  ) {
+    return undefined;
+  }
+
+  return {
+    type: buffer[0],
+    port: buffer[1],
+    controlByte: buffer[2] & 0x7f,
+    sequence: buffer.readUInt32LE(4),
+    data: buffer.subarray(aunHeaderLength),
+  };
+};
+
+/**
+ * An Econet station made reachable from AUN by an {@link AunGateway}.
+ */
+export type AunGatewayStation = {
+  /**
+   * Econet station number (integer in range 1-254, inclusive).
+   */
+  station: number;
+
+  /**
+   * Econet network number. Defaults to `0` (the local network).
+   */
+  network?: number;
+
+  /**
+   * UDP port at which AUN hosts address the station. AUN identifies stations by address, so
+   * each needs its own. Specify `0` to have one allocated (see {@link AunGateway.addressOf}).
+   */
+  port: number;
+
+  /**
+   * Local address to which the station's UDP socket is bound. Defaults to `0.0.0.0`.
+   */
+  address?: string;
+};
+
+/**
+ * The address of an AUN host.
+ */
+export type AunRoute = {
+  host: string;
+  port: number;
+};
+
+/**
+ * Options for {@link AunGateway}.
+ */
+export type AunGatewayOptions = {
+  /**
+   * Econet stations made reachable from AUN.
+   */
+  stations: Array<AunGatewayStation>;
+
+  /**
+   * AUN host to which packets received from Econet are forwarded when the sending station hasn't
+   * been contacted from AUN. Otherwise they go to the AUN host which most recently sent the
+   * station a packet, so that replies find their way back to the client which made the request.
+   */
+  defaultRoute?: AunRoute;
+
+  /**
+   * Maximum number of transmissions to each Econet station queued at the board at once. The board
+   * still carries them out one at a time, in the order they were queued, so this bounds how much
+   * work one station can have ahead of the others rather than isolating them. Defaults to `4`.
+   */
+  window?: number;
+
+  /**
+   * Maximum number of packets waiting for a transmission slot for each Econet station. Packets
+   * arriving beyond this are dropped unacknowledged so that the AUN host retries them later.
+   * Defaults to `64`.
+   */
+  maxQueued?: number;
+
+  /**
+   * Interval between retransmissions of unacknowledged packets sent to AUN hosts. Defaults to
+   * `200`.
+   */
+  retryIntervalMs?: number;
+
+  /**
+   * Number of times an unacknowledged packet is retransmitted to an AUN host before giving up.
+   * Defaults to `5`.
+   */
+  maxRetries?: number;
+};
+
+/**
+ * The means by which an {@link AunGateway} talks to the board, normally the driver itself (see
+ * {@link aunGateway}). `transmit` must cope with being called again before earlier calls have
+ * completed.
+ */
+export type AunGatewayBoard = {
+  transmit: (
+    station: number,
+    network: number,
+    controlByte: number,
+    port: number,
+    data: Buffer,
+  ) => Promise<TxResultEvent>;
+  addListener: (listener: (event: EconetEvent) => void) => void;
+  removeListener: (listener: (event: EconetEvent) => void) => void;
+};
+
+/**
+ * Counters describing the traffic passed by an {@link AunGateway}.
+ */
+export type AunGatewayMetrics = {
+  /**
+   * Milliseconds since the gateway was started.
+   */
+  uptimeMs: number;
+
+  /**
+   * Total number of AUN packets received, including acknowledgements.
+   */
+  aunPacketsReceived: number;
+
+  /**
+   * Number of AUN packets which were retransmissions of ones already received.
+   */
+  duplicatePackets: number;
+
+  /**
+   * Number of AUN packets ignored because they were malformed or of a type which isn't
+   * forwarded (broadcasts and immediate operations).
+   */
+  unsupportedPackets: number;
+
+  /**
+   * Number of AUN packets dropped because too many were queued for their Econet station.
+   */
+  droppedPackets: number;
+
+  /**
+   * Number of packets transmitted to Econet stations successfully.
+   */
+  econetTransmits: number;
+
+  /**
+   * Number of transmissions to Econet stations which failed, each answered with an AUN reject.
+   */
+  econetTransmitFailures: number;
+
+  /**
+   * Number of payload bytes transmitted to Econet stations successfully.
+   */
+  bytesToEconet: number;
+
+  /**
+   * Mean time in milliseconds from receipt of an AUN packet to completion of its transmission to
+   * Econet, including any time queued.
+   */
+  meanTransmitLatencyMs: number;
+
+  /**
+   * Greatest time in milliseconds from receipt of an AUN packet to completion of its
+   * transmission to Econet.
+   */
+  maxTransmitLatencyMs: number;
+
+  /**
+   * Number of transmissions to Econet currently queued at the board.
+   */
+  inFlight: number;
+
+  /**
+   * Number of AUN packets currently waiting for a transmission slot.
+   */
+  queued: number;
+
+  /**
+   * Number of packets received from Econet and acknowledged by their AUN host.
+   */
+  aunDeliveries: number;
+
+  /**
+   * Number of packets received from Econet which their AUN host rejected or never acknowledged.
+   */
+  aunDeliveryFailures: number;
+
+  /**
+   * Number of retransmissions of packets to AUN hosts.
+   */
+  aunRetries: number;
+
+  /**
+   * Number of payload bytes forwarded from Econet to AUN hosts.
+   */
+  bytesToAun: number;
+
+  /**
+   * Number of packets received from Econet which couldn't be forwarded because their source
+   * station isn't exposed by the gateway or there was no route to an AUN host.
+   */
+  unroutablePackets: number;
+};
+
+type InboundState = 'pending' | 'acked' | 'rejected';
+
+type InboundPacket = {
+  from: AunRoute;
+  packet: AunPacket;
+  receivedAt: number;
+};
+
+type OutboundPacket = {
+  datagram: Buffer;
+  to: AunRoute;
+  retries: number;
+  timer?: NodeJS.Timeout;
+};
+
+type StationEndpoint = {
+  config: AunGatewayStation;
+  network: number;
+  socket: dgram.Socket;
+  nextSequence: number;
+
+  // most recent sequence numbers received from each AUN host, for spotting retransmissions
+  inbound: Map<string, Map<number, InboundState>>;
+  outbound: Map<string, OutboundPacket>;
+  queue: Array<InboundPacket>;
+  inFlight: number;
+
+  // set when a transmission finds nobody listening; the window shrinks to one until one succeeds
+  unresponsive: boolean;
+  returnRoute?: AunRoute;
+};
+
+const inboundHistoryLength = 64;
+
+const routeKey = (route: AunRoute) => `${route.host}:${route.port}`;
+
+/**
+ * Bridges AUN hosts (such as emulated or networked Acorn machines) and the physical Econet
+ * attached to the board.
+ *
+ * Each Econet station listed in the options is given a UDP socket. A unicast AUN packet arriving
+ * at that socket is transmitted to the station by the board and acknowledged to its sender once
+ * the Econet four-way handshake completes, or rejected if it fails. Transmissions are pipelined
+ * to the board, with up to `window` queued there per station. The board carries them out one at
+ * a time in order, so each one queued for a station which isn't answering delays everything
+ * behind it by a scout timeout. A station whose scout goes unacknowledged is therefore cut back
+ * to one transmission at a time until a transmission to it succeeds again. Packets which the board receives from Econet in `LISTEN` mode are
+ * sent on to AUN from the socket of their source station and retransmitted until acknowledged.
+ *
+ * Note that the board has a single Econet station number, which is therefore the source of
+ * everything the gateway transmits to Econet and the destination of everything it forwards to
+ * AUN.
+ */
+export class AunGateway {
+  private readonly window: number;
+
+  private readonly maxQueued: number;
+
+  private readonly retryIntervalMs: number;
+
+  private readonly maxRetries: number;
+
+  private endpoints = new Array<StationEndpoint>();
+
+  private startedAt = 0;
+
+  private running = false;
+
+  private counters = {
+    aunPacketsReceived: 0,
+    duplicatePackets: 0,
+    unsupportedPackets: 0,
+    droppedPackets: 0,
+    econetTransmits: 0,
+    econetTransmitFailures: 0,
+    bytesToEconet: 0,
+    totalTransmitLatencyMs: 0,
+    maxTransmitLatencyMs: 0,
+    aunDeliveries: 0,
+    aunDeliveryFailures: 0,
+    aunRetries: 0,
+    bytesToAun: 0,
+    unroutablePackets: 0,
+  };
+
+  private readonly listener = (event: EconetEvent) =>
+    this.handleEconetEvent(event);
+
+  constructor(
+    private readonly board: AunGatewayBoard,
+    private readonly options: AunGatewayOptions,
+  ) {
+    options.stations.forEach(station => {
+      if (station.station < 1 || station.station >= 255) {
+        throw new Error('Invalid station number');
+      }
+      if (
+        typeof station.network !== 'undefined' &&
+        (station.network < 0 || station.network > 255)
+      ) {
+        throw new Error('Invalid network number');
+      }
+    });
+
+    this.window = options.window ?? 4;
+    this.maxQueued = options.maxQueued ?? 64;
+    this.retryIntervalMs = options.retryIntervalMs ?? 200;
+    this.maxRetries = options.maxRetries ?? 5;
+  }
+
+  /**
+   * Binds the UDP socket of each station and starts forwarding packets.
+   */
+  public async start(): Promise<void> {
+    if (this.running) {
+      throw new Error('Gateway already started');
+    }
+
+    this.endpoints = this.options.stations.map(config => ({
+      config,
+      network: config.network ?? 0,
+      socket: dgram.createSocket('udp4'),
+      nextSequence: 4,
+      inbound: new Map(),
+      outbound: new Map(),
+      queue: [],
+      inFlight: 0,
+      unresponsive: false,
+    }));
+
+    try {
+      await Promise.all(
+        this.endpoints.map(
+          endpoint =>
+            new Promise<void>((resolve, reject) => {
+              endpoint.socket.once('error', reject);
+              endpoint.socket.bind(
+                endpoint.config.port,
+                endpoint.config.address ?? '0.0.0.0',
+                () => {
+                  endpoint.socket.off('error', reject);
+                  resolve();
+                },
+              );
+            }),
+        ),
+      );
+    } catch (e) {
+      this.endpoints.forEach(endpoint => endpoint.socket.close());
+      this.endpoints = [];
+      throw e;
+    }
+
+    this.endpoints.forEach(endpoint => {
+      endpoint.socket.on('message', (message, remote) =>
+        this.handleAunMessage(endpoint, message, {
+          host: remote.address,
+          port: remote.port,
+        }),
+      );
+      endpoint.socket.on('error', e => {
+        console.error(
+          `AUN socket for station ${endpoint.config.station} failed`,
+          e,
+        );
+      });
+    });
+
+    this.running = true;
+    this.startedAt = Date.now();
+    this.board.addListener(this.listener);
+  }
+
+  /**
+   * Stops forwarding packets and closes the UDP sockets. Transmissions already queued at the
+   * board complete, but their results are no longer passed on.
+   */
+  public async stop(): Promise<void> {
+    if (!this.running) {
+      return;
+    }
+
+    this.running = false;
+    this.board.removeListener(this.listener);
+    await Promise.all(
+      this.endpoints.map(endpoint => {
+        endpoint.outbound.forEach(outbound => clearTimeout(outbound.timer));
+        endpoint.outbound.clear();
+        endpoint.queue.splice(0);
+        return new Promise<void>(resolve => endpoint.socket.close(resolve));
+      }),
+    );
+  }
+
+  /**
+   * The local address of the UDP socket for an Econet station, useful when its port was
+   * allocated automatically.
+   */
+  public addressOf(station: number, network = 0): AddressInfo {
+    const endpoint = this.endpoints.find(
+      e => e.config.station === station && e.network === network,
+    );
+    if (!endpoint) {
+      throw new Error(`Station ${network}.${station} is not exposed`);
+    }
+    return endpoint.socket.address();
+  }
+
+  /**
+   * Current traffic counters for the gateway.
+   */
+  public get metrics(): AunGatewayMetrics {
+    const { totalTransmitLatencyMs, ...counters } = this.counters;
+    const completed =
+      this.counters.econetTransmits + this.counters.econetTransmitFailures;
+    return {
+      ...counters,
+      uptimeMs: this.running ? Date.now() - this.startedAt : 0,
+      meanTransmitLatencyMs:
+        completed > 0 ? totalTransmitLatencyMs / completed : 0,
+      inFlight: this.endpoints.reduce((n, e) => n + e.inFlight, 0),
+      queued: this.endpoints.reduce((n, e) => n + e.queue.length, 0),
+    };
+  }
+
+  private handleAunMessage(
+    endpoint: StationEndpoint,
+    message: Buffer,
+    from: AunRoute,
+  ) {
+    this.counters.aunPacketsReceived++;
+    const packet = decodeAunPacket(message);
+    if (!packet) {
+      this.counters.unsupportedPackets++;
+      return;
+    }
+
+    switch (packet.type) {
+      case AunPacketType.Unicast:
+        this.handleAunUnicast(endpoint, packet, from);
+        break;
+      case AunPacketType.Ack:
+      case AunPacketType.Reject:
+        this.handleAunResponse(endpoint, packet, from);
+        break;
+      default:
+        this.counters.unsupportedPackets++;
+        break;
+    }
+  }
+
+  private handleAunUnicast(
+    endpoint: StationEndpoint,
+    packet: AunPacket,
+    from: AunRoute,
+  ) {
+    const key = routeKey(from);
+    let history = endpoint.inbound.get(key);
+    if (!history) {
+      history = new Map();
+      endpoint.inbound.set(key, history);
+    }
+
+    // the sender didn't hear our response (or hasn't yet had one): answer again rather than
+    // transmitting the packet twice
+    const previous = history.get(packet.sequence);
+    if (previous) {
+      this.counters.duplicatePackets++;
+      if (previous !== 'pending') {
+        this.respond(
+          endpoint,
+          from,
+          packet,
+          previous === 'acked' ? AunPacketType.Ack : AunPacketType.Reject,
+        );
+      }
+      return;
+    }
+
+    if (endpoint.queue.length >= this.maxQueued) {
+      this.counters.droppedPackets++;
+      return;
+    }
+
+    history.set(packet.sequence, 'pending');
+    if (history.size > inboundHistoryLength) {
+      history.delete(history.keys().next().value);
+    }
+
+    endpoint.returnRoute = from;
+    endpoint.queue.push({ from, packet, receivedAt: Date.now() });
+    this.pump(endpoint);
+  }
+
+  private pump(endpoint: StationEndpoint) {
+    while (
+      this.running &&
+      endpoint.inFlight < (endpoint.unresponsive ? 1 : this.window) &&
+      endpoint.queue.length > 0
+    ) {
+      const inbound = endpoint.queue.shift() as InboundPacket;
+      endpoint.inFlight++;
+      this.board
+        .transmit(
+          endpoint.config.station,
+          endpoint.network,
+          inbound.packet.controlByte | 0x80,
+          inbound.packet.port,
+          inbound.packet.data,
+        )
+        .then(
+          result => this.completeTransmit(endpoint, inbound, result),
+          () =>
+            this.completeTransmit(
+              endpoint,
+              inbound,
+              new TxResultEvent(false, 'ERROR'),
+            ),
+        );
+    }
+  }
+
+  private completeTransmit(
+    endpoint: StationEndpoint,
+    inbound: InboundPacket,
+    result: TxResultEvent,
+  ) {
+    endpoint.inFlight--;
+    if (!this.running) {
+      return;
+    }
+
+    const success = result.success;
+    if (success) {
+      endpoint.unresponsive = false;
+    } else if (result.description === 'NO_SCOUT_ACK') {
+      endpoint.unresponsive = true;
+    }
+
+    const latencyMs = Date.now() - inbound.receivedAt;
+    this.counters.totalTransmitLatencyMs += latencyMs;
+    this.counters.maxTransmitLatencyMs = Math.max(
+      this.counters.maxTransmitLatencyMs,
+      latencyMs,
+    );
+
+    if (success) {
+      this.counters.econetTransmits++;
+      this.counters.bytesToEconet += inbound.packet.data.length;
+    } else {
+      this.counters.econetTransmitFailures++;
+    }
+
+    endpoint.inbound
+      .get(routeKey(inbound.from))
+      ?.set(inbound.packet.sequence, success ? 'acked' : 'rejected');
+    this.respond(
+      endpoint,
+      inbound.from,
+      inbound.packet,
+      success ? AunPacketType.Ack : AunPacketType.Reject,
+    );
+    this.pump(endpoint);
+  }
+
+  private respond(
+    endpoint: StationEndpoint,
+    to: AunRoute,
+    packet: AunPacket,
+    type: AunPacketType.Ack | AunPacketType.Reject,
+  ) {
+    endpoint.socket.send(
+      encodeAunPacket({
+        type,
+        port: packet.port,
+        controlByte: packet.controlByte,
+        sequence: packet.sequence,
+        data: Buffer.alloc(0),
+      }),
+      to.port,
+      to.host,
+    );
+  }
+
+  private handleAunResponse(
+    endpoint: StationEndpoint,
+    packet: AunPacket,
+    from: AunRoute,
+  ) {
+    const key = `${routeKey(from)}/${packet.sequence}`;
+    const outbound = endpoint.outbound.get(key);
+    if (!outbound) {
+      // late response to a packet already given up on, or answered twice
+      return;
+    }
+
+    clearTimeout(outbound.timer);
+    endpoint.outbound.delete(key);
+    if (packet.type === AunPacketType.Ack) {
+      this.counters.aunDeliveries++;
+    } else {
+      this.counters.aunDeliveryFailures++;
+    }
+  }
+
+  private handleEconetEvent(event: EconetEvent) {
+    if (event instanceof RxTransmitEvent) {
+      this.forwardToAun(
+        event.fromStation,
+        event.fromNetwork,
+        AunPacketType.Unicast,
+        event.port,
+        event.controlByte,
+        event.payload,
+      );
+    } else if (event instanceof RxBroadcastEvent) {
+      // a broadcast frame holds its control byte and port after the address header
+      this.forwardToAun(
+        event.fromStation,
+        event.fromNetwork,
+        AunPacketType.Broadcast,
+        event.econetFrame[5],
+        event.econetFrame[4],
+        event.econetFrame.subarray(6),
+      );
+    }
+  }
+
+  private forwardToAun(
+    station: number,
+    network: number,
+    type: AunPacketType.Unicast | AunPacketType.Broadcast,
+    port: number,
+    controlByte: number,
+    data: Buffer,
+  ) {
+    const endpoint = this.endpoints.find(
+      e => e.config.station === station && e.network === network,
+    );
+    const to = endpoint?.returnRoute ?? this.options.defaultRoute;
+    if (!endpoint || !to) {
+      this.counters.unroutablePackets++;
+      return;
+    }
+
+    const sequence = endpoint.nextSequence;
+    endpoint.nextSequence = (endpoint.nextSequence + 4) >>> 0;
+    const datagram = encodeAunPacket({
+      type,
+      port,
+      controlByte,
+      sequence,
+      data,
+    });
+    this.counters.bytesToAun += data.length;
+    endpoint.socket.send(datagram, to.port, to.host);
+
+    // broadcasts aren't acknowledged
+    if (type === AunPacketType.Broadcast) {
+      return;
+    }
+
+    const key = `${routeKey(to)}/${sequence}`;
+    const outbound: OutboundPacket = { datagram, to, retries: 0 };
+    const retry = () => {
+      if (outbound.retries >= this.maxRetries) {
+        endpoint.outbound.delete(key);
+        this.counters.aunDeliveryFailures++;
+        return;
+      }
+
+      outbound.retries++;
+      this.counters.aunRetries++;
+      endpoint.socket.send(datagram, to.port, to.host);
+      outbound.timer = setTimeout(retry, this.retryIntervalMs);
+    };
+    outbound.timer = setTimeout(retry, this.retryIntervalMs);
+    endpoint.outbound.set(key, outbound);
+  }
+}
@@ -0,0 +1,69 @@
+import { BulkRecordDecoder } from './bulkRecords';
+
+const chunk = (text: string, end: boolean) => {
+  const header = Buffer.alloc(2);
+  header.writeUInt16LE(text.length | (end ? 0x8000 : 0));
+  return Buffer.concat([header, Buffer.from(text, 'latin1')]);
+};
+
+describe('bulk record decoder', () => {
+  it('should return lines sent as a single chunk', () => {
+    const decoder = new BulkRecordDecoder();
+    const data = Buffer.concat([
+      chunk('STATUS 2.0.20 2 00 0', true),
+      chunk('MONITOR AQD+AA==', true),
+    ]);
+
+    expect(decoder.push(data)).toEqual([
+      'STATUS 2.0.20 2 00 0',
+      'MONITOR AQD+AA==',
+    ]);
+  });
+
+  it('should join the chunks of a line', () => {
+    const decoder = new BulkRecordDecoder();
+    const data = Buffer.concat([
+      chunk('MONITOR ', false),
+      chunk('AQD+AA==', false),
+      chunk('', true),
+    ]);
+
+    expect(decoder.push(data)).toEqual(['MONITOR AQD+AA==']);
+  });
+
+  it('should reassemble chunks split across transfers', () => {
+    const decoder = new BulkRecordDecoder();
+    const data = Buffer.concat([
+      chunk('MONITOR ', false),
+      chunk('AQD+AA==', true),
+      chunk('FLOW 0 0 0', true),
+    ]);
+
+    // split mid-header and mid-payload
+    expect(decoder.push(data.subarray(0, 1))).toEqual([]);
+    expect(decoder.push(data.subarray(1, 14))).toEqual([]);
+    expect(decoder.push(data.subarray(14, 21))).toEqual(['MONITOR AQD+AA==']);
+    expect(decoder.push(data.subarray(21))).toEqual(['FLOW 0 0 0']);
+  });
+
+  it('should discard a partly received line the board has abandoned', () => {
+    const decoder = new BulkRecordDecoder();
+    const data = Buffer.concat([
+      chunk('MONITOR ', false),
+      chunk('AQD', false),
+      chunk('', false),
+      chunk('FLOW 0 0 0', true),
+    ]);
+
+    expect(decoder.push(data)).toEqual(['FLOW 0 0 0']);
+  });
+
+  it('should discard a partly received line on reset', () => {
+    const decoder = new BulkRecordDecoder();
+    decoder.push(chunk('MONITOR ', false));
+    decoder.push(chunk('AQD', true).subarray(0, 3));
+    decoder.reset();
+
+    expect(decoder.push(chunk('FLOW 0 0 0', true))).toEqual(['FLOW 0 0 0']);
+  });
+});
@@ -0,0 +1,53 @@
+const headerLength = 2;
+const lengthMask = 0x7fff;
+const endOfLine = 0x8000;
+
+/**
+ * Reassembles lines from the stream of chunks sent by the board's vendor bulk interface. Each
+ * chunk is a 16-bit little-endian header, holding the chunk's length in its bottom 15 bits with
+ * the top bit set on a line's last chunk, followed by that many bytes of the line. A header of 0
+ * means that the rest of the line will never come, so the part received is discarded. Chunks
+ * may be split across, or share, USB transfers.
+ */
+export class BulkRecordDecoder {
+  private pending = Buffer.alloc(0);
+  private parts: Array<Buffer> = [];
+
+  /**
+   * Forgets any partly received line, as when the interface is reopened.
+   */
+  public reset() {
+    this.pending = Buffer.alloc(0);
+    this.parts = [];
+  }
+
+  /**
+   * Consumes data received from the board, returning each line completed by it.
+   */
+  public push(data: Buffer): Array<string> {
+    const lines: Array<string> = [];
+    let input =
+      this.pending.length > 0 ? Buffer.concat([this.pending, data]) : data;
+
+    while (input.length >= headerLength) {
+      const header = input.readUInt16LE(0);
+      const length = header & lengthMask;
+      if (input.length < headerLength + length) {
+        break;
+      }
+
+      this.parts.push(input.subarray(headerLength, headerLength + length));
+      input = input.subarray(headerLength + length);
+      if (header === 0) {
+        this.parts = [];
+      } else if (header & endOfLine) {
+        lines.push(Buffer.concat(this.parts).toString('latin1'));
+        this.parts = [];
+      }
+    }
+
+    // copied, so that the transfer's buffer isn't held on to
+    this.pending = Buffer.from(input);
+    return lines;
+  }
+}
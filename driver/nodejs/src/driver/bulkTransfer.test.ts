@@ -0,0 +1,186 @@
+import { TxResultEvent } from '../types/txResultEvent';
+import { transmitBulk } from './bulkTransfer';
+
+type Transmission = {
+  data: Buffer;
+  complete: (result: TxResultEvent) => void;
+  fail: (error: Error) => void;
+};
+
+// stands in for the driver and firmware, completing transmissions when told to
+const createBoard = () => {
+  const transmissions = new Array<Transmission>();
+  return {
+    transmissions,
+    transmit: jest.fn(
+      (
+        station: number,
+        network: number,
+        controlByte: number,
+        port: number,
+        data: Buffer,
+      ) =>
+        new Promise<TxResultEvent>((resolve, reject) => {
+          transmissions.push({ data, complete: resolve, fail: reject });
+        }),
+    ),
+  };
+};
+
+const flush = () => new Promise(resolve => setTimeout(resolve, 0));
+
+const ok = new TxResultEvent(true, 'OK');
+const noScoutAck = new TxResultEvent(false, 'NO_SCOUT_ACK');
+
+describe('bulk transfer', () => {
+  let board: ReturnType<typeof createBoard>;
+
+  beforeEach(() => {
+    board = createBoard();
+  });
+
+  it('should split payload into chunks and limit chunks in flight', async () => {
+    const data = Buffer.from('abcdefghij');
+    const result = transmitBulk(board, 254, 0, 0x99, data, {
+      chunkSize: 3,
+      window: 2,
+    });
+
+    expect(board.transmit).toHaveBeenCalledTimes(2);
+    expect(board.transmit).toHaveBeenCalledWith(
+      254,
+      0,
+      0x80,
+      0x99,
+      Buffer.from('abc'),
+    );
+
+    for (let i = 0; i < 4; i++) {
+      board.transmissions[i].complete(ok);
+      await flush();
+    }
+
+    expect(board.transmissions.map(t => t.data.toString())).toEqual([
+      'abc',
+      'def',
+      'ghi',
+      'j',
+    ]);
+    await expect(result).resolves.toMatchObject({
+      success: true,
+      description: 'OK',
+      chunks: 4,
+      chunksSent: 4,
+      bytesSent: 10,
+      retries: 0,
+    });
+  });
+
+  it('should retry failed chunk ahead of chunks not yet sent', async () => {
+    const data = Buffer.from('abcdefghij');
+    const result = transmitBulk(board, 254, 0, 0x99, data, {
+      chunkSize: 3,
+      window: 2,
+    });
+
+    board.transmissions[0].complete(noScoutAck);
+    await flush();
+    board.transmissions[1].complete(ok);
+    await flush();
+    for (let i = 2; i < 5; i++) {
+      board.transmissions[i].complete(ok);
+      await flush();
+    }
+
+    expect(board.transmissions.map(t => t.data.toString())).toEqual([
+      'abc',
+      'def',
+      'abc',
+      'ghi',
+      'j',
+    ]);
+    await expect(result).resolves.toMatchObject({
+      success: true,
+      chunksSent: 4,
+      retries: 1,
+    });
+  });
+
+  it('should give up once a chunk has failed too often', async () => {
+    const data = Buffer.from('abcdefghij');
+    const result = transmitBulk(board, 254, 0, 0x99, data, {
+      chunkSize: 3,
+      window: 1,
+      maxRetries: 1,
+    });
+
+    board.transmissions[0].complete(ok);
+    await flush();
+    board.transmissions[1].complete(noScoutAck);
+    await flush();
+    board.transmissions[2].complete(noScoutAck);
+    await flush();
+
+    expect(board.transmit).toHaveBeenCalledTimes(3);
+    await expect(result).resolves.toMatchObject({
+      success: false,
+      description: 'NO_SCOUT_ACK',
+      failedChunk: 1,
+      chunksSent: 1,
+      bytesSent: 3,
+      retries: 1,
+    });
+  });
+
+  it('should reject once chunks in flight complete if transmit throws', async () => {
+    const data = Buffer.alloc(8);
+    const result = transmitBulk(board, 254, 0, 0x99, data, {
+      chunkSize: 2,
+      window: 2,
+    });
+
+    board.transmissions[0].fail(new Error('Connection closed'));
+    await flush();
+    expect(board.transmit).toHaveBeenCalledTimes(2);
+
+    board.transmissions[1].complete(ok);
+    await expect(result).rejects.toThrow('Connection closed');
+  });
+
+  it('should report progress as chunks are acknowledged', async () => {
+    const progress = jest.fn();
+    const result = transmitBulk(board, 254, 0, 0x99, Buffer.alloc(4), {
+      chunkSize: 2,
+      onProgress: progress,
+    });
+
+    board.transmissions[0].complete(ok);
+    await flush();
+    expect(progress).toHaveBeenCalledWith(
+      expect.objectContaining({ chunks: 2, chunksSent: 1, bytesSent: 2 }),
+    );
+
+    board.transmissions[1].complete(ok);
+    await result;
+    expect(progress).toHaveBeenCalledTimes(2);
+  });
+
+  it('should complete immediately given empty payload', async () => {
+    await expect(
+      transmitBulk(board, 254, 0, 0x99, Buffer.alloc(0)),
+    ).resolves.toMatchObject({ success: true, chunks: 0 });
+    expect(board.transmit).not.toHaveBeenCalled();
+  });
+
+  it('should reject invalid options', () => {
+    expect(() =>
+      transmitBulk(board, 254, 0, 0x99, Buffer.alloc(1), { chunkSize: 0 }),
+    ).toThrow('Invalid chunk size');
+    expect(() =>
+      transmitBulk(board, 254, 0, 0x99, Buffer.alloc(1), { window: 0 }),
+    ).toThrow('Invalid window');
+    expect(() =>
+      transmitBulk(board, 254, 0, 0x99, Buffer.alloc(1), { controlByte: 256 }),
+    ).toThrow('Invalid control byte');
+  });
+});
@@ -0,0 +1,308 @@
+import config from '../config';
+import { TxResultEvent } from '../types/txResultEvent';
+
+/**
+ * Options for {@link transmitBulk}.
+ */
+export type BulkTransferOptions = {
+  /**
+   * Econet control byte sent with every chunk (integer in range 0-254, inclusive). Defaults to
+   * `0x80`.
+   */
+  controlByte?: number;
+
+  /**
+   * Maximum number of payload bytes sent in each packet. Defaults to `config.maxTxDataLength`.
+   */
+  chunkSize?: number;
+
+  /**
+   * Maximum number of chunks queued at the board at once. Defaults to `4`.
+   */
+  window?: number;
+
+  /**
+   * Number of times a failed chunk is retransmitted before the transfer is abandoned. Defaults
+   * to `3`.
+   */
+  maxRetries?: number;
+
+  /**
+   * Delay before retransmitting a failed chunk, giving a busy receiver time to get ready.
+   * Defaults to `0`.
+   */
+  retryDelayMs?: number;
+
+  /**
+   * Called each time a chunk is acknowledged, with the progress of the transfer so far.
+   */
+  onProgress?: (metrics: BulkTransferMetrics) => void;
+};
+
+/**
+ * The means by which {@link transmitBulk} sends each chunk, normally the driver's `transmit`.
+ * It must cope with being called again before earlier calls have completed.
+ */
+export type BulkTransferBoard = {
+  transmit: (
+    station: number,
+    network: number,
+    controlByte: number,
+    port: number,
+    data: Buffer,
+  ) => Promise<TxResultEvent>;
+};
+
+/**
+ * Counters describing the progress of a bulk transfer.
+ */
+export type BulkTransferMetrics = {
+  /**
+   * Number of chunks into which the payload was split.
+   */
+  chunks: number;
+
+  /**
+   * Number of chunks acknowledged by the receiver.
+   */
+  chunksSent: number;
+
+  /**
+   * Number of payload bytes acknowledged by the receiver.
+   */
+  bytesSent: number;
+
+  /**
+   * Number of retransmissions of failed chunks.
+   */
+  retries: number;
+
+  /**
+   * Milliseconds since the transfer started.
+   */
+  elapsedMs: number;
+
+  /**
+   * Payload bytes acknowledged per second since the transfer started.
+   */
+  bytesPerSecond: number;
+
+  /**
+   * Mean time in milliseconds from a chunk being queued at the board to its result, including
+   * time spent behind other chunks in the window.
+   */
+  meanChunkLatencyMs: number;
+
+  /**
+   * Greatest time in milliseconds from a chunk being queued at the board to its result.
+   */
+  maxChunkLatencyMs: number;
+};
+
+/**
+ * Describes the outcome of a {@link transmitBulk} call.
+ */
+export type BulkTransferResult = BulkTransferMetrics & {
+  /**
+   * `true` if every chunk was acknowledged.
+   */
+  success: boolean;
+
+  /**
+   * `OK`, or the `TxResultEvent` description of the last attempt to send the chunk which failed.
+   */
+  description: string;
+
+  /**
+   * Index of the chunk which failed, if any.
+   */
+  failedChunk?: number;
+};
+
+/**
+ * Sends a payload of any length to an Econet station as a series of packets of at most
+ * `chunkSize` bytes.
+ *
+ * Up to `window` chunks are queued at the board at once, so the serial round trip is paid once
+ * per transfer rather than once per chunk. A chunk which fails (e.g. because the receiver wasn't
+ * ready) is retransmitted ahead of any chunk not yet sent, lowest index first. Chunks already
+ * queued behind it are not held back, so a receiver may see chunks out of order following a
+ * retry; use a `window` of `1` or carry the chunk index in the data if order matters.
+ *
+ * Once a chunk has failed `maxRetries` times no further chunks are sent and the result reports
+ * the failure. Errors thrown by `board.transmit` (such as the connection closing) are rethrown
+ * once the chunks already queued have completed.
+ */
+export const transmitBulk = (
+  board: BulkTransferBoard,
+  station: number,
+  network: number,
+  port: number,
+  data: Buffer,
+  options: BulkTransferOptions = {},
+): Promise<BulkTransferResult> => {
+  const controlByte = options.controlByte ?? 0x80;
+  const chunkSize = options.chunkSize ?? config.maxTxDataLength;
+  const window = options.window ?? 4;
+  const maxRetries = options.maxRetries ?? 3;
+  const retryDelayMs = options.retryDelayMs ?? 0;
+
+  if (!Number.isInteger(controlByte) || controlByte < 0 || controlByte > 255) {
+    throw new Error('Invalid control byte');
+  }
+
+  if (
+    !Number.isInteger(chunkSize) ||
+    chunkSize < 1 ||
+    chunkSize > config.maxTxDataLength
+  ) {
+    throw new Error('Invalid chunk size');
+  }
+
+  if (!Number.isInteger(window) || window < 1) {
+    throw new Error('Invalid window');
+  }
+
+  if (!Number.isInteger(maxRetries) || maxRetries < 0) {
+    throw new Error('Invalid retry count');
+  }
+
+  const chunks = Math.ceil(data.length / chunkSize);
+  const attempts = new Array<number>(chunks).fill(0);
+  const startedAt = Date.now();
+  let nextChunk = 0;
+  let inFlight = 0;
+
+  // failed chunks awaiting retransmission, in ascending order of index
+  const retryQueue = new Array<number>();
+  const retryTimers = new Set<NodeJS.Timeout>();
+
+  let failure: { chunk: number; description: string } | undefined;
+  let error: Error | undefined;
+  const counters = {
+    chunksSent: 0,
+    bytesSent: 0,
+    retries: 0,
+    completed: 0,
+    totalLatencyMs: 0,
+    maxChunkLatencyMs: 0,
+  };
+
+  const metrics = (): BulkTransferMetrics => {
+    const elapsedMs = Date.now() - startedAt;
+    return {
+      chunks,
+      chunksSent: counters.chunksSent,
+      bytesSent: counters.bytesSent,
+      retries: counters.retries,
+      elapsedMs,
+      bytesPerSecond:
+        elapsedMs > 0 ? (counters.bytesSent * 1000) / elapsedMs : 0,
+      meanChunkLatencyMs:
+        counters.completed > 0
+          ? counters.totalLatencyMs / counters.completed
+          : 0,
+      maxChunkLatencyMs: counters.maxChunkLatencyMs,
+    };
+  };
+
+  return new Promise((resolve, reject) => {
+    const chunkData = (chunk: number) =>
+      data.subarray(chunk * chunkSize, (chunk + 1) * chunkSize);
+
+    const queueRetry = (chunk: number) => {
+      const index = retryQueue.findIndex(queued => queued > chunk);
+      retryQueue.splice(index === -1 ? retryQueue.length : index, 0, chunk);
+    };
+
+    const send = (chunk: number) => {
+      const queuedAt = Date.now();
+      attempts[chunk]++;
+      inFlight++;
+      board
+        .transmit(station, network, controlByte, port, chunkData(chunk))
+        .then(
+          result => complete(chunk, queuedAt, result),
+          (e: Error) => {
+            inFlight--;
+            error = error ?? e;
+            pump();
+          },
+        );
+    };
+
+    const complete = (
+      chunk: number,
+      queuedAt: number,
+      result: TxResultEvent,
+    ) => {
+      inFlight--;
+      const latencyMs = Date.now() - queuedAt;
+      counters.completed++;
+      counters.totalLatencyMs += latencyMs;
+      counters.maxChunkLatencyMs = Math.max(
+        counters.maxChunkLatencyMs,
+        latencyMs,
+      );
+
+      if (result.success) {
+        counters.chunksSent++;
+        counters.bytesSent += chunkData(chunk).length;
+        options.onProgress?.(metrics());
+      } else if (attempts[chunk] > maxRetries) {
+        failure = failure ?? { chunk, description: result.description };
+      } else {
+        counters.retries++;
+        if (retryDelayMs > 0) {
+          const timer = setTimeout(() => {
+            retryTimers.delete(timer);
+            queueRetry(chunk);
+            pump();
+          }, retryDelayMs);
+          retryTimers.add(timer);
+        } else {
+          queueRetry(chunk);
+        }
+      }
+
+      pump();
+    };
+
+    const pump = () => {
+      if (failure || error) {
+        retryTimers.forEach(timer => clearTimeout(timer));
+        retryTimers.clear();
+        retryQueue.splice(0);
+      }
+
+      while (!failure && !error && inFlight < window) {
+        const chunk = retryQueue.length > 0 ? retryQueue.shift() : nextChunk;
+        if (typeof chunk === 'undefined' || chunk >= chunks) {
+          break;
+        }
+        if (chunk === nextChunk) {
+          nextChunk++;
+        }
+        send(chunk);
+      }
+
+      if (inFlight > 0 || retryTimers.size > 0 || retryQueue.length > 0) {
+        return;
+      }
+
+      if (error) {
+        reject(error);
+        return;
+      }
+
+      resolve({
+        ...metrics(),
+        success: !failure,
+        description: failure?.description ?? 'OK',
+        failedChunk: failure?.chunk,
+      });
+    };
+
+    pump();
+  });
+};
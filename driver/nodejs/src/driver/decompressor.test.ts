@@ -0,0 +1,99 @@
+import { Decompressor } from './decompressor';
+
+// produced by the board's compressor from three consecutive frames, the second of which
+// refers back into the first and the third of which is a run of zero bytes
+const compressedFrames = [
+  'AQCtAQD+AGhlbGxvIAYA',
+  'AAEGGwBQd29ybGQ=',
+  'AAIfAAEALA==',
+];
+const originalFrames = [
+  Buffer.concat([
+    Buffer.from('0100fe00', 'hex'),
+    Buffer.from('hello hello hello hello'),
+  ]).toString('base64'),
+  'AQD+AGhlbGxvIHdvcmxk',
+  Buffer.alloc(64).toString('base64'),
+];
+
+describe('decompressor', () => {
+  it('should leave uncompressed lines untouched', () => {
+    const decompressor = new Decompressor();
+    expect(decompressor.expandLine('MONITOR AQD+AA==')).toEqual(
+      'MONITOR AQD+AA==',
+    );
+    expect(decompressor.expandLine('STATUS 2.0.0 1 00 0')).toEqual(
+      'STATUS 2.0.0 1 00 0',
+    );
+  });
+
+  it('should decompress consecutive frames', () => {
+    const decompressor = new Decompressor();
+    compressedFrames.forEach((frame, index) => {
+      const line = decompressor.expandLine(`MONITOR ~${frame}`);
+      expect(Buffer.from(line?.split(' ')[1] ?? '', 'base64')).toEqual(
+        Buffer.from(originalFrames[index], 'base64'),
+      );
+    });
+    expect(decompressor.metrics).toEqual({
+      frames: 3,
+      droppedFrames: 0,
+      inputBytes: 33,
+      outputBytes: 106,
+    });
+  });
+
+  it('should only expand the data field', () => {
+    const decompressor = new Decompressor();
+    expect(
+      decompressor.expandLine(`RX_TRANSMIT AQD+AA== ~${compressedFrames[0]}`),
+    ).toEqual(
+      `RX_TRANSMIT AQD+AA== ${originalFrames[0]}`,
+    );
+  });
+
+  it('should drop frames after a lost frame until the next reset', () => {
+    const decompressor = new Decompressor();
+    expect(
+      decompressor.expandLine(`MONITOR ~${compressedFrames[0]}`),
+    ).toBeDefined();
+    expect(
+      decompressor.expandLine(`MONITOR ~${compressedFrames[2]}`),
+    ).toBeUndefined();
+    expect(
+      decompressor.expandLine(`MONITOR ~${compressedFrames[1]}`),
+    ).toBeUndefined();
+
+    expect(
+      decompressor.expandLine(`MONITOR ~${compressedFrames[0]}`),
+    ).toBeDefined();
+    expect(decompressor.metrics.frames).toEqual(2);
+    expect(decompressor.metrics.droppedFrames).toEqual(2);
+  });
+
+  it('should not decompress before the first reset', () => {
+    const decompressor = new Decompressor();
+    expect(
+      decompressor.expandLine(`MONITOR ~${compressedFrames[1]}`),
+    ).toBeUndefined();
+    expect(decompressor.metrics.droppedFrames).toEqual(1);
+  });
+
+  it('should reject matches reaching back beyond the history', () => {
+    const decompressor = new Decompressor();
+    // reset frame with 'ab' followed by a match 3 bytes back
+    const frame = Buffer.from([0x01, 0x00, 0x20, 0x61, 0x62, 0x03, 0x00]);
+    expect(
+      decompressor.expandLine(`MONITOR ~${frame.toString('base64')}`),
+    ).toBeUndefined();
+  });
+
+  it('should forget history when reset', () => {
+    const decompressor = new Decompressor();
+    decompressor.expandLine(`MONITOR ~${compressedFrames[0]}`);
+    decompressor.reset();
+    expect(
+      decompressor.expandLine(`MONITOR ~${compressedFrames[1]}`),
+    ).toBeUndefined();
+  });
+});
@@ -0,0 +1,209 @@
+const windowSize = 4096;
+const windowMask = windowSize - 1;
+const minMatch = 4;
+const flagReset = 1;
+
+/**
+ * Marks a frame data field which the board has compressed (see {@link setCompression}).
+ */
+const compressedMarker = '~';
+
+/**
+ * Counters describing the work done by a {@link Decompressor}.
+ */
+export type DecompressorMetrics = {
+  /**
+   * Number of frames successfully decompressed.
+   */
+  frames: number;
+
+  /**
+   * Number of frames discarded because an earlier frame was lost or corrupt, so their history
+   * was unknown. Decompression resumes at the next frame which resets the history.
+   */
+  droppedFrames: number;
+
+  /**
+   * Total compressed bytes received (excluding base64 encoding).
+   */
+  inputBytes: number;
+
+  /**
+   * Total bytes after decompression.
+   */
+  outputBytes: number;
+};
+
+/**
+ * Reverses the board's frame data compression. Compressed frames may refer back into earlier
+ * frames so every compressed line from the board must pass through the same instance, in the
+ * order received, even if nobody is interested in the resulting event.
+ */
+export class Decompressor {
+  private history = Buffer.alloc(windowSize);
+  private output = Buffer.allocUnsafe(32768);
+  private pos = 0;
+  private base = 0;
+  private nextSeq = 0;
+  private synced = false;
+  private counters: DecompressorMetrics = {
+    frames: 0,
+    droppedFrames: 0,
+    inputBytes: 0,
+    outputBytes: 0,
+  };
+
+  /**
+   * Forgets all history, as when the board is reconnected.
+   */
+  public reset() {
+    this.pos = 0;
+    this.base = 0;
+    this.synced = false;
+  }
+
+  public get metrics(): DecompressorMetrics {
+    return { ...this.counters };
+  }
+
+  /**
+   * Replaces the compressed frame data field of a line (always its last) with the base64
+   * encoding of the original data, leaving lines without one untouched.
+   *
+   * @returns The expanded line or `undefined` if the frame could not be decompressed and the
+   *          line should be discarded.
+   */
+  public expandLine(line: string): string | undefined {
+    const start = line.lastIndexOf(' ') + 1;
+    if (start === 0 || line[start] !== compressedMarker) {
+      return line;
+    }
+
+    const len = this.decompress(
+      Buffer.from(line.substring(start + 1), 'base64'),
+    );
+    if (len === undefined) {
+      return undefined;
+    }
+    return line.substring(0, start) + this.output.toString('base64', 0, len);
+  }
+
+  /**
+   * Decompresses a single frame into `this.output`, returning its length.
+   */
+  private decompress(frame: Buffer): number | undefined {
+    if (frame.length < 2) {
+      this.drop();
+      return undefined;
+    }
+
+    const flags = frame[0];
+    const seq = frame[1];
+    if (flags & flagReset) {
+      this.base = this.pos;
+      this.synced = true;
+    } else if (!this.synced || seq !== this.nextSeq) {
+      this.drop();
+      return undefined;
+    }
+    this.nextSeq = (seq + 1) & 0xff;
+
+    const len = this.decodeSequences(frame);
+    if (len === undefined) {
+      this.drop();
+      return undefined;
+    }
+
+    // keep the tail of the frame for the next to refer back into
+    for (let k = Math.max(0, len - windowSize); k < len; k++) {
+      this.history[(this.pos + k) & windowMask] = this.output[k];
+    }
+    this.pos += len;
+
+    this.counters.frames++;
+    this.counters.inputBytes += frame.length;
+    this.counters.outputBytes += len;
+    return len;
+  }
+
+  private decodeSequences(frame: Buffer): number | undefined {
+    let i = 2;
+    let o = 0;
+
+    const readLength = (len: number): number | undefined => {
+      let b: number;
+      do {
+        if (i >= frame.length) {
+          return undefined;
+        }
+        b = frame[i++];
+        len += b;
+      } while (b === 255);
+      return len;
+    };
+
+    while (i < frame.length) {
+      const token = frame[i++];
+
+      let literals: number | undefined = token >> 4;
+      if (literals === 15) {
+        literals = readLength(literals);
+      }
+      if (literals === undefined || i + literals > frame.length) {
+        return undefined;
+      }
+      this.ensureOutput(o + literals);
+      frame.copy(this.output, o, i, i + literals);
+      i += literals;
+      o += literals;
+
+      if (i === frame.length) {
+        break;
+      }
+
+      if (i + 2 > frame.length) {
+        return undefined;
+      }
+      const distance = frame[i] | (frame[i + 1] << 8);
+      i += 2;
+      let matchLen: number | undefined = token & 0x0f;
+      if (matchLen === 15) {
+        matchLen = readLength(matchLen);
+      }
+      if (matchLen === undefined) {
+        return undefined;
+      }
+      matchLen += minMatch;
+
+      const available = Math.min(this.pos + o - this.base, windowSize - 1);
+      if (distance === 0 || distance > available) {
+        return undefined;
+      }
+
+      // byte by byte, as matches may overlap the bytes they produce
+      this.ensureOutput(o + matchLen);
+      let src = o - distance;
+      for (let k = 0; k < matchLen; k++, src++) {
+        this.output[o++] =
+          src < 0
+            ? this.history[(this.pos + src) & windowMask]
+            : this.output[src];
+      }
+    }
+    return o;
+  }
+
+  private ensureOutput(len: number) {
+    if (len <= this.output.length) {
+      return;
+    }
+    const output = Buffer.allocUnsafe(Math.max(len, this.output.length * 2));
+    this.output.copy(output);
+    this.output = output;
+  }
+
+  private drop() {
+    this.synced = false;
+    this.counters.droppedFrames++;
+  }
+}
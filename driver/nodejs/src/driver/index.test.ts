@@ -9,8 +9,27 @@ import {
   eventQueueCreate,
   eventQueueWait,
   eventQueueDestroy,
+  setCompression,
+  setDuplicateSuppression,
+  setAdlcTrace,
+  setFlowControl,
+  runBenchmark,
+  recoverAdlc,
+  readRecoveryStatus,
+  setTrafficInterval,
+  readTraffic,
+  setSnapLength,
+  scanNetwork,
+  setUsbFlushDeadline,
+  readUsbStatus,
+  decompressorMetrics,
+  transmit,
+  transmitBulk,
+  reply,
 } from '.';
 import { EconetEvent } from '../types/econetEvent';
+import { MonitorEvent } from '../types/monitorEvent';
+import { ReplyResultEvent } from '../types/replyResultEvent';
 import { StatusEvent } from '../types/statusEvent';
 import { openPort, writeToPort } from './serial';
 import { PKG_VERSION } from './version';
@@ -35,6 +54,30 @@ describe('driver', () => {
     await expect(close()).resolves.toBeUndefined();
   });
 
+  it('should open the data channel when given its device', async () => {
+    setTimeout(() => {
+      const dataHandlerFunc = openPortMock.mock.calls[0][0];
+      dataHandlerFunc(`STATUS ${PKG_VERSION} 2 00 0`);
+    }, 100);
+
+    await connect('/dev/ttyACM0', '/dev/ttyACM1');
+    expect(openPortMock.mock.calls[0][1]).toBe('/dev/ttyACM0');
+    expect(openPortMock.mock.calls[0][2]).toBe('/dev/ttyACM1');
+    await close();
+  });
+
+  it('should open the bulk interface when requested', async () => {
+    setTimeout(() => {
+      const dataHandlerFunc = openPortMock.mock.calls[0][0];
+      dataHandlerFunc(`STATUS ${PKG_VERSION} 2 00 0`);
+    }, 100);
+
+    await connect(undefined, undefined, { transport: 'bulk' });
+    expect(openPortMock.mock.calls[0][1]).toBeUndefined();
+    expect(openPortMock.mock.calls[0][3]).toBe('bulk');
+    await close();
+  });
+
   it('should fire events to handler registered with addListener', async () => {
     let event;
     const eventHandler = (e: EconetEvent) => {
@@ -73,6 +116,27 @@ describe('driver', () => {
     await close();
   });
 
+  it('should only fire events of requested types to handler registered with addListener', async () => {
+    const events: Array<EconetEvent> = [];
+    const eventHandler = (e: EconetEvent) => {
+      events.push(e);
+    };
+    addListener(eventHandler, [MonitorEvent]);
+
+    mockStatusEventFromBoard(0);
+    await connect();
+    const dataHandlerFunc = openPortMock.mock.calls[0][0];
+
+    dataHandlerFunc('MONITOR abcdef123=');
+    dataHandlerFunc(`STATUS ${PKG_VERSION} 2 00 2`);
+
+    expect(events.length).toEqual(1);
+    expect(events[0]).toBeInstanceOf(MonitorEvent);
+
+    removeListener(eventHandler);
+    await close();
+  });
+
   it('should return matching event from waitForEvent', async () => {
     // eslint-disable-next-line @typescript-eslint/no-unused-vars
     const matcher = (e: EconetEvent) => true;
@@ -143,6 +207,111 @@ describe('driver', () => {
     await close();
   });
 
+  it('should wake eventQueueWait as soon as a matching event arrives', async () => {
+    // eslint-disable-next-line @typescript-eslint/no-unused-vars
+    const matcher = (e: EconetEvent) => true;
+
+    mockStatusEventFromBoard(0);
+    await connect();
+    const dataHandlerFunc = openPortMock.mock.calls[0][0];
+
+    const queue = eventQueueCreate(matcher);
+    const pending = eventQueueWait(queue, 1000);
+    dataHandlerFunc(`STATUS ${PKG_VERSION} 2 00 1`);
+
+    const event = await pending;
+    expect(event instanceof StatusEvent && event.rxMode === 1).toBeTruthy();
+    expect(queue.events.length).toEqual(0);
+
+    eventQueueDestroy(queue);
+    await close();
+  });
+
+  it('should drop oldest events from a full queue by default', async () => {
+    // eslint-disable-next-line @typescript-eslint/no-unused-vars
+    const matcher = (e: EconetEvent) => true;
+
+    mockStatusEventFromBoard(0);
+    await connect();
+    const dataHandlerFunc = openPortMock.mock.calls[0][0];
+
+    const queue = eventQueueCreate(matcher, undefined, { capacity: 2 });
+    dataHandlerFunc(`STATUS ${PKG_VERSION} 2 00 0`);
+    dataHandlerFunc(`STATUS ${PKG_VERSION} 2 00 1`);
+    dataHandlerFunc(`STATUS ${PKG_VERSION} 2 00 2`);
+
+    expect(queue.droppedEvents).toEqual(1);
+    const event1 = await eventQueueWait(queue, 1000);
+    const event2 = await eventQueueWait(queue, 1000);
+    expect(event1 instanceof StatusEvent && event1.rxMode === 1).toBeTruthy();
+    expect(event2 instanceof StatusEvent && event2.rxMode === 2).toBeTruthy();
+
+    eventQueueDestroy(queue);
+    await close();
+  });
+
+  it('should drop newest events from a full queue if requested', async () => {
+    // eslint-disable-next-line @typescript-eslint/no-unused-vars
+    const matcher = (e: EconetEvent) => true;
+
+    mockStatusEventFromBoard(0);
+    await connect();
+    const dataHandlerFunc = openPortMock.mock.calls[0][0];
+
+    const queue = eventQueueCreate(matcher, undefined, {
+      capacity: 1,
+      overflowPolicy: 'dropNewest',
+    });
+    dataHandlerFunc(`STATUS ${PKG_VERSION} 2 00 1`);
+    dataHandlerFunc(`STATUS ${PKG_VERSION} 2 00 2`);
+
+    expect(queue.droppedEvents).toEqual(1);
+    const event = await eventQueueWait(queue, 1000);
+    expect(event instanceof StatusEvent && event.rxMode === 1).toBeTruthy();
+
+    eventQueueDestroy(queue);
+    await close();
+  });
+
+  it('should reject eventQueueWait if queue is destroyed', async () => {
+    // eslint-disable-next-line @typescript-eslint/no-unused-vars
+    const matcher = (e: EconetEvent) => false;
+
+    const queue = eventQueueCreate(matcher);
+    const pending = eventQueueWait(queue, 1000);
+    eventQueueDestroy(queue);
+
+    await expect(pending).rejects.toThrow(
+      'Event queue destroyed whilst waiting for event',
+    );
+  });
+
+  it('should deliver events to other listeners if one throws', async () => {
+    let event;
+    const badHandler = () => {
+      throw new Error('oops');
+    };
+    const goodHandler = (e: EconetEvent) => {
+      event = e;
+    };
+    const consoleErrorSpy = jest
+      .spyOn(console, 'error')
+      .mockImplementation(() => undefined);
+    addListener(badHandler);
+    addListener(goodHandler);
+
+    mockStatusEventFromBoard(0);
+    await connect();
+
+    expect(event).toBeDefined();
+    expect(consoleErrorSpy).toHaveBeenCalled();
+
+    removeListener(badHandler);
+    removeListener(goodHandler);
+    consoleErrorSpy.mockRestore();
+    await close();
+  });
+
   it('should return a connection failure if versions do not match', async () => {
     setTimeout(() => {
       const dataHandlerFunc = openPortMock.mock.calls[0][0];
@@ -233,7 +402,373 @@ describe('driver', () => {
     await close();
   });
 
-  // TODO: test transmit
+  it('should send SET_COMPRESSION correctly on call to setCompression', async () => {
+    mockStatusEventFromBoard(0);
+    await connect();
+
+    setTimeout(() => {
+      const dataHandlerFunc = openPortMock.mock.calls[0][0];
+      dataHandlerFunc('COMPRESSION LZ 0 0 0\r');
+    }, 100);
+    const status = await setCompression('LZ');
+    expect(writeToPortMock).toHaveBeenCalledWith('SET_COMPRESSION LZ\r');
+    expect(status.scheme).toEqual('LZ');
+    await close();
+  });
+
+  it('should send SET_DEDUP correctly on call to setDuplicateSuppression', async () => {
+    mockStatusEventFromBoard(0);
+    await connect();
+
+    setTimeout(() => {
+      const dataHandlerFunc = openPortMock.mock.calls[0][0];
+      dataHandlerFunc('DEDUP 500 0 0 0\r');
+    }, 100);
+    const status = await setDuplicateSuppression(500);
+    expect(writeToPortMock).toHaveBeenCalledWith('SET_DEDUP 500\r');
+    expect(status.windowMs).toEqual(500);
+    await expect(setDuplicateSuppression(70000)).rejects.toThrow(
+      'Invalid duplicate suppression window',
+    );
+    await close();
+  });
+
+  it('should send SET_TRACE correctly on call to setAdlcTrace', async () => {
+    mockStatusEventFromBoard(0);
+    await connect();
+
+    setTimeout(() => {
+      const dataHandlerFunc = openPortMock.mock.calls[0][0];
+      dataHandlerFunc('TRACE 1 0\r');
+    }, 100);
+    const trace = await setAdlcTrace(true);
+    expect(writeToPortMock).toHaveBeenCalledWith('SET_TRACE 1\r');
+    expect(trace.enabled).toEqual(true);
+    expect(trace.entries).toEqual([]);
+    await close();
+  });
+
+  it('should send SET_FLOW and return credits as frames are handled', async () => {
+    mockStatusEventFromBoard(0);
+    await connect();
+    const dataHandlerFunc = openPortMock.mock.calls[0][0];
+
+    const pending = setFlowControl(4);
+    await new Promise(resolve => setImmediate(resolve));
+    expect(writeToPortMock).toHaveBeenCalledWith('SET_FLOW 4\r');
+    dataHandlerFunc('FLOW 1 4 0 0 0 0');
+    const flow = await pending;
+    expect(flow.enabled).toEqual(true);
+    expect(flow.credits).toEqual(4);
+
+    dataHandlerFunc('MONITOR AAAAAAAA');
+    dataHandlerFunc('TX_RESULT OK');
+    expect(writeToPortMock).not.toHaveBeenCalledWith('CREDIT 2\r');
+    dataHandlerFunc('MONITOR AAAAAAAA');
+    expect(writeToPortMock).toHaveBeenCalledWith('CREDIT 2\r');
+    await close();
+  });
+
+  it('should send BENCH correctly on call to runBenchmark', async () => {
+    mockStatusEventFromBoard(0);
+    await connect();
+
+    setTimeout(() => {
+      const dataHandlerFunc = openPortMock.mock.calls[0][0];
+      dataHandlerFunc('BENCH 64 100 0 0 0 279653 357 22885 2.15\r');
+    }, 100);
+    const bench = await runBenchmark(64, 100);
+    expect(writeToPortMock).toHaveBeenCalledWith('BENCH 64 100\r');
+    expect(bench.frames).toEqual(100);
+    expect(bench.busCyclesPerByte).toEqual(2.15);
+    await expect(runBenchmark(1, 100)).rejects.toThrowError(
+      'Invalid benchmark frame length',
+    );
+    await close();
+  });
+
+  it('should send RECOVER and RECOVERY correctly', async () => {
+    mockStatusEventFromBoard(0);
+    await connect();
+
+    setTimeout(() => {
+      const dataHandlerFunc = openPortMock.mock.calls[0][0];
+      dataHandlerFunc('RECOVERY SOFT 0 0 1 1 20 20 0 0 0 0 0 0 0 0\r');
+    }, 100);
+    const recovery = await recoverAdlc();
+    expect(writeToPortMock).toHaveBeenCalledWith('RECOVER\r');
+    expect(recovery.lastTier).toEqual('SOFT');
+    expect(recovery.soft.lastUs).toEqual(20);
+
+    setTimeout(() => {
+      const dataHandlerFunc = openPortMock.mock.calls[0][0];
+      dataHandlerFunc('RECOVERY SOFT 1 0 2 2 20 21 0 0 0 0 0 0 0 0\r');
+    }, 100);
+    const status = await readRecoveryStatus();
+    expect(writeToPortMock).toHaveBeenCalledWith('RECOVERY\r');
+    expect(status.lineJammedStalls).toEqual(1);
+    await close();
+  });
+
+  it('should send SET_TRAFFIC and TRAFFIC correctly', async () => {
+    mockStatusEventFromBoard(0);
+    await connect();
+
+    setTimeout(() => {
+      const dataHandlerFunc = openPortMock.mock.calls[0][0];
+      dataHandlerFunc(
+        'TRAFFIC 1000000 0 0 0 0 0 0 0 AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA\r',
+      );
+    }, 100);
+    const traffic = await setTrafficInterval(5000);
+    expect(writeToPortMock).toHaveBeenCalledWith('SET_TRAFFIC 5000\r');
+    expect(traffic.elapsedUs).toEqual(1000000);
+    expect(traffic.utilisation).toEqual(0);
+
+    setTimeout(() => {
+      const dataHandlerFunc = openPortMock.mock.calls[0][0];
+      dataHandlerFunc(
+        'TRAFFIC 250000 1000 1 20 1 0 0 0 AAAAAAAAAAABAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA\r',
+      );
+    }, 100);
+    const snapshot = await readTraffic();
+    expect(writeToPortMock).toHaveBeenCalledWith('TRAFFIC\r');
+    expect(snapshot.errors).toEqual(1);
+    expect(snapshot.sizeHistogram[2]).toEqual(1);
+    await expect(setTrafficInterval(-1)).rejects.toThrowError(
+      'Invalid traffic interval',
+    );
+    await close();
+  });
+
+  it('should send SET_SNAPLEN correctly on call to setSnapLength', async () => {
+    mockStatusEventFromBoard(0);
+    await connect();
+
+    mockStatusEventFromBoard(0);
+    await setSnapLength(6);
+    expect(writeToPortMock).toHaveBeenCalledWith('SET_SNAPLEN 6\r');
+    await expect(setSnapLength(65536)).rejects.toThrowError(
+      'Invalid snap length',
+    );
+    await close();
+  });
+
+  it('should send SET_USB_FLUSH and USB correctly', async () => {
+    mockStatusEventFromBoard(0);
+    await connect();
+    const dataHandlerFunc = openPortMock.mock.calls[0][0];
+
+    setTimeout(() => {
+      dataHandlerFunc('USB 2000 0 0 0 0 0 0');
+    }, 100);
+    const reset = await setUsbFlushDeadline(2000);
+    expect(writeToPortMock).toHaveBeenCalledWith('SET_USB_FLUSH 2000\r');
+    expect(reset.flushUs).toEqual(2000);
+
+    setTimeout(() => {
+      dataHandlerFunc('USB 2000 300 6400 100 99 1 0');
+    }, 100);
+    const usb = await readUsbStatus();
+    expect(writeToPortMock).toHaveBeenCalledWith('USB\r');
+    expect(usb.fillRatio).toEqual(1);
+    expect(usb.linesPerPacket).toEqual(3);
+    await expect(setUsbFlushDeadline(65536)).rejects.toThrowError(
+      'Invalid USB flush deadline',
+    );
+    await close();
+  });
+
+  it('should send SCAN and collect stations on call to scanNetwork', async () => {
+    mockStatusEventFromBoard(0);
+    await connect();
+
+    setTimeout(() => {
+      const dataHandlerFunc = openPortMock.mock.calls[0][0];
+      dataHandlerFunc('SCAN_STATION 100 0 01006003 530');
+      dataHandlerFunc('SCAN_STATION 254 0 01006003 512');
+      dataHandlerFunc('SCAN 253 2 2754459 OK');
+    }, 100);
+    const scan = await scanNetwork();
+    expect(writeToPortMock).toHaveBeenCalledWith('SCAN 1 254 10\r');
+    expect(scan.stations.map(s => s.station)).toEqual([100, 254]);
+    expect(scan.stations[0].versionMajor).toEqual(3);
+    expect(scan.summary.found).toEqual(2);
+    expect(scan.summary.result).toEqual('OK');
+    await expect(scanNetwork(10, 5)).rejects.toThrowError(
+      'Invalid station range',
+    );
+    await expect(scanNetwork(1, 254, 0)).rejects.toThrowError(
+      'Invalid scan timeout',
+    );
+    await close();
+  });
+
+  it('should decompress frame data before firing events', async () => {
+    const events: Array<EconetEvent> = [];
+    const eventHandler = (e: EconetEvent) => {
+      events.push(e);
+    };
+    addListener(eventHandler, [MonitorEvent]);
+
+    mockStatusEventFromBoard(0);
+    await connect();
+    const dataHandlerFunc = openPortMock.mock.calls[0][0];
+
+    // second frame refers back into the first
+    dataHandlerFunc('MONITOR ~AQCtAQD+AGhlbGxvIAYA');
+    dataHandlerFunc('MONITOR ~AAEGGwBQd29ybGQ=');
+
+    expect(events.length).toEqual(2);
+    const frame = (events[1] as MonitorEvent).econetFrame;
+    expect(frame.toString('latin1')).toEqual('\x01\x00\xfe\x00hello world');
+    expect(decompressorMetrics().frames).toEqual(2);
+
+    removeListener(eventHandler);
+    await close();
+  });
+
+  it('should match results to pipelined transmissions in order', async () => {
+    mockStatusEventFromBoard(0);
+    await connect();
+    const dataHandlerFunc = openPortMock.mock.calls[0][0];
+
+    const first = transmit(254, 0, 0x80, 0x99, Buffer.from('one'));
+    const second = transmit(254, 0, 0x80, 0x99, Buffer.from('two'));
+    await new Promise(resolve => setImmediate(resolve));
+
+    expect(writeToPortMock).toHaveBeenCalledWith('TX 254 0 128 153 b25l\r');
+    expect(writeToPortMock).toHaveBeenCalledWith('TX 254 0 128 153 dHdv\r');
+
+    dataHandlerFunc('TX_RESULT NO_SCOUT_ACK');
+    dataHandlerFunc('TX_RESULT OK');
+
+    expect((await first).description).toEqual('NO_SCOUT_ACK');
+    expect((await second).success).toEqual(true);
+    await expect(transmit(254, 0, 256, 0x99, Buffer.from('x'))).rejects.toThrow(
+      'Invalid control byte',
+    );
+
+    const third = transmit(254, 0, 0xff, 0x99, Buffer.from('x'));
+    await new Promise(resolve => setImmediate(resolve));
+    expect(writeToPortMock).toHaveBeenCalledWith('TX 254 0 255 153 eA==\r');
+    dataHandlerFunc('TX_RESULT OK');
+    expect((await third).success).toEqual(true);
+    await close();
+  });
+
+  it('should match results to replies pipelined with transmissions', async () => {
+    mockStatusEventFromBoard(0);
+    await connect();
+    const dataHandlerFunc = openPortMock.mock.calls[0][0];
+
+    const first = reply(7, 0x80, 0x90, Buffer.from('one'));
+    const second = transmit(254, 0, 0x80, 0x99, Buffer.from('two'));
+    await new Promise(resolve => setImmediate(resolve));
+
+    expect(writeToPortMock).toHaveBeenCalledWith('REPLY 7 128 144 b25l\r');
+
+    dataHandlerFunc('REPLY_RESULT INVALID_RECEIVE_ID');
+    dataHandlerFunc('TX_RESULT OK');
+
+    const firstResult = await first;
+    expect(firstResult).toBeInstanceOf(ReplyResultEvent);
+    expect(firstResult.description).toEqual('INVALID_RECEIVE_ID');
+    expect((await second).success).toEqual(true);
+    await expect(reply(65536, 0x80, 0x90, Buffer.from('x'))).rejects.toThrow(
+      'Invalid reply ID',
+    );
+    await expect(reply(7, 256, 0x90, Buffer.from('x'))).rejects.toThrow(
+      'Invalid control byte',
+    );
+
+    const third = reply(8, 0xff, 0x90, Buffer.from('x'));
+    await new Promise(resolve => setImmediate(resolve));
+    expect(writeToPortMock).toHaveBeenCalledWith('REPLY 8 255 144 eA==\r');
+    dataHandlerFunc('REPLY_RESULT OK');
+    expect((await third).success).toEqual(true);
+    await close();
+  });
+
+  it('should reject transmissions with non-integer parameters unsent', async () => {
+    mockStatusEventFromBoard(0);
+    await connect();
+    const data = Buffer.from('x');
+
+    await expect(transmit(1.5, 0, 0x80, 0x99, data)).rejects.toThrow(
+      'Invalid station number',
+    );
+    await expect(transmit(254, NaN, 0x80, 0x99, data)).rejects.toThrow(
+      'Invalid network number',
+    );
+    await expect(transmit(254, 0, 0.5, 0x99, data)).rejects.toThrow(
+      'Invalid control byte',
+    );
+    await expect(transmit(254, 0, 0x80, 99.9, data)).rejects.toThrow(
+      'Invalid port number',
+    );
+    await expect(reply(7.5, 0x80, 0x90, data)).rejects.toThrow(
+      'Invalid reply ID',
+    );
+    await expect(reply(7, 0x80, 0x90 + 0.1, data)).rejects.toThrow(
+      'Invalid port number',
+    );
+    const sent = writeToPortMock.mock.calls.map(call => call[0] as string);
+    expect(sent.filter(command => /^(TX|REPLY) /.test(command))).toEqual([]);
+    await close();
+  });
+
+  it('should match a result for an invalid transmission in its turn', async () => {
+    mockStatusEventFromBoard(0);
+    await connect();
+    const dataHandlerFunc = openPortMock.mock.calls[0][0];
+
+    const first = transmit(254, 0, 0x80, 0x99, Buffer.from('one'));
+    const second = transmit(254, 0, 0x80, 0x99, Buffer.from('two'));
+    await new Promise(resolve => setImmediate(resolve));
+
+    // the board couldn't parse the first, but still answers it before the second
+    dataHandlerFunc('TX_RESULT INVALID_COMMAND');
+    dataHandlerFunc('TX_RESULT OK');
+
+    expect((await first).description).toEqual('INVALID_COMMAND');
+    expect((await second).success).toEqual(true);
+    await close();
+  });
+
+  it('should send chunks of transmitBulk payload as pipelined transmissions', async () => {
+    mockStatusEventFromBoard(0);
+    await connect();
+    const dataHandlerFunc = openPortMock.mock.calls[0][0];
+
+    const result = transmitBulk(254, 0, 0x99, Buffer.from('onetwo'), {
+      chunkSize: 3,
+    });
+    await new Promise(resolve => setImmediate(resolve));
+
+    expect(writeToPortMock).toHaveBeenCalledWith('TX 254 0 128 153 b25l\r');
+    expect(writeToPortMock).toHaveBeenCalledWith('TX 254 0 128 153 dHdv\r');
+
+    dataHandlerFunc('TX_RESULT OK');
+    dataHandlerFunc('TX_RESULT OK');
+
+    const bulkResult = await result;
+    expect(bulkResult.success).toEqual(true);
+    expect(bulkResult.bytesSent).toEqual(6);
+    await close();
+  });
+
+  it('should fail pending transmissions on close', async () => {
+    mockStatusEventFromBoard(0);
+    await connect();
+
+    const pending = transmit(254, 0, 0x80, 0x99, Buffer.from('one'));
+    await close();
+
+    await expect(pending).rejects.toThrow(
+      'Connection closed whilst transmitting',
+    );
+  });
 });
 
 const mockStatusEventFromBoard = (rxMode: number) => {
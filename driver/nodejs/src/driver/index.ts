@@ -3,15 +3,44 @@ import { PKG_VERSION } from './version';
 import { StatusEvent } from '../types/statusEvent';
 import { EconetEvent } from '../types/econetEvent';
 import { TxResultEvent } from '../types/txResultEvent';
-import { parseStatusEvent } from '../parser/statusParser';
-import { parseMonitorEvent } from '../parser/monitorParser';
-import { parseErrorEvent } from '../parser/errorParser';
-import { parseRxImmediateEvent } from '../parser/rxImmediateParser';
-import { parseTxResultEvent } from '../parser/txResultParser';
-import { parseRxBroadcastEvent } from '../parser/rxBroadcastParser';
-import { drainAndClose, openPort, setDebug, writeToPort } from './serial';
+import { ReplyResultEvent } from '../types/replyResultEvent';
+import {
+  EventType,
+  eventName,
+  eventNamesFor,
+  parseEvent,
+} from '../parser/eventParser';
+import { MonitorEvent } from '../types/monitorEvent';
+import { CompressionEvent } from '../types/compressionEvent';
+import { DedupEvent } from '../types/dedupEvent';
+import { AdlcTraceEvent } from '../types/adlcTraceEvent';
+import { BenchEvent } from '../types/benchEvent';
+import { FlowEvent } from '../types/flowEvent';
+import { RecoveryEvent } from '../types/recoveryEvent';
+import { TrafficEvent } from '../types/trafficEvent';
+import { ScanEvent, ScanResult } from '../types/scanEvent';
+import { ScanStationEvent } from '../types/scanStationEvent';
+import { UsbEvent } from '../types/usbEvent';
+import {
+  drainAndClose,
+  openPort,
+  pauseInput,
+  resumeInput,
+  setDebug,
+  Transport,
+  writeToPort,
+} from './serial';
+import { MonitorStream, MonitorStreamOptions } from './monitorStream';
 import { areVersionsCompatible, parseSemver } from './semver';
-import { parseRxTransmitEvent } from '../parser/rxTransmitParser';
+import { Decompressor, DecompressorMetrics } from './decompressor';
+import { AunGateway, AunGatewayOptions } from './aunGateway';
+import {
+  BulkTransferOptions,
+  BulkTransferResult,
+  transmitBulk as runBulkTransfer,
+} from './bulkTransfer';
+import { RxTransmitEvent } from '../types/rxTransmitEvent';
+import { RxBroadcastEvent } from '../types/rxBroadcastEvent';
 
 enum ConnectionState {
   Disconnected = 'Disconnected',
@@ -33,25 +62,90 @@ export type Listener = (event: EconetEvent) => void;
  */
 export type EventMatcher = (event: EconetEvent) => boolean;
 
+/**
+ * Determines which event is discarded when an event arrives at a full {@link EventQueue}:
+ * the oldest queued event (`dropOldest`) or the newly arrived one (`dropNewest`).
+ */
+export type EventQueueOverflowPolicy = 'dropOldest' | 'dropNewest';
+
+/**
+ * Options for {@link eventQueueCreate}.
+ */
+export type EventQueueOptions = {
+  /**
+   * Maximum number of events held by the queue. Defaults to `config.eventQueueCapacity`.
+   */
+  capacity?: number;
+
+  /**
+   * What to do when an event arrives at a full queue. Defaults to `dropOldest`.
+   */
+  overflowPolicy?: EventQueueOverflowPolicy;
+};
+
+/**
+ * Options for {@link connect}.
+ */
+export type ConnectOptions = {
+  /**
+   * How to talk to the board. `serial` (the default) uses its USB serial ports. `bulk` uses its
+   * vendor bulk interface through libusb instead, avoiding the overhead of the host's serial
+   * line discipline; this needs the optional `usb` package and, on Linux, permission to access
+   * the board's USB device.
+   */
+  transport?: Transport;
+};
+
+type EventQueueWaiter = {
+  resolve: (event: EconetEvent) => void;
+  reject: (error: Error) => void;
+};
+
 /**
  * Holds an ordered set of events.
  */
 export type EventQueue = {
   events: Array<EconetEvent>;
   listener: Listener;
+  capacity: number;
+  overflowPolicy: EventQueueOverflowPolicy;
+
+  /**
+   * Number of events discarded because the queue was full.
+   */
+  droppedEvents: number;
+
+  /**
+   * Callers blocked in {@link eventQueueWait}, in order of arrival. An event is handed
+   * straight to the first of these rather than being queued.
+   */
+  waiters: Array<EventQueueWaiter>;
 };
 
-const parsers = [
-  parseStatusEvent,
-  parseErrorEvent,
-  parseMonitorEvent,
-  parseRxTransmitEvent,
-  parseRxImmediateEvent,
-  parseRxBroadcastEvent,
-  parseTxResultEvent,
-];
 let listeners: Array<Listener> = [];
+const listenerEventTypes = new Map<Listener, Array<EventType>>();
+let wantedEventNames: Set<string> | undefined;
 let state: ConnectionState = ConnectionState.Disconnected;
+const decompressor = new Decompressor();
+
+type PendingTransmit = {
+  resolve: (result: TxResultEvent) => void;
+  reject: (error: Error) => void;
+  timer?: NodeJS.Timeout;
+};
+
+const transmitTimeoutMs = 20000;
+const pendingTransmits = new Array<PendingTransmit>();
+
+// events which each cost the board a credit when flow control is enabled
+const creditedEventNames = new Set([
+  'MONITOR',
+  'RX_TRANSMIT',
+  'RX_IMMEDIATE',
+  'RX_BROADCAST',
+]);
+let flowWindow = 0;
+let creditsOwed = 0;
 
 /**
  * Connect the driver to the Piconet board.
@@ -61,7 +155,8 @@ let state: ConnectionState = ConnectionState.Disconnected;
  *
  * 1. Open a serial connection to the board. If `requestedDevice` is not specified then an attempt will be
  *    made to autodetect it. This step may fail if the board is not connected or another application is using
- *    it.
+ *    it. The board has two serial ports: one for commands and their results, and one for the frames it
+ *    receives, so that a flood of frames can't hold up results. Both are opened.
  * 2. The driver will then send a `STATUS` command to the board. This step may fail if the Raspberry Pi Pico
  *    has not been flashed with {@link https://github.com/jprayner/piconet/releases|the correct firmware}
  *    (.uf2 image).
@@ -71,11 +166,22 @@ let state: ConnectionState = ConnectionState.Disconnected;
  * After connecting, the board will be in the `STOP` operating mode. Remember to call {@link setMode} to
  * start it doing useful work.
  *
- * @param requestedDevice Optionally specifies the serial device for the Raspberry Pi Pico on the
- *                        Piconet board. If left undefined then an attempt will be made to automatically
- *                        detect it.
+ * @param requestedDevice     Optionally specifies the serial device for the Raspberry Pi Pico on the
+ *                            Piconet board (its first, control port). If left undefined then an attempt
+ *                            will be made to automatically detect both of the board's ports.
+ * @param requestedDataDevice Optionally specifies the serial device for the board's second, data port.
+ *                            If a `requestedDevice` is given without this, frames arrive on the control
+ *                            port instead.
+ * @param options             Optionally selects the bulk transport, with which neither port is opened:
+ *                            a `requestedDevice` is then taken to carry the bulk interface's stream, as
+ *                            the emulator's `--bulk-link` does, and the board is found through libusb
+ *                            if it isn't given.
  */
-export const connect = async (requestedDevice?: string): Promise<void> => {
+export const connect = async (
+  requestedDevice?: string,
+  requestedDataDevice?: string,
+  options: ConnectOptions = {},
+): Promise<void> => {
   if (
     state !== ConnectionState.Disconnected &&
     state !== ConnectionState.Error
@@ -84,8 +190,16 @@ export const connect = async (requestedDevice?: string): Promise<void> => {
   }
 
   state = ConnectionState.Connecting;
+  decompressor.reset();
+  flowWindow = 0;
+  creditsOwed = 0;
   try {
-    await openPort(handleData, requestedDevice);
+    await openPort(
+      handleData,
+      requestedDevice,
+      requestedDataDevice,
+      options.transport,
+    );
     const status = await readStatus();
 
     const firmwareVersionStr = status.firmwareVersion;
@@ -108,7 +222,7 @@ export const connect = async (requestedDevice?: string): Promise<void> => {
 /**
  * Puts the board into a new operating mode.
  *
- * The board can be in one of three operating modes:
+ * The board can be in one of four operating modes:
  *
  * * `STOP` - The board starts in this mode. No events are generated in response to network traffic,
  *        allowing the client to initialise configuration before proceeding.
@@ -121,10 +235,14 @@ export const connect = async (requestedDevice?: string): Promise<void> => {
  *        destination (promiscuous mode). Useful for capturing traffic between other stations like
  *        the BBC NETMON utility. A code example is provided for how to build such a utility.
  *
+ * * `TRAFFIC` - The board counts every frame received, as in `MONITOR` mode, but rather than an
+ *        event for each one it generates a periodic {@link TrafficEvent} summarising who talked to
+ *        whom and how busy the line was: see {@link setTrafficInterval}.
+ *
  * @param mode The new operating mode.
  */
 export const setMode = async (
-  mode: 'STOP' | 'MONITOR' | 'LISTEN',
+  mode: 'STOP' | 'MONITOR' | 'LISTEN' | 'TRAFFIC',
 ): Promise<void> => {
   if (state !== ConnectionState.Connected) {
     throw new Error(`Cannot set mode on device whilst in ${state} state`);
@@ -140,6 +258,9 @@ export const setMode = async (
     case 'LISTEN':
       await writeToPort('SET_MODE LISTEN\r');
       break;
+    case 'TRAFFIC':
+      await writeToPort('SET_MODE TRAFFIC\r');
+      break;
     default:
       throw new Error('Invalid mode');
   }
@@ -170,6 +291,524 @@ export const setEconetStation = async (station: number): Promise<void> => {
   await readStatus();
 };
 
+/**
+ * Asks the board to capture no more than the first `snapLength` bytes of each frame in `MONITOR`
+ * mode. The rest of each frame is still received and checked, and {@link MonitorEvent} reports
+ * its full length, but isn't sent to the driver, so the load on the USB link barely depends on
+ * the size of frames. Analysing traffic generally needs only the first few bytes: 4 of address
+ * and 2 of control byte and port in a scout.
+ *
+ * @param snapLength Bytes of each frame to capture (integer in range 0-65535), or `0` to capture
+ *                   frames in full, as after the board is reset.
+ */
+export const setSnapLength = async (snapLength: number): Promise<void> => {
+  if (state !== ConnectionState.Connected) {
+    throw new Error(
+      `Cannot set snap length on device whilst in ${state} state`,
+    );
+  }
+
+  if (!Number.isInteger(snapLength) || snapLength < 0 || snapLength > 65535) {
+    throw new Error('Invalid snap length');
+  }
+
+  await writeToPort(`SET_SNAPLEN ${snapLength}\r`);
+  await readStatus();
+};
+
+/**
+ * Asks the board to compress the data of received frames before sending it to the driver,
+ * which decompresses it transparently. This reduces the load on the USB link when monitoring
+ * a busy network, at the cost of some CPU time on the board (see {@link readCompressionStatus}).
+ *
+ * Compression is off after the board is reset.
+ *
+ * @param scheme `LZ` to enable compression or `NONE` to disable it.
+ * @returns The new compression status of the board.
+ */
+export const setCompression = async (
+  scheme: 'LZ' | 'NONE',
+): Promise<CompressionEvent> => {
+  if (state !== ConnectionState.Connected) {
+    throw new Error(
+      `Cannot set compression on device whilst in ${state} state`,
+    );
+  }
+
+  if (scheme !== 'LZ' && scheme !== 'NONE') {
+    throw new Error('Invalid compression scheme');
+  }
+
+  return requestCompressionStatus(`SET_COMPRESSION ${scheme}\r`);
+};
+
+/**
+ * Queries how effective compression has been since it was enabled with {@link setCompression}.
+ *
+ * @returns The compression status of the board.
+ */
+export const readCompressionStatus = async (): Promise<CompressionEvent> => {
+  if (state !== ConnectionState.Connected) {
+    throw new Error(
+      `Cannot read compression status from device whilst in ${state} state`,
+    );
+  }
+
+  return requestCompressionStatus('COMPRESSION\r');
+};
+
+// Sends a command and waits for the event the board reports in response, such as the status
+// of a feature after setting or querying it.
+const requestStatus = async <T extends EconetEvent>(
+  command: string,
+  eventClass: new (...args: never[]) => T,
+  description: string,
+  timeoutMs = 1000,
+): Promise<T> => {
+  const queue = eventQueueCreate(
+    event => event instanceof eventClass,
+    [eventClass],
+  );
+  try {
+    await writeToPort(command);
+    return (await eventQueueWait(queue, timeoutMs, description)) as T;
+  } finally {
+    eventQueueDestroy(queue);
+  }
+};
+
+const requestCompressionStatus = (command: string) =>
+  requestStatus(
+    command,
+    CompressionEvent,
+    'COMPRESSION response (firmware may not support compression)',
+  );
+
+/**
+ * Asks the board to suppress events for copies of a packet received within `windowMs`
+ * milliseconds of the first: retransmissions by a station which missed the board's ack, or
+ * broadcasts repeated by an over-eager station. Copies are still acknowledged on the wire.
+ *
+ * Packets are compared by source, port, control byte and data, so an application which
+ * legitimately receives identical packets in quick succession should keep the window short or
+ * leave suppression disabled, as it is after the board is reset.
+ *
+ * @param windowMs The suppression window in milliseconds (integer in range 0-65535), or `0` to
+ *                 disable suppression.
+ * @returns The new duplicate suppression status of the board, with its counters reset.
+ */
+export const setDuplicateSuppression = async (
+  windowMs: number,
+): Promise<DedupEvent> => {
+  if (state !== ConnectionState.Connected) {
+    throw new Error(
+      `Cannot set duplicate suppression on device whilst in ${state} state`,
+    );
+  }
+
+  if (!Number.isInteger(windowMs) || windowMs < 0 || windowMs > 65535) {
+    throw new Error('Invalid duplicate suppression window');
+  }
+
+  return requestDedupStatus(`SET_DEDUP ${windowMs}\r`);
+};
+
+/**
+ * Queries how many duplicate packets the board has suppressed since
+ * {@link setDuplicateSuppression} was last called.
+ *
+ * @returns The duplicate suppression status of the board.
+ */
+export const readDuplicateSuppressionStatus =
+  async (): Promise<DedupEvent> => {
+    if (state !== ConnectionState.Connected) {
+      throw new Error(
+        `Cannot read duplicate suppression status from device whilst in ${state} state`,
+      );
+    }
+
+    return requestDedupStatus('DEDUP\r');
+  };
+
+const requestDedupStatus = (command: string) =>
+  requestStatus(
+    command,
+    DedupEvent,
+    'DEDUP response (firmware may not support duplicate suppression)',
+  );
+
+/**
+ * Enables credit-based flow control, so that the board reports no more than `window` received
+ * frames (`MONITOR` and `RX_xxx` events) ahead of the driver handling them.
+ *
+ * The driver grants the board more credits as it passes events to listeners, so if the
+ * application falls behind (or pauses a {@link monitorStream}) the board stops acknowledging
+ * scouts rather than stalling part way through a handshake: senders see `NO_SCOUT_ACK` and may
+ * retry later, and broadcast or monitored frames are dropped. Either way, `WatermarkEvent`s warn
+ * when events back up on the board, and {@link readFlowStatus} counts the frames turned away.
+ *
+ * The board keeps this setting until it's changed, so call this again after reconnecting.
+ *
+ * @param window Maximum number of frames the board may report before being granted more
+ *               credits (integer in range 1-65535, inclusive), or `0` to disable flow control.
+ * @returns The flow control status of the board.
+ */
+export const setFlowControl = async (window: number): Promise<FlowEvent> => {
+  if (state !== ConnectionState.Connected) {
+    throw new Error(
+      `Cannot set flow control on device whilst in ${state} state`,
+    );
+  }
+
+  if (!Number.isInteger(window) || window < 0 || window > 65535) {
+    throw new Error('Invalid flow control window');
+  }
+
+  flowWindow = window;
+  creditsOwed = 0;
+  return requestFlowStatus(`SET_FLOW ${window}\r`);
+};
+
+/**
+ * Queries the state of flow control on the board, including the number of frames turned away
+ * since {@link setFlowControl} was last called.
+ *
+ * @returns The flow control status of the board.
+ */
+export const readFlowStatus = async (): Promise<FlowEvent> => {
+  if (state !== ConnectionState.Connected) {
+    throw new Error(
+      `Cannot read flow control status from device whilst in ${state} state`,
+    );
+  }
+
+  return requestFlowStatus('FLOW\r');
+};
+
+const requestFlowStatus = (command: string) =>
+  requestStatus(
+    command,
+    FlowEvent,
+    'FLOW response (firmware may not support flow control)',
+  );
+
+// Returns credits to the board in batches of half the window, once listeners have had the
+// events which used them.
+const returnCredit = (line: string) => {
+  if (flowWindow === 0 || !creditedEventNames.has(eventName(line))) {
+    return;
+  }
+
+  creditsOwed++;
+  if (creditsOwed >= Math.ceil(flowWindow / 2)) {
+    const credits = creditsOwed;
+    creditsOwed = 0;
+    writeToPort(`CREDIT ${credits}\r`).catch(() => {
+      // the connection is closing, so there's no board to credit
+    });
+  }
+};
+
+/**
+ * Starts or stops recording the board's ADLC bus transactions (with timings and the protocol
+ * phase to which they belong) for profiling the firmware. Starting discards any entries already
+ * recorded; stopping reports them. See {@link readAdlcTrace} and `summariseAdlcTrace`.
+ *
+ * @param enabled `true` to start recording or `false` to stop.
+ * @returns The trace recorded so far.
+ */
+export const setAdlcTrace = async (
+  enabled: boolean,
+): Promise<AdlcTraceEvent> => {
+  if (state !== ConnectionState.Connected) {
+    throw new Error(`Cannot set ADLC trace on device whilst in ${state} state`);
+  }
+
+  return requestAdlcTrace(`SET_TRACE ${enabled ? 1 : 0}\r`);
+};
+
+/**
+ * Reports the ADLC bus transactions recorded since {@link setAdlcTrace} was last called to
+ * start tracing. The board holds the most recent 1024 entries.
+ *
+ * @returns The trace recorded so far.
+ */
+export const readAdlcTrace = async (): Promise<AdlcTraceEvent> => {
+  if (state !== ConnectionState.Connected) {
+    throw new Error(
+      `Cannot read ADLC trace from device whilst in ${state} state`,
+    );
+  }
+
+  return requestAdlcTrace('TRACE\r');
+};
+
+const requestAdlcTrace = (command: string) =>
+  requestStatus(
+    command,
+    AdlcTraceEvent,
+    'TRACE response (firmware may not support ADLC tracing)',
+  );
+
+// the board gives up on a looped back frame after this long, bounding the length of a benchmark
+const benchFrameTimeoutMs = 100;
+
+/**
+ * Measures how quickly the firmware can move frames through the ADLC, free of the Econet line
+ * and of other stations. The board puts the ADLC into loop mode, so that its transmitter feeds
+ * its own receiver, and sends `frameCount` frames of `frameLength` bytes, checking each one as it
+ * comes back. Frames in flight when the benchmark starts are lost, and the board neither receives
+ * nor acknowledges frames from the line until it ends.
+ *
+ * Underruns or overruns mean the firmware couldn't keep up with the ADLC's clock, and
+ * `busCyclesPerByte` shows how many register reads and writes each byte cost.
+ *
+ * @param frameLength Number of bytes in each frame (integer in range 2-3500, inclusive).
+ * @param frameCount Number of frames to send (integer in range 1-65535, inclusive).
+ * @returns The outcome of the benchmark.
+ */
+export const runBenchmark = async (
+  frameLength: number,
+  frameCount: number,
+): Promise<BenchEvent> => {
+  if (state !== ConnectionState.Connected) {
+    throw new Error(`Cannot run benchmark on device whilst in ${state} state`);
+  }
+
+  if (
+    !Number.isInteger(frameLength) ||
+    frameLength < 2 ||
+    frameLength > config.maxTxDataLength + 4
+  ) {
+    throw new Error('Invalid benchmark frame length');
+  }
+
+  if (!Number.isInteger(frameCount) || frameCount < 1 || frameCount > 65535) {
+    throw new Error('Invalid benchmark frame count');
+  }
+
+  return requestStatus(
+    `BENCH ${frameLength} ${frameCount}\r`,
+    BenchEvent,
+    'BENCH response (firmware may not support benchmarking)',
+    1000 + frameCount * benchFrameTimeoutMs,
+  );
+};
+
+/**
+ * Brings the board's ADLC back to a working state, abandoning any frame in progress. The board
+ * resets the ADLC's transmitter and receiver, then if need be rewrites its control registers and
+ * finally pulses its reset line, stopping at the first which leaves it healthy; each takes
+ * microseconds. The board does the same by itself when it detects a stall (transmissions
+ * repeatedly failing with `LINE_JAMMED` or received data it can't discard).
+ *
+ * @returns Recovery counters, including the tier at which this recovery succeeded.
+ */
+export const recoverAdlc = async (): Promise<RecoveryEvent> => {
+  if (state !== ConnectionState.Connected) {
+    throw new Error(`Cannot recover ADLC on device whilst in ${state} state`);
+  }
+
+  return requestRecoveryStatus('RECOVER\r');
+};
+
+/**
+ * Queries how often and how quickly the board has recovered its ADLC, whether requested with
+ * {@link recoverAdlc}, on restart or because it detected a stall.
+ *
+ * @returns Recovery counters.
+ */
+export const readRecoveryStatus = async (): Promise<RecoveryEvent> => {
+  if (state !== ConnectionState.Connected) {
+    throw new Error(
+      `Cannot read recovery status from device whilst in ${state} state`,
+    );
+  }
+
+  return requestRecoveryStatus('RECOVERY\r');
+};
+
+const requestRecoveryStatus = (command: string) =>
+  requestStatus(
+    command,
+    RecoveryEvent,
+    'RECOVERY response (firmware may not support ADLC recovery)',
+  );
+
+/**
+ * Sets how often the board reports the traffic it has counted in `TRAFFIC` mode (see
+ * {@link setMode}). Each report covers the time since the last, so this also starts counting
+ * afresh. The interval is one second after the board is reset.
+ *
+ * @param intervalMs The reporting interval in milliseconds (integer in range 0-65535), or `0`
+ *                   to report only when asked with {@link readTraffic}.
+ * @returns The traffic counted up to now.
+ */
+export const setTrafficInterval = async (
+  intervalMs: number,
+): Promise<TrafficEvent> => {
+  if (state !== ConnectionState.Connected) {
+    throw new Error(
+      `Cannot set traffic interval on device whilst in ${state} state`,
+    );
+  }
+
+  if (!Number.isInteger(intervalMs) || intervalMs < 0 || intervalMs > 65535) {
+    throw new Error('Invalid traffic interval');
+  }
+
+  return requestTraffic(`SET_TRAFFIC ${intervalMs}\r`);
+};
+
+/**
+ * Asks the board to report the traffic it has counted in `TRAFFIC` mode (see {@link setMode})
+ * since its last report, then start counting afresh.
+ *
+ * @returns The traffic counted. This may be a periodic report which crossed with the request.
+ */
+export const readTraffic = async (): Promise<TrafficEvent> => {
+  if (state !== ConnectionState.Connected) {
+    throw new Error(`Cannot read traffic from device whilst in ${state} state`);
+  }
+
+  return requestTraffic('TRAFFIC\r');
+};
+
+const requestTraffic = (command: string) =>
+  requestStatus(
+    command,
+    TrafficEvent,
+    'TRAFFIC response (firmware may not support traffic counting)',
+  );
+
+// allowance per station for the scout and acknowledgement frames of a scan on top of its timeout
+const scanFrameTimeoutMs = 20;
+
+/**
+ * Finds the stations on the local network by having the board peek at the machine type of each
+ * in turn, far faster than transmitting an immediate operation to each from the host. A
+ * {@link ScanStationEvent} is fired for each station as it answers. The board's own station is
+ * skipped, and it handles no other traffic until the scan is done.
+ *
+ * @param firstStation First station to peek at (integer in range 1-254).
+ * @param lastStation  Last station to peek at (integer in range `firstStation`-254).
+ * @param timeoutMs    How long to wait for each station to answer (integer in range 1-65535).
+ *                     Stations answer within a millisecond or so, but absent ones take this
+ *                     long each.
+ * @returns The stations which answered and a summary of the scan.
+ */
+export const scanNetwork = async (
+  firstStation = 1,
+  lastStation = 254,
+  timeoutMs = 10,
+): Promise<ScanResult> => {
+  if (state !== ConnectionState.Connected) {
+    throw new Error(`Cannot scan network whilst in ${state} state`);
+  }
+
+  if (
+    !Number.isInteger(firstStation) ||
+    !Number.isInteger(lastStation) ||
+    firstStation < 1 ||
+    lastStation > 254 ||
+    firstStation > lastStation
+  ) {
+    throw new Error('Invalid station range');
+  }
+
+  if (!Number.isInteger(timeoutMs) || timeoutMs < 1 || timeoutMs > 65535) {
+    throw new Error('Invalid scan timeout');
+  }
+
+  const queue = eventQueueCreate(
+    event => event instanceof ScanStationEvent || event instanceof ScanEvent,
+    [ScanStationEvent, ScanEvent],
+    { capacity: lastStation - firstStation + 2 },
+  );
+  try {
+    await writeToPort(`SCAN ${firstStation} ${lastStation} ${timeoutMs}\r`);
+    const deadline =
+      Date.now() +
+      1000 +
+      (lastStation - firstStation + 1) * (timeoutMs + scanFrameTimeoutMs);
+    const stations = new Array<ScanStationEvent>();
+    while (true) {
+      const event = await eventQueueWait(
+        queue,
+        Math.max(deadline - Date.now(), 0),
+        'SCAN response (firmware may not support network scans)',
+      );
+      if (event instanceof ScanEvent) {
+        return { stations, summary: event };
+      }
+      stations.push(event as ScanStationEvent);
+    }
+  } finally {
+    eventQueueDestroy(queue);
+  }
+};
+
+/**
+ * Sets how long the board may hold back events for more to fill a USB packet. Sending whole
+ * packets rather than one per event lets the board deliver many more short events (such as
+ * `MONITOR` events with a small snap length, see {@link setSnapLength}) each second, at the cost
+ * of delaying them by up to this long. The results of commands are never held back.
+ *
+ * The deadline is 1000us after the board is reset.
+ *
+ * @param flushUs Longest time an event may wait for a packet to fill, in microseconds (integer
+ *                in range 0-65535), or `0` to send each event as soon as it's complete. The
+ *                board checks deadlines about once a millisecond.
+ * @returns The USB output counters of the board, which start afresh.
+ */
+export const setUsbFlushDeadline = async (
+  flushUs: number,
+): Promise<UsbEvent> => {
+  if (state !== ConnectionState.Connected) {
+    throw new Error(
+      `Cannot set USB flush deadline on device whilst in ${state} state`,
+    );
+  }
+
+  if (!Number.isInteger(flushUs) || flushUs < 0 || flushUs > 65535) {
+    throw new Error('Invalid USB flush deadline');
+  }
+
+  return requestUsbStatus(`SET_USB_FLUSH ${flushUs}\r`);
+};
+
+/**
+ * Queries how well the board has filled USB packets since {@link setUsbFlushDeadline} was last
+ * called.
+ *
+ * @returns The USB output counters of the board.
+ */
+export const readUsbStatus = async (): Promise<UsbEvent> => {
+  if (state !== ConnectionState.Connected) {
+    throw new Error(
+      `Cannot read USB status from device whilst in ${state} state`,
+    );
+  }
+
+  return requestUsbStatus('USB\r');
+};
+
+const requestUsbStatus = (command: string) =>
+  requestStatus(
+    command,
+    UsbEvent,
+    'USB response (firmware may not support USB output counters)',
+  );
+
+/**
+ * Returns counters describing the driver's decompression of frame data (see
+ * {@link setCompression}), including the number of frames discarded because an earlier one
+ * was lost.
+ */
+export const decompressorMetrics = (): DecompressorMetrics => {
+  return decompressor.metrics;
+};
+
 /**
  * Enables/disables driver debug logging. When enabled, shows the raw data passing between the driver
  * and the board.
@@ -191,6 +830,10 @@ export const setDebugEnabled = (enabled: boolean) => {
  * 3. The board sends a frame containing the payload `data` to the destination station.
  * 4. The receiver responds with a "data ack" frame confirming receipt of the data.
  *
+ * Several transmissions may be in progress at once: the board queues them and performs them in
+ * the order requested, so callers sending a series of packets needn't wait for each result before
+ * requesting the next.
+ *
  * @param station         Destination Econet station number (integer in range 1-254, inclusive).
  * @param network         Destination Econet network number (0 for local network; only use other
  *                        values if you have an appropriately configured Econet bridge).
@@ -216,19 +859,19 @@ export const transmit = async (
     throw new Error(`Cannot transmit data on device whilst in ${state} state`);
   }
 
-  if (station < 1 || station >= 255) {
+  if (!Number.isInteger(station) || station < 1 || station >= 255) {
     throw new Error('Invalid station number');
   }
 
-  if (network < 0 || network > 255) {
+  if (!Number.isInteger(network) || network < 0 || network > 255) {
     throw new Error('Invalid network number');
   }
 
-  if (controlByte < 0 || controlByte >= 255) {
+  if (!Number.isInteger(controlByte) || controlByte < 0 || controlByte > 255) {
     throw new Error('Invalid control byte');
   }
 
-  if (port < 0 || port > 255) {
+  if (!Number.isInteger(port) || port < 0 || port > 255) {
     throw new Error('Invalid port number');
   }
 
@@ -236,31 +879,205 @@ export const transmit = async (
     throw new Error('Data too long');
   }
 
-  const queue = eventQueueCreate(event => event instanceof TxResultEvent);
-  try {
-    if (typeof extraScoutData !== 'undefined') {
-      if (extraScoutData.length > config.maxScoutExtraDataLength) {
-        throw new Error('Extra scout data too long');
-      }
+  if (
+    typeof extraScoutData !== 'undefined' &&
+    extraScoutData.length > config.maxScoutExtraDataLength
+  ) {
+    throw new Error('Extra scout data too long');
+  }
 
-      await writeToPort(
-        `TX ${station} ${network} ${controlByte} ${port} ${data.toString(
+  const command =
+    typeof extraScoutData !== 'undefined'
+      ? `TX ${station} ${network} ${controlByte} ${port} ${data.toString(
           'base64',
-        )} ${extraScoutData.toString('base64')}\r`,
-      );
-    } else {
-      await writeToPort(
-        `TX ${station} ${network} ${controlByte} ${port} ${data.toString(
+        )} ${extraScoutData.toString('base64')}\r`
+      : `TX ${station} ${network} ${controlByte} ${port} ${data.toString(
           'base64',
-        )}\r`,
-      );
+        )}\r`;
+
+  return queueTransmit(command);
+};
+
+/**
+ * Sends a payload too large for a single `transmit` (more than `config.maxTxDataLength` bytes) as
+ * a series of packets to the same station and port.
+ *
+ * The payload is split into chunks of `options.chunkSize` bytes, of which up to `options.window`
+ * are queued at the board at once so that the line is kept busy rather than waiting a serial
+ * round trip for each result. Failed chunks are retransmitted, lowest index first, up to
+ * `options.maxRetries` times each. Chunks may therefore reach the receiver out of order following
+ * a failure unless the window is `1`.
+ *
+ * ```
+ * const result = await driver.transmitBulk(254, 0, 0x99, fileData, { window: 4 });
+ * console.log(`${result.bytesPerSecond.toFixed(0)} bytes/s`);
+ * ```
+ *
+ * @param station Destination Econet station number (integer in range 1-254, inclusive).
+ * @param network Destination Econet network number (0 for local network).
+ * @param port    Econet port number (integer in range 0-255, inclusive).
+ * @param data    Buffer containing binary payload data to send.
+ * @param options Optionally specifies the control byte, chunk size, window and retry policy.
+ *
+ * @returns Describes the result of the transfer, including its throughput and the latency of
+ *          each chunk. If a chunk could not be sent then `success` is `false` and `failedChunk`
+ *          identifies it.
+ */
+export const transmitBulk = async (
+  station: number,
+  network: number,
+  port: number,
+  data: Buffer,
+  options?: BulkTransferOptions,
+): Promise<BulkTransferResult> => {
+  if (state !== ConnectionState.Connected) {
+    throw new Error(`Cannot transmit data on device whilst in ${state} state`);
+  }
+
+  if (!Number.isInteger(station) || station < 1 || station >= 255) {
+    throw new Error('Invalid station number');
+  }
+
+  if (!Number.isInteger(network) || network < 0 || network > 255) {
+    throw new Error('Invalid network number');
+  }
+
+  if (!Number.isInteger(port) || port < 0 || port > 255) {
+    throw new Error('Invalid port number');
+  }
+
+  return runBulkTransfer(
+    {
+      transmit: (station, network, controlByte, port, data) =>
+        transmit(station, network, controlByte, port, data),
+    },
+    station,
+    network,
+    port,
+    data,
+    options,
+  );
+};
+
+/**
+ * Answers a packet received in an `RxTransmitEvent`, sending a packet back to the station (and
+ * network) which sent it. Unlike `transmit`, the destination needn't be tracked by the caller, so
+ * a server may answer several clients in whatever order it completes their requests.
+ *
+ * The board remembers the sender of each of the last 8 packets received for up to 2 seconds;
+ * replying to a packet outside this window fails with `INVALID_RECEIVE_ID`, as does replying to
+ * the same packet twice.
+ *
+ * @param replyId     The `replyId` of the received `RxTransmitEvent`.
+ * @param controlByte Econet control byte (integer in range 0-255, inclusive).
+ * @param port        Econet port number (integer in range 0-255, inclusive).
+ * @param data        Buffer containing binary payload data to send.
+ *
+ * @returns A `ReplyResultEvent` describing the result of the operation as for `transmit`.
+ */
+export const reply = async (
+  replyId: number,
+  controlByte: number,
+  port: number,
+  data: Buffer,
+): Promise<ReplyResultEvent> => {
+  if (state !== ConnectionState.Connected) {
+    throw new Error(`Cannot reply on device whilst in ${state} state`);
+  }
+
+  if (!Number.isInteger(replyId) || replyId < 0 || replyId > 65535) {
+    throw new Error('Invalid reply ID');
+  }
+
+  if (!Number.isInteger(controlByte) || controlByte < 0 || controlByte > 255) {
+    throw new Error('Invalid control byte');
+  }
+
+  if (!Number.isInteger(port) || port < 0 || port > 255) {
+    throw new Error('Invalid port number');
+  }
+
+  if (data.length > config.maxTxDataLength) {
+    throw new Error('Data too long');
+  }
+
+  // the board answers a REPLY with a REPLY_RESULT, which parses to a ReplyResultEvent
+  return (await queueTransmit(
+    `REPLY ${replyId} ${controlByte} ${port} ${data.toString('base64')}\r`,
+  )) as ReplyResultEvent;
+};
+
+// The board buffers commands whilst busy and answers each TX (or REPLY) with a TX_RESULT (or
+// REPLY_RESULT) in the order received, even one it couldn't parse (with INVALID_COMMAND), so
+// results are matched to transmissions first-in, first-out. This lets callers pipeline
+// transmissions (e.g. the AUN gateway) rather than waiting a serial round trip for each one.
+const queueTransmit = (command: string): Promise<TxResultEvent> => {
+  return new Promise((resolve, reject) => {
+    const pending: PendingTransmit = { resolve, reject };
+    if (pendingTransmits.length === 0) {
+      addListener(transmitResultListener, [TxResultEvent]);
+    }
+    pendingTransmits.push(pending);
+    if (pendingTransmits.length === 1) {
+      startTransmitTimer();
     }
 
-    const result = await eventQueueWait(queue, 20000, 'TxResultEvent');
-    return result as TxResultEvent;
-  } finally {
-    eventQueueDestroy(queue);
+    writeToPort(command).catch((e: Error) => {
+      // never reached the board, so there's no result to wait for
+      const index = pendingTransmits.indexOf(pending);
+      if (index !== -1) {
+        pendingTransmits.splice(index, 1);
+        if (index === 0) {
+          clearTimeout(pending.timer);
+          startTransmitTimer();
+        }
+        if (pendingTransmits.length === 0) {
+          removeListener(transmitResultListener);
+        }
+      }
+      reject(e);
+    });
+  });
+};
+
+const transmitResultListener = (event: EconetEvent) => {
+  const pending = pendingTransmits.shift();
+  if (!pending) {
+    return;
+  }
+
+  clearTimeout(pending.timer);
+  if (pendingTransmits.length === 0) {
+    removeListener(transmitResultListener);
+  } else {
+    startTransmitTimer();
   }
+  pending.resolve(event as TxResultEvent);
+};
+
+// times the transmission at the head of the queue, which is the one the board is working on
+const startTransmitTimer = () => {
+  const head = pendingTransmits[0];
+  if (!head) {
+    return;
+  }
+
+  head.timer = setTimeout(() => {
+    // the pairing of later results with transmissions can no longer be trusted
+    failPendingTransmits(
+      new Error(
+        `Timed out after ${transmitTimeoutMs}ms waiting for TxResultEvent`,
+      ),
+    );
+  }, transmitTimeoutMs);
+};
+
+const failPendingTransmits = (error: Error) => {
+  removeListener(transmitResultListener);
+  pendingTransmits.splice(0).forEach(pending => {
+    clearTimeout(pending.timer);
+    pending.reject(error);
+  });
 };
 
 /**
@@ -270,6 +1087,7 @@ export const close = async (): Promise<void> => {
   if (state !== ConnectionState.Connected) {
     throw new Error(`Cannot close device whilst in ${state} state`);
   }
+  failPendingTransmits(new Error('Connection closed whilst transmitting'));
   await drainAndClose();
   state = ConnectionState.Disconnected;
 };
@@ -277,11 +1095,28 @@ export const close = async (): Promise<void> => {
 /**
  * Adds a new listener for events generated by the board.
  *
- * @param listener The listener to add.
+ * Listeners are called synchronously, one after another in the order they were added, as each
+ * event arrives. An exception thrown by one doesn't stop delivery to the others, but one which
+ * is slow to return delays every listener after it, including those completing `transmit` calls
+ * and filling event queues; slow work should be handed on (e.g. to an {@link EventQueue}) rather
+ * than done in the listener.
+ *
+ * @param listener   The listener to add.
+ * @param eventTypes Optionally restricts the listener to events of the specified types (or their
+ *                   subclasses) e.g. `[MonitorEvent]`. Lines from the board are only decoded if
+ *                   some listener is interested in them, so specifying this reduces CPU load
+ *                   when the board is busy.
  */
-export const addListener = (listener: Listener) => {
+export const addListener = (
+  listener: Listener,
+  eventTypes?: Array<EventType>,
+) => {
   if (!listeners.find(l => l === listener)) {
     listeners.push(listener);
+    if (eventTypes) {
+      listenerEventTypes.set(listener, eventTypes);
+    }
+    updateWantedEventNames();
   }
 };
 
@@ -292,10 +1127,45 @@ export const addListener = (listener: Listener) => {
  */
 export const removeListener = (listener: Listener) => {
   listeners = listeners.filter(l => l !== listener);
+  listenerEventTypes.delete(listener);
+  updateWantedEventNames();
+};
+
+const updateWantedEventNames = () => {
+  if (listeners.some(listener => !listenerEventTypes.has(listener))) {
+    wantedEventNames = undefined;
+    return;
+  }
+
+  wantedEventNames = new Set(
+    listeners.flatMap(listener =>
+      eventNamesFor(listenerEventTypes.get(listener) ?? []),
+    ),
+  );
+};
+
+const isWantedBy = (listener: Listener, event: EconetEvent) => {
+  const eventTypes = listenerEventTypes.get(listener);
+  return (
+    !eventTypes || eventTypes.some(eventType => event instanceof eventType)
+  );
 };
 
+// synchronous and in order of registration, so a slow listener delays those after it (see
+// addListener)
 const fireListeners = (event: EconetEvent) => {
-  listeners.forEach(listener => listener(event));
+  listeners.forEach(listener => {
+    if (!isWantedBy(listener, event)) {
+      return;
+    }
+
+    try {
+      listener(event);
+    } catch (e) {
+      // a misbehaving listener mustn't prevent delivery to the others
+      console.error(`Listener failed to handle ${event.constructor.name}`, e);
+    }
+  });
 };
 
 /**
@@ -342,42 +1212,77 @@ export const waitForEvent = async (
  * Creates an event queue to store all events matching the specified criteria, ready for
  * collection at the caller's convenience.
  *
+ * The queue holds at most `options.capacity` events. When it is full, the event chosen by
+ * `options.overflowPolicy` is discarded and counted in the queue's `droppedEvents` field, so a
+ * stalled consumer cannot consume unbounded memory.
+ *
  * The queue should be destroyed using {@link eventQueueDestroy} when it is no longer needed
  * to avoid consuming memory unnecessarily.
  *
- * @param matcher Specifies which events should be stored in the queue.
+ * @param matcher    Specifies which events should be stored in the queue.
+ * @param eventTypes Optionally restricts the queue to events of the specified types. See
+ *                   {@link addListener}.
+ * @param options    Optionally specifies the capacity and overflow policy of the queue.
  * @returns A queue object which can be passed to the other `eventQueueXXX` functions.
  */
-export const eventQueueCreate = (matcher: EventMatcher): EventQueue => {
-  const events = new Array<EconetEvent>();
-  const listener = (event: EconetEvent) => {
-    if (!matcher(event)) {
-      return;
-    }
-    events.push(event);
+export const eventQueueCreate = (
+  matcher: EventMatcher,
+  eventTypes?: Array<EventType>,
+  options?: EventQueueOptions,
+): EventQueue => {
+  const queue: EventQueue = {
+    events: new Array<EconetEvent>(),
+    listener: (event: EconetEvent) => {
+      if (!matcher(event)) {
+        return;
+      }
+      eventQueuePush(queue, event);
+    },
+    capacity: options?.capacity ?? config.eventQueueCapacity,
+    overflowPolicy: options?.overflowPolicy ?? 'dropOldest',
+    droppedEvents: 0,
+    waiters: [],
   };
-  addListener(listener);
+  addListener(queue.listener, eventTypes);
 
-  return {
-    events,
-    listener,
-  };
+  return queue;
+};
+
+const eventQueuePush = (queue: EventQueue, event: EconetEvent) => {
+  const waiter = queue.waiters.shift();
+  if (waiter) {
+    waiter.resolve(event);
+    return;
+  }
+
+  if (queue.events.length >= queue.capacity) {
+    queue.droppedEvents++;
+    if (queue.overflowPolicy === 'dropNewest') {
+      return;
+    }
+    queue.events.shift();
+  }
+  queue.events.push(event);
 };
 
 /**
  * Removes all events from queue and removes listener, preventing new events from being added.
+ * Any calls to {@link eventQueueWait} still waiting on the queue are rejected.
  *
  * @param queue The queue to destroy.
  */
 export const eventQueueDestroy = (queue: EventQueue) => {
   removeListener(queue.listener);
   queue.events.splice(0);
+  const error = new Error('Event queue destroyed whilst waiting for event');
+  queue.waiters.splice(0).forEach(waiter => waiter.reject(error));
 };
 
 /**
  * Waits for a matching event with a timeout, removing it from the queue.
  *
- * If no matching event is found within the specified timeout then an error is thrown.
+ * The returned promise resolves as soon as a matching event arrives. If no matching event is
+ * found within the specified timeout then an error is thrown.
  *
  * @param queue       The queue to wait on.
  * @param timeoutMs   Maximum time to wait for a matching event in milliseconds.
@@ -389,20 +1294,36 @@ export const eventQueueWait = async (
   timeoutMs: number,
   description?: string,
 ): Promise<EconetEvent> => {
-  const startTime = Date.now();
-  while (Date.now() - startTime < timeoutMs) {
-    const event = queue.events.shift();
-    if (event) {
-      return event;
-    }
-    await sleepMs(10);
+  const queuedEvent = queue.events.shift();
+  if (queuedEvent) {
+    return queuedEvent;
   }
 
-  throw new Error(
-    description
-      ? `Timed out after ${timeoutMs}ms waiting for ${description}`
-      : `No matching event found within ${timeoutMs}ms`,
-  );
+  return new Promise((resolve, reject) => {
+    const waiter: EventQueueWaiter = {
+      resolve: (event: EconetEvent) => {
+        clearTimeout(timer);
+        resolve(event);
+      },
+      reject: (error: Error) => {
+        clearTimeout(timer);
+        reject(error);
+      },
+    };
+
+    const timer = setTimeout(() => {
+      queue.waiters = queue.waiters.filter(w => w !== waiter);
+      reject(
+        new Error(
+          description
+            ? `Timed out after ${timeoutMs}ms waiting for ${description}`
+            : `No matching event found within ${timeoutMs}ms`,
+        ),
+      );
+    }, timeoutMs);
+
+    queue.waiters.push(waiter);
+  });
 };
 
 /**
@@ -414,6 +1335,79 @@ export const eventQueueShift = (queue: EventQueue): EconetEvent | undefined => {
   return queue.events.shift();
 };
 
+/**
+ * Creates a stream of the `MonitorEvent`s generated whilst the board is in `MONITOR` mode, for
+ * consumption with `for await` (which yields batches of events) or as an object mode `Readable`
+ * (see {@link MonitorStream.toReadable}).
+ *
+ * Unlike a listener, the stream applies backpressure: when the consumer falls behind and the
+ * number of buffered events reaches `options.highWaterMark`, the driver stops reading from the
+ * board until the consumer catches up. Note that all events from the board are held up whilst
+ * input is paused, so consumers should keep up if other operations are in progress.
+ *
+ * ```
+ * const stream = driver.monitorStream();
+ * for await (const batch of stream) {
+ *   await writeToCapture(batch);
+ * }
+ * ```
+ *
+ * @param options Optionally specifies the high/low-water marks and batch size of the stream.
+ * @returns The stream, which should be closed with `close()` (or by breaking out of the
+ *          `for await` loop) when no longer needed.
+ */
+export const monitorStream = (
+  options?: MonitorStreamOptions,
+): MonitorStream => {
+  const listener = (event: EconetEvent) => {
+    if (event instanceof MonitorEvent) {
+      stream.push(event);
+    }
+  };
+  const stream: MonitorStream = new MonitorStream(
+    {
+      pause: () => pauseInput(stream),
+      resume: () => resumeInput(stream),
+      detach: () => removeListener(listener),
+    },
+    options,
+  );
+  addListener(listener, [MonitorEvent]);
+
+  return stream;
+};
+
+/**
+ * Creates a gateway between the Econet and AUN (Econet over UDP) hosts such as emulated or
+ * networked Acorn machines. See {@link AunGateway} for how packets are routed.
+ *
+ * The board should be put into `LISTEN` mode so that packets from Econet stations are passed to
+ * the gateway.
+ *
+ * ```
+ * const gateway = driver.aunGateway({
+ *   stations: [{ station: 254, port: 32768, address: '192.168.0.10' }],
+ *   defaultRoute: { host: '192.168.0.20', port: 32768 },
+ * });
+ * await gateway.start();
+ * ```
+ *
+ * @param options Specifies the Econet stations to expose to AUN and how to reach AUN hosts.
+ * @returns The gateway, which must be started with `start()`.
+ */
+export const aunGateway = (options: AunGatewayOptions): AunGateway => {
+  return new AunGateway(
+    {
+      transmit: (station, network, controlByte, port, data) =>
+        transmit(station, network, controlByte, port, data),
+      addListener: listener =>
+        addListener(listener, [RxTransmitEvent, RxBroadcastEvent]),
+      removeListener: listener => removeListener(listener),
+    },
+    options,
+  );
+};
+
 /**
  * Queries the current status of the board.
  *
@@ -427,14 +1421,7 @@ export const readStatus = async (): Promise<StatusEvent> => {
     throw new Error(`Cannot read status from device whilst in ${state} state`);
   }
 
-  const queue = eventQueueCreate(event => event instanceof StatusEvent);
-  try {
-    await writeToPort('STATUS\r');
-    const result = await eventQueueWait(queue, 1000, 'STATUS response');
-    return result as StatusEvent;
-  } finally {
-    eventQueueDestroy(queue);
-  }
+  return requestStatus('STATUS\r', StatusEvent, 'STATUS response');
 };
 
 const handleData = (data: string) => {
@@ -445,12 +1432,15 @@ const handleData = (data: string) => {
     return;
   }
 
-  parsers.forEach(parser => {
-    const event = parser(data);
-    if (event) {
-      fireListeners(event);
-    }
-  });
-};
+  // must see every line, wanted or not, to keep its history in step with the board
+  const line = decompressor.expandLine(data);
+  if (line === undefined) {
+    return;
+  }
 
-const sleepMs = (ms: number) => new Promise(resolve => setTimeout(resolve, ms));
+  const event = parseEvent(line, wantedEventNames);
+  if (event) {
+    fireListeners(event);
+  }
+  returnCredit(line);
+};
@@ -0,0 +1,120 @@
+import { Writable } from 'stream';
+import { MonitorEvent } from '../types/monitorEvent';
+import { MonitorStream } from './monitorStream';
+
+const createSource = () => ({
+  pause: jest.fn(),
+  resume: jest.fn(),
+  detach: jest.fn(),
+});
+
+const monitorEvent = (n: number) => new MonitorEvent(Buffer.from([n]));
+
+describe('monitor stream', () => {
+  it('should yield buffered events in batches', async () => {
+    const stream = new MonitorStream(createSource(), { maxBatchSize: 2 });
+    stream.push(monitorEvent(1));
+    stream.push(monitorEvent(2));
+    stream.push(monitorEvent(3));
+
+    const batch1 = await stream.nextBatch();
+    const batch2 = await stream.nextBatch();
+
+    expect(batch1.map(e => e.econetFrame[0])).toEqual([1, 2]);
+    expect(batch2.map(e => e.econetFrame[0])).toEqual([3]);
+    expect(stream.metrics.deliveredEvents).toEqual(3);
+  });
+
+  it('should wake a waiting consumer when an event arrives', async () => {
+    const stream = new MonitorStream(createSource());
+    const pending = stream.nextBatch();
+    stream.push(monitorEvent(1));
+
+    const batch = await pending;
+    expect(batch.length).toEqual(1);
+  });
+
+  it('should pause source at high-water mark and resume at low-water mark', async () => {
+    const source = createSource();
+    const stream = new MonitorStream(source, {
+      highWaterMark: 4,
+      lowWaterMark: 1,
+      maxBatchSize: 2,
+    });
+
+    for (let i = 0; i < 4; i++) {
+      stream.push(monitorEvent(i));
+    }
+    expect(source.pause).toHaveBeenCalledTimes(1);
+    expect(stream.metrics.pauseCount).toEqual(1);
+
+    await stream.nextBatch();
+    expect(source.resume).not.toHaveBeenCalled();
+
+    await stream.nextBatch();
+    expect(source.resume).toHaveBeenCalledTimes(1);
+  });
+
+  it('should drop events arriving when buffer is full', () => {
+    const stream = new MonitorStream(createSource(), {
+      highWaterMark: 2,
+      capacity: 3,
+    });
+
+    for (let i = 0; i < 5; i++) {
+      stream.push(monitorEvent(i));
+    }
+
+    expect(stream.metrics.receivedEvents).toEqual(5);
+    expect(stream.metrics.bufferedEvents).toEqual(3);
+    expect(stream.metrics.droppedEvents).toEqual(2);
+  });
+
+  it('should be iterable with for await and close when loop exits', async () => {
+    const source = createSource();
+    const stream = new MonitorStream(source);
+    stream.push(monitorEvent(1));
+    stream.push(monitorEvent(2));
+
+    const received: Array<number> = [];
+    for await (const batch of stream) {
+      batch.forEach(e => received.push(e.econetFrame[0]));
+      break;
+    }
+
+    expect(received).toEqual([1, 2]);
+    expect(source.detach).toHaveBeenCalled();
+  });
+
+  it('should resolve waiting consumer with empty batch on close', async () => {
+    const stream = new MonitorStream(createSource());
+    const pending = stream.nextBatch();
+    stream.close();
+
+    await expect(pending).resolves.toEqual([]);
+  });
+
+  it('should emit individual events from object mode readable', async () => {
+    const stream = new MonitorStream(createSource());
+    const received: Array<number> = [];
+    const sink = new Writable({
+      objectMode: true,
+      write: (event: MonitorEvent, _encoding, callback) => {
+        received.push(event.econetFrame[0]);
+        if (received.length === 3) {
+          stream.close();
+        }
+        callback();
+      },
+    });
+
+    const finished = new Promise(resolve => sink.on('finish', resolve));
+    stream.toReadable().pipe(sink);
+    stream.push(monitorEvent(1));
+    stream.push(monitorEvent(2));
+    stream.push(monitorEvent(3));
+    await finished;
+
+    expect(received).toEqual([1, 2, 3]);
+  });
+});
@@ -0,0 +1,255 @@
+import { Readable } from 'stream';
+import { MonitorEvent } from '../types/monitorEvent';
+
+/**
+ * Options for {@link monitorStream}.
+ */
+export type MonitorStreamOptions = {
+  /**
+   * Number of buffered events at which input from the board is paused. Defaults to `1000`.
+   */
+  highWaterMark?: number;
+
+  /**
+   * Number of buffered events at which input from the board is resumed after having been
+   * paused. Defaults to a quarter of `highWaterMark`.
+   */
+  lowWaterMark?: number;
+
+  /**
+   * Maximum number of events buffered. Events arriving whilst the buffer is full (for example,
+   * those already in flight when input was paused) are dropped. Defaults to twice
+   * `highWaterMark`.
+   */
+  capacity?: number;
+
+  /**
+   * Maximum number of events returned by each iteration. Defaults to `256`.
+   */
+  maxBatchSize?: number;
+};
+
+/**
+ * Counters describing how well the consumer of a {@link MonitorStream} is keeping up.
+ */
+export type MonitorStreamMetrics = {
+  /**
+   * Total number of events received from the board.
+   */
+  receivedEvents: number;
+
+  /**
+   * Total number of events handed to the consumer.
+   */
+  deliveredEvents: number;
+
+  /**
+   * Total number of events dropped because the buffer was full.
+   */
+  droppedEvents: number;
+
+  /**
+   * Number of events currently buffered, awaiting the consumer.
+   */
+  bufferedEvents: number;
+
+  /**
+   * Number of times input from the board has been paused because the buffer reached its
+   * high-water mark.
+   */
+  pauseCount: number;
+
+  /**
+   * Age in milliseconds of the oldest buffered event, or zero if none are buffered.
+   */
+  lagMs: number;
+
+  /**
+   * Greatest age in milliseconds of any event when it was handed to the consumer.
+   */
+  maxLagMs: number;
+};
+
+/**
+ * Means by which a {@link MonitorStream} applies backpressure to its source and detaches from
+ * it when closed.
+ */
+export type MonitorStreamSource = {
+  pause: () => void;
+  resume: () => void;
+  detach: () => void;
+};
+
+type BufferedEvent = {
+  event: MonitorEvent;
+  receivedAt: number;
+};
+
+/**
+ * A stream of `MonitorEvent`s with flow control, created by {@link monitorStream}.
+ *
+ * Iterating the stream with `for await` yields arrays of the events received since the previous
+ * iteration. If the consumer falls behind and the number of buffered events reaches the
+ * high-water mark, input from the board is paused until the consumer catches up so that memory
+ * use stays constant however long the capture runs.
+ */
+export class MonitorStream implements AsyncIterable<Array<MonitorEvent>> {
+  private readonly highWaterMark: number;
+
+  private readonly lowWaterMark: number;
+
+  private readonly capacity: number;
+
+  private readonly maxBatchSize: number;
+
+  private buffer = new Array<BufferedEvent>();
+
+  private wakers = new Array<() => void>();
+
+  private paused = false;
+
+  private closed = false;
+
+  private counters = {
+    receivedEvents: 0,
+    deliveredEvents: 0,
+    droppedEvents: 0,
+    pauseCount: 0,
+    maxLagMs: 0,
+  };
+
+  constructor(
+    private readonly source: MonitorStreamSource,
+    options?: MonitorStreamOptions,
+  ) {
+    this.highWaterMark = options?.highWaterMark ?? 1000;
+    this.lowWaterMark =
+      options?.lowWaterMark ?? Math.floor(this.highWaterMark / 4);
+    this.capacity = options?.capacity ?? this.highWaterMark * 2;
+    this.maxBatchSize = options?.maxBatchSize ?? 256;
+  }
+
+  /**
+   * Adds an event received from the board to the stream.
+   */
+  public push(event: MonitorEvent) {
+    if (this.closed) {
+      return;
+    }
+
+    this.counters.receivedEvents++;
+    if (this.buffer.length >= this.capacity) {
+      this.counters.droppedEvents++;
+      return;
+    }
+
+    this.buffer.push({ event, receivedAt: Date.now() });
+    if (!this.paused && this.buffer.length >= this.highWaterMark) {
+      this.paused = true;
+      this.counters.pauseCount++;
+      this.source.pause();
+    }
+
+    this.wakeConsumer();
+  }
+
+  /**
+   * Waits for the next batch of events. Resolves to an empty array once the stream is closed.
+   */
+  public async nextBatch(): Promise<Array<MonitorEvent>> {
+    while (this.buffer.length === 0) {
+      if (this.closed) {
+        return [];
+      }
+      await new Promise<void>(resolve => {
+        this.wakers.push(resolve);
+      });
+    }
+
+    const now = Date.now();
+    const batch = this.buffer.splice(0, this.maxBatchSize);
+    this.counters.deliveredEvents += batch.length;
+    this.counters.maxLagMs = Math.max(
+      this.counters.maxLagMs,
+      now - batch[0].receivedAt,
+    );
+
+    if (this.paused && this.buffer.length <= this.lowWaterMark) {
+      this.paused = false;
+      this.source.resume();
+    }
+
+    return batch.map(bufferedEvent => bufferedEvent.event);
+  }
+
+  /**
+   * Stops receiving events, resuming input from the board if it was paused. Any batch being
+   * waited upon resolves to an empty array.
+   */
+  public close() {
+    if (this.closed) {
+      return;
+    }
+
+    this.closed = true;
+    this.buffer.splice(0);
+    this.source.detach();
+    if (this.paused) {
+      this.paused = false;
+      this.source.resume();
+    }
+    this.wakeConsumer();
+  }
+
+  /**
+   * Current flow control counters for the stream.
+   */
+  public get metrics(): MonitorStreamMetrics {
+    return {
+      ...this.counters,
+      bufferedEvents: this.buffer.length,
+      lagMs:
+        this.buffer.length > 0 ? Date.now() - this.buffer[0].receivedAt : 0,
+    };
+  }
+
+  public async *[Symbol.asyncIterator](): AsyncIterator<Array<MonitorEvent>> {
+    try {
+      while (!this.closed) {
+        const batch = await this.nextBatch();
+        if (batch.length > 0) {
+          yield batch;
+        }
+      }
+    } finally {
+      this.close();
+    }
+  }
+
+  /**
+   * Wraps the stream in an object mode `Readable` which emits individual `MonitorEvent`s. The
+   * readable only pulls events as fast as it is read, so piping it to a slow destination
+   * applies backpressure all the way to the board.
+   */
+  public toReadable(): Readable {
+    const batches = this[Symbol.asyncIterator]();
+    const readable = Readable.from(
+      (async function* events() {
+        for (;;) {
+          const result = await batches.next();
+          if (result.done) {
+            return;
+          }
+          yield* result.value;
+        }
+      })(),
+      { objectMode: true },
+    );
+    readable.once('close', () => this.close());
+    return readable;
+  }
+
+  private wakeConsumer() {
+    this.wakers.splice(0).forEach(wake => wake());
+  }
+}
@@ -1,44 +1,219 @@
 import { autoDetect } from '@serialport/bindings-cpp';
 import { SerialPort } from 'serialport';
 import { ReadlineParser } from '@serialport/parser-readline';
+import { BulkRecordDecoder } from './bulkRecords';
+import { BulkPort, openUsbBulk } from './usbBulk';
 
 export type DataListener = (data: string) => void;
+
+/**
+ * How the driver talks to the board: over its serial ports (`serial`), or over its vendor bulk
+ * interface through libusb (`bulk`), which avoids the host's serial line discipline.
+ */
+export type Transport = 'serial' | 'bulk';
+
+type Devices = {
+  control: string;
+  data?: string;
+};
+
+type PortInfo = {
+  path: string;
+  vendorId?: string;
+  productId?: string;
+  serialNumber?: string;
+  pnpId?: string;
+};
+
+// ends a line which the board gave up on part way through (see usb_io.h)
+const cancelMarker = '\x18';
+
+// The board's control channel carries commands and their results, its data channel frames
+// received. Until the data channel is opened, the board sends everything on the control channel.
 let port: SerialPort;
+let parser: ReadlineParser | undefined;
+let dataPort: SerialPort | undefined;
+let dataParser: ReadlineParser | undefined;
+let bulkPort: BulkPort | undefined;
 let debug: boolean;
+const pauseRequesters = new Set<object>();
 
+/**
+ * Opens the board's serial ports, delivering lines from both to `listener`, or its bulk
+ * interface.
+ *
+ * @param listener            Receives each line from the board.
+ * @param requestedDevice     Serial device of the board's control channel, autodetected (along
+ *                            with the data channel) if undefined. With the bulk transport, a
+ *                            device carrying the bulk interface's stream (e.g. the emulator's
+ *                            `--bulk-link`) rather than the board, which is opened through libusb
+ *                            if undefined.
+ * @param requestedDataDevice Serial device of the board's data channel. If neither this nor
+ *                            `requestedDevice` is given, the data channel is autodetected; if
+ *                            there isn't one (older firmware), everything arrives on the control
+ *                            channel. Not used with the bulk transport.
+ * @param transport           Whether to use the serial ports or the bulk interface.
+ */
 export const openPort = async (
   listener: DataListener,
   requestedDevice?: string,
+  requestedDataDevice?: string,
+  transport: Transport = 'serial',
 ): Promise<void> => {
-  const device = requestedDevice ?? (await autoDetectDevice());
+  if (transport === 'bulk') {
+    const decoder = new BulkRecordDecoder();
+    const onData = (data: Buffer) => {
+      decoder.push(data).forEach(line => {
+        if (debug) {
+          console.debug(line);
+        }
+        listener(line);
+      });
+    };
+    bulkPort = requestedDevice
+      ? await openBulkStream(requestedDevice, onData)
+      : await openUsbBulk(onData);
+    if (pauseRequesters.size > 0) {
+      bulkPort.pause();
+    }
+    return;
+  }
 
+  const devices: Devices = requestedDevice
+    ? { control: requestedDevice, data: requestedDataDevice }
+    : await autoDetectDevices();
+
+  const control = await openSerialPort(devices.control, listener);
+  port = control.port;
+  parser = control.parser;
+
+  if (devices.data) {
+    try {
+      const data = await openSerialPort(devices.data, listener);
+      dataPort = data.port;
+      dataParser = data.parser;
+    } catch (e) {
+      await closeSerialPort(port);
+      throw e;
+    }
+  }
+
+  if (pauseRequesters.size > 0) {
+    pausableParser()?.pause();
+  }
+};
+
+const openRawSerialPort = async (device: string): Promise<SerialPort> => {
   return new Promise((resolve, reject) => {
-    port = new SerialPort({
+    const serialPort = new SerialPort({
       path: device,
       baudRate: 115200,
       autoOpen: false,
     });
 
-    port.open(openError => {
+    serialPort.open(openError => {
       if (openError) {
         reject(`[open] Failed to open: ${openError.message}`);
         return;
       }
+      resolve(serialPort);
+    });
+  });
+};
+
+const openSerialPort = async (
+  device: string,
+  listener: DataListener,
+): Promise<{ port: SerialPort; parser: ReadlineParser }> => {
+  const serialPort = await openRawSerialPort(device);
+  const lineParser = serialPort.pipe(
+    new ReadlineParser({ delimiter: '\r\n' }),
+  );
+  lineParser.on('data', data => {
+    if (debug) {
+      console.debug(data);
+    }
+    // a line the board gave up on, which mustn't be taken for a complete (and shorter) event
+    if ((data as string).endsWith(cancelMarker)) {
+      return;
+    }
+    listener(data as string);
+  });
+
+  return { port: serialPort, parser: lineParser };
+};
+
+const writeAndDrain = async (
+  serialPort: SerialPort,
+  data: string | Buffer,
+): Promise<void> => {
+  return new Promise((resolve, reject) => {
+    serialPort.write(data, err => {
+      if (err) {
+        reject(`[writeToPort] Error writing '${data}: ${err.message}`);
+        return;
+      }
 
-      const parser = port.pipe(new ReadlineParser({ delimiter: '\r\n' }));
-      parser.on('data', data => {
-        if (debug) {
-          console.debug(data);
+      serialPort.drain(drainError => {
+        if (drainError) {
+          reject(
+            `[writeToPort] Error on drain writing '${data}: ${drainError.message}`,
+          );
+          return;
         }
-        listener(data as string);
+        resolve();
       });
+    });
+  });
+};
+
+// A device carrying the bulk interface's stream, as the emulator provides
+const openBulkStream = async (
+  device: string,
+  onData: (data: Buffer) => void,
+): Promise<BulkPort> => {
+  const serialPort = await openRawSerialPort(device);
+  serialPort.on('data', onData);
+
+  return {
+    write: (data: Buffer) => writeAndDrain(serialPort, data),
+    pause: () => {
+      serialPort.pause();
+    },
+    resume: () => {
+      serialPort.resume();
+    },
+    close: () => closeSerialPort(serialPort),
+  };
+};
 
+const closeSerialPort = async (serialPort: SerialPort): Promise<void> => {
+  return new Promise((resolve, reject) => {
+    serialPort.close(closeError => {
+      if (closeError) {
+        reject(`[drainAndClose] Failed to close: ${closeError.message}`);
+        return;
+      }
       resolve();
     });
   });
 };
 
 export const drainAndClose = async (): Promise<void> => {
+  if (bulkPort) {
+    const closingPort = bulkPort;
+    bulkPort = undefined;
+    await closingPort.close();
+    return;
+  }
+
+  if (dataPort) {
+    const closingPort = dataPort;
+    dataPort = undefined;
+    dataParser = undefined;
+    await closeSerialPort(closingPort);
+  }
+
   return new Promise((resolve, reject) => {
     port.drain(drainError => {
       if (drainError) {
@@ -57,38 +232,61 @@ export const drainAndClose = async (): Promise<void> => {
 };
 
 export const writeToPort = async (data: string): Promise<void> => {
-  return new Promise((resolve, reject) => {
-    if (debug) {
-      console.debug(data);
-    }
+  if (debug) {
+    console.debug(data);
+  }
 
-    port.write(`${data}\r`, err => {
-      if (err) {
-        reject(`[writeToPort] Error writing '${data}: ${err.message}`);
-        return;
-      }
+  if (bulkPort) {
+    return bulkPort.write(Buffer.from(`${data}\r`, 'latin1'));
+  }
+  return writeAndDrain(port, `${data}\r`);
+};
 
-      port.drain(drainError => {
-        if (drainError) {
-          reject(
-            `[writeToPort] Error on drain writing '${data}: ${drainError.message}`,
-          );
-          return;
-        }
-        resolve();
-      });
-    });
-  });
+// the data channel if the board has one, so that results keep arriving whilst frames are held up
+const pausableParser = (): ReadlineParser | undefined => dataParser ?? parser;
+
+/**
+ * Stops delivering frames from the board until every requester has called {@link resumeInput}.
+ * Whilst paused, the serial port stops being read once its buffers fill, so the board's USB
+ * output stalls rather than the driver buffering without limit. With firmware that has a
+ * separate data channel, only that is paused; the bulk transport carries everything in one
+ * stream, so results are held up too.
+ */
+export const pauseInput = (requester: object): void => {
+  pauseRequesters.add(requester);
+  if (bulkPort) {
+    bulkPort.pause();
+  } else {
+    pausableParser()?.pause();
+  }
+};
+
+export const resumeInput = (requester: object): void => {
+  pauseRequesters.delete(requester);
+  if (pauseRequesters.size === 0) {
+    if (bulkPort) {
+      bulkPort.resume();
+    } else {
+      pausableParser()?.resume();
+    }
+  }
 };
 
 export const setDebug = (value: boolean): void => {
   debug = value;
 };
 
-const autoDetectDevice = async (): Promise<string> => {
+// USB interface number of a port, from its Plug and Play ID on Linux (`...-if02`) and Windows
+// (`...&MI_02`), or NaN if unknown
+const interfaceNumber = (portInfo: PortInfo): number => {
+  const match = /(?:-if|&MI_)([0-9a-f]{2})/i.exec(portInfo.pnpId ?? '');
+  return match ? parseInt(match[1], 16) : NaN;
+};
+
+const autoDetectDevices = async (): Promise<Devices> => {
   const Binding = autoDetect();
-  const portInfos = await Binding.list();
-  const picoPort = portInfos.find(
+  const portInfos: Array<PortInfo> = await Binding.list();
+  const picoPorts = portInfos.filter(
     portInfo =>
       portInfo.vendorId &&
       portInfo.vendorId.toLowerCase() === '2e8a' &&
@@ -96,9 +294,19 @@ const autoDetectDevice = async (): Promise<string> => {
       portInfo.productId.toLowerCase() === '000a',
   );
 
-  if (!picoPort) {
+  if (picoPorts.length === 0) {
     throw new Error('Failed to find a Pico device');
   }
 
-  return picoPort.path;
+  // the ports of the first board found, control channel first
+  const boardPorts = picoPorts
+    .filter(portInfo => portInfo.serialNumber === picoPorts[0].serialNumber)
+    .sort((a, b) => {
+      const byInterface = interfaceNumber(a) - interfaceNumber(b);
+      return Number.isNaN(byInterface)
+        ? a.path.localeCompare(b.path, undefined, { numeric: true })
+        : byInterface;
+    });
+
+  return { control: boardPorts[0].path, data: boardPorts[1]?.path };
 };
@@ -0,0 +1,263 @@
+import { Device, InEndpoint, Interface, OutEndpoint } from 'usb';
+
+const picoVendorId = 0x2e8a;
+const picoProductId = 0x000a;
+const vendorClass = 0xff;
+
+// as usb_descriptors.c; other Picos running the SDK's USB stdio share the IDs above
+const productName = 'Piconet';
+
+// as usb_descriptors.c
+const vendorRequestBulkOpen = 2;
+const requestTypeVendorInterfaceOut = 0x41;
+
+// reads kept outstanding on the IN endpoint, each completing early on a short packet
+const readsInFlight = 4;
+const readSize = 16384;
+
+// how long the interface must be quiet before opening, to see off output left over from an
+// earlier session which might otherwise start mid-chunk
+const staleQuietMs = 20;
+
+/**
+ * The board's vendor bulk interface, opened through libusb, or a stream carrying what it would
+ * (see {@link openPort}).
+ */
+export type BulkPort = {
+  write: (data: Buffer) => Promise<void>;
+  pause: () => void;
+  resume: () => void;
+  close: () => Promise<void>;
+};
+
+type Read = {
+  transfer: ReturnType<InEndpoint['makeTransfer']>;
+  buffer: Buffer;
+  active: boolean;
+};
+
+const sleepMs = (ms: number) =>
+  new Promise(resolve => {
+    setTimeout(resolve, ms);
+  });
+
+const loadUsb = async () => {
+  try {
+    return await import('usb');
+  } catch {
+    throw new Error(
+      'The bulk transport requires the optional "usb" package (libusb), which is not installed',
+    );
+  }
+};
+
+const controlOut = (
+  device: Device,
+  request: number,
+  value: number,
+  index: number,
+): Promise<void> =>
+  new Promise((resolve, reject) => {
+    device.controlTransfer(
+      requestTypeVendorInterfaceOut,
+      request,
+      value,
+      index,
+      Buffer.alloc(0),
+      error => {
+        if (error) {
+          reject(
+            new Error(`[bulk] Control transfer failed: ${error.message}`),
+          );
+          return;
+        }
+        resolve();
+      },
+    );
+  });
+
+const readString = (
+  device: Device,
+  index: number,
+): Promise<string | undefined> =>
+  new Promise(resolve => {
+    device.getStringDescriptor(index, (error, value) => {
+      resolve(error ? undefined : value);
+    });
+  });
+
+// opens the first device with the board's IDs whose product string is Piconet's
+const findBoard = async (
+  usb: Awaited<ReturnType<typeof loadUsb>>,
+): Promise<Device | undefined> => {
+  const candidates = usb
+    .getDeviceList()
+    .filter(
+      device =>
+        device.deviceDescriptor.idVendor === picoVendorId &&
+        device.deviceDescriptor.idProduct === picoProductId,
+    );
+  for (const device of candidates) {
+    try {
+      device.open();
+    } catch {
+      // claimed elsewhere, or no permission to open it
+      continue;
+    }
+    const product = await readString(
+      device,
+      device.deviceDescriptor.iProduct,
+    );
+    if (product === productName) {
+      return device;
+    }
+    device.close();
+  }
+  return undefined;
+};
+
+const releaseInterface = (iface: Interface): Promise<void> =>
+  new Promise(resolve => {
+    iface.release(true, () => resolve());
+  });
+
+/**
+ * Opens the vendor bulk interface of the first Piconet board found, delivering whatever it
+ * sends to `onData`.
+ */
+export const openUsbBulk = async (
+  onData: (data: Buffer) => void,
+): Promise<BulkPort> => {
+  const device = await findBoard(await loadUsb());
+  if (!device) {
+    throw new Error('Failed to find a Pico device running Piconet');
+  }
+
+  const iface = device.interfaces?.find(
+    i => i.descriptor.bInterfaceClass === vendorClass,
+  );
+  if (!iface) {
+    device.close();
+    throw new Error(
+      'Board has no bulk interface (firmware may not support the bulk transport)',
+    );
+  }
+  iface.claim();
+
+  const inEndpoint = iface.endpoints.find(e => e.direction === 'in');
+  const outEndpoint = iface.endpoints.find(e => e.direction === 'out');
+  if (!inEndpoint || !outEndpoint) {
+    await releaseInterface(iface);
+    device.close();
+    throw new Error('Board bulk interface is missing an endpoint');
+  }
+  const reader = inEndpoint as InEndpoint;
+  const writer = outEndpoint as OutEndpoint;
+
+  let paused = false;
+  let closing = false;
+  let discarding = true;
+  let lastDataAt = Date.now();
+
+  const reads: Array<Read> = [];
+  const submit = (read: Read) => {
+    read.active = true;
+    read.transfer.submit(read.buffer);
+  };
+  for (let i = 0; i < readsInFlight; i++) {
+    const buffer = Buffer.alloc(readSize);
+    const read: Read = {
+      buffer,
+      active: false,
+      transfer: reader.makeTransfer(0, (error, _, length) => {
+        read.active = false;
+        if (error) {
+          // cancelled on close, or the board has gone
+          return;
+        }
+        if (length > 0) {
+          if (discarding) {
+            lastDataAt = Date.now();
+          } else {
+            onData(Buffer.from(buffer.subarray(0, length)));
+          }
+        }
+        if (!paused && !closing) {
+          submit(read);
+        }
+      }),
+    };
+    reads.push(read);
+  }
+
+  const startReading = () => {
+    reads.filter(read => !read.active).forEach(submit);
+  };
+
+  const shutDown = async () => {
+    closing = true;
+    reads
+      .filter(read => read.active)
+      .forEach(read => read.transfer.cancel());
+    while (reads.some(read => read.active)) {
+      await sleepMs(1);
+    }
+    await releaseInterface(iface);
+    device.close();
+  };
+
+  startReading();
+  while (Date.now() - lastDataAt < staleQuietMs) {
+    await sleepMs(staleQuietMs);
+  }
+  discarding = false;
+  try {
+    await controlOut(device, vendorRequestBulkOpen, 1, iface.interfaceNumber);
+  } catch (e) {
+    await shutDown();
+    throw e;
+  }
+
+  return {
+    write: (data: Buffer) =>
+      new Promise((resolve, reject) => {
+        writer.transfer(data, error => {
+          if (error) {
+            reject(new Error(`[bulk] Error writing: ${error.message}`));
+            return;
+          }
+          resolve();
+        });
+      }),
+    pause: () => {
+      // outstanding reads complete, then no more are made
+      paused = true;
+    },
+    resume: () => {
+      paused = false;
+      if (!closing) {
+        startReading();
+        // the board closes the interface if results go unread for long, so make sure it's open
+        controlOut(
+          device,
+          vendorRequestBulkOpen,
+          1,
+          iface.interfaceNumber,
+        ).catch(() => undefined);
+      }
+    },
+    close: async () => {
+      closing = true;
+      try {
+        await controlOut(
+          device,
+          vendorRequestBulkOpen,
+          0,
+          iface.interfaceNumber,
+        );
+      } finally {
+        await shutDown();
+      }
+    },
+  };
+};
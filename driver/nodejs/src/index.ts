@@ -9,4 +9,66 @@ export { MonitorEvent } from './types/monitorEvent';
 export { RxImmediateEvent } from './types/rxImmediateEvent';
 export { RxBroadcastEvent } from './types/rxBroadcastEvent';
 export { TxResultEvent } from './types/txResultEvent';
-export { EventMatcher, Listener, EventQueue } from './driver';
+export { ReplyResultEvent } from './types/replyResultEvent';
+export { CompressionEvent } from './types/compressionEvent';
+export { DedupEvent } from './types/dedupEvent';
+export { FlowEvent } from './types/flowEvent';
+export { WatermarkEvent } from './types/watermarkEvent';
+export { AdlcTraceEvent } from './types/adlcTraceEvent';
+export { BenchEvent } from './types/benchEvent';
+export {
+  RecoveryEvent,
+  RecoveryTier,
+  RecoveryTierStats,
+} from './types/recoveryEvent';
+export { ScanEvent, ScanResult } from './types/scanEvent';
+export { ScanStationEvent } from './types/scanStationEvent';
+export {
+  TrafficEvent,
+  TrafficPair,
+  TrafficTalker,
+} from './types/trafficEvent';
+export { UsbEvent } from './types/usbEvent';
+export {
+  ConnectOptions,
+  EventMatcher,
+  Listener,
+  EventQueue,
+  EventQueueOptions,
+  EventQueueOverflowPolicy,
+} from './driver';
+export { EventType } from './parser/eventParser';
+export { Transport } from './driver/serial';
+export {
+  MonitorStream,
+  MonitorStreamMetrics,
+  MonitorStreamOptions,
+} from './driver/monitorStream';
+export { DecompressorMetrics } from './driver/decompressor';
+export {
+  AunGateway,
+  AunGatewayBoard,
+  AunGatewayMetrics,
+  AunGatewayOptions,
+  AunGatewayStation,
+  AunPacket,
+  AunPacketType,
+  AunRoute,
+  decodeAunPacket,
+  encodeAunPacket,
+} from './driver/aunGateway';
+export {
+  AdlcTraceEntry,
+  AdlcTraceOp,
+  AdlcTracePhase,
+  AdlcTracePhaseSummary,
+  adlcTracePhaseName,
+  decodeAdlcTrace,
+  formatAdlcTimeline,
+  summariseAdlcTrace,
+} from './driver/adlcTrace';
+export {
+  BulkTransferMetrics,
+  BulkTransferOptions,
+  BulkTransferResult,
+} from './driver/bulkTransfer';
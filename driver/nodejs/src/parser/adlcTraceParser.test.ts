@@ -0,0 +1,37 @@
+import { AdlcTraceOp } from '../driver/adlcTrace';
+import { parseAdlcTraceEvent } from './adlcTraceParser';
+
+describe('ADLC trace message parser', () => {
+  it('should parse valid TRACE event', () => {
+    const data = Buffer.from([0x10, 0, 0, 0, 0x06, 0x01, 0x02, 0x00]);
+    const parsedEvent = parseAdlcTraceEvent(
+      `TRACE 1 1200 ${data.toString('base64')}`,
+    );
+    expect(parsedEvent?.enabled).toEqual(true);
+    expect(parsedEvent?.recorded).toEqual(1200);
+    expect(parsedEvent?.entries).toEqual([
+      {
+        timeUs: 0x10,
+        op: AdlcTraceOp.Write,
+        register: 2,
+        value: 1,
+        wait: 2,
+      },
+    ]);
+  });
+
+  it('should parse TRACE event without entries', () => {
+    const parsedEvent = parseAdlcTraceEvent('TRACE 0 0');
+    expect(parsedEvent?.enabled).toEqual(false);
+    expect(parsedEvent?.entries).toEqual([]);
+  });
+
+  it('should reject invalid TRACE event', () => {
+    expect(() => parseAdlcTraceEvent('TRACE 1')).toThrow(
+      "Protocol error. Invalid TRACE event 'TRACE 1' received.",
+    );
+    expect(() => parseAdlcTraceEvent('TRACE 1 1 AAAA')).toThrow(
+      "Protocol error. Invalid TRACE event 'TRACE 1 1 AAAA' received.",
+    );
+  });
+});
@@ -0,0 +1,31 @@
+import { adlcTraceEntrySize, decodeAdlcTrace } from '../driver/adlcTrace';
+import { AdlcTraceEvent } from '../types/adlcTraceEvent';
+import { eventAttributes, hasEventName } from './parserUtils';
+
+export const parseAdlcTraceEvent = (
+  event: string,
+): AdlcTraceEvent | undefined => {
+  if (!hasEventName(event, 'TRACE')) {
+    return undefined;
+  }
+
+  // the data is omitted when no entries have been recorded
+  const attributes =
+    eventAttributes(event, 'TRACE', 3) ?? eventAttributes(event, 'TRACE', 2);
+  const recorded = attributes ? parseInt(attributes[1], 10) : NaN;
+  const data = Buffer.from(attributes?.[2] ?? '', 'base64');
+  if (
+    !attributes ||
+    (attributes[0] !== '0' && attributes[0] !== '1') ||
+    isNaN(recorded) ||
+    data.length % adlcTraceEntrySize !== 0
+  ) {
+    throw new Error(`Protocol error. Invalid TRACE event '${event}' received.`);
+  }
+
+  return new AdlcTraceEvent(
+    attributes[0] === '1',
+    recorded,
+    decodeAdlcTrace(data),
+  );
+};
@@ -0,0 +1,34 @@
+import { parseBenchEvent } from './benchParser';
+
+describe('benchmark message parser', () => {
+  it('should parse valid BENCH event', () => {
+    const parsedEvent = parseBenchEvent(
+      'BENCH 64 100 0 0 0 279653 357 22885 2.15',
+    );
+    expect(parsedEvent).toBeDefined();
+    expect(parsedEvent?.frameLength).toEqual(64);
+    expect(parsedEvent?.frames).toEqual(100);
+    expect(parsedEvent?.errors).toEqual(0);
+    expect(parsedEvent?.underruns).toEqual(0);
+    expect(parsedEvent?.overruns).toEqual(0);
+    expect(parsedEvent?.elapsedUs).toEqual(279653);
+    expect(parsedEvent?.framesPerSecond).toEqual(357);
+    expect(parsedEvent?.bytesPerSecond).toEqual(22885);
+    expect(parsedEvent?.busCyclesPerByte).toEqual(2.15);
+  });
+
+  it('should ignore other events', () => {
+    expect(parseBenchEvent('STATUS 2.0.0 1 00 0')).toBeUndefined();
+  });
+
+  it('should reject invalid events', () => {
+    expect(() =>
+      parseBenchEvent('BENCH 64 100 0 0 0 279653 357 22885'),
+    ).toThrow(
+      "Protocol error. Invalid BENCH event 'BENCH 64 100 0 0 0 279653 357 22885' received.",
+    );
+    expect(() =>
+      parseBenchEvent('BENCH 64 100 0 0 0 279653 357 22885 x'),
+    ).toThrow('Protocol error');
+  });
+});
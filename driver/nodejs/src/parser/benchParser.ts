@@ -0,0 +1,31 @@
+import { BenchEvent } from '../types/benchEvent';
+import { eventAttributes, hasEventName } from './parserUtils';
+
+export const parseBenchEvent = (event: string): BenchEvent | undefined => {
+  if (!hasEventName(event, 'BENCH')) {
+    return undefined;
+  }
+
+  const attributes = eventAttributes(event, 'BENCH', 9);
+  const counters = attributes?.slice(0, 8).map(str => parseInt(str, 10));
+  const busCyclesPerByte = attributes ? parseFloat(attributes[8]) : NaN;
+  if (
+    !counters ||
+    counters.some(counter => isNaN(counter) || counter < 0) ||
+    isNaN(busCyclesPerByte)
+  ) {
+    throw new Error(`Protocol error. Invalid BENCH event '${event}' received.`);
+  }
+
+  return new BenchEvent(
+    counters[0],
+    counters[1],
+    counters[2],
+    counters[3],
+    counters[4],
+    counters[5],
+    counters[6],
+    counters[7],
+    busCyclesPerByte,
+  );
+};
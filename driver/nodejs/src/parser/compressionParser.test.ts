@@ -0,0 +1,39 @@
+import { parseCompressionEvent } from './compressionParser';
+
+describe('compression message parser', () => {
+  it('should parse valid COMPRESSION event', () => {
+    const parsedEvent = parseCompressionEvent(
+      'COMPRESSION LZ 20752 8492 55125',
+    );
+    expect(parsedEvent).toBeDefined();
+    expect(parsedEvent?.scheme).toEqual('LZ');
+    expect(parsedEvent?.inputBytes).toEqual(20752);
+    expect(parsedEvent?.outputBytes).toEqual(8492);
+    expect(parsedEvent?.cycles).toEqual(55125);
+    expect(parsedEvent?.ratio).toBeCloseTo(2.44);
+    expect(parsedEvent?.cyclesPerByte).toBeCloseTo(2.66);
+  });
+
+  it('should report unit ratio before anything is compressed', () => {
+    const parsedEvent = parseCompressionEvent('COMPRESSION NONE 0 0 0');
+    expect(parsedEvent?.scheme).toEqual('NONE');
+    expect(parsedEvent?.ratio).toEqual(1);
+    expect(parsedEvent?.cyclesPerByte).toEqual(0);
+  });
+
+  it('should ignore other events', () => {
+    expect(parseCompressionEvent('STATUS 2.0.0 1 00 0')).toBeUndefined();
+  });
+
+  it('should reject invalid COMPRESSION event', () => {
+    expect(() => parseCompressionEvent('COMPRESSION LZ 1 2')).toThrow(
+      "Protocol error. Invalid COMPRESSION event 'COMPRESSION LZ 1 2' received.",
+    );
+    expect(() => parseCompressionEvent('COMPRESSION ZIP 1 2 3')).toThrow(
+      'Protocol error',
+    );
+    expect(() => parseCompressionEvent('COMPRESSION LZ 1 x 3')).toThrow(
+      'Protocol error',
+    );
+  });
+});
@@ -0,0 +1,30 @@
+import { CompressionEvent } from '../types/compressionEvent';
+import { eventAttributes, hasEventName } from './parserUtils';
+
+export const parseCompressionEvent = (
+  event: string,
+): CompressionEvent | undefined => {
+  if (!hasEventName(event, 'COMPRESSION')) {
+    return undefined;
+  }
+
+  const attributes = eventAttributes(event, 'COMPRESSION', 4);
+  if (!attributes) {
+    throw new Error(
+      `Protocol error. Invalid COMPRESSION event '${event}' received.`,
+    );
+  }
+
+  const [scheme, ...counterStrs] = attributes;
+  const counters = counterStrs.map(str => parseInt(str, 10));
+  if (
+    (scheme !== 'LZ' && scheme !== 'NONE') ||
+    counters.some(counter => isNaN(counter) || counter < 0)
+  ) {
+    throw new Error(
+      `Protocol error. Invalid COMPRESSION event '${event}' received.`,
+    );
+  }
+
+  return new CompressionEvent(scheme, counters[0], counters[1], counters[2]);
+};
@@ -0,0 +1,25 @@
+import { parseDedupEvent } from './dedupParser';
+
+describe('dedup message parser', () => {
+  it('should parse valid DEDUP event', () => {
+    const parsedEvent = parseDedupEvent('DEDUP 1000 69 2 7');
+    expect(parsedEvent).toBeDefined();
+    expect(parsedEvent?.windowMs).toEqual(1000);
+    expect(parsedEvent?.transmitSuppressed).toEqual(69);
+    expect(parsedEvent?.immediateSuppressed).toEqual(2);
+    expect(parsedEvent?.broadcastSuppressed).toEqual(7);
+  });
+
+  it('should ignore other events', () => {
+    expect(parseDedupEvent('STATUS 2.0.0 1 00 0')).toBeUndefined();
+  });
+
+  it('should reject invalid DEDUP event', () => {
+    expect(() => parseDedupEvent('DEDUP 1000 1 2')).toThrow(
+      "Protocol error. Invalid DEDUP event 'DEDUP 1000 1 2' received.",
+    );
+    expect(() => parseDedupEvent('DEDUP 1000 1 x 3')).toThrow(
+      'Protocol error',
+    );
+  });
+});
@@ -0,0 +1,17 @@
+import { DedupEvent } from '../types/dedupEvent';
+import { eventAttributes, hasEventName } from './parserUtils';
+
+export const parseDedupEvent = (event: string): DedupEvent | undefined => {
+  if (!hasEventName(event, 'DEDUP')) {
+    return undefined;
+  }
+
+  const counters = eventAttributes(event, 'DEDUP', 4)?.map(str =>
+    parseInt(str, 10),
+  );
+  if (!counters || counters.some(counter => isNaN(counter) || counter < 0)) {
+    throw new Error(`Protocol error. Invalid DEDUP event '${event}' received.`);
+  }
+
+  return new DedupEvent(counters[0], counters[1], counters[2], counters[3]);
+};
@@ -0,0 +1,67 @@
+import { EconetEvent } from '../types/econetEvent';
+import { MonitorEvent } from '../types/monitorEvent';
+import { RxDataEvent } from '../types/rxDataEvent';
+import { RxTransmitEvent } from '../types/rxTransmitEvent';
+import { StatusEvent } from '../types/statusEvent';
+import { TxResultEvent } from '../types/txResultEvent';
+import { eventName, eventNamesFor, parseEvent } from './eventParser';
+
+describe('event parser', () => {
+  it('should extract event name', () => {
+    expect(eventName('MONITOR abcdef123=')).toEqual('MONITOR');
+    expect(eventName('STATUS')).toEqual('STATUS');
+  });
+
+  it('should dispatch to parser for event name', () => {
+    expect(parseEvent('TX_RESULT OK')).toBeInstanceOf(TxResultEvent);
+    expect(parseEvent('MONITOR abcdef123=')).toBeInstanceOf(MonitorEvent);
+    expect(parseEvent('STATUS 0.1.1 32 10 1')).toBeInstanceOf(StatusEvent);
+  });
+
+  it('should return undefined for unrecognised event', () => {
+    expect(parseEvent('WHATEVER abcdef')).toBeUndefined();
+    expect(parseEvent('')).toBeUndefined();
+  });
+
+  it('should skip events not in wanted set', () => {
+    const wanted = new Set(['TX_RESULT']);
+    expect(parseEvent('MONITOR abcdef123=', wanted)).toBeUndefined();
+    expect(parseEvent('TX_RESULT OK', wanted)).toBeInstanceOf(TxResultEvent);
+  });
+
+  it('should not decode unwanted malformed events', () => {
+    expect(() => parseEvent('MONITOR', new Set(['STATUS']))).not.toThrow();
+    expect(() => parseEvent('MONITOR')).toThrow(
+      "Protocol error. Invalid MONITOR event 'MONITOR' received.",
+    );
+  });
+
+  it('should map event types to event names including subclasses', () => {
+    expect(eventNamesFor([StatusEvent])).toEqual(['STATUS']);
+    expect(eventNamesFor([RxDataEvent]).sort()).toEqual([
+      'MONITOR',
+      'RX_BROADCAST',
+      'RX_IMMEDIATE',
+      'RX_TRANSMIT',
+    ]);
+    expect(eventNamesFor([EconetEvent]).length).toBeGreaterThan(4);
+  });
+
+  it('should decode header fields from scout and data frames', () => {
+    const scout = Buffer.from([0x01, 0x00, 0xfe, 0x00, 0x80, 0x99]);
+    const data = Buffer.from([0x01, 0x00, 0xfe, 0x00, 0x41, 0x42]);
+    const event = parseEvent(
+      `RX_TRANSMIT ${scout.toString('base64')} ${data.toString('base64')}`,
+    );
+
+    expect(event).toBeInstanceOf(RxTransmitEvent);
+    const rxTransmitEvent = event as RxTransmitEvent;
+    expect(rxTransmitEvent.scoutFrame).toEqual(scout);
+    expect(rxTransmitEvent.dataFrame).toEqual(data);
+    expect(rxTransmitEvent.toStation).toEqual(0x01);
+    expect(rxTransmitEvent.fromStation).toEqual(0xfe);
+    expect(rxTransmitEvent.controlByte).toEqual(0x80);
+    expect(rxTransmitEvent.port).toEqual(0x99);
+    expect(rxTransmitEvent.payload).toEqual(Buffer.from('AB'));
+  });
+});
@@ -0,0 +1,133 @@
+import { AdlcTraceEvent } from '../types/adlcTraceEvent';
+import { BenchEvent } from '../types/benchEvent';
+import { CompressionEvent } from '../types/compressionEvent';
+import { DedupEvent } from '../types/dedupEvent';
+import { EconetEvent } from '../types/econetEvent';
+import { ErrorEvent } from '../types/errorEvent';
+import { FlowEvent } from '../types/flowEvent';
+import { MonitorEvent } from '../types/monitorEvent';
+import { RecoveryEvent } from '../types/recoveryEvent';
+import { ReplyResultEvent } from '../types/replyResultEvent';
+import { RxBroadcastEvent } from '../types/rxBroadcastEvent';
+import { RxImmediateEvent } from '../types/rxImmediateEvent';
+import { RxTransmitEvent } from '../types/rxTransmitEvent';
+import { ScanEvent } from '../types/scanEvent';
+import { ScanStationEvent } from '../types/scanStationEvent';
+import { StatusEvent } from '../types/statusEvent';
+import { TrafficEvent } from '../types/trafficEvent';
+import { TxResultEvent } from '../types/txResultEvent';
+import { UsbEvent } from '../types/usbEvent';
+import { WatermarkEvent } from '../types/watermarkEvent';
+import { parseAdlcTraceEvent } from './adlcTraceParser';
+import { parseBenchEvent } from './benchParser';
+import { parseCompressionEvent } from './compressionParser';
+import { parseDedupEvent } from './dedupParser';
+import { parseErrorEvent } from './errorParser';
+import { parseFlowEvent, parseWatermarkEvent } from './flowParser';
+import { parseMonitorEvent } from './monitorParser';
+import { parseRecoveryEvent } from './recoveryParser';
+import { parseReplyResultEvent } from './replyResultParser';
+import { parseRxBroadcastEvent } from './rxBroadcastParser';
+import { parseRxImmediateEvent } from './rxImmediateParser';
+import { parseRxTransmitEvent } from './rxTransmitParser';
+import { parseScanEvent, parseScanStationEvent } from './scanParser';
+import { parseStatusEvent } from './statusParser';
+import { parseTrafficEvent } from './trafficParser';
+import { parseTxResultEvent } from './txResultParser';
+import { parseUsbEvent } from './usbParser';
+
+/**
+ * A class of event, such as `MonitorEvent` or one of its superclasses.
+ */
+export type EventType = new (...args: never[]) => unknown;
+
+type ParserEntry = {
+  eventType: EventType;
+  parse: (event: string) => EconetEvent | undefined;
+};
+
+const parserTable = new Map<string, ParserEntry>([
+  ['STATUS', { eventType: StatusEvent, parse: parseStatusEvent }],
+  ['ERROR', { eventType: ErrorEvent, parse: parseErrorEvent }],
+  ['MONITOR', { eventType: MonitorEvent, parse: parseMonitorEvent }],
+  ['RX_TRANSMIT', { eventType: RxTransmitEvent, parse: parseRxTransmitEvent }],
+  [
+    'RX_IMMEDIATE',
+    { eventType: RxImmediateEvent, parse: parseRxImmediateEvent },
+  ],
+  [
+    'RX_BROADCAST',
+    { eventType: RxBroadcastEvent, parse: parseRxBroadcastEvent },
+  ],
+  ['TX_RESULT', { eventType: TxResultEvent, parse: parseTxResultEvent }],
+  [
+    'REPLY_RESULT',
+    { eventType: ReplyResultEvent, parse: parseReplyResultEvent },
+  ],
+  [
+    'COMPRESSION',
+    { eventType: CompressionEvent, parse: parseCompressionEvent },
+  ],
+  ['DEDUP', { eventType: DedupEvent, parse: parseDedupEvent }],
+  ['TRACE', { eventType: AdlcTraceEvent, parse: parseAdlcTraceEvent }],
+  ['FLOW', { eventType: FlowEvent, parse: parseFlowEvent }],
+  ['WATERMARK', { eventType: WatermarkEvent, parse: parseWatermarkEvent }],
+  ['BENCH', { eventType: BenchEvent, parse: parseBenchEvent }],
+  ['RECOVERY', { eventType: RecoveryEvent, parse: parseRecoveryEvent }],
+  ['TRAFFIC', { eventType: TrafficEvent, parse: parseTrafficEvent }],
+  [
+    'SCAN_STATION',
+    { eventType: ScanStationEvent, parse: parseScanStationEvent },
+  ],
+  ['SCAN', { eventType: ScanEvent, parse: parseScanEvent }],
+  ['USB', { eventType: UsbEvent, parse: parseUsbEvent }],
+]);
+
+/**
+ * Returns the name of an event line (its first space-delimited term).
+ */
+export const eventName = (event: string): string => {
+  const end = event.indexOf(' ');
+  return end === -1 ? event : event.substring(0, end);
+};
+
+/**
+ * Returns the names of the events which produce instances of any of the specified event types
+ * (or their subclasses).
+ */
+export const eventNamesFor = (eventTypes: Array<EventType>): Array<string> => {
+  const names = new Array<string>();
+  parserTable.forEach((entry, name) => {
+    if (
+      eventTypes.some(
+        eventType =>
+          entry.eventType === eventType ||
+          entry.eventType.prototype instanceof eventType,
+      )
+    ) {
+      names.push(name);
+    }
+  });
+  return names;
+};
+
+/**
+ * Parses a line received from the board, looking up the single parser for its event name.
+ *
+ * @param event       The line received from the board.
+ * @param wantedNames Optional set of event names of interest. Events with any other name are
+ *                    skipped without being decoded.
+ * @returns The parsed event or `undefined` if the event is unrecognised or not wanted.
+ */
+export const parseEvent = (
+  event: string,
+  wantedNames?: ReadonlySet<string>,
+): EconetEvent | undefined => {
+  const name = eventName(event);
+  if (wantedNames && !wantedNames.has(name)) {
+    return undefined;
+  }
+
+  const entry = parserTable.get(name);
+  return entry ? entry.parse(event) : undefined;
+};
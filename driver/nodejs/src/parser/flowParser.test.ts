@@ -0,0 +1,34 @@
+import { parseFlowEvent, parseWatermarkEvent } from './flowParser';
+
+describe('flow control message parser', () => {
+  it('should parse valid FLOW event', () => {
+    const parsedEvent = parseFlowEvent('FLOW 1 12 3 5 2 1');
+    expect(parsedEvent).toBeDefined();
+    expect(parsedEvent?.enabled).toEqual(true);
+    expect(parsedEvent?.credits).toEqual(12);
+    expect(parsedEvent?.backlog).toEqual(3);
+    expect(parsedEvent?.declinedScouts).toEqual(5);
+    expect(parsedEvent?.droppedFrames).toEqual(2);
+    expect(parsedEvent?.droppedErrors).toEqual(1);
+  });
+
+  it('should parse valid WATERMARK events', () => {
+    expect(parseWatermarkEvent('WATERMARK HIGH 5')?.level).toEqual('HIGH');
+    expect(parseWatermarkEvent('WATERMARK LOW 1')?.backlog).toEqual(1);
+  });
+
+  it('should ignore other events', () => {
+    expect(parseFlowEvent('STATUS 2.0.0 1 00 0')).toBeUndefined();
+    expect(parseWatermarkEvent('FLOW 0 0 0 0 0 0')).toBeUndefined();
+  });
+
+  it('should reject invalid events', () => {
+    expect(() => parseFlowEvent('FLOW 1 2 3 4 5')).toThrow(
+      "Protocol error. Invalid FLOW event 'FLOW 1 2 3 4 5' received.",
+    );
+    expect(() => parseFlowEvent('FLOW 2 0 0 0 0 0')).toThrow('Protocol error');
+    expect(() => parseWatermarkEvent('WATERMARK FULL 3')).toThrow(
+      "Protocol error. Invalid WATERMARK event 'WATERMARK FULL 3' received.",
+    );
+  });
+});
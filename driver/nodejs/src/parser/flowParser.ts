@@ -0,0 +1,51 @@
+import { FlowEvent } from '../types/flowEvent';
+import { WatermarkEvent } from '../types/watermarkEvent';
+import { eventAttributes, hasEventName } from './parserUtils';
+
+export const parseFlowEvent = (event: string): FlowEvent | undefined => {
+  if (!hasEventName(event, 'FLOW')) {
+    return undefined;
+  }
+
+  const counters = eventAttributes(event, 'FLOW', 6)?.map(str =>
+    parseInt(str, 10),
+  );
+  if (
+    !counters ||
+    counters.some(counter => isNaN(counter) || counter < 0) ||
+    counters[0] > 1
+  ) {
+    throw new Error(`Protocol error. Invalid FLOW event '${event}' received.`);
+  }
+
+  return new FlowEvent(
+    counters[0] === 1,
+    counters[1],
+    counters[2],
+    counters[3],
+    counters[4],
+    counters[5],
+  );
+};
+
+export const parseWatermarkEvent = (
+  event: string,
+): WatermarkEvent | undefined => {
+  if (!hasEventName(event, 'WATERMARK')) {
+    return undefined;
+  }
+
+  const attributes = eventAttributes(event, 'WATERMARK', 2);
+  const backlog = attributes ? parseInt(attributes[1], 10) : NaN;
+  if (
+    !attributes ||
+    (attributes[0] !== 'HIGH' && attributes[0] !== 'LOW') ||
+    isNaN(backlog)
+  ) {
+    throw new Error(
+      `Protocol error. Invalid WATERMARK event '${event}' received.`,
+    );
+  }
+
+  return new WatermarkEvent(attributes[0], backlog);
+};
@@ -6,11 +6,22 @@ describe('monitor message parser', () => {
     const result = parseMonitorEvent(eventStr);
     expect(result).toBeDefined();
     expect(result?.econetFrame).toEqual(Buffer.from('abcdef123', 'base64'));
+    expect(result?.truncated).toEqual(false);
+  });
+
+  it('should parse MONITOR event with frame length', () => {
+    const result = parseMonitorEvent('MONITOR 68 ZQBkAAME');
+    expect(result?.econetFrame).toEqual(Buffer.from([101, 0, 100, 0, 3, 4]));
+    expect(result?.frameLength).toEqual(68);
+    expect(result?.truncated).toEqual(true);
   });
 
   it('should reject invalid MONITOR event', () => {
     expect(() => parseMonitorEvent('MONITOR')).toThrow(
       "Protocol error. Invalid MONITOR event 'MONITOR' received.",
     );
+    expect(() => parseMonitorEvent('MONITOR x ZABlAA==')).toThrow(
+      'Protocol error',
+    );
   });
 });
@@ -1,22 +1,30 @@
 import { MonitorEvent } from '../types/monitorEvent';
+import { eventAttributes, hasEventName } from './parserUtils';
 
 export const parseMonitorEvent = (event: string): MonitorEvent | undefined => {
-  const terms = event.split(' ');
-
-  if (terms.length == 0 || terms[0] !== 'MONITOR') {
+  if (!hasEventName(event, 'MONITOR')) {
     return undefined;
   }
 
-  if (terms.length < 2) {
+  // with a snap length set, the frame's length on the wire precedes its data
+  const attributes =
+    eventAttributes(event, 'MONITOR', 2) ??
+    eventAttributes(event, 'MONITOR', 1);
+  const frameLength =
+    attributes?.length === 2 ? parseInt(attributes[0], 10) : undefined;
+  if (
+    !attributes ||
+    (frameLength !== undefined && (isNaN(frameLength) || frameLength < 0))
+  ) {
     throw new Error(
       `Protocol error. Invalid MONITOR event '${event}' received.`,
     );
   }
-  const attributes = terms.slice(1);
 
-  const data = attributes[0];
+  const data = attributes[attributes.length - 1];
   try {
-    return new MonitorEvent(Buffer.from(data, 'base64'));
+    const frame = Buffer.from(data, 'base64');
+    return new MonitorEvent(frame, frameLength ?? frame.length);
   } catch (e) {
     throw new Error(
       `Protocol error. Invalid MONITOR event '${event}' received. Failed to parse base64 data.`,
@@ -0,0 +1,58 @@
+/**
+ * Determines whether `event` is named `name` (i.e. its first space-delimited term is `name`).
+ */
+export const hasEventName = (event: string, name: string): boolean => {
+  return (
+    event.startsWith(name) &&
+    (event.length === name.length || event.charCodeAt(name.length) === 0x20)
+  );
+};
+
+/**
+ * Extracts the first `count` space-delimited attributes following the event name, without
+ * splitting the remainder of the line. Returns `undefined` if fewer than `count` are present.
+ */
+export const eventAttributes = (
+  event: string,
+  name: string,
+  count: number,
+): Array<string> | undefined => {
+  const attributes = new Array<string>();
+  let start = name.length + 1;
+  while (attributes.length < count) {
+    if (start > event.length) {
+      return undefined;
+    }
+
+    const end = event.indexOf(' ', start);
+    if (end === -1) {
+      attributes.push(event.substring(start));
+      start = event.length + 1;
+    } else {
+      attributes.push(event.substring(start, end));
+      start = end + 1;
+    }
+  }
+  return attributes;
+};
+
+const maxDecodedLength = (base64: string) => Math.ceil((base64.length * 3) / 4);
+
+/**
+ * Decodes a pair of base64 strings (e.g. scout and data frames) into a single allocation,
+ * returning views onto it rather than separately allocated buffers.
+ */
+export const decodeBase64Pair = (
+  first: string,
+  second: string,
+): [Buffer, Buffer] => {
+  const buffer = Buffer.allocUnsafe(
+    maxDecodedLength(first) + maxDecodedLength(second),
+  );
+  const firstLen = buffer.write(first, 0, 'base64');
+  const secondLen = buffer.write(second, firstLen, 'base64');
+  return [
+    buffer.subarray(0, firstLen),
+    buffer.subarray(firstLen, firstLen + secondLen),
+  ];
+};
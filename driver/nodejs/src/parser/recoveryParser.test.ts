@@ -0,0 +1,41 @@
+import { parseRecoveryEvent } from './recoveryParser';
+
+describe('recovery message parser', () => {
+  it('should parse valid RECOVERY event', () => {
+    const parsedEvent = parseRecoveryEvent(
+      'RECOVERY REPROGRAM 2 1 3 2 18 21 1 1 27 27 0 0 0 0',
+    );
+    expect(parsedEvent).toBeDefined();
+    expect(parsedEvent?.lastTier).toEqual('REPROGRAM');
+    expect(parsedEvent?.lineJammedStalls).toEqual(2);
+    expect(parsedEvent?.stuckFifoStalls).toEqual(1);
+    expect(parsedEvent?.soft).toEqual({
+      attempts: 3,
+      successes: 2,
+      lastUs: 18,
+      maxUs: 21,
+    });
+    expect(parsedEvent?.reprogram).toEqual({
+      attempts: 1,
+      successes: 1,
+      lastUs: 27,
+      maxUs: 27,
+    });
+    expect(parsedEvent?.hard.attempts).toEqual(0);
+  });
+
+  it('should ignore other events', () => {
+    expect(parseRecoveryEvent('STATUS 2.0.0 1 00 0')).toBeUndefined();
+  });
+
+  it('should reject invalid events', () => {
+    expect(() =>
+      parseRecoveryEvent('RECOVERY SOFT 0 0 1 1 20 20 0 0 0 0 0 0 0'),
+    ).toThrow(
+      "Protocol error. Invalid RECOVERY event 'RECOVERY SOFT 0 0 1 1 20 20 0 0 0 0 0 0 0' received.",
+    );
+    expect(() =>
+      parseRecoveryEvent('RECOVERY WARM 0 0 1 1 20 20 0 0 0 0 0 0 0 0'),
+    ).toThrow('Protocol error');
+  });
+});
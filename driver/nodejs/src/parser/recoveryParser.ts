@@ -0,0 +1,51 @@
+import {
+  RecoveryEvent,
+  RecoveryTier,
+  RecoveryTierStats,
+} from '../types/recoveryEvent';
+import { eventAttributes, hasEventName } from './parserUtils';
+
+const tiers: ReadonlyArray<RecoveryTier> = [
+  'NONE',
+  'SOFT',
+  'REPROGRAM',
+  'HARD',
+  'FAILED',
+];
+
+export const parseRecoveryEvent = (
+  event: string,
+): RecoveryEvent | undefined => {
+  if (!hasEventName(event, 'RECOVERY')) {
+    return undefined;
+  }
+
+  const attributes = eventAttributes(event, 'RECOVERY', 15);
+  const counters = attributes?.slice(1).map(str => parseInt(str, 10));
+  const lastTier = tiers.find(tier => tier === attributes?.[0]);
+  if (
+    !counters ||
+    !lastTier ||
+    counters.some(counter => isNaN(counter) || counter < 0)
+  ) {
+    throw new Error(
+      `Protocol error. Invalid RECOVERY event '${event}' received.`,
+    );
+  }
+
+  const tierStats = (offset: number): RecoveryTierStats => ({
+    attempts: counters[offset],
+    successes: counters[offset + 1],
+    lastUs: counters[offset + 2],
+    maxUs: counters[offset + 3],
+  });
+
+  return new RecoveryEvent(
+    lastTier,
+    counters[0],
+    counters[1],
+    tierStats(2),
+    tierStats(6),
+    tierStats(10),
+  );
+};
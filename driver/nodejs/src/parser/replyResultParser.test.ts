@@ -0,0 +1,25 @@
+import { ReplyResultEvent } from '../types/replyResultEvent';
+import { parseReplyResultEvent } from './replyResultParser';
+
+describe('reply result message parser', () => {
+  it('should parse valid, successful REPLY_RESULT event', () => {
+    const parsedEvent = parseReplyResultEvent('REPLY_RESULT OK');
+    expect(parsedEvent).toBeInstanceOf(ReplyResultEvent);
+    expect(parsedEvent?.success).toEqual(true);
+    expect(parsedEvent?.description).toEqual('OK');
+  });
+
+  it('should parse valid, unsuccessful REPLY_RESULT event', () => {
+    const parsedEvent = parseReplyResultEvent(
+      'REPLY_RESULT INVALID_RECEIVE_ID',
+    );
+    expect(parsedEvent?.success).toEqual(false);
+    expect(parsedEvent?.description).toEqual('INVALID_RECEIVE_ID');
+  });
+
+  it('should reject invalid REPLY_RESULT event', () => {
+    expect(() => parseReplyResultEvent('REPLY_RESULT')).toThrow(
+      "Protocol error. Invalid REPLY_RESULT event 'REPLY_RESULT' received.",
+    );
+  });
+});
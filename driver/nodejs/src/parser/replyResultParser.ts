@@ -0,0 +1,20 @@
+import { ReplyResultEvent } from '../types/replyResultEvent';
+import { eventAttributes, hasEventName } from './parserUtils';
+
+export const parseReplyResultEvent = (
+  event: string,
+): ReplyResultEvent | undefined => {
+  if (!hasEventName(event, 'REPLY_RESULT')) {
+    return undefined;
+  }
+
+  const attributes = eventAttributes(event, 'REPLY_RESULT', 1);
+  if (!attributes) {
+    throw new Error(
+      `Protocol error. Invalid REPLY_RESULT event '${event}' received.`,
+    );
+  }
+
+  const result = attributes[0];
+  return new ReplyResultEvent(result === 'OK', result);
+};
@@ -1,20 +1,19 @@
 import { RxBroadcastEvent } from '../types/rxBroadcastEvent';
+import { eventAttributes, hasEventName } from './parserUtils';
 
 export const parseRxBroadcastEvent = (
   event: string,
 ): RxBroadcastEvent | undefined => {
-  const terms = event.split(' ');
-
-  if (terms.length == 0 || terms[0] !== 'RX_BROADCAST') {
+  if (!hasEventName(event, 'RX_BROADCAST')) {
     return undefined;
   }
 
-  if (terms.length < 2) {
+  const attributes = eventAttributes(event, 'RX_BROADCAST', 1);
+  if (!attributes) {
     throw new Error(
       `Protocol error. Invalid RX_BROADCAST event '${event}' received.`,
     );
   }
-  const attributes = terms.slice(1);
 
   const data = attributes[0];
   try {
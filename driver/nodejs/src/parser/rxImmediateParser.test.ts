@@ -1,3 +1,4 @@
+import { RxTransmitEvent } from '../types/rxTransmitEvent';
 import { parseRxImmediateEvent as parseRxImmediateEvent } from './rxImmediateParser';
 
 describe('immediate message parser', () => {
@@ -9,6 +10,13 @@ describe('immediate message parser', () => {
     expect(result?.dataFrame).toEqual(Buffer.from('123abcdef', 'base64'));
   });
 
+  it('should not give immediate operations a reply ID', () => {
+    // only transmitted packets can be answered with REPLY
+    const result = parseRxImmediateEvent('RX_IMMEDIATE abcdef123= 123abcdef=');
+    expect(result).not.toBeInstanceOf(RxTransmitEvent);
+    expect((result as unknown as { replyId?: number }).replyId).toBeUndefined();
+  });
+
   it('should reject invalid RX_IMMEDIATE event', () => {
     expect(() => parseRxImmediateEvent('RX_IMMEDIATE abcdef123')).toThrow(
       "Protocol error. Invalid RX_IMMEDIATE event 'RX_IMMEDIATE abcdef123' received.",
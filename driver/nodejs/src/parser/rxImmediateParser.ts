@@ -1,28 +1,25 @@
 import { RxImmediateEvent } from '../types/rxImmediateEvent';
+import { decodeBase64Pair, eventAttributes, hasEventName } from './parserUtils';
 
 export const parseRxImmediateEvent = (
   event: string,
 ): RxImmediateEvent | undefined => {
-  const terms = event.split(' ');
-
-  if (terms.length == 0 || terms[0] !== 'RX_IMMEDIATE') {
+  if (!hasEventName(event, 'RX_IMMEDIATE')) {
     return undefined;
   }
 
-  if (terms.length < 3) {
+  const attributes = eventAttributes(event, 'RX_IMMEDIATE', 2);
+  if (!attributes) {
     throw new Error(
       `Protocol error. Invalid RX_IMMEDIATE event '${event}' received.`,
     );
   }
-  const attributes = terms.slice(1);
 
   const scout = attributes[0];
   const data = attributes[1];
   try {
-    return new RxImmediateEvent(
-      Buffer.from(scout, 'base64'),
-      Buffer.from(data, 'base64'),
-    );
+    const [scoutFrame, dataFrame] = decodeBase64Pair(scout, data);
+    return new RxImmediateEvent(scoutFrame, dataFrame);
   } catch (e) {
     throw new Error(
       `Protocol error. Invalid RX_IMMEDIATE event '${event}' received. Failed to parse base64 data.`,
@@ -7,11 +7,23 @@ describe('rx transmit message parser', () => {
     expect(result).toBeDefined();
     expect(result?.scoutFrame).toEqual(Buffer.from('abcdef123', 'base64'));
     expect(result?.dataFrame).toEqual(Buffer.from('123abcdef', 'base64'));
+    expect(result?.replyId).toBeUndefined();
+  });
+
+  it('should parse RX_TRANSMIT event with reply ID', () => {
+    const eventStr = 'RX_TRANSMIT 513 abcdef123= 123abcdef=';
+    const result = parseRxTransmitEvent(eventStr);
+    expect(result?.replyId).toEqual(513);
+    expect(result?.scoutFrame).toEqual(Buffer.from('abcdef123', 'base64'));
+    expect(result?.dataFrame).toEqual(Buffer.from('123abcdef', 'base64'));
   });
 
   it('should reject invalid RX_TRANSMIT event', () => {
     expect(() => parseRxTransmitEvent('RX_TRANSMIT abcdef123')).toThrow(
       "Protocol error. Invalid RX_TRANSMIT event 'RX_TRANSMIT abcdef123' received.",
     );
+    expect(() => parseRxTransmitEvent('RX_TRANSMIT x abcd abcd')).toThrow(
+      "Protocol error. Invalid RX_TRANSMIT event 'RX_TRANSMIT x abcd abcd' received.",
+    );
   });
 });
@@ -1,23 +1,37 @@
 import { RxTransmitEvent } from '../types/rxTransmitEvent';
+import { decodeBase64Pair, eventAttributes, hasEventName } from './parserUtils';
 
 export const parseRxTransmitEvent = (
   event: string,
 ): RxTransmitEvent | undefined => {
-  const terms = event.split(' ');
-
-  if (terms.length == 0 || terms[0] !== 'RX_TRANSMIT') {
+  if (!hasEventName(event, 'RX_TRANSMIT')) {
     return undefined;
   }
 
-  if (terms.length < 3) {
+  // firmware which predates replies omits the reply ID
+  const attributes =
+    eventAttributes(event, 'RX_TRANSMIT', 3) ??
+    eventAttributes(event, 'RX_TRANSMIT', 2);
+  if (!attributes) {
     throw new Error(
       `Protocol error. Invalid RX_TRANSMIT event '${event}' received.`,
     );
   }
-  const attributes = terms.slice(1);
 
-  return new RxTransmitEvent(
-    Buffer.from(attributes[0], 'base64'),
-    Buffer.from(attributes[1], 'base64'),
+  let replyId: number | undefined;
+  if (attributes.length === 3) {
+    const replyIdStr = attributes.shift() ?? '';
+    replyId = parseInt(replyIdStr, 10);
+    if (!/^\d+$/.test(replyIdStr) || replyId > 65535) {
+      throw new Error(
+        `Protocol error. Invalid RX_TRANSMIT event '${event}' received.`,
+      );
+    }
+  }
+
+  const [scoutFrame, dataFrame] = decodeBase64Pair(
+    attributes[0],
+    attributes[1],
   );
+  return new RxTransmitEvent(scoutFrame, dataFrame, replyId);
 };
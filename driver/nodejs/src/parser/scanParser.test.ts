@@ -0,0 +1,42 @@
+import { parseScanEvent, parseScanStationEvent } from './scanParser';
+
+describe('scan message parser', () => {
+  it('should parse valid SCAN_STATION event', () => {
+    const parsedEvent = parseScanStationEvent(
+      'SCAN_STATION 100 0 01006003 530',
+    );
+    expect(parsedEvent).toBeDefined();
+    expect(parsedEvent?.station).toEqual(100);
+    expect(parsedEvent?.network).toEqual(0);
+    expect(parsedEvent?.machineType).toEqual(1);
+    expect(parsedEvent?.manufacturerId).toEqual(0);
+    expect(parsedEvent?.versionMajor).toEqual(3);
+    expect(parsedEvent?.versionMinor).toEqual(0x60);
+    expect(parsedEvent?.responseUs).toEqual(530);
+  });
+
+  it('should parse valid SCAN event', () => {
+    const parsedEvent = parseScanEvent('SCAN 253 3 2754459 OK');
+    expect(parsedEvent).toBeDefined();
+    expect(parsedEvent?.probed).toEqual(253);
+    expect(parsedEvent?.found).toEqual(3);
+    expect(parsedEvent?.elapsedUs).toEqual(2754459);
+    expect(parsedEvent?.result).toEqual('OK');
+  });
+
+  it('should ignore other events', () => {
+    expect(parseScanEvent('SCAN_STATION 100 0 01006003 530')).toBeUndefined();
+    expect(parseScanStationEvent('SCAN 253 3 2754459 OK')).toBeUndefined();
+  });
+
+  it('should reject invalid events', () => {
+    expect(() =>
+      parseScanStationEvent('SCAN_STATION 100 0 0100 530'),
+    ).toThrow(
+      "Protocol error. Invalid SCAN_STATION event 'SCAN_STATION 100 0 0100 530' received.",
+    );
+    expect(() => parseScanEvent('SCAN 253 3 OK')).toThrow(
+      "Protocol error. Invalid SCAN event 'SCAN 253 3 OK' received.",
+    );
+  });
+});
@@ -0,0 +1,51 @@
+import { ScanEvent } from '../types/scanEvent';
+import { ScanStationEvent } from '../types/scanStationEvent';
+import { eventAttributes, hasEventName } from './parserUtils';
+
+export const parseScanStationEvent = (
+  event: string,
+): ScanStationEvent | undefined => {
+  if (!hasEventName(event, 'SCAN_STATION')) {
+    return undefined;
+  }
+
+  const attributes = eventAttributes(event, 'SCAN_STATION', 4);
+  const station = attributes ? parseInt(attributes[0], 10) : NaN;
+  const network = attributes ? parseInt(attributes[1], 10) : NaN;
+  const responseUs = attributes ? parseInt(attributes[3], 10) : NaN;
+  const machineType = Buffer.from(attributes?.[2] ?? '', 'hex');
+  if (
+    isNaN(station) ||
+    isNaN(network) ||
+    isNaN(responseUs) ||
+    machineType.length !== 4
+  ) {
+    throw new Error(
+      `Protocol error. Invalid SCAN_STATION event '${event}' received.`,
+    );
+  }
+
+  return new ScanStationEvent(
+    station,
+    network,
+    machineType[0],
+    machineType[1],
+    machineType[3],
+    machineType[2],
+    responseUs,
+  );
+};
+
+export const parseScanEvent = (event: string): ScanEvent | undefined => {
+  if (!hasEventName(event, 'SCAN')) {
+    return undefined;
+  }
+
+  const attributes = eventAttributes(event, 'SCAN', 4);
+  const counters = attributes?.slice(0, 3).map(str => parseInt(str, 10));
+  if (!counters || counters.some(counter => isNaN(counter) || counter < 0)) {
+    throw new Error(`Protocol error. Invalid SCAN event '${event}' received.`);
+  }
+
+  return new ScanEvent(counters[0], counters[1], counters[2], attributes[3]);
+};
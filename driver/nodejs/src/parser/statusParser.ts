@@ -64,6 +64,9 @@ export const parseStatusEvent = (event: string): StatusEvent | undefined => {
     case 2:
       rxState = RxMode.MONITOR;
       break;
+    case 3:
+      rxState = RxMode.TRAFFIC;
+      break;
     default:
       throw new Error(
         `Protocol error. Invalid STATUS event '${event}' received. Invalid board state value '${boardStateStr}'.`,
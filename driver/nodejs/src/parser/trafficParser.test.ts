@@ -0,0 +1,60 @@
+import { parseTrafficEvent } from './trafficParser';
+
+const data =
+  'DAAAAAAAAAAAAAAAAAAAAAQAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAZAAAACgBAAAAAAAAZQAAACAAAAAAAAAAZABlAAgAAAAgAAAAAAAAAGUAZAAIAAAAKAEAAAAAAAA=';
+
+describe('traffic message parser', () => {
+  it('should parse valid TRAFFIC event', () => {
+    const parsedEvent = parseTrafficEvent(
+      `TRAFFIC 352648 14675 16 328 0 0 2 2 ${data}`,
+    );
+    expect(parsedEvent).toBeDefined();
+    expect(parsedEvent?.elapsedUs).toEqual(352648);
+    expect(parsedEvent?.busyUs).toEqual(14675);
+    expect(parsedEvent?.frames).toEqual(16);
+    expect(parsedEvent?.bytes).toEqual(328);
+    expect(parsedEvent?.errors).toEqual(0);
+    expect(parsedEvent?.untracked).toEqual(0);
+    expect(parsedEvent?.sizeHistogram).toEqual([
+      12, 0, 0, 0, 4, 0, 0, 0, 0, 0, 0, 0,
+    ]);
+    expect(parsedEvent?.talkers).toEqual([
+      { station: 100, network: 0, bytes: 296, maxOverestimate: 0 },
+      { station: 101, network: 0, bytes: 32, maxOverestimate: 0 },
+    ]);
+    expect(parsedEvent?.pairs).toEqual([
+      {
+        destStation: 100,
+        destNetwork: 0,
+        srcStation: 101,
+        srcNetwork: 0,
+        frames: 8,
+        bytes: 32,
+        errors: 0,
+      },
+      {
+        destStation: 101,
+        destNetwork: 0,
+        srcStation: 100,
+        srcNetwork: 0,
+        frames: 8,
+        bytes: 296,
+        errors: 0,
+      },
+    ]);
+    expect(parsedEvent?.utilisation).toBeCloseTo(0.0416, 4);
+  });
+
+  it('should ignore other events', () => {
+    expect(parseTrafficEvent('TRACE 0 0')).toBeUndefined();
+  });
+
+  it('should reject invalid events', () => {
+    expect(() => parseTrafficEvent(`TRAFFIC 1000 0 0 0 0 0 0 0`)).toThrow(
+      "Protocol error. Invalid TRAFFIC event 'TRAFFIC 1000 0 0 0 0 0 0 0' received.",
+    );
+    expect(() =>
+      parseTrafficEvent(`TRAFFIC 352648 14675 16 328 0 0 2 3 ${data}`),
+    ).toThrow('Protocol error');
+  });
+});
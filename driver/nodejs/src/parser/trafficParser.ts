@@ -0,0 +1,75 @@
+import {
+  TrafficEvent,
+  TrafficPair,
+  TrafficTalker,
+} from '../types/trafficEvent';
+import { eventAttributes, hasEventName } from './parserUtils';
+
+// sizes of the board's raw records (see traffic.h)
+const sizeBuckets = 12;
+const talkerSize = 12;
+const pairSize = 16;
+
+export const parseTrafficEvent = (event: string): TrafficEvent | undefined => {
+  if (!hasEventName(event, 'TRAFFIC')) {
+    return undefined;
+  }
+
+  const attributes = eventAttributes(event, 'TRAFFIC', 9);
+  const counters = attributes?.slice(0, 8).map(str => parseInt(str, 10));
+  const data = Buffer.from(attributes?.[8] ?? '', 'base64');
+  if (
+    !counters ||
+    counters.some(counter => isNaN(counter) || counter < 0) ||
+    data.length !==
+      sizeBuckets * 4 + counters[6] * talkerSize + counters[7] * pairSize
+  ) {
+    throw new Error(
+      `Protocol error. Invalid TRAFFIC event '${event}' received.`,
+    );
+  }
+
+  const sizeHistogram = Array.from({ length: sizeBuckets }, (_, i) =>
+    data.readUInt32LE(i * 4),
+  );
+
+  const talkersOffset = sizeBuckets * 4;
+  const talkers = Array.from(
+    { length: counters[6] },
+    (_, i): TrafficTalker => {
+      const offset = talkersOffset + i * talkerSize;
+      return {
+        station: data.readUInt8(offset),
+        network: data.readUInt8(offset + 1),
+        bytes: data.readUInt32LE(offset + 4),
+        maxOverestimate: data.readUInt32LE(offset + 8),
+      };
+    },
+  );
+
+  const pairsOffset = talkersOffset + counters[6] * talkerSize;
+  const pairs = Array.from({ length: counters[7] }, (_, i): TrafficPair => {
+    const offset = pairsOffset + i * pairSize;
+    return {
+      destStation: data.readUInt8(offset),
+      destNetwork: data.readUInt8(offset + 1),
+      srcStation: data.readUInt8(offset + 2),
+      srcNetwork: data.readUInt8(offset + 3),
+      frames: data.readUInt32LE(offset + 4),
+      bytes: data.readUInt32LE(offset + 8),
+      errors: data.readUInt32LE(offset + 12),
+    };
+  });
+
+  return new TrafficEvent(
+    counters[0],
+    counters[1],
+    counters[2],
+    counters[3],
+    counters[4],
+    counters[5],
+    sizeHistogram,
+    talkers,
+    pairs,
+  );
+};
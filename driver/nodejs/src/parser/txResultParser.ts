@@ -1,20 +1,19 @@
 import { TxResultEvent } from '../types/txResultEvent';
+import { eventAttributes, hasEventName } from './parserUtils';
 
 export const parseTxResultEvent = (
   event: string,
 ): TxResultEvent | undefined => {
-  const terms = event.split(' ');
-
-  if (terms.length == 0 || terms[0] !== 'TX_RESULT') {
+  if (!hasEventName(event, 'TX_RESULT')) {
     return undefined;
   }
 
-  if (terms.length < 2) {
+  const attributes = eventAttributes(event, 'TX_RESULT', 1);
+  if (!attributes) {
     throw new Error(
       `Protocol error. Invalid TX_RESULT event '${event}' received.`,
     );
   }
-  const attributes = terms.slice(1);
 
   const result = attributes[0];
   return new TxResultEvent(result === 'OK', result);
@@ -0,0 +1,36 @@
+import { parseUsbEvent } from './usbParser';
+
+describe('USB output message parser', () => {
+  it('should parse valid USB event', () => {
+    const parsedEvent = parseUsbEvent('USB 1000 42517 849636 13303 13263 9 31');
+    expect(parsedEvent).toBeDefined();
+    expect(parsedEvent?.flushUs).toEqual(1000);
+    expect(parsedEvent?.lines).toEqual(42517);
+    expect(parsedEvent?.bytes).toEqual(849636);
+    expect(parsedEvent?.packets).toEqual(13303);
+    expect(parsedEvent?.fullPackets).toEqual(13263);
+    expect(parsedEvent?.deadlineFlushes).toEqual(9);
+    expect(parsedEvent?.urgentFlushes).toEqual(31);
+    expect(parsedEvent?.fillRatio).toBeCloseTo(0.998);
+    expect(parsedEvent?.linesPerPacket).toBeCloseTo(3.2);
+  });
+
+  it('should report zero ratios before anything is sent', () => {
+    const parsedEvent = parseUsbEvent('USB 0 0 0 0 0 0 0');
+    expect(parsedEvent?.fillRatio).toEqual(0);
+    expect(parsedEvent?.linesPerPacket).toEqual(0);
+  });
+
+  it('should ignore other events', () => {
+    expect(parseUsbEvent('STATUS 2.0.0 1 00 0')).toBeUndefined();
+  });
+
+  it('should reject invalid USB event', () => {
+    expect(() => parseUsbEvent('USB 1000 1 2 3 4 5')).toThrow(
+      "Protocol error. Invalid USB event 'USB 1000 1 2 3 4 5' received.",
+    );
+    expect(() => parseUsbEvent('USB 1000 1 2 x 4 5 6')).toThrow(
+      'Protocol error',
+    );
+  });
+});
@@ -0,0 +1,24 @@
+import { UsbEvent } from '../types/usbEvent';
+import { eventAttributes, hasEventName } from './parserUtils';
+
+export const parseUsbEvent = (event: string): UsbEvent | undefined => {
+  if (!hasEventName(event, 'USB')) {
+    return undefined;
+  }
+
+  const attributes = eventAttributes(event, 'USB', 7);
+  const values = attributes?.map(str => parseInt(str, 10));
+  if (!values || values.some(value => isNaN(value) || value < 0)) {
+    throw new Error(`Protocol error. Invalid USB event '${event}' received.`);
+  }
+
+  return new UsbEvent(
+    values[0],
+    values[1],
+    values[2],
+    values[3],
+    values[4],
+    values[5],
+    values[6],
+  );
+};
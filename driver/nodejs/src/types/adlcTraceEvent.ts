@@ -0,0 +1,34 @@
+import { AdlcTraceEntry } from '../driver/adlcTrace';
+import { EconetEvent } from './econetEvent';
+
+/**
+ * Generated by the board in response to a `SET_TRACE` or `TRACE` command, reporting the ADLC
+ * bus transactions recorded since tracing was last enabled.
+ */
+export class AdlcTraceEvent extends EconetEvent {
+  constructor(
+    /**
+     * `true` if the board is recording bus transactions.
+     */
+    public enabled: boolean,
+
+    /**
+     * Number of entries recorded since tracing was enabled, including any overwritten once the
+     * board's ring filled.
+     */
+    public recorded: number,
+
+    /**
+     * The entries still held by the board, oldest first.
+     */
+    public entries: Array<AdlcTraceEntry>,
+  ) {
+    super();
+  }
+
+  public toString() {
+    return `[${this.constructor.name} enabled=${
+      this.enabled ? 'true' : 'false'
+    } recorded=${this.recorded} entries=${this.entries.length}]`;
+  }
+}
@@ -0,0 +1,69 @@
+import { EconetEvent } from './econetEvent';
+
+/**
+ * Generated by the board in response to a `BENCH` command, reporting the outcome of sending
+ * frames through the ADLC in loop mode (its transmitter feeding its own receiver, away from the
+ * Econet line).
+ */
+export class BenchEvent extends EconetEvent {
+  constructor(
+    /**
+     * Number of bytes in each frame sent.
+     */
+    public frameLength: number,
+
+    /**
+     * Number of frames received back intact.
+     */
+    public frames: number,
+
+    /**
+     * Number of frames lost or received back corrupt, including underruns and overruns.
+     */
+    public errors: number,
+
+    /**
+     * Number of frames lost because the firmware didn't keep the transmit FIFO fed.
+     */
+    public underruns: number,
+
+    /**
+     * Number of frames lost because the firmware didn't keep the receive FIFO drained.
+     */
+    public overruns: number,
+
+    /**
+     * Time taken to send every frame in microseconds.
+     */
+    public elapsedUs: number,
+
+    /**
+     * Frames received back intact per second.
+     */
+    public framesPerSecond: number,
+
+    /**
+     * Bytes received back intact per second.
+     */
+    public bytesPerSecond: number,
+
+    /**
+     * Mean number of ADLC register reads and writes made per byte sent.
+     */
+    public busCyclesPerByte: number,
+  ) {
+    super();
+  }
+
+  public toString() {
+    return `[${this.constructor.name} frameLength=${this.frameLength} frames=${
+      this.frames
+    } errors=${this.errors} underruns=${this.underruns} overruns=${
+      this.overruns
+    } elapsedUs=${this.elapsedUs} framesPerSecond=${
+      this.framesPerSecond
+    } bytesPerSecond=${this.bytesPerSecond} busCyclesPerByte=${
+      this.busCyclesPerByte
+    }]`;
+  }
+}
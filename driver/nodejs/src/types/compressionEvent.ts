@@ -0,0 +1,55 @@
+import { EconetEvent } from './econetEvent';
+
+/**
+ * Generated by the board in response to a `SET_COMPRESSION` or `COMPRESSION` command, reporting
+ * whether frame data is being compressed and how effective that has been.
+ */
+export class CompressionEvent extends EconetEvent {
+  constructor(
+    /**
+     * The compression scheme in use: `LZ` or `NONE`.
+     */
+    public scheme: string,
+
+    /**
+     * Number of frame data bytes passed to the compressor since it was last enabled.
+     */
+    public inputBytes: number,
+
+    /**
+     * Number of compressed bytes produced (before base64 encoding) since it was last enabled.
+     */
+    public outputBytes: number,
+
+    /**
+     * Approximate number of CPU cycles the board has spent compressing since it was last
+     * enabled.
+     */
+    public cycles: number,
+  ) {
+    super();
+  }
+
+  /**
+   * Ratio of input to output bytes e.g. 2 if the data has been halved in size. This is 1
+   * if nothing has been compressed yet.
+   */
+  public get ratio(): number {
+    return this.outputBytes === 0 ? 1 : this.inputBytes / this.outputBytes;
+  }
+
+  /**
+   * Average number of CPU cycles spent by the board per input byte.
+   */
+  public get cyclesPerByte(): number {
+    return this.inputBytes === 0 ? 0 : this.cycles / this.inputBytes;
+  }
+
+  public toString() {
+    return `[${this.constructor.name} scheme=${this.scheme} inputBytes=${
+      this.inputBytes
+    } outputBytes=${this.outputBytes} ratio=${this.ratio.toFixed(
+      2,
+    )} cyclesPerByte=${this.cyclesPerByte.toFixed(1)}]`;
+  }
+}
@@ -0,0 +1,36 @@
+import { EconetEvent } from './econetEvent';
+
+/**
+ * Generated by the board in response to a `SET_DEDUP` or `DEDUP` command, reporting how
+ * duplicate packets are being suppressed and how many have been.
+ */
+export class DedupEvent extends EconetEvent {
+  constructor(
+    /**
+     * Period in milliseconds within which copies of a packet are suppressed, or `0` if
+     * suppression is disabled.
+     */
+    public windowMs: number,
+
+    /**
+     * Number of duplicate transmit packets suppressed since the window was last set.
+     */
+    public transmitSuppressed: number,
+
+    /**
+     * Number of duplicate immediate operations suppressed since the window was last set.
+     */
+    public immediateSuppressed: number,
+
+    /**
+     * Number of duplicate broadcasts suppressed since the window was last set.
+     */
+    public broadcastSuppressed: number,
+  ) {
+    super();
+  }
+
+  public toString() {
+    return `[${this.constructor.name} windowMs=${this.windowMs} transmitSuppressed=${this.transmitSuppressed} immediateSuppressed=${this.immediateSuppressed} broadcastSuppressed=${this.broadcastSuppressed}]`;
+  }
+}
@@ -0,0 +1,55 @@
+import { EconetEvent } from './econetEvent';
+
+/**
+ * Generated by the board in response to a `SET_FLOW` or `FLOW` command, reporting the state of
+ * flow control and how many frames have been turned away for want of room.
+ */
+export class FlowEvent extends EconetEvent {
+  constructor(
+    /**
+     * `true` if the board only reports received frames for which it holds a credit.
+     */
+    public enabled: boolean,
+
+    /**
+     * Number of credits the board holds, i.e. frames it may report before it must be granted
+     * more.
+     */
+    public credits: number,
+
+    /**
+     * Number of events waiting to be sent to the host.
+     */
+    public backlog: number,
+
+    /**
+     * Number of scouts left unacknowledged since `SET_FLOW` was last sent because the board had
+     * no room to report the packet. The sender sees `NO_SCOUT_ACK` and may retry.
+     */
+    public declinedScouts: number,
+
+    /**
+     * Number of broadcast or monitored frames discarded since `SET_FLOW` was last sent because
+     * the board had no room to report them.
+     */
+    public droppedFrames: number,
+
+    /**
+     * Number of receive errors left unreported since `SET_FLOW` was last sent because the
+     * board's event queue was full.
+     */
+    public droppedErrors: number,
+  ) {
+    super();
+  }
+
+  public toString() {
+    return `[${this.constructor.name} enabled=${
+      this.enabled ? 'true' : 'false'
+    } credits=${this.credits} backlog=${this.backlog} declinedScouts=${
+      this.declinedScouts
+    } droppedFrames=${this.droppedFrames} droppedErrors=${
+      this.droppedErrors
+    }]`;
+  }
+}
@@ -4,7 +4,8 @@ import { RxDataEvent } from './rxDataEvent';
 /**
  * Fired asynchronously as frames are received by the ADLC whilst in `MONITOR` mode.
  *
- * This event is fired regardless of the source or destination of the frame.
+ * This event is fired regardless of the source or destination of the frame. If a snap length has
+ * been set (see `setSnapLength`), the frame may be truncated to it.
  */
 export class MonitorEvent extends RxDataEvent {
   constructor(
@@ -12,10 +13,26 @@ export class MonitorEvent extends RxDataEvent {
      * The raw Econet frame.
      */
     public econetFrame: Buffer,
+
+    /**
+     * Length of the frame on the wire, which exceeds that of `econetFrame` if it was truncated.
+     */
+    public frameLength: number = econetFrame.length,
   ) {
     super();
   }
 
+  /**
+   * `true` if the board captured only the start of the frame.
+   */
+  public get truncated(): boolean {
+    return this.frameLength > this.econetFrame.length;
+  }
+
+  protected get headerFrame(): Buffer {
+    return this.econetFrame;
+  }
+
   public toString() {
     return (
       this.titleForFrame(this.econetFrame) +
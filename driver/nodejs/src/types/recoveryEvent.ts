@@ -0,0 +1,87 @@
+import { EconetEvent } from './econetEvent';
+
+/**
+ * Ways in which the board brings its ADLC back to a working state, cheapest first: `SOFT` resets
+ * the transmitter and receiver, `REPROGRAM` also rewrites the control registers and `HARD`
+ * pulses the chip's reset line first. `NONE` means no recovery has been needed and `FAILED` that
+ * the ADLC was still unhealthy after a hard reset.
+ */
+export type RecoveryTier = 'NONE' | 'SOFT' | 'REPROGRAM' | 'HARD' | 'FAILED';
+
+/**
+ * Counters describing one tier of ADLC recovery.
+ */
+export type RecoveryTierStats = {
+  /**
+   * Number of times the tier has been tried.
+   */
+  attempts: number;
+
+  /**
+   * Number of attempts after which the ADLC was healthy.
+   */
+  successes: number;
+
+  /**
+   * Time taken by the latest attempt in microseconds.
+   */
+  lastUs: number;
+
+  /**
+   * Longest time taken by an attempt in microseconds.
+   */
+  maxUs: number;
+};
+
+/**
+ * Generated by the board in response to a `RECOVER` or `RECOVERY` command, reporting how its
+ * ADLC has been recovered, whether at the host's request, on `RESTART` or because the board
+ * detected a stall.
+ */
+export class RecoveryEvent extends EconetEvent {
+  constructor(
+    /**
+     * Tier at which the latest recovery succeeded.
+     */
+    public lastTier: RecoveryTier,
+
+    /**
+     * Number of times recovery was triggered by transmissions failing with `LINE_JAMMED`
+     * several times running.
+     */
+    public lineJammedStalls: number,
+
+    /**
+     * Number of times recovery was triggered by the receive FIFO still holding data after the
+     * board discarded it.
+     */
+    public stuckFifoStalls: number,
+
+    /**
+     * Counters for the soft tier.
+     */
+    public soft: RecoveryTierStats,
+
+    /**
+     * Counters for the reprogram tier.
+     */
+    public reprogram: RecoveryTierStats,
+
+    /**
+     * Counters for the hard tier.
+     */
+    public hard: RecoveryTierStats,
+  ) {
+    super();
+  }
+
+  public toString() {
+    const tier = (stats: RecoveryTierStats) =>
+      `${stats.successes}/${stats.attempts} lastUs=${stats.lastUs} maxUs=${stats.maxUs}`;
+    return `[${this.constructor.name} lastTier=${this.lastTier} lineJammedStalls=${
+      this.lineJammedStalls
+    } stuckFifoStalls=${this.stuckFifoStalls} soft=${tier(
+      this.soft,
+    )} reprogram=${tier(this.reprogram)} hard=${tier(this.hard)}]`;
+  }
+}
@@ -0,0 +1,8 @@
+import { TxResultEvent } from './txResultEvent';
+
+/**
+ * Generated in response to a `REPLY` command. Besides the `TxResultEvent` descriptions, a reply
+ * may fail with `INVALID_RECEIVE_ID` if the packet being answered has expired or was already
+ * answered.
+ */
+export class ReplyResultEvent extends TxResultEvent {}
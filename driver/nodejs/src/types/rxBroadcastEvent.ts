@@ -14,6 +14,10 @@ export class RxBroadcastEvent extends RxDataEvent {
     super();
   }
 
+  protected get headerFrame(): Buffer {
+    return this.econetFrame;
+  }
+
   public toString() {
     return (
       this.titleForFrame(this.econetFrame) +
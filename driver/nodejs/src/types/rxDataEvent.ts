@@ -2,8 +2,46 @@ import { EconetEvent } from './econetEvent';
 
 /**
  * Superclass for events emitted by the Econet driver in response to incoming data.
+ *
+ * Address fields are decoded on demand from the frame holding the Econet header, so that
+ * events which are never inspected cost no more than their raw buffers.
  */
 export class RxDataEvent extends EconetEvent {
+  /**
+   * The frame carrying the Econet address header (the scout frame, where there is one).
+   */
+  protected get headerFrame(): Buffer {
+    return Buffer.alloc(0);
+  }
+
+  /**
+   * Destination Econet station number.
+   */
+  public get toStation(): number {
+    return this.headerFrame[0];
+  }
+
+  /**
+   * Destination Econet network number.
+   */
+  public get toNetwork(): number {
+    return this.headerFrame[1];
+  }
+
+  /**
+   * Source Econet station number.
+   */
+  public get fromStation(): number {
+    return this.headerFrame[2];
+  }
+
+  /**
+   * Source Econet network number.
+   */
+  public get fromNetwork(): number {
+    return this.headerFrame[3];
+  }
+
   protected titleForFrame(frame: Buffer) {
     const toStation = frame[0];
     const toNet = frame[1];
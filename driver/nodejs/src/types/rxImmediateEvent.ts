@@ -20,6 +20,32 @@ export class RxImmediateEvent extends RxDataEvent {
     super();
   }
 
+  protected get headerFrame(): Buffer {
+    return this.scoutFrame;
+  }
+
+  /**
+   * Econet control byte from the scout frame.
+   */
+  public get controlByte(): number {
+    return this.scoutFrame[4];
+  }
+
+  /**
+   * Econet port number from the scout frame.
+   */
+  public get port(): number {
+    return this.scoutFrame[5];
+  }
+
+  /**
+   * Payload of the data frame (i.e. excluding its 4-byte address header). This is a view onto
+   * `dataFrame` rather than a copy.
+   */
+  public get payload(): Buffer {
+    return this.dataFrame.subarray(4);
+  }
+
   public toString() {
     return (
       this.titleForFrame(this.scoutFrame) +
@@ -15,10 +15,41 @@ export class RxTransmitEvent extends RxDataEvent {
      * The raw data frame.
      */
     public dataFrame: Buffer,
+    /**
+     * Identifies the packet in a subsequent call to `reply`, which answers the station that sent
+     * it. `undefined` if the firmware does not support replies.
+     */
+    public replyId?: number,
   ) {
     super();
   }
 
+  protected get headerFrame(): Buffer {
+    return this.scoutFrame;
+  }
+
+  /**
+   * Econet control byte from the scout frame.
+   */
+  public get controlByte(): number {
+    return this.scoutFrame[4];
+  }
+
+  /**
+   * Econet port number from the scout frame.
+   */
+  public get port(): number {
+    return this.scoutFrame[5];
+  }
+
+  /**
+   * Payload of the data frame (i.e. excluding its 4-byte address header). This is a view onto
+   * `dataFrame` rather than a copy.
+   */
+  public get payload(): Buffer {
+    return this.dataFrame.subarray(4);
+  }
+
   public toString() {
     return (
       this.titleForFrame(this.scoutFrame) +
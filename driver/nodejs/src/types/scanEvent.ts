@@ -0,0 +1,51 @@
+import { EconetEvent } from './econetEvent';
+import { ScanStationEvent } from './scanStationEvent';
+
+/**
+ * Generated by the board at the end of a `SCAN`, once a `ScanStationEvent` has been generated
+ * for each station found.
+ */
+export class ScanEvent extends EconetEvent {
+  constructor(
+    /**
+     * Number of stations peeked at.
+     */
+    public probed: number,
+
+    /**
+     * Number of stations which answered.
+     */
+    public found: number,
+
+    /**
+     * Time taken by the scan in microseconds.
+     */
+    public elapsedUs: number,
+
+    /**
+     * `OK` if every station in the range was peeked at, or the reason the scan was cut short
+     * (a `TxResultEvent` description such as `LINE_JAMMED`).
+     */
+    public result: string,
+  ) {
+    super();
+  }
+
+  public toString() {
+    return `[${this.constructor.name} probed=${this.probed} found=${
+      this.found
+    } elapsedUs=${this.elapsedUs} result=${this.result}]`;
+  }
+}
+
+/**
+ * Outcome of a network scan (see `scanNetwork`).
+ */
+export type ScanResult = {
+  /**
+   * The stations which answered, in station order.
+   */
+  stations: Array<ScanStationEvent>;
+
+  summary: ScanEvent;
+};
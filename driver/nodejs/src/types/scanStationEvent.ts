@@ -0,0 +1,49 @@
+import { EconetEvent } from './econetEvent';
+
+/**
+ * Generated by the board during a `SCAN` for each station which answers its machine type peek.
+ */
+export class ScanStationEvent extends EconetEvent {
+  constructor(
+    public station: number,
+    public network: number,
+
+    /**
+     * Type of machine, e.g. `1` for a BBC Micro.
+     */
+    public machineType: number,
+
+    /**
+     * Maker of the machine's network software, `0` being Acorn.
+     */
+    public manufacturerId: number,
+
+    /**
+     * Major version of the network software, e.g. `3` for NFS 3.60.
+     */
+    public versionMajor: number,
+
+    /**
+     * Minor version of the network software in binary coded decimal, e.g. `0x60` for NFS 3.60.
+     */
+    public versionMinor: number,
+
+    /**
+     * Time from sending the peek to receiving the reply in microseconds.
+     */
+    public responseUs: number,
+  ) {
+    super();
+  }
+
+  public toString() {
+    const version = `${this.versionMajor}.${this.versionMinor
+      .toString(16)
+      .padStart(2, '0')}`;
+    return `[${this.constructor.name} station=${this.station} network=${
+      this.network
+    } machineType=${this.machineType} manufacturerId=${
+      this.manufacturerId
+    } version=${version} responseUs=${this.responseUs}]`;
+  }
+}
@@ -23,6 +23,13 @@ export enum RxMode {
    * the BBC NETMON utility. A code example is provided for how to build such a utility.
    */
   MONITOR,
+
+  /**
+   * The board counts every frame received, as in `MONITOR` mode, but rather than an event for
+   * each one it periodically generates a `TrafficEvent` summarising who talked to whom and how
+   * busy the line was.
+   */
+  TRAFFIC,
 }
 
 /**
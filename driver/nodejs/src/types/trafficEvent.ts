@@ -0,0 +1,117 @@
+import { EconetEvent } from './econetEvent';
+
+/**
+ * A station among those sending the most bytes, as tracked by the board.
+ */
+export type TrafficTalker = {
+  /**
+   * Station number.
+   */
+  station: number;
+
+  /**
+   * Network number.
+   */
+  network: number;
+
+  /**
+   * Bytes counted for the station, including the frames' addresses.
+   */
+  bytes: number;
+
+  /**
+   * Bytes by which `bytes` may overstate the station's traffic. The board only tracks a few
+   * stations, each one it hasn't room for taking over the count of the least busy.
+   */
+  maxOverestimate: number;
+};
+
+/**
+ * Frames sent from one station to another.
+ */
+export type TrafficPair = {
+  destStation: number;
+  destNetwork: number;
+  srcStation: number;
+  srcNetwork: number;
+  frames: number;
+  bytes: number;
+
+  /**
+   * Frames which were corrupt or not read in full.
+   */
+  errors: number;
+};
+
+/**
+ * Generated by the board in `TRAFFIC` mode every `SET_TRAFFIC` interval, and in response to a
+ * `SET_TRAFFIC` or `TRAFFIC` command, summarising the frames seen on the line since the last
+ * such event.
+ */
+export class TrafficEvent extends EconetEvent {
+  constructor(
+    /**
+     * Time covered in microseconds.
+     */
+    public elapsedUs: number,
+
+    /**
+     * Time the line spent carrying frames in microseconds, measured from each frame's address
+     * to its end.
+     */
+    public busyUs: number,
+
+    public frames: number,
+
+    /**
+     * Bytes in all frames, including their addresses.
+     */
+    public bytes: number,
+
+    /**
+     * Frames which were corrupt or not read in full.
+     */
+    public errors: number,
+
+    /**
+     * Frames counted but not attributed to a station pair, being too short to carry an address
+     * or arriving once the board's table of pairs was full.
+     */
+    public untracked: number,
+
+    /**
+     * Number of frames by size: the first element counts those of fewer than 8 bytes, each
+     * following one those of up to twice the size of the last and the final one any larger.
+     */
+    public sizeHistogram: Array<number>,
+
+    /**
+     * The stations sending the most bytes, in no particular order.
+     */
+    public talkers: Array<TrafficTalker>,
+
+    /**
+     * Traffic between each pair of stations seen, in no particular order.
+     */
+    public pairs: Array<TrafficPair>,
+  ) {
+    super();
+  }
+
+  /**
+   * Fraction of the time covered for which the line was busy, from 0 to 1.
+   */
+  public get utilisation(): number {
+    return this.elapsedUs > 0 ? Math.min(this.busyUs / this.elapsedUs, 1) : 0;
+  }
+
+  public toString() {
+    return `[${this.constructor.name} elapsedUs=${this.elapsedUs} busyUs=${
+      this.busyUs
+    } frames=${this.frames} bytes=${this.bytes} errors=${
+      this.errors
+    } untracked=${this.untracked} talkers=${this.talkers.length} pairs=${
+      this.pairs.length
+    }]`;
+  }
+}
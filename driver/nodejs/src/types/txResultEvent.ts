@@ -32,6 +32,8 @@ export class TxResultEvent extends EconetEvent {
      * `MISC` — Logic error e.g. in protocol decode
      *
      * `UNEXPECTED` — Firmware issue — should never happen
+     *
+     * `INVALID_COMMAND` — The board couldn't parse the command, so nothing was sent
      */
     public description: string,
   ) {
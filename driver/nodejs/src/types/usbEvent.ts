@@ -0,0 +1,79 @@
+import { EconetEvent } from './econetEvent';
+
+// as USB_PACKET_SZ in the firmware's usb_io.h
+const usbPacketSize = 64;
+
+/**
+ * Generated by the board in response to a `SET_USB_FLUSH` or `USB` command, reporting how well
+ * it has been filling USB packets with output. The board gathers events into whole packets,
+ * sending a partly filled one only once the results of a command are complete or the oldest
+ * event in it has waited the flush deadline. Counters run from when `SET_USB_FLUSH` was last
+ * sent.
+ */
+export class UsbEvent extends EconetEvent {
+  constructor(
+    /**
+     * How long, in microseconds, output may wait for a packet to fill, or `0` if each line is
+     * sent as soon as it's complete.
+     */
+    public flushUs: number,
+
+    /**
+     * Number of lines (events, results and reports) sent.
+     */
+    public lines: number,
+
+    /**
+     * Number of bytes sent.
+     */
+    public bytes: number,
+
+    /**
+     * Number of packets sent, whether full or not.
+     */
+    public packets: number,
+
+    /**
+     * Number of packets sent full.
+     */
+    public fullPackets: number,
+
+    /**
+     * Number of partly filled packets sent because their flush deadline had passed.
+     */
+    public deadlineFlushes: number,
+
+    /**
+     * Number of partly filled packets sent at once because they completed the results of a
+     * command (or, with a flush deadline of `0`, any line).
+     */
+    public urgentFlushes: number,
+  ) {
+    super();
+  }
+
+  /**
+   * Proportion of the packets' capacity used, from 0 to 1. This is 0 if nothing has been sent
+   * yet.
+   */
+  public get fillRatio(): number {
+    return this.packets === 0 ? 0 : this.bytes / (this.packets * usbPacketSize);
+  }
+
+  /**
+   * Average number of lines per packet sent.
+   */
+  public get linesPerPacket(): number {
+    return this.packets === 0 ? 0 : this.lines / this.packets;
+  }
+
+  public toString() {
+    return `[${this.constructor.name} flushUs=${this.flushUs} lines=${
+      this.lines
+    } bytes=${this.bytes} packets=${this.packets} fullPackets=${
+      this.fullPackets
+    } deadlineFlushes=${this.deadlineFlushes} urgentFlushes=${
+      this.urgentFlushes
+    } fillRatio=${this.fillRatio.toFixed(2)}]`;
+  }
+}
@@ -0,0 +1,22 @@
+import { EconetEvent } from './econetEvent';
+
+/**
+ * Fired by the board when events back up waiting for the host, or it starts turning frames
+ * away (level `HIGH`), and again once the host has caught up (level `LOW`).
+ */
+export class WatermarkEvent extends EconetEvent {
+  constructor(
+    public level: 'HIGH' | 'LOW',
+
+    /**
+     * Number of events waiting to be sent to the host.
+     */
+    public backlog: number,
+  ) {
+    super();
+  }
+
+  public toString() {
+    return `[${this.constructor.name} level=${this.level} backlog=${this.backlog}]`;
+  }
+}